@@ -46,6 +46,13 @@ void Model::Load(std::string strDir, std::string strFilename, glm::mat4 matTrans
 
         Material &material = m_listMaterials[pMesh->mMaterialIndex];
 
+        uint32_t nFirstPosition = (uint32_t)m_listPositions.size();
+        for(unsigned int v = 0; v < pMesh->mNumVertices; v++)
+        {
+            aiVector3D p = pMesh->mVertices[v];
+            m_listPositions.push_back(glm::vec3(matTransform * glm::vec4(p.x, p.y, p.z, 1.0f)));
+        }
+
         for(unsigned int f = 0; f < pMesh->mNumFaces; f++)
         {
             aiFace face = pMesh->mFaces[f];
@@ -55,6 +62,11 @@ void Model::Load(std::string strDir, std::string strFilename, glm::mat4 matTrans
                 continue;
             }
 
+            for(int i = 0; i < 3; i++)
+            {
+                m_listPositionIndices.push_back(nFirstPosition + face.mIndices[i]);
+            }
+
             for(int i = 0; i < 3; i++)
             {
                 aiVector3D v = pMesh->mVertices[ face.mIndices[i] ];
@@ -115,6 +127,99 @@ void Model::CreateOpenGLBuffers()
     }
 }
 
+void Model::CreateInstanceBuffer(int nMaxInstances)
+{
+    if (0 == m_glInstanceBuffer)
+    {
+        glGenBuffers(1, &m_glInstanceBuffer);
+    }
+
+    m_nMaxInstances = nMaxInstances;
+    glBindBuffer(GL_ARRAY_BUFFER, m_glInstanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * m_nMaxInstances, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Model::SetInstances(const glm::mat4 *pMatrices, int nNumInstances)
+{
+    if (nNumInstances > m_nMaxInstances)
+    {
+        CreateInstanceBuffer(nNumInstances);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_glInstanceBuffer);
+    // orphan the old storage, so the driver does not wait for the previous frame
+    glBufferData(GL_ARRAY_BUFFER, sizeof(glm::mat4) * m_nMaxInstances, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4) * nNumInstances, pMatrices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint Model::GetInstanceBuffer()
+{
+    return m_glInstanceBuffer;
+}
+
+void Model::BeginInstanced(Shader* shader)
+{
+    Begin(shader);
+
+    for (int i = 0; i < 4; i++)
+    {
+        glEnableVertexAttribArray(3 + i);
+        glVertexAttribDivisor(3 + i, 1);
+    }
+}
+
+void Model::DrawInstanced(Shader *shader, int nFirstInstance, int nNumInstances)
+{
+    if (nNumInstances <= 0)
+    {
+        return;
+    }
+
+    // GL 3.3 has no base instance, so the matrix attributes start at the first instance instead
+    glBindBuffer(GL_ARRAY_BUFFER, m_glInstanceBuffer);
+    for (int i = 0; i < 4; i++)
+    {
+        GLsizeiptr offset = sizeof(glm::mat4) * nFirstInstance + sizeof(glm::vec4) * i;
+        glVertexAttribPointer(3 + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (GLvoid*)offset);
+    }
+
+    for(unsigned int m = 0; m < m_listMaterials.size(); m++)
+    {
+        Material &material = m_listMaterials[m];
+
+        if (material.m_listVertices.size() == 0)
+        {
+            continue;
+        }
+
+        if (true == m_bIsLoadTextures)
+        {
+            if (nullptr == material.m_pTexture)
+            {
+                continue;
+            }
+
+            shader->SetTexture("g_Texture", material.m_pTexture, 0);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, material.m_glIndexBuffer);
+        glDrawElementsInstanced(GL_TRIANGLES, (int)material.m_listIndices.size(), GL_UNSIGNED_INT, nullptr, nNumInstances);
+    }
+}
+
+void Model::EndInstanced(Shader* shader)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        glVertexAttribDivisor(3 + i, 0);
+        glDisableVertexAttribArray(3 + i);
+    }
+
+    End(shader);
+}
+
 void Model::Begin(Shader* shader)
 {
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -185,6 +290,15 @@ void Model::Release()
 
     m_listMaterials.clear();
     m_listAllVertices.clear();
+    m_listPositions.clear();
+    m_listPositionIndices.clear();
+
+    if (0 != m_glInstanceBuffer)
+    {
+        glDeleteBuffers(1, &m_glInstanceBuffer);
+        m_glInstanceBuffer = 0;
+        m_nMaxInstances = 0;
+    }
 }
 
 std::vector< Vertex >* Model::GetVertices()
@@ -196,3 +310,13 @@ std::vector< Material >* Model::GetMaterials()
 {
     return &m_listMaterials;
 }
+
+std::vector< glm::vec3 >* Model::GetPositions()
+{
+    return &m_listPositions;
+}
+
+std::vector< uint32_t >* Model::GetPositionIndices()
+{
+    return &m_listPositionIndices;
+}
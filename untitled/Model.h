@@ -45,15 +45,34 @@ public:
     void End(Shader* shader);
 
     void CreateOpenGLBuffers();
+
+    // instancing: per instance world matrices at attribute locations 3..6
+    void CreateInstanceBuffer(int nMaxInstances);
+    void SetInstances(const glm::mat4 *pMatrices, int nNumInstances);
+    void BeginInstanced(Shader* shader);
+    void DrawInstanced(Shader* shader, int nFirstInstance, int nNumInstances);
+    void EndInstanced(Shader* shader);
+    GLuint GetInstanceBuffer();
+
     std::vector< Vertex >* GetVertices();
     std::vector< Material >* GetMaterials();
 
+    // indexed triangles of all meshes, with the vertices shared like in the file (for the physics)
+    std::vector< glm::vec3 >* GetPositions();
+    std::vector< uint32_t >* GetPositionIndices();
+
 private:
     std::vector< Material > m_listMaterials;
 
     GLuint m_glVertexBuffer = 0;
     std::vector< Vertex > m_listAllVertices;
 
+    std::vector< glm::vec3 > m_listPositions;
+    std::vector< uint32_t > m_listPositionIndices;
+
+    GLuint m_glInstanceBuffer = 0;
+    int m_nMaxInstances = 0;
+
     bool m_bIsLoadTextures;
 };
 
@@ -167,6 +167,35 @@ b3DynamicBvhBroadphase::~b3DynamicBvhBroadphase()
 	}
 }
 
+//
+void b3DynamicBvhBroadphase::reserveProxies(int proxyCapacity)
+{
+	int oldCapacity = m_proxies.size();
+	if (proxyCapacity <= oldCapacity)
+		return;
+
+	const b3DbvtProxy* oldProxies = oldCapacity ? &m_proxies[0] : 0;
+	m_proxies.resize(proxyCapacity);
+	if (!oldProxies)
+		return;
+
+	//the leaves and the stage lists point into the old array, only the live proxies are linked
+	for (int i = 0; i <= STAGECOUNT; ++i)
+	{
+		if (m_stageRoots[i])
+			m_stageRoots[i] = &m_proxies[int(m_stageRoots[i] - oldProxies)];
+		for (b3DbvtProxy* proxy = m_stageRoots[i]; proxy; proxy = proxy->links[1])
+		{
+			for (int j = 0; j < 2; ++j)
+			{
+				if (proxy->links[j])
+					proxy->links[j] = &m_proxies[int(proxy->links[j] - oldProxies)];
+			}
+			proxy->leaf->data = proxy;
+		}
+	}
+}
+
 //
 b3BroadphaseProxy* b3DynamicBvhBroadphase::createProxy(const b3Vector3& aabbMin,
 													   const b3Vector3& aabbMax,
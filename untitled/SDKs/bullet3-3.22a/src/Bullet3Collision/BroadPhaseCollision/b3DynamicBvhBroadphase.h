@@ -156,6 +156,9 @@ struct b3DynamicBvhBroadphase
 	void collide(b3Dispatcher* dispatcher);
 	void optimize();
 
+	///grows the proxy array indexed by the object id, the tree leaves and stage lists are moved along
+	void reserveProxies(int proxyCapacity);
+
 	/* b3BroadphaseInterface Implementation	*/
 	b3BroadphaseProxy* createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int objectIndex, void* userPtr, int collisionFilterGroup, int collisionFilterMask);
 	virtual void destroyProxy(b3BroadphaseProxy* proxy, b3Dispatcher* dispatcher);
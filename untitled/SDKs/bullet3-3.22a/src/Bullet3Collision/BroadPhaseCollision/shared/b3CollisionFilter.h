@@ -0,0 +1,12 @@
+#ifndef B3_COLLISION_FILTER_H
+#define B3_COLLISION_FILTER_H
+
+#include "Bullet3Common/shared/b3Int2.h"
+
+//the collision filters hold the group (x) and the mask (y) per user index, a pair is only reported if each group is in the other mask
+inline bool b3NeedsCollision(b3Int2 filterA, b3Int2 filterB)
+{
+	return (filterA.x & filterB.y) && (filterB.x & filterA.y);
+}
+
+#endif  //B3_COLLISION_FILTER_H
@@ -1,6 +1,14 @@
 #ifndef B3_CONFIG_H
 #define B3_CONFIG_H
 
+///what happens when the broadphase pairs, compound pairs, triangle-convex pairs or contacts exceed their capacity
+enum b3CapacityGrowthPolicy
+{
+	B3_CAPACITY_FIXED,          ///<the overflow is dropped (with a b3Error), the capacities never change
+	B3_CAPACITY_GROW_DEFERRED,  ///<the capacity grows for the next step, the overflow of this step is dropped
+	B3_CAPACITY_GROW_RERUN      ///<the capacity grows and the stage runs again, so nothing is dropped
+};
+
 struct b3Config
 {
 	int m_maxConvexBodies;
@@ -19,6 +27,42 @@ struct b3Config
 
 	int m_maxTriConvexPairCapacity;
 
+	///see b3CapacityGrowthPolicy, unless it is B3_CAPACITY_FIXED the m_max* values above are initial capacities
+	///m_maxConvexBodies and m_maxConvexShapes then also grow when more bodies or collidables are registered
+	int m_capacityGrowthPolicy;
+
+	///iterations of the GPU PGS contact solver, warm starting gives stable stacks with fewer of them
+	int m_numSolverIterations;
+	///start each contact from the impulses of the matching contact of the previous step, scaled by m_warmStartingFactor
+	bool m_enableWarmStarting;
+	float m_warmStartingFactor;
+	///contact points further apart than this between two steps are treated as new contacts
+	float m_warmStartingMaxDistance;
+
+	///islands of touching bodies fall asleep once all their bodies stayed below both velocity thresholds for m_timeToSleep seconds
+	///sleeping bodies are not integrated or solved and keep their aabbs, until an awake body touches their island
+	bool m_enableSleeping;
+	float m_linearSleepingThreshold;
+	float m_angularSleepingThreshold;
+	float m_timeToSleep;
+
+	///the aabb of a body that moves more than m_ccdMotionThreshold times its smallest half extent in a step is swept along
+	///its motion, and its motion is clamped at the first triangle of a concave mesh it would pass through
+	bool m_enableCcd;
+	float m_ccdMotionThreshold;
+
+	///a contact normal of a convex against a concave mesh triangle that tilts towards an edge shared with a neighbour triangle
+	///is replaced by the triangle normal, unless the edge is convex by more than m_maxInternalEdgeAngle radians
+	bool m_enableInternalEdgeFiltering;
+	float m_maxInternalEdgeAngle;
+
+	///the contact solver batches the contacts by a graph coloring on the GPU, the contacts of a color share no dynamic body
+	///m_maxSolverColors is the minimum number of coloring rounds, a heuristic adds rounds when a body has many contacts or a
+	///color reaches its size cap. The contacts left after the last round go to an overflow batch solved by a single work item
+	///when disabled the contacts are batched per cell of a spatial grid
+	bool m_enableGraphColoring;
+	int m_maxSolverColors;
+
 	b3Config()
 		: m_maxConvexBodies(128 * 1024),
 		  m_maxVerticesPerFace(64),
@@ -27,7 +71,22 @@ struct b3Config
 		  m_maxConvexIndices(81920),
 		  m_maxConvexUniqueEdges(8192),
 		  m_maxCompoundChildShapes(8192),
-		  m_maxTriConvexPairCapacity(256 * 1024)
+		  m_maxTriConvexPairCapacity(256 * 1024),
+		  m_capacityGrowthPolicy(B3_CAPACITY_GROW_RERUN),
+		  m_numSolverIterations(4),
+		  m_enableWarmStarting(true),
+		  m_warmStartingFactor(0.85f),
+		  m_warmStartingMaxDistance(0.05f),
+		  m_enableSleeping(true),
+		  m_linearSleepingThreshold(0.8f),
+		  m_angularSleepingThreshold(1.0f),
+		  m_timeToSleep(2.0f),
+		  m_enableCcd(true),
+		  m_ccdMotionThreshold(0.5f),
+		  m_enableInternalEdgeFiltering(true),
+		  m_maxInternalEdgeAngle(0.5f),
+		  m_enableGraphColoring(true),
+		  m_maxSolverColors(32)
 	{
 		m_maxConvexShapes = m_maxConvexBodies;
 		m_maxBroadphasePairs = 16 * m_maxConvexBodies;
@@ -36,4 +95,16 @@ struct b3Config
 	}
 };
 
+///returns a capacity of at least required, growing geometrically so an overflow does not happen again every step
+inline int b3GrowCapacity(int capacity, int required)
+{
+	const int maxCapacity = 0x7fffffff / 2;
+	int newCapacity = capacity > 1024 ? capacity : 1024;
+	while (newCapacity < required && newCapacity < maxCapacity)
+	{
+		newCapacity *= 2;
+	}
+	return newCapacity > required ? newCapacity : required;
+}
+
 #endif  //B3_CONFIG_H
@@ -0,0 +1,45 @@
+#ifndef B3_INTERNAL_EDGE_AXIS_H
+#define B3_INTERNAL_EDGE_AXIS_H
+
+#include "Bullet3Common/shared/b3Float4.h"
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3TriangleInfo.h"
+
+//internal edge filtering, like btAdjustInternalEdgeContacts of Bullet 2. The separating axis points from the convex to the
+//triangle. When it tilts from the triangle normal towards edges where the neighbour triangle continues the surface, or folds
+//away by at most maxInternalEdgeAngle, the neighbour produces the contacts there, so the axis becomes the triangle normal and
+//a convex sliding over the mesh does not bump on the edges between its triangles.
+//Returns true and writes the triangle normal to adjustedAxis when the axis should be replaced, the caller still has to
+//test the new axis against the convex before it uses it.
+inline bool b3AdjustInternalEdgeAxis(b3Float4ConstArg sepAxis, b3Float4ConstArg normalWS, const b3Float4* verticesWS, const b3TriangleInfo_t* info, float maxInternalEdgeAngle, b3Float4* adjustedAxis)
+{
+	if (maxInternalEdgeAngle < 0.f || info->m_flags == B3_TRIANGLE_EDGE_ALL_BORDERS)
+		return false;
+
+	b3Float4 towardsConvex = -sepAxis;
+	towardsConvex.w = 0.f;
+	//the triangles are two sided, the convex is on the side the axis points to
+	float side = b3Dot3F4(towardsConvex, normalWS) < 0.f ? -1.f : 1.f;
+	b3Float4 sideNormal = normalWS * side;
+	if (b3Dot3F4(towardsConvex, sideNormal) > 0.9999f)
+		return false;
+
+	float edgeAngles[3];
+	edgeAngles[0] = info->m_edgeV0V1Angle;
+	edgeAngles[1] = info->m_edgeV1V2Angle;
+	edgeAngles[2] = info->m_edgeV2V0Angle;
+	for (int k = 0; k < 3; k++)
+	{
+		b3Float4 edgeNormal = b3Normalized(b3Cross3(verticesWS[(k + 1) % 3] - verticesWS[k], normalWS));
+		if (b3Dot3F4(towardsConvex, edgeNormal) > 1e-4f)
+		{
+			//a border, or an edge that is convex by more than the threshold seen from the side of the convex
+			if ((info->m_flags & (B3_TRIANGLE_EDGE_V0V1_BORDER << k)) || -side * edgeAngles[k] > maxInternalEdgeAngle)
+				return false;
+		}
+	}
+
+	*adjustedAxis = -sideNormal;
+	return true;
+}
+
+#endif  //B3_INTERNAL_EDGE_AXIS_H
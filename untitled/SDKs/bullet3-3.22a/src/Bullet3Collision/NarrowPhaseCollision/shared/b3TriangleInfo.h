@@ -0,0 +1,23 @@
+#ifndef B3_TRIANGLE_INFO_H
+#define B3_TRIANGLE_INFO_H
+
+///the edge has no neighbour triangle (or more than one), contacts at it are never corrected
+#define B3_TRIANGLE_EDGE_V0V1_BORDER 1
+#define B3_TRIANGLE_EDGE_V1V2_BORDER 2
+#define B3_TRIANGLE_EDGE_V2V0_BORDER 4
+#define B3_TRIANGLE_EDGE_ALL_BORDERS 7
+
+///edge information of a concave mesh triangle for internal edge filtering, like btTriangleInfo of Bullet 2
+///there is one per face (b3GpuFace), the faces of convex hulls have all border flags set
+typedef struct b3TriangleInfo b3TriangleInfo_t;
+struct b3TriangleInfo
+{
+	int m_flags;
+	///angle in radians at which the neighbour triangle folds away from the plane of this triangle at the edge
+	///0 when both are coplanar, negative when it folds towards the back side (a convex edge seen from the front)
+	float m_edgeV0V1Angle;
+	float m_edgeV1V2Angle;
+	float m_edgeV2V0Angle;
+};
+
+#endif  //B3_TRIANGLE_INFO_H
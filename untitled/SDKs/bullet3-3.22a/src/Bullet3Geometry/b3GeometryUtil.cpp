@@ -172,3 +172,131 @@ void b3GeometryUtil::getVerticesFromPlaneEquations(const b3AlignedObjectArray<b3
 		}
 	}
 }
+
+static unsigned int b3HashWeldCell(int x, int y, int z)
+{
+	//multiply as unsigned, the signed products overflow for cells far from the origin
+	return ((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u);
+}
+
+int b3GeometryUtil::weldVertices(const b3AlignedObjectArray<b3Vector3>& vertices, const b3AlignedObjectArray<int>& indices, b3Scalar weldDistance, b3AlignedObjectArray<b3Vector3>& verticesOut, b3AlignedObjectArray<int>& indicesOut)
+{
+	b3Assert(weldDistance > b3Scalar(0));
+	b3Scalar invCellSize = b3Scalar(1) / weldDistance;
+	b3Scalar weldDistance2 = weldDistance * weldDistance;
+
+	//chained hash of the merged vertices by cell, a vertex is looked up in the 27 cells around its own
+	int numBuckets = 1;
+	while (numBuckets < 2 * vertices.size())
+		numBuckets <<= 1;
+	b3AlignedObjectArray<int> bucketHeads;
+	bucketHeads.resize(numBuckets, -1);
+	b3AlignedObjectArray<int> nextInBucket;
+	nextInBucket.reserve(vertices.size());
+
+	verticesOut.resize(0);
+	verticesOut.reserve(vertices.size());
+	b3AlignedObjectArray<int> remap;
+	remap.resize(vertices.size());
+
+	for (int i = 0; i < vertices.size(); i++)
+	{
+		const b3Vector3& vertex = vertices[i];
+		int cellX = (int)floor(vertex.x * invCellSize);
+		int cellY = (int)floor(vertex.y * invCellSize);
+		int cellZ = (int)floor(vertex.z * invCellSize);
+
+		int weldedIndex = -1;
+		for (int dz = -1; dz <= 1 && weldedIndex < 0; dz++)
+		{
+			for (int dy = -1; dy <= 1 && weldedIndex < 0; dy++)
+			{
+				for (int dx = -1; dx <= 1 && weldedIndex < 0; dx++)
+				{
+					int bucket = b3HashWeldCell(cellX + dx, cellY + dy, cellZ + dz) & (numBuckets - 1);
+					for (int j = bucketHeads[bucket]; j >= 0; j = nextInBucket[j])
+					{
+						if ((verticesOut[j] - vertex).length2() <= weldDistance2)
+						{
+							weldedIndex = j;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if (weldedIndex < 0)
+		{
+			weldedIndex = verticesOut.size();
+			int bucket = b3HashWeldCell(cellX, cellY, cellZ) & (numBuckets - 1);
+			verticesOut.push_back(vertex);
+			nextInBucket.push_back(bucketHeads[bucket]);
+			bucketHeads[bucket] = weldedIndex;
+		}
+		remap[i] = weldedIndex;
+	}
+
+	indicesOut.resize(0);
+	indicesOut.reserve(indices.size());
+	for (int t = 0; t + 2 < indices.size(); t += 3)
+	{
+		int i0 = remap[indices[t]];
+		int i1 = remap[indices[t + 1]];
+		int i2 = remap[indices[t + 2]];
+		if (i0 != i1 && i1 != i2 && i2 != i0)
+		{
+			indicesOut.push_back(i0);
+			indicesOut.push_back(i1);
+			indicesOut.push_back(i2);
+		}
+	}
+	return verticesOut.size();
+}
+
+struct b3MeshEdge
+{
+	unsigned long long m_key;
+	int m_halfEdge;
+};
+
+struct b3MeshEdgeSortPredicate
+{
+	bool operator()(const b3MeshEdge& a, const b3MeshEdge& b) const
+	{
+		return a.m_key < b.m_key;
+	}
+};
+
+void b3GeometryUtil::computeTriangleAdjacency(const b3AlignedObjectArray<int>& indices, b3AlignedObjectArray<int>& adjacencyOut)
+{
+	int numHalfEdges = (indices.size() / 3) * 3;
+	adjacencyOut.resize(0);
+	adjacencyOut.resize(numHalfEdges, -1);
+
+	//the half edges of an edge are neighbours once they are sorted by their vertex pair
+	b3AlignedObjectArray<b3MeshEdge> edges;
+	edges.resize(numHalfEdges);
+	for (int h = 0; h < numHalfEdges; h++)
+	{
+		int triangleStart = h - h % 3;
+		unsigned int v0 = (unsigned int)indices[h];
+		unsigned int v1 = (unsigned int)indices[triangleStart + (h + 1) % 3];
+		edges[h].m_key = v0 < v1 ? ((unsigned long long)v0 << 32) | v1 : ((unsigned long long)v1 << 32) | v0;
+		edges[h].m_halfEdge = h;
+	}
+	edges.quickSort(b3MeshEdgeSortPredicate());
+
+	for (int first = 0; first < numHalfEdges;)
+	{
+		int end = first + 1;
+		while (end < numHalfEdges && edges[end].m_key == edges[first].m_key)
+			end++;
+		if (end - first == 2)
+		{
+			adjacencyOut[edges[first].m_halfEdge] = edges[first + 1].m_halfEdge;
+			adjacencyOut[edges[first + 1].m_halfEdge] = edges[first].m_halfEdge;
+		}
+		first = end;
+	}
+}
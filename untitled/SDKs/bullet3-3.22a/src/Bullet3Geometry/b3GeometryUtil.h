@@ -31,6 +31,15 @@ public:
 	static bool isPointInsidePlanes(const b3AlignedObjectArray<b3Vector3>& planeEquations, const b3Vector3& point, b3Scalar margin);
 
 	static bool areVerticesBehindPlane(const b3Vector3& planeNormal, const b3AlignedObjectArray<b3Vector3>& vertices, b3Scalar margin);
+
+	///merges the vertices of a triangle mesh that are closer than weldDistance, using a spatial hash with cells of that size
+	///the indices are remapped to the merged vertices and triangles that collapse to an edge or a point are dropped
+	///returns the number of merged vertices
+	static int weldVertices(const b3AlignedObjectArray<b3Vector3>& vertices, const b3AlignedObjectArray<int>& indices, b3Scalar weldDistance, b3AlignedObjectArray<b3Vector3>& verticesOut, b3AlignedObjectArray<int>& indicesOut);
+
+	///adjacencyOut[3*t+k] is the half edge (3*triangle+edge) that shares edge k (from corner k to corner k+1) of triangle t
+	///or -1 for a border edge, edges of more than two triangles are treated as borders too
+	static void computeTriangleAdjacency(const b3AlignedObjectArray<int>& indices, b3AlignedObjectArray<int>& adjacencyOut);
 };
 
 #endif  //B3_GEOMETRY_UTIL_H
@@ -0,0 +1,451 @@
+#include "b3GpuAdaptiveBroadphase.h"
+#include "b3GpuSapBroadphase.h"
+#include "b3GpuGridBroadphase.h"
+#include "b3GpuParallelLinearBvhBroadphase.h"
+#include "b3GpuMultiLevelGridBroadphase.h"
+#include "Bullet3Common/b3MinMax.h"
+#include "kernels/adaptiveBroadphaseKernels.h"
+
+#include "Bullet3OpenCL/Initialize/b3OpenCLUtils.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h"
+
+#include <chrono>
+
+#define B3_ADAPTIVE_BROADPHASE_PATH "src/Bullet3OpenCL/BroadphaseCollision/kernels/adaptiveBroadphase.cl"
+
+///the grid cell is a bit larger than the largest small aabb, rotating bodies grow their aabbs between two evaluations
+static const float B3_GRID_CELL_MARGIN = 1.25f;
+///a measured time of another broadphase is trusted for this many evaluations, then the scene may have changed too much
+static const int B3_MAX_TIME_AGE = 8;
+///work group size of gatherStatisticsKernel, and the number of groups, so at most this many partial results are read back
+static const int B3_STATISTICS_WG_SIZE = 64;
+static const int B3_MAX_STATISTICS_GROUPS = 64;
+
+b3GpuAdaptiveBroadphase::b3GpuAdaptiveBroadphase(cl_context ctx, cl_device_id device, cl_command_queue q, int initialBroadphaseType)
+	: m_context(ctx),
+	  m_device(device),
+	  m_queue(q),
+	  m_broadphase(0),
+	  m_broadphaseType(initialBroadphaseType),
+	  m_autoSelect(true),
+	  m_evaluationInterval(60),
+	  m_stepsSinceEvaluation(0),
+	  m_numEvaluations(0),
+	  m_gridCellSize(3.f),
+	  m_multiLevelBaseCellSize(1.f),
+	  m_multiLevelNumLevels(8),
+	  m_statisticsProxiesGPU(ctx, q),
+	  m_statisticsProxiesDirty(true),
+	  m_statisticsNumAabbs(0),
+	  m_statisticsPartialsGPU(ctx, q)
+{
+	for (int i = 0; i < B3_GPU_BROADPHASE_NUM_TYPES; i++)
+	{
+		m_averageTimeMs[i] = 0.f;
+		m_timeEvaluation[i] = -1;
+	}
+	m_statistics.m_numSmallProxies = 0;
+	m_statistics.m_minExtent = 0.f;
+	m_statistics.m_meanExtent = 0.f;
+	m_statistics.m_maxExtent = 0.f;
+	m_statistics.m_occupancy = 0.f;
+	m_statistics.m_pairsPerProxy = 0.f;
+
+	cl_int errNum = 0;
+	cl_program statisticsProg = b3OpenCLUtils::compileCLProgramFromString(m_context, m_device, adaptiveBroadphaseCL, &errNum, "", B3_ADAPTIVE_BROADPHASE_PATH);
+	b3Assert(errNum == CL_SUCCESS);
+	m_gatherStatisticsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, adaptiveBroadphaseCL, "gatherStatisticsKernel", &errNum, statisticsProg);
+	b3Assert(errNum == CL_SUCCESS);
+
+	m_broadphase = createBroadphase(initialBroadphaseType);
+}
+
+b3GpuAdaptiveBroadphase::~b3GpuAdaptiveBroadphase()
+{
+	clReleaseKernel(m_gatherStatisticsKernel);
+	delete m_broadphase;
+}
+
+b3GpuBroadphaseInterface* b3GpuAdaptiveBroadphase::createBroadphase(int broadphaseType)
+{
+	switch (broadphaseType)
+	{
+		case B3_GPU_BROADPHASE_GRID:
+		{
+			b3GpuGridBroadphase* grid = new b3GpuGridBroadphase(m_context, m_device, m_queue);
+			grid->setCellSize(m_gridCellSize);
+			return grid;
+		}
+		case B3_GPU_BROADPHASE_LBVH:
+		{
+			return new b3GpuParallelLinearBvhBroadphase(m_context, m_device, m_queue);
+		}
+		case B3_GPU_BROADPHASE_MULTI_LEVEL_GRID:
+		{
+			b3GpuMultiLevelGridBroadphase* grid = new b3GpuMultiLevelGridBroadphase(m_context, m_device, m_queue);
+			grid->setGridParameters(m_multiLevelBaseCellSize, m_multiLevelNumLevels);
+			return grid;
+		}
+		case B3_GPU_BROADPHASE_SAP:
+		{
+			return new b3GpuSapBroadphase(m_context, m_device, m_queue);
+		}
+		default:
+		{
+			b3Error("Unknown broadphase type %d, fallback to the SAP broadphase\n", broadphaseType);
+			m_broadphaseType = B3_GPU_BROADPHASE_SAP;
+			return new b3GpuSapBroadphase(m_context, m_device, m_queue);
+		}
+	};
+}
+
+void b3GpuAdaptiveBroadphase::setBroadphaseType(int broadphaseType)
+{
+	if (broadphaseType != m_broadphaseType)
+	{
+		migrate(broadphaseType);
+	}
+}
+
+void b3GpuAdaptiveBroadphase::migrate(int broadphaseType)
+{
+	B3_PROFILE("b3GpuAdaptiveBroadphase::migrate");
+
+	b3GpuBroadphaseInterface* oldBroadphase = m_broadphase;
+	oldBroadphase->writeChangedAabbsToGpu();
+
+	m_broadphaseType = broadphaseType;
+	b3GpuBroadphaseInterface* newBroadphase = createBroadphase(broadphaseType);
+
+	//create the proxies again in the same slots, removed ones as well so their slots can be reused later
+	b3AlignedObjectArray<b3SapAabb>& oldAabbs = oldBroadphase->getAllAabbsCPU();
+	for (int i = 0; i < m_proxies.size(); i++)
+	{
+		const b3GpuAdaptiveProxy& proxy = m_proxies[i];
+		b3Vector3 aabbMin = b3MakeVector3(0, 0, 0);
+		b3Vector3 aabbMax = b3MakeVector3(0, 0, 0);
+		if (i < oldAabbs.size())
+		{
+			aabbMin = oldAabbs[i].m_minVec;
+			aabbMax = oldAabbs[i].m_maxVec;
+		}
+		if (proxy.m_largeProxy)
+		{
+			newBroadphase->createLargeProxy(aabbMin, aabbMax, proxy.m_userPtr, proxy.m_collisionFilterGroup, proxy.m_collisionFilterMask);
+		}
+		else
+		{
+			newBroadphase->createProxy(aabbMin, aabbMax, proxy.m_userPtr, proxy.m_collisionFilterGroup, proxy.m_collisionFilterMask);
+		}
+		if (proxy.m_removed)
+		{
+			newBroadphase->removeProxy(i);
+		}
+	}
+	newBroadphase->writeAabbsToGpu();
+
+	//the cpu aabbs are stale, the up to date world space aabbs only live on the gpu
+	int numAabbs = b3Min(oldBroadphase->getAllAabbsGPU().size(), newBroadphase->getAllAabbsGPU().size());
+	if (numAabbs)
+	{
+		oldBroadphase->getAllAabbsGPU().copyToCL(newBroadphase->getAllAabbsGPU().getBufferCL(), numAabbs);
+		clFinish(m_queue);
+	}
+
+	delete oldBroadphase;
+	m_broadphase = newBroadphase;
+}
+
+void b3GpuAdaptiveBroadphase::gatherStatistics()
+{
+	B3_PROFILE("b3GpuAdaptiveBroadphase::gatherStatistics");
+
+	//the world space aabbs stay on the gpu, only the small proxies that are not removed are reduced there
+	int numAabbs = m_broadphase->getAllAabbsGPU().size();
+	if (m_statisticsProxiesDirty || numAabbs != m_statisticsNumAabbs)
+	{
+		m_statisticsProxiesCPU.resize(0);
+		int numProxies = b3Min(m_proxies.size(), numAabbs);
+		for (int i = 0; i < numProxies; i++)
+		{
+			if (!m_proxies[i].m_removed && !m_proxies[i].m_largeProxy)
+				m_statisticsProxiesCPU.push_back(i);
+		}
+		m_statisticsProxiesGPU.copyFromHost(m_statisticsProxiesCPU);
+		m_statisticsProxiesDirty = false;
+		m_statisticsNumAabbs = numAabbs;
+	}
+
+	int numSmallProxies = 0;
+	float sumExtent = 0.f;
+	float minExtent = B3_LARGE_FLOAT;
+	float maxExtent = 0.f;
+	float sumVolume = 0.f;
+	b3Vector3 boundsMin = b3MakeVector3(B3_LARGE_FLOAT, B3_LARGE_FLOAT, B3_LARGE_FLOAT);
+	b3Vector3 boundsMax = b3MakeVector3(-B3_LARGE_FLOAT, -B3_LARGE_FLOAT, -B3_LARGE_FLOAT);
+
+	int numProxies = m_statisticsProxiesCPU.size();
+	if (numProxies)
+	{
+		int numGroups = b3Min((numProxies + B3_STATISTICS_WG_SIZE - 1) / B3_STATISTICS_WG_SIZE, B3_MAX_STATISTICS_GROUPS);
+		m_statisticsPartialsGPU.resize(numGroups);
+
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_broadphase->getAllAabbsGPU().getBufferCL(), true),
+			b3BufferInfoCL(m_statisticsProxiesGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_statisticsPartialsGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_gatherStatisticsKernel, "m_gatherStatisticsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numProxies);
+		launcher.launch1D(numGroups * B3_STATISTICS_WG_SIZE, B3_STATISTICS_WG_SIZE);
+
+		m_statisticsPartialsGPU.copyToHost(m_statisticsPartialsCPU);
+		for (int i = 0; i < numGroups; i++)
+		{
+			const b3GpuBroadphaseStatisticsPartial& partial = m_statisticsPartialsCPU[i];
+			if (!partial.m_numProxies)
+				continue;
+			sumExtent += partial.m_extents[0];
+			minExtent = b3Min(minExtent, partial.m_extents[1]);
+			maxExtent = b3Max(maxExtent, partial.m_extents[2]);
+			sumVolume += partial.m_extents[3];
+			boundsMin.setMin(b3MakeVector3(partial.m_boundsMin[0], partial.m_boundsMin[1], partial.m_boundsMin[2]));
+			boundsMax.setMax(b3MakeVector3(partial.m_boundsMax[0], partial.m_boundsMax[1], partial.m_boundsMax[2]));
+			numSmallProxies += partial.m_numProxies;
+		}
+	}
+
+	m_statistics.m_numSmallProxies = numSmallProxies;
+	m_statistics.m_meanExtent = numSmallProxies ? sumExtent / numSmallProxies : 0.f;
+	m_statistics.m_minExtent = numSmallProxies ? minExtent : 0.f;
+	m_statistics.m_maxExtent = maxExtent;
+	m_statistics.m_occupancy = 0.f;
+	m_statistics.m_pairsPerProxy = 0.f;
+	if (numSmallProxies)
+	{
+		//flat scenes would have no volume, so each side of the bounds is at least one mean extent
+		float boundsVolume = 1.f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boundsVolume *= b3Max(boundsMax[axis] - boundsMin[axis], m_statistics.m_meanExtent);
+		}
+		m_statistics.m_occupancy = boundsVolume > 0.f ? sumVolume / boundsVolume : 0.f;
+		m_statistics.m_pairsPerProxy = float(m_broadphase->getNumOverlapRequired()) / float(numSmallProxies);
+	}
+}
+
+int b3GpuAdaptiveBroadphase::selectBroadphaseType() const
+{
+	const b3GpuBroadphaseStatistics& stats = m_statistics;
+
+	//for small scenes the kernel launches dominate, and the SAP needs the fewest
+	if (stats.m_numSmallProxies < 1024 || stats.m_meanExtent <= 0.f)
+		return B3_GPU_BROADPHASE_SAP;
+
+	float sizeRatio = stats.m_maxExtent / stats.m_meanExtent;
+
+	//dense piles of similar bodies: each body only needs to visit the 27 cells around it
+	if (sizeRatio < 4.f && (stats.m_occupancy > 0.1f || stats.m_pairsPerProxy > 2.f))
+		return B3_GPU_BROADPHASE_GRID;
+
+	//widely varying sizes spoil the grid cell size and make the sorted sweep visit many neighbours,
+	//dense mixed scenes suit the grid levels, sparse ones the tree
+	if (sizeRatio > 16.f)
+		return (stats.m_occupancy > 0.1f || stats.m_pairsPerProxy > 2.f) ? B3_GPU_BROADPHASE_MULTI_LEVEL_GRID : B3_GPU_BROADPHASE_LBVH;
+
+	return B3_GPU_BROADPHASE_SAP;
+}
+
+void b3GpuAdaptiveBroadphase::evaluate()
+{
+	m_numEvaluations++;
+	gatherStatistics();
+
+	//the grid misses pairs of bodies larger than a cell, so it grows right away and only shrinks when far too coarse
+	float cellSize = m_statistics.m_maxExtent * B3_GRID_CELL_MARGIN;
+	if (cellSize > 0.f && (m_statistics.m_maxExtent > m_gridCellSize || m_gridCellSize > 2.f * cellSize))
+	{
+		m_gridCellSize = cellSize;
+		if (m_broadphaseType == B3_GPU_BROADPHASE_GRID)
+		{
+			((b3GpuGridBroadphase*)m_broadphase)->setCellSize(m_gridCellSize);
+		}
+	}
+
+	//the finest level fits the smallest bodies, the levels double up to the largest ones
+	if (m_statistics.m_maxExtent > 0.f)
+	{
+		m_multiLevelBaseCellSize = b3Max(m_statistics.m_minExtent, m_statistics.m_maxExtent / 32768.f) * B3_GRID_CELL_MARGIN;
+		m_multiLevelNumLevels = 1;
+		float cellSize = m_multiLevelBaseCellSize;
+		while (cellSize < m_statistics.m_maxExtent * B3_GRID_CELL_MARGIN && m_multiLevelNumLevels < 16)
+		{
+			cellSize *= 2.f;
+			m_multiLevelNumLevels++;
+		}
+		if (m_broadphaseType == B3_GPU_BROADPHASE_MULTI_LEVEL_GRID)
+		{
+			((b3GpuMultiLevelGridBroadphase*)m_broadphase)->setGridParameters(m_multiLevelBaseCellSize, m_multiLevelNumLevels);
+		}
+	}
+
+	//a proposal that was not measured recently is tried, otherwise the recent measurements decide,
+	//and a broadphase has to be clearly faster than the current one to be worth the migration
+	int broadphaseType = selectBroadphaseType();
+	if (broadphaseType == m_broadphaseType || isTimeMeasured(broadphaseType))
+	{
+		broadphaseType = m_broadphaseType;
+		for (int i = 0; i < B3_GPU_BROADPHASE_NUM_TYPES; i++)
+		{
+			if (isTimeMeasured(i) && m_averageTimeMs[i] < 0.9f * m_averageTimeMs[m_broadphaseType] && m_averageTimeMs[i] < m_averageTimeMs[broadphaseType])
+				broadphaseType = i;
+		}
+	}
+	if (broadphaseType == m_broadphaseType)
+		return;
+
+	migrate(broadphaseType);
+}
+
+bool b3GpuAdaptiveBroadphase::isTimeMeasured(int broadphaseType) const
+{
+	return m_timeEvaluation[broadphaseType] >= 0 && (m_numEvaluations - m_timeEvaluation[broadphaseType]) <= B3_MAX_TIME_AGE;
+}
+
+void b3GpuAdaptiveBroadphase::calculateOverlappingPairs(int maxPairs)
+{
+	//evaluate before the search, the caller reads the pairs of the broadphase that is current afterwards,
+	//and a migration leaves the new broadphase without pairs
+	if (m_autoSelect && ++m_stepsSinceEvaluation >= m_evaluationInterval)
+	{
+		m_stepsSinceEvaluation = 0;
+		evaluate();
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	m_broadphase->calculateOverlappingPairs(maxPairs);
+	float timeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	//the pair search reads back the pair count, so the time includes the gpu work
+	float& averageTimeMs = m_averageTimeMs[m_broadphaseType];
+	averageTimeMs = m_timeEvaluation[m_broadphaseType] == m_numEvaluations ? 0.9f * averageTimeMs + 0.1f * timeMs : timeMs;
+	m_timeEvaluation[m_broadphaseType] = m_numEvaluations;
+}
+
+void b3GpuAdaptiveBroadphase::calculateOverlappingPairsHost(int maxPairs)
+{
+	m_broadphase->calculateOverlappingPairsHost(maxPairs);
+}
+
+void b3GpuAdaptiveBroadphase::createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
+{
+	b3GpuAdaptiveProxy proxy;
+	proxy.m_userPtr = userPtr;
+	proxy.m_collisionFilterGroup = collisionFilterGroup;
+	proxy.m_collisionFilterMask = collisionFilterMask;
+	proxy.m_largeProxy = false;
+	proxy.m_removed = false;
+	m_proxies.push_back(proxy);
+	m_statisticsProxiesDirty = true;
+
+	m_broadphase->createProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
+void b3GpuAdaptiveBroadphase::createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
+{
+	b3GpuAdaptiveProxy proxy;
+	proxy.m_userPtr = userPtr;
+	proxy.m_collisionFilterGroup = collisionFilterGroup;
+	proxy.m_collisionFilterMask = collisionFilterMask;
+	proxy.m_largeProxy = true;
+	proxy.m_removed = false;
+	m_proxies.push_back(proxy);
+	m_statisticsProxiesDirty = true;
+
+	m_broadphase->createLargeProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
+void b3GpuAdaptiveBroadphase::removeProxy(int proxyIndex)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_proxies.size())
+	{
+		b3Warning("removeProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+	m_proxies[proxyIndex].m_removed = true;
+	m_statisticsProxiesDirty = true;
+	m_broadphase->removeProxy(proxyIndex);
+}
+
+void b3GpuAdaptiveBroadphase::insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_proxies.size())
+	{
+		b3Warning("insertProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+	b3GpuAdaptiveProxy& proxy = m_proxies[proxyIndex];
+	proxy.m_userPtr = userPtr;
+	proxy.m_collisionFilterGroup = collisionFilterGroup;
+	proxy.m_collisionFilterMask = collisionFilterMask;
+	proxy.m_largeProxy = largeProxy;
+	proxy.m_removed = false;
+	m_statisticsProxiesDirty = true;
+
+	m_broadphase->insertProxy(proxyIndex, aabbMin, aabbMax, userPtr, largeProxy, collisionFilterGroup, collisionFilterMask);
+}
+
+void b3GpuAdaptiveBroadphase::writeAabbsToGpu()
+{
+	m_broadphase->writeAabbsToGpu();
+}
+
+void b3GpuAdaptiveBroadphase::writeChangedAabbsToGpu()
+{
+	m_broadphase->writeChangedAabbsToGpu();
+}
+
+cl_mem b3GpuAdaptiveBroadphase::getAabbBufferWS()
+{
+	return m_broadphase->getAabbBufferWS();
+}
+
+int b3GpuAdaptiveBroadphase::getNumOverlap()
+{
+	return m_broadphase->getNumOverlap();
+}
+
+int b3GpuAdaptiveBroadphase::getNumOverlapRequired()
+{
+	return m_broadphase->getNumOverlapRequired();
+}
+
+cl_mem b3GpuAdaptiveBroadphase::getOverlappingPairBuffer()
+{
+	return m_broadphase->getOverlappingPairBuffer();
+}
+
+b3OpenCLArray<b3SapAabb>& b3GpuAdaptiveBroadphase::getAllAabbsGPU()
+{
+	return m_broadphase->getAllAabbsGPU();
+}
+
+b3AlignedObjectArray<b3SapAabb>& b3GpuAdaptiveBroadphase::getAllAabbsCPU()
+{
+	return m_broadphase->getAllAabbsCPU();
+}
+
+b3OpenCLArray<b3Int4>& b3GpuAdaptiveBroadphase::getOverlappingPairsGPU()
+{
+	return m_broadphase->getOverlappingPairsGPU();
+}
+
+b3OpenCLArray<int>& b3GpuAdaptiveBroadphase::getSmallAabbIndicesGPU()
+{
+	return m_broadphase->getSmallAabbIndicesGPU();
+}
+
+b3OpenCLArray<int>& b3GpuAdaptiveBroadphase::getLargeAabbIndicesGPU()
+{
+	return m_broadphase->getLargeAabbIndicesGPU();
+}
@@ -0,0 +1,149 @@
+#ifndef B3_GPU_ADAPTIVE_BROADPHASE_H
+#define B3_GPU_ADAPTIVE_BROADPHASE_H
+
+#include "b3GpuBroadphaseInterface.h"
+
+///everything needed to create a proxy again in another broadphase
+struct b3GpuAdaptiveProxy
+{
+	int m_userPtr;
+	int m_collisionFilterGroup;
+	int m_collisionFilterMask;
+	bool m_largeProxy;
+	bool m_removed;
+};
+
+///scene statistics gathered from the world space aabbs of the small proxies
+struct b3GpuBroadphaseStatistics
+{
+	int m_numSmallProxies;
+	float m_minExtent;
+	float m_meanExtent;
+	float m_maxExtent;
+	///summed volume of the small aabbs, relative to the volume of their bounds
+	float m_occupancy;
+	float m_pairsPerProxy;
+};
+
+///result of one work group of gatherStatisticsKernel, see adaptiveBroadphase.cl
+struct b3GpuBroadphaseStatisticsPartial
+{
+	float m_boundsMin[4];
+	float m_boundsMax[4];
+	///sum of the largest extents, smallest largest extent, largest extent and summed volume
+	float m_extents[4];
+	int m_numProxies;
+	int m_padding[3];
+};
+
+///wraps the SAP, grid, multi level grid and parallel linear BVH broadphases, and switches between them at runtime
+///every few steps it reduces the aabb sizes on the gpu and tunes the grid cell size. The heuristic proposes a broadphase
+///for these statistics and the pair count, then the measured times of calculateOverlappingPairs pick the fastest of
+///the proposed, the current and the recently used broadphases. The proxies are migrated on a switch.
+class b3GpuAdaptiveBroadphase : public b3GpuBroadphaseInterface
+{
+public:
+	enum b3GpuBroadphaseType
+	{
+		B3_GPU_BROADPHASE_SAP = 0,
+		B3_GPU_BROADPHASE_GRID,
+		B3_GPU_BROADPHASE_LBVH,
+		B3_GPU_BROADPHASE_MULTI_LEVEL_GRID,
+		B3_GPU_BROADPHASE_NUM_TYPES
+	};
+
+private:
+	cl_context m_context;
+	cl_device_id m_device;
+	cl_command_queue m_queue;
+
+	b3GpuBroadphaseInterface* m_broadphase;
+	int m_broadphaseType;
+	b3AlignedObjectArray<b3GpuAdaptiveProxy> m_proxies;
+
+	bool m_autoSelect;
+	int m_evaluationInterval;
+	int m_stepsSinceEvaluation;
+	int m_numEvaluations;
+	///moving average of calculateOverlappingPairs in milliseconds per broadphase type, and the evaluation it was last measured in
+	float m_averageTimeMs[B3_GPU_BROADPHASE_NUM_TYPES];
+	int m_timeEvaluation[B3_GPU_BROADPHASE_NUM_TYPES];
+	float m_gridCellSize;
+	float m_multiLevelBaseCellSize;
+	int m_multiLevelNumLevels;
+
+	b3GpuBroadphaseStatistics m_statistics;
+	///slots of the small proxies that are not removed, rebuilt when the proxies change
+	b3AlignedObjectArray<int> m_statisticsProxiesCPU;
+	b3OpenCLArray<int> m_statisticsProxiesGPU;
+	bool m_statisticsProxiesDirty;
+	int m_statisticsNumAabbs;
+	b3OpenCLArray<b3GpuBroadphaseStatisticsPartial> m_statisticsPartialsGPU;
+	b3AlignedObjectArray<b3GpuBroadphaseStatisticsPartial> m_statisticsPartialsCPU;
+	cl_kernel m_gatherStatisticsKernel;
+
+	b3GpuBroadphaseInterface* createBroadphase(int broadphaseType);
+	void migrate(int broadphaseType);
+	void gatherStatistics();
+	int selectBroadphaseType() const;
+	bool isTimeMeasured(int broadphaseType) const;
+	void evaluate();
+
+public:
+	b3GpuAdaptiveBroadphase(cl_context ctx, cl_device_id device, cl_command_queue q, int initialBroadphaseType = B3_GPU_BROADPHASE_SAP);
+	virtual ~b3GpuAdaptiveBroadphase();
+
+	static b3GpuBroadphaseInterface* CreateFunc(cl_context ctx, cl_device_id device, cl_command_queue q)
+	{
+		return new b3GpuAdaptiveBroadphase(ctx, device, q);
+	}
+
+	///with auto selection disabled the broadphase only changes through setBroadphaseType
+	void setAutoSelect(bool enable)
+	{
+		m_autoSelect = enable;
+	}
+	///number of calculateOverlappingPairs calls between two evaluations of the scene
+	void setEvaluationInterval(int numSteps)
+	{
+		m_evaluationInterval = numSteps;
+	}
+	void setBroadphaseType(int broadphaseType);
+	int getBroadphaseType() const
+	{
+		return m_broadphaseType;
+	}
+	b3GpuBroadphaseInterface* getBroadphase()
+	{
+		return m_broadphase;
+	}
+	const b3GpuBroadphaseStatistics& getStatistics() const
+	{
+		return m_statistics;
+	}
+
+	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	virtual void removeProxy(int proxyIndex);
+	virtual void insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask);
+
+	virtual void calculateOverlappingPairs(int maxPairs);
+	virtual void calculateOverlappingPairsHost(int maxPairs);
+
+	virtual void writeAabbsToGpu();
+	virtual void writeChangedAabbsToGpu();
+
+	virtual cl_mem getAabbBufferWS();
+	virtual int getNumOverlap();
+	virtual int getNumOverlapRequired();
+	virtual cl_mem getOverlappingPairBuffer();
+
+	virtual b3OpenCLArray<b3SapAabb>& getAllAabbsGPU();
+	virtual b3AlignedObjectArray<b3SapAabb>& getAllAabbsCPU();
+
+	virtual b3OpenCLArray<b3Int4>& getOverlappingPairsGPU();
+	virtual b3OpenCLArray<int>& getSmallAabbIndicesGPU();
+	virtual b3OpenCLArray<int>& getLargeAabbIndicesGPU();
+};
+
+#endif  //B3_GPU_ADAPTIVE_BROADPHASE_H
@@ -6,9 +6,57 @@
 #include "Bullet3Common/b3Vector3.h"
 #include "b3SapAabb.h"
 #include "Bullet3Common/shared/b3Int2.h"
+#include "Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h"
 #include "Bullet3Common/shared/b3Int4.h"
 #include "Bullet3OpenCL/ParallelPrimitives/b3OpenCLArray.h"
 
+///collision filter group (x) and mask (y) of the proxies, indexed by the user index the pair kernels report
+///a pair is only reported when the group of each proxy is in the mask of the other one
+struct b3GpuCollisionFilters
+{
+	b3AlignedObjectArray<b3Int2> m_filtersCPU;
+	b3OpenCLArray<b3Int2> m_filtersGPU;
+	b3DirtyElements m_dirtyFilters;
+
+	b3GpuCollisionFilters(cl_context ctx, cl_command_queue q)
+		: m_filtersGPU(ctx, q)
+	{
+	}
+
+	void setFilter(int userIndex, int collisionFilterGroup, int collisionFilterMask)
+	{
+		if (userIndex >= m_filtersCPU.size())
+		{
+			//proxies without a filter collide with everything
+			b3Int2 noFilter = b3MakeInt2(-1, -1);
+			int newSize = m_filtersCPU.size() * 2 > userIndex + 1 ? m_filtersCPU.size() * 2 : userIndex + 1;
+			m_dirtyFilters.markDirty(m_filtersCPU.size(), newSize - m_filtersCPU.size());
+			m_filtersCPU.resize(newSize, noFilter);
+		}
+		m_filtersCPU[userIndex].x = collisionFilterGroup;
+		m_filtersCPU[userIndex].y = collisionFilterMask;
+		m_dirtyFilters.markDirty(userIndex);
+	}
+
+	bool needsCollision(int userIndexA, int userIndexB) const
+	{
+		return b3NeedsCollision(m_filtersCPU[userIndexA], m_filtersCPU[userIndexB]);
+	}
+
+	///cheap when nothing changed, so it is called before each pair search
+	void writeChangedToGpu()
+	{
+		m_filtersGPU.copyDirtyFromHost(m_filtersCPU, m_dirtyFilters);
+	}
+
+	void reset()
+	{
+		m_filtersCPU.resize(0);
+		m_filtersGPU.resize(0);
+		m_dirtyFilters.clear();
+	}
+};
+
 class b3GpuBroadphaseInterface
 {
 public:
@@ -21,14 +69,32 @@ public:
 	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask) = 0;
 	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask) = 0;
 
+	///takes the proxy out of the overlap search, its slot stays allocated and can be reused by insertProxy
+	virtual void removeProxy(int /*proxyIndex*/)
+	{
+		b3Error("removeProxy is not supported by this broadphase\n");
+	}
+	///puts a proxy back into the slot of a removed proxy
+	virtual void insertProxy(int /*proxyIndex*/, const b3Vector3& /*aabbMin*/, const b3Vector3& /*aabbMax*/, int /*userPtr*/, bool /*largeProxy*/, int /*collisionFilterGroup*/, int /*collisionFilterMask*/)
+	{
+		b3Error("insertProxy is not supported by this broadphase\n");
+	}
+
 	virtual void calculateOverlappingPairs(int maxPairs) = 0;
 	virtual void calculateOverlappingPairsHost(int maxPairs) = 0;
 
 	//call writeAabbsToGpu after done making all changes (createProxy etc)
 	virtual void writeAabbsToGpu() = 0;
+	///only uploads the proxies changed since the last write, falls back to writeAabbsToGpu unless overridden
+	virtual void writeChangedAabbsToGpu()
+	{
+		writeAabbsToGpu();
+	}
 
 	virtual cl_mem getAabbBufferWS() = 0;
 	virtual int getNumOverlap() = 0;
+	///number of pairs the last calculateOverlappingPairs found, larger than getNumOverlap when maxPairs was exceeded
+	virtual int getNumOverlapRequired() = 0;
 	virtual cl_mem getOverlappingPairBuffer() = 0;
 
 	virtual b3OpenCLArray<b3SapAabb>& getAllAabbsGPU() = 0;
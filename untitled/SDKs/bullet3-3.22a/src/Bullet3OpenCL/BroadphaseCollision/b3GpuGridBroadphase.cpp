@@ -29,6 +29,8 @@ b3GpuGridBroadphase::b3GpuGridBroadphase(cl_context ctx, cl_device_id device, cl
 	  m_smallAabbsMappingGPU(ctx, q),
 	  m_largeAabbsMappingGPU(ctx, q),
 	  m_gpuPairs(ctx, q),
+	  m_numOverlapRequired(0),
+	  m_collisionFilters(ctx, q),
 
 	  m_hashGpu(ctx, q),
 
@@ -98,7 +100,8 @@ void b3GpuGridBroadphase::createProxy(const b3Vector3& aabbMin, const b3Vector3&
 	aabb.m_maxVec = aabbMax;
 	aabb.m_minIndices[3] = userPtr;
 	aabb.m_signedMaxIndices[3] = m_allAabbsCPU1.size();  //NOT userPtr;
-	m_smallAabbsMappingCPU.push_back(m_allAabbsCPU1.size());
+	addToMapping(m_allAabbsCPU1.size(), false);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_allAabbsCPU1.push_back(aabb);
 }
@@ -109,11 +112,72 @@ void b3GpuGridBroadphase::createLargeProxy(const b3Vector3& aabbMin, const b3Vec
 	aabb.m_maxVec = aabbMax;
 	aabb.m_minIndices[3] = userPtr;
 	aabb.m_signedMaxIndices[3] = m_allAabbsCPU1.size();  //NOT userPtr;
-	m_largeAabbsMappingCPU.push_back(m_allAabbsCPU1.size());
+	addToMapping(m_allAabbsCPU1.size(), true);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_allAabbsCPU1.push_back(aabb);
 }
 
+void b3GpuGridBroadphase::addToMapping(int proxyIndex, bool largeProxy)
+{
+	b3AlignedObjectArray<int>& mapping = largeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+	if (proxyIndex >= m_proxyMappingCPU.size())
+	{
+		m_proxyMappingCPU.resize(proxyIndex + 1);
+	}
+	m_proxyMappingCPU[proxyIndex].x = largeProxy ? 1 : 0;
+	m_proxyMappingCPU[proxyIndex].y = mapping.size();
+	mapping.push_back(proxyIndex);
+}
+
+void b3GpuGridBroadphase::removeProxy(int proxyIndex)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_allAabbsCPU1.size())
+	{
+		b3Warning("removeProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+	m_collisionFilters.setFilter(m_allAabbsCPU1[proxyIndex].m_minIndices[3], 0, 0);
+}
+
+void b3GpuGridBroadphase::insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_allAabbsCPU1.size())
+	{
+		b3Warning("insertProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+
+	b3SapAabb& aabb = m_allAabbsCPU1[proxyIndex];
+	aabb.m_minVec = aabbMin;
+	aabb.m_maxVec = aabbMax;
+	aabb.m_minIndices[3] = userPtr;
+	aabb.m_signedMaxIndices[3] = proxyIndex;
+
+	bool wasLargeProxy = m_proxyMappingCPU[proxyIndex].x == 1;
+	if (wasLargeProxy != largeProxy)
+	{
+		//move the last entry of the old mapping into the hole, the order of the mappings does not matter
+		b3AlignedObjectArray<int>& oldMapping = wasLargeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+		int position = m_proxyMappingCPU[proxyIndex].y;
+		int lastProxy = oldMapping[oldMapping.size() - 1];
+		oldMapping[position] = lastProxy;
+		m_proxyMappingCPU[lastProxy].y = position;
+		oldMapping.pop_back();
+		addToMapping(proxyIndex, largeProxy);
+	}
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
+void b3GpuGridBroadphase::setCellSize(float cellSize)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		m_paramsCPU.m_invCellSize[i] = 1.f / cellSize;
+	}
+	m_paramsGPU.copyFromHostPointer(&m_paramsCPU, 1);
+}
+
 void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 {
 	B3_PROFILE("b3GpuGridBroadphase::calculateOverlappingPairs");
@@ -134,6 +198,8 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 	}
 
 	int numSmallAabbs = m_smallAabbsMappingGPU.size();
+	m_numOverlapRequired = 0;
+	m_collisionFilters.writeChangedToGpu();
 
 	b3OpenCLArray<int> pairCount(m_context, m_queue);
 	pairCount.push_back(0);
@@ -149,7 +215,8 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 				b3BufferInfoCL(m_largeAabbsMappingGPU.getBufferCL()),
 				b3BufferInfoCL(m_smallAabbsMappingGPU.getBufferCL()),
 				b3BufferInfoCL(m_gpuPairs.getBufferCL()),
-				b3BufferInfoCL(pairCount.getBufferCL())};
+				b3BufferInfoCL(pairCount.getBufferCL()),
+				b3BufferInfoCL(m_collisionFilters.m_filtersGPU.getBufferCL(), true)};
 			b3LauncherCL launcher(m_queue, m_sap2Kernel, "m_sap2Kernel");
 			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 			launcher.setConst(numLargeAabbs);
@@ -160,6 +227,7 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 			launcher.launch2D(numLargeAabbs, numSmallAabbs, 4, 64);
 
 			int numPairs = pairCount.at(0);
+			m_numOverlapRequired = numPairs;
 
 			if (numPairs > maxPairs)
 			{
@@ -184,7 +252,10 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 			launch.launch1D(numSmallAabbs);
 		}
 
-		m_sorter->execute(m_hashGpu);
+		{
+			B3_GPU_STAGE("broadphaseSort");
+			m_sorter->execute(m_hashGpu);
+		}
 
 		int numCells = this->m_paramsCPU.m_gridSize[0] * this->m_paramsCPU.m_gridSize[1] * this->m_paramsCPU.m_gridSize[2];
 		m_cellStartGpu.resize(numCells);
@@ -225,11 +296,13 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 			//launch.setBuffer(0);
 			launch.setBuffer(pairCount.getBufferCL());
 			launch.setBuffer(m_gpuPairs.getBufferCL());
+			launch.setBuffer(m_collisionFilters.m_filtersGPU.getBufferCL());
 
 			launch.setConst(maxPairs);
 			launch.launch1D(numSmallAabbs);
 
 			int numPairs = pairCount.at(0);
+			m_numOverlapRequired = numPairs;
 			if (numPairs > maxPairs)
 			{
 				b3Error("Error running out of pairs: numPairs = %d, maxPairs = %d.\n", numPairs, maxPairs);
@@ -260,13 +333,15 @@ void b3GpuGridBroadphase::calculateOverlappingPairs(int maxPairs)
 void b3GpuGridBroadphase::calculateOverlappingPairsHost(int maxPairs)
 {
 	m_hostPairs.resize(0);
+	m_numOverlapRequired = 0;
 	m_allAabbsGPU1.copyToHost(m_allAabbsCPU1);
 	for (int i = 0; i < m_allAabbsCPU1.size(); i++)
 	{
 		for (int j = i + 1; j < m_allAabbsCPU1.size(); j++)
 		{
 			if (b3TestAabbAgainstAabb2(m_allAabbsCPU1[i].m_minVec, m_allAabbsCPU1[i].m_maxVec,
-									   m_allAabbsCPU1[j].m_minVec, m_allAabbsCPU1[j].m_maxVec))
+									   m_allAabbsCPU1[j].m_minVec, m_allAabbsCPU1[j].m_maxVec) &&
+				m_collisionFilters.needsCollision(m_allAabbsCPU1[i].m_minIndices[3], m_allAabbsCPU1[j].m_minIndices[3]))
 			{
 				b3Int4 pair;
 				int a = m_allAabbsCPU1[j].m_minIndices[3];
@@ -286,6 +361,7 @@ void b3GpuGridBroadphase::calculateOverlappingPairsHost(int maxPairs)
 				{
 					m_hostPairs.push_back(pair);
 				}
+				m_numOverlapRequired++;
 			}
 		}
 	}
@@ -309,6 +385,10 @@ int b3GpuGridBroadphase::getNumOverlap()
 {
 	return m_gpuPairs.size();
 }
+int b3GpuGridBroadphase::getNumOverlapRequired()
+{
+	return m_numOverlapRequired;
+}
 cl_mem b3GpuGridBroadphase::getOverlappingPairBuffer()
 {
 	return m_gpuPairs.getBufferCL();
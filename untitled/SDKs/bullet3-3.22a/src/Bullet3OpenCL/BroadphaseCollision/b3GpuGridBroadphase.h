@@ -36,8 +36,13 @@ protected:
 	b3OpenCLArray<int> m_largeAabbsMappingGPU;
 	b3AlignedObjectArray<int> m_largeAabbsMappingCPU;
 
+	///per slot of m_allAabbsCPU1: x is 1 for a large proxy and 0 for a small one, y is the position in that mapping
+	b3AlignedObjectArray<b3Int2> m_proxyMappingCPU;
+
 	b3AlignedObjectArray<b3Int4> m_hostPairs;
 	b3OpenCLArray<b3Int4> m_gpuPairs;
+	int m_numOverlapRequired;
+	b3GpuCollisionFilters m_collisionFilters;
 
 	b3OpenCLArray<b3SortData> m_hashGpu;
 	b3OpenCLArray<int> m_cellStartGpu;
@@ -47,6 +52,8 @@ protected:
 
 	class b3RadixSort32CL* m_sorter;
 
+	void addToMapping(int proxyIndex, bool largeProxy);
+
 public:
 	b3GpuGridBroadphase(cl_context ctx, cl_device_id device, cl_command_queue q);
 	virtual ~b3GpuGridBroadphase();
@@ -58,6 +65,16 @@ public:
 
 	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
 	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	///a removed proxy keeps its slot and mapping entry, it just collides with nothing until insertProxy reuses it
+	virtual void removeProxy(int proxyIndex);
+	virtual void insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask);
+
+	///the cell size should be at least the largest extent of the small proxies, larger ones need createLargeProxy
+	void setCellSize(float cellSize);
+	float getCellSize() const
+	{
+		return 1.f / m_paramsCPU.m_invCellSize[0];
+	}
 
 	virtual void calculateOverlappingPairs(int maxPairs);
 	virtual void calculateOverlappingPairsHost(int maxPairs);
@@ -67,6 +84,7 @@ public:
 
 	virtual cl_mem getAabbBufferWS();
 	virtual int getNumOverlap();
+	virtual int getNumOverlapRequired();
 	virtual cl_mem getOverlappingPairBuffer();
 
 	virtual b3OpenCLArray<b3SapAabb>& getAllAabbsGPU();
@@ -0,0 +1,355 @@
+#include "b3GpuMultiLevelGridBroadphase.h"
+#include "Bullet3Geometry/b3AabbUtil.h"
+#include "kernels/multiLevelGridBroadphaseKernels.h"
+
+#include "Bullet3OpenCL/Initialize/b3OpenCLUtils.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3BoundSearchCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3FillCL.h"
+
+#define B3_MULTI_LEVEL_GRID_BROADPHASE_PATH "src/Bullet3OpenCL/BroadphaseCollision/kernels/multiLevelGridBroadphase.cl"
+
+b3GpuMultiLevelGridBroadphase::b3GpuMultiLevelGridBroadphase(cl_context ctx, cl_device_id device, cl_command_queue q)
+	: m_context(ctx),
+	  m_device(device),
+	  m_queue(q),
+	  m_allAabbsGPU(ctx, q),
+	  m_smallAabbsMappingGPU(ctx, q),
+	  m_largeAabbsMappingGPU(ctx, q),
+	  m_overlappingPairs(ctx, q),
+	  m_pairCount(ctx, q),
+	  m_numOverlapRequired(0),
+	  m_collisionFilters(ctx, q),
+	  m_hashGPU(ctx, q),
+	  m_proxyLevelsGPU(ctx, q),
+	  m_overflowProxiesGPU(ctx, q),
+	  m_levelInfoGPU(ctx, q),
+	  m_cellStartGPU(ctx, q),
+	  m_cellEndGPU(ctx, q),
+	  m_baseCellSize(1.f),
+	  m_numLevels(8),
+	  m_gridDim(64)
+{
+	cl_int errNum = 0;
+
+	cl_program gridProg = b3OpenCLUtils::compileCLProgramFromString(m_context, m_device, multiLevelGridBroadphaseCL, &errNum, "", B3_MULTI_LEVEL_GRID_BROADPHASE_PATH);
+	b3Assert(errNum == CL_SUCCESS);
+
+	m_calcHashKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, multiLevelGridBroadphaseCL, "mlgCalcHashKernel", &errNum, gridProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_findPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, multiLevelGridBroadphaseCL, "mlgFindPairsKernel", &errNum, gridProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_overflowPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, multiLevelGridBroadphaseCL, "mlgOverflowPairsKernel", &errNum, gridProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_clearCellsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, multiLevelGridBroadphaseCL, "mlgClearCellsKernel", &errNum, gridProg);
+	b3Assert(errNum == CL_SUCCESS);
+
+	m_levelInfoGPU.resize(2);
+
+	m_sorter = new b3RadixSort32CL(m_context, m_device, m_queue);
+	m_boundSearch = new b3BoundSearchCL(m_context, m_device, m_queue, 0);
+	m_fill = new b3FillCL(m_context, m_device, m_queue);
+}
+
+b3GpuMultiLevelGridBroadphase::~b3GpuMultiLevelGridBroadphase()
+{
+	clReleaseKernel(m_calcHashKernel);
+	clReleaseKernel(m_findPairsKernel);
+	clReleaseKernel(m_overflowPairsKernel);
+	clReleaseKernel(m_clearCellsKernel);
+
+	delete m_sorter;
+	delete m_boundSearch;
+	delete m_fill;
+}
+
+void b3GpuMultiLevelGridBroadphase::setGridParameters(float baseCellSize, int numLevels, int gridDim)
+{
+	b3Assert(numLevels > 0 && numLevels < 32);
+	b3Assert(gridDim > 2 && (gridDim & (gridDim - 1)) == 0);
+	m_baseCellSize = baseCellSize;
+	m_numLevels = numLevels;
+	m_gridDim = gridDim;
+}
+
+void b3GpuMultiLevelGridBroadphase::addProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask, bool largeProxy)
+{
+	b3SapAabb aabb;
+	aabb.m_minVec = aabbMin;
+	aabb.m_maxVec = aabbMax;
+	aabb.m_minIndices[3] = userPtr;
+	aabb.m_signedMaxIndices[3] = m_allAabbsCPU.size();  //NOT userPtr;
+	addToMapping(m_allAabbsCPU.size(), largeProxy);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
+
+	m_allAabbsCPU.push_back(aabb);
+}
+
+void b3GpuMultiLevelGridBroadphase::addToMapping(int proxyIndex, bool largeProxy)
+{
+	b3AlignedObjectArray<int>& mapping = largeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+	if (proxyIndex >= m_proxyMappingCPU.size())
+	{
+		m_proxyMappingCPU.resize(proxyIndex + 1);
+	}
+	m_proxyMappingCPU[proxyIndex].x = largeProxy ? 1 : 0;
+	m_proxyMappingCPU[proxyIndex].y = mapping.size();
+	mapping.push_back(proxyIndex);
+}
+
+void b3GpuMultiLevelGridBroadphase::createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
+{
+	addProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask, false);
+}
+
+void b3GpuMultiLevelGridBroadphase::createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
+{
+	addProxy(aabbMin, aabbMax, userPtr, collisionFilterGroup, collisionFilterMask, true);
+}
+
+void b3GpuMultiLevelGridBroadphase::removeProxy(int proxyIndex)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_allAabbsCPU.size())
+	{
+		b3Warning("removeProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+	m_collisionFilters.setFilter(m_allAabbsCPU[proxyIndex].m_minIndices[3], 0, 0);
+}
+
+void b3GpuMultiLevelGridBroadphase::insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_allAabbsCPU.size())
+	{
+		b3Warning("insertProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+
+	b3SapAabb& aabb = m_allAabbsCPU[proxyIndex];
+	aabb.m_minVec = aabbMin;
+	aabb.m_maxVec = aabbMax;
+	aabb.m_minIndices[3] = userPtr;
+	aabb.m_signedMaxIndices[3] = proxyIndex;
+
+	//the grid does not care, but the small and large indices are also used for raycasting
+	bool wasLargeProxy = m_proxyMappingCPU[proxyIndex].x == 1;
+	if (wasLargeProxy != largeProxy)
+	{
+		//move the last entry of the old mapping into the hole, the order of the mappings does not matter
+		b3AlignedObjectArray<int>& oldMapping = wasLargeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+		int position = m_proxyMappingCPU[proxyIndex].y;
+		int lastProxy = oldMapping[oldMapping.size() - 1];
+		oldMapping[position] = lastProxy;
+		m_proxyMappingCPU[lastProxy].y = position;
+		oldMapping.pop_back();
+		addToMapping(proxyIndex, largeProxy);
+	}
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
+void b3GpuMultiLevelGridBroadphase::calculateOverlappingPairs(int maxPairs)
+{
+	B3_PROFILE("b3GpuMultiLevelGridBroadphase::calculateOverlappingPairs");
+
+	int numProxies = m_allAabbsGPU.size();
+	m_numOverlapRequired = 0;
+	m_collisionFilters.writeChangedToGpu();
+
+	if (numProxies == 0)
+	{
+		m_overlappingPairs.resize(0);
+		return;
+	}
+
+	//one extra cell behind all levels holds the overflow proxies
+	int numCells = m_numLevels * m_gridDim * m_gridDim * m_gridDim + 1;
+	if ((int)m_cellStartGPU.size() != numCells)
+	{
+		//afterwards only the cells used by a frame are cleared again
+		m_cellStartGPU.resize(numCells, false);
+		m_cellEndGPU.resize(numCells, false);
+		m_fill->execute(m_cellStartGPU, 0, numCells);
+		m_fill->execute(m_cellEndGPU, 0, numCells);
+	}
+
+	m_hashGPU.resize(numProxies);
+	m_proxyLevelsGPU.resize(numProxies);
+	m_overflowProxiesGPU.resize(numProxies);
+
+	int levelInfo[2] = {0, 0};
+	m_levelInfoGPU.copyFromHostPointer(levelInfo, 2);
+	{
+		B3_PROFILE("mlgCalcHashKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_hashGPU.getBufferCL()),
+			b3BufferInfoCL(m_proxyLevelsGPU.getBufferCL()),
+			b3BufferInfoCL(m_levelInfoGPU.getBufferCL()),
+			b3BufferInfoCL(m_overflowProxiesGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_calcHashKernel, "m_calcHashKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numProxies);
+		launcher.setConst(m_baseCellSize);
+		launcher.setConst(m_numLevels);
+		launcher.setConst(m_gridDim);
+		launcher.launch1D(numProxies);
+	}
+	m_levelInfoGPU.copyToHostPointer(levelInfo, 2);
+	int numOverflowProxies = levelInfo[0];
+	int levelMask = levelInfo[1];
+
+	{
+		B3_PROFILE("sort and find cell ranges");
+		B3_GPU_STAGE("broadphaseSort");
+		int sortBits = 4;
+		while ((1 << sortBits) < numCells)
+		{
+			sortBits += 4;
+		}
+		m_sorter->execute(m_hashGPU, sortBits);
+		m_boundSearch->execute(m_hashGPU, numProxies, m_cellStartGPU, numCells, b3BoundSearchCL::BOUND_LOWER);
+		m_boundSearch->execute(m_hashGPU, numProxies, m_cellEndGPU, numCells, b3BoundSearchCL::BOUND_UPPER);
+	}
+
+	m_overlappingPairs.resize(maxPairs);
+	m_pairCount.resize(0);
+	m_pairCount.push_back(0);
+
+	{
+		B3_PROFILE("mlgFindPairsKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_hashGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_proxyLevelsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_cellStartGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_cellEndGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_overlappingPairs.getBufferCL()),
+			b3BufferInfoCL(m_pairCount.getBufferCL()),
+			b3BufferInfoCL(m_collisionFilters.m_filtersGPU.getBufferCL(), true)};
+		b3LauncherCL launcher(m_queue, m_findPairsKernel, "m_findPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numProxies);
+		launcher.setConst(m_baseCellSize);
+		launcher.setConst(m_numLevels);
+		launcher.setConst(m_gridDim);
+		launcher.setConst(levelMask);
+		launcher.setConst(maxPairs);
+		launcher.launch1D(numProxies);
+	}
+
+	if (numOverflowProxies)
+	{
+		B3_PROFILE("mlgOverflowPairsKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_proxyLevelsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_overflowProxiesGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_overlappingPairs.getBufferCL()),
+			b3BufferInfoCL(m_pairCount.getBufferCL()),
+			b3BufferInfoCL(m_collisionFilters.m_filtersGPU.getBufferCL(), true)};
+		b3LauncherCL launcher(m_queue, m_overflowPairsKernel, "m_overflowPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numOverflowProxies);
+		launcher.setConst(numProxies);
+		launcher.setConst(m_numLevels);
+		launcher.setConst(maxPairs);
+		//@todo: use actual maximum work item sizes of the device instead of hardcoded values
+		launcher.launch2D(numOverflowProxies, numProxies, 4, 64);
+	}
+
+	{
+		B3_PROFILE("mlgClearCellsKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_hashGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_cellStartGPU.getBufferCL()),
+			b3BufferInfoCL(m_cellEndGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_clearCellsKernel, "m_clearCellsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numProxies);
+		launcher.launch1D(numProxies);
+	}
+
+	int numPairs = m_pairCount.at(0);
+	m_numOverlapRequired = numPairs;
+	if (numPairs > maxPairs)
+	{
+		b3Error("Error running out of pairs: numPairs = %d, maxPairs = %d.\n", numPairs, maxPairs);
+		numPairs = maxPairs;
+	}
+	m_overlappingPairs.resize(numPairs);
+}
+
+void b3GpuMultiLevelGridBroadphase::calculateOverlappingPairsHost(int maxPairs)
+{
+	b3AlignedObjectArray<b3Int4> hostPairs;
+	m_numOverlapRequired = 0;
+	m_allAabbsGPU.copyToHost(m_allAabbsCPU);
+	for (int i = 0; i < m_allAabbsCPU.size(); i++)
+	{
+		for (int j = i + 1; j < m_allAabbsCPU.size(); j++)
+		{
+			int a = m_allAabbsCPU[i].m_minIndices[3];
+			int b = m_allAabbsCPU[j].m_minIndices[3];
+			if (b3TestAabbAgainstAabb2(m_allAabbsCPU[i].m_minVec, m_allAabbsCPU[i].m_maxVec,
+									   m_allAabbsCPU[j].m_minVec, m_allAabbsCPU[j].m_maxVec) &&
+				m_collisionFilters.needsCollision(a, b))
+			{
+				if (hostPairs.size() < maxPairs)
+				{
+					hostPairs.push_back(b3MakeInt4(a, b, -1, -1));
+				}
+				m_numOverlapRequired++;
+			}
+		}
+	}
+
+	m_overlappingPairs.copyFromHost(hostPairs);
+}
+
+//call writeAabbsToGpu after done making all changes (createProxy etc)
+void b3GpuMultiLevelGridBroadphase::writeAabbsToGpu()
+{
+	m_allAabbsGPU.copyFromHost(m_allAabbsCPU);
+	m_smallAabbsMappingGPU.copyFromHost(m_smallAabbsMappingCPU);
+	m_largeAabbsMappingGPU.copyFromHost(m_largeAabbsMappingCPU);
+}
+
+cl_mem b3GpuMultiLevelGridBroadphase::getAabbBufferWS()
+{
+	return m_allAabbsGPU.getBufferCL();
+}
+int b3GpuMultiLevelGridBroadphase::getNumOverlap()
+{
+	return m_overlappingPairs.size();
+}
+int b3GpuMultiLevelGridBroadphase::getNumOverlapRequired()
+{
+	return m_numOverlapRequired;
+}
+cl_mem b3GpuMultiLevelGridBroadphase::getOverlappingPairBuffer()
+{
+	return m_overlappingPairs.getBufferCL();
+}
+
+b3OpenCLArray<b3SapAabb>& b3GpuMultiLevelGridBroadphase::getAllAabbsGPU()
+{
+	return m_allAabbsGPU;
+}
+
+b3AlignedObjectArray<b3SapAabb>& b3GpuMultiLevelGridBroadphase::getAllAabbsCPU()
+{
+	return m_allAabbsCPU;
+}
+
+b3OpenCLArray<b3Int4>& b3GpuMultiLevelGridBroadphase::getOverlappingPairsGPU()
+{
+	return m_overlappingPairs;
+}
+b3OpenCLArray<int>& b3GpuMultiLevelGridBroadphase::getSmallAabbIndicesGPU()
+{
+	return m_smallAabbsMappingGPU;
+}
+b3OpenCLArray<int>& b3GpuMultiLevelGridBroadphase::getLargeAabbIndicesGPU()
+{
+	return m_largeAabbsMappingGPU;
+}
@@ -0,0 +1,104 @@
+#ifndef B3_GPU_MULTI_LEVEL_GRID_BROADPHASE_H
+#define B3_GPU_MULTI_LEVEL_GRID_BROADPHASE_H
+
+#include "b3GpuBroadphaseInterface.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3RadixSort32CL.h"
+
+///hierarchical hashed grid for scenes with mixed object sizes
+///level l has cells of baseCellSize*2^l, and each proxy goes into the finest level whose cells fit it, so there is no
+///separate brute force pass for large proxies. Proxies larger than the coarsest cells are tested against all others.
+class b3GpuMultiLevelGridBroadphase : public b3GpuBroadphaseInterface
+{
+protected:
+	cl_context m_context;
+	cl_device_id m_device;
+	cl_command_queue m_queue;
+
+	cl_kernel m_calcHashKernel;
+	cl_kernel m_findPairsKernel;
+	cl_kernel m_overflowPairsKernel;
+	cl_kernel m_clearCellsKernel;
+
+	b3OpenCLArray<b3SapAabb> m_allAabbsGPU;
+	b3AlignedObjectArray<b3SapAabb> m_allAabbsCPU;
+
+	b3OpenCLArray<int> m_smallAabbsMappingGPU;
+	b3AlignedObjectArray<int> m_smallAabbsMappingCPU;
+
+	b3OpenCLArray<int> m_largeAabbsMappingGPU;
+	b3AlignedObjectArray<int> m_largeAabbsMappingCPU;
+
+	///per slot of m_allAabbsCPU: x is 1 for a large proxy and 0 for a small one, y is the position in that mapping
+	b3AlignedObjectArray<b3Int2> m_proxyMappingCPU;
+
+	b3OpenCLArray<b3Int4> m_overlappingPairs;
+	b3OpenCLArray<int> m_pairCount;
+	int m_numOverlapRequired;
+	b3GpuCollisionFilters m_collisionFilters;
+
+	///all proxies go through the same grid, whether they were created small or large
+	b3OpenCLArray<b3SortData> m_hashGPU;
+	b3OpenCLArray<int> m_proxyLevelsGPU;
+	b3OpenCLArray<int> m_overflowProxiesGPU;
+	b3OpenCLArray<int> m_levelInfoGPU;
+	b3OpenCLArray<unsigned int> m_cellStartGPU;
+	b3OpenCLArray<unsigned int> m_cellEndGPU;
+
+	float m_baseCellSize;
+	int m_numLevels;
+	int m_gridDim;
+
+	class b3RadixSort32CL* m_sorter;
+	class b3BoundSearchCL* m_boundSearch;
+	class b3FillCL* m_fill;
+
+	void addProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask, bool largeProxy);
+	void addToMapping(int proxyIndex, bool largeProxy);
+
+public:
+	b3GpuMultiLevelGridBroadphase(cl_context ctx, cl_device_id device, cl_command_queue q);
+	virtual ~b3GpuMultiLevelGridBroadphase();
+
+	static b3GpuBroadphaseInterface* CreateFunc(cl_context ctx, cl_device_id device, cl_command_queue q)
+	{
+		return new b3GpuMultiLevelGridBroadphase(ctx, device, q);
+	}
+
+	///baseCellSize should be about the size of the smallest objects, numLevels doubles the cell size each level (at most 31)
+	///gridDim cells per axis (a power of two) are hashed per level, beyond that the cells wrap around
+	void setGridParameters(float baseCellSize, int numLevels, int gridDim = 64);
+	float getBaseCellSize() const
+	{
+		return m_baseCellSize;
+	}
+	int getNumLevels() const
+	{
+		return m_numLevels;
+	}
+
+	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	///a removed proxy keeps its slot, it just collides with nothing until insertProxy reuses it
+	virtual void removeProxy(int proxyIndex);
+	virtual void insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask);
+
+	virtual void calculateOverlappingPairs(int maxPairs);
+	virtual void calculateOverlappingPairsHost(int maxPairs);
+
+	//call writeAabbsToGpu after done making all changes (createProxy etc)
+	virtual void writeAabbsToGpu();
+
+	virtual cl_mem getAabbBufferWS();
+	virtual int getNumOverlap();
+	virtual int getNumOverlapRequired();
+	virtual cl_mem getOverlappingPairBuffer();
+
+	virtual b3OpenCLArray<b3SapAabb>& getAllAabbsGPU();
+	virtual b3AlignedObjectArray<b3SapAabb>& getAllAabbsCPU();
+
+	virtual b3OpenCLArray<b3Int4>& getOverlappingPairsGPU();
+	virtual b3OpenCLArray<int>& getSmallAabbIndicesGPU();
+	virtual b3OpenCLArray<int>& getLargeAabbIndicesGPU();
+};
+
+#endif  //B3_GPU_MULTI_LEVEL_GRID_BROADPHASE_H
@@ -27,6 +27,7 @@ b3GpuParallelLinearBvh::b3GpuParallelLinearBvh(cl_context context, cl_device_id
 																												  m_internalNodeLeafIndexRanges(context, queue),
 																												  m_internalNodeChildNodes(context, queue),
 																												  m_internalNodeParentNodes(context, queue),
+																												  m_internalNodeSurfaceAreas(context, queue),
 
 																												  m_commonPrefixes(context, queue),
 																												  m_commonPrefixLengths(context, queue),
@@ -37,7 +38,19 @@ b3GpuParallelLinearBvh::b3GpuParallelLinearBvh(cl_context context, cl_device_id
 																												  m_mergedAabb(context, queue),
 																												  m_leafNodeAabbs(context, queue),
 
-																												  m_largeAabbs(context, queue)
+																												  m_largeAabbs(context, queue),
+
+																												  m_refitEnabled(false),
+																												  m_topologyValid(false),
+																												  m_numTreeLeaves(0),
+																												  m_maxDistanceFromRootCpu(-1),
+																												  m_rootNodeIndexCpu(0),
+																												  m_rebuildThreshold(1.5f),
+																												  m_qualityCheckInterval(4),
+																												  m_numRefitsSinceCheck(0),
+																												  m_builtTreeCost(0.f),
+																												  m_treeCost(0.f),
+																												  m_lastBuildWasRefit(false)
 {
 	m_rootNodeIndex.resize(1);
 	m_maxDistanceFromRoot.resize(1);
@@ -73,6 +86,11 @@ b3GpuParallelLinearBvh::b3GpuParallelLinearBvh(cl_context context, cl_device_id
 	m_findLeafIndexRangesKernel = b3OpenCLUtils::compileCLKernelFromString(context, device, kernelSource, "findLeafIndexRanges", &error, m_parallelLinearBvhProgram, additionalMacros);
 	b3Assert(m_findLeafIndexRangesKernel);
 
+	m_computeInternalNodeSurfaceAreasKernel = b3OpenCLUtils::compileCLKernelFromString(context, device, kernelSource, "computeInternalNodeSurfaceAreas", &error, m_parallelLinearBvhProgram, additionalMacros);
+	b3Assert(m_computeInternalNodeSurfaceAreasKernel);
+	m_sumSurfaceAreasKernel = b3OpenCLUtils::compileCLKernelFromString(context, device, kernelSource, "sumSurfaceAreas", &error, m_parallelLinearBvhProgram, additionalMacros);
+	b3Assert(m_sumSurfaceAreasKernel);
+
 	m_plbvhCalculateOverlappingPairsKernel = b3OpenCLUtils::compileCLKernelFromString(context, device, kernelSource, "plbvhCalculateOverlappingPairs", &error, m_parallelLinearBvhProgram, additionalMacros);
 	b3Assert(m_plbvhCalculateOverlappingPairsKernel);
 	m_plbvhRayTraverseKernel = b3OpenCLUtils::compileCLKernelFromString(context, device, kernelSource, "plbvhRayTraverse", &error, m_parallelLinearBvhProgram, additionalMacros);
@@ -97,6 +115,9 @@ b3GpuParallelLinearBvh::~b3GpuParallelLinearBvh()
 
 	clReleaseKernel(m_findLeafIndexRangesKernel);
 
+	clReleaseKernel(m_computeInternalNodeSurfaceAreasKernel);
+	clReleaseKernel(m_sumSurfaceAreasKernel);
+
 	clReleaseKernel(m_plbvhCalculateOverlappingPairsKernel);
 	clReleaseKernel(m_plbvhRayTraverseKernel);
 	clReleaseKernel(m_plbvhLargeAabbAabbTestKernel);
@@ -163,6 +184,9 @@ void b3GpuParallelLinearBvh::build(const b3OpenCLArray<b3SapAabb>& worldSpaceAab
 
 	if (numLeaves < 2)
 	{
+		m_topologyValid = false;
+		m_lastBuildWasRefit = false;
+
 		//Number of leaf nodes is checked in calculateOverlappingPairs() and testRaysAgainstBvhAabbs(),
 		//so it does not matter if numLeaves == 0 and rootNodeIndex == -1
 		int rootNodeIndex = numLeaves - 1;
@@ -184,6 +208,27 @@ void b3GpuParallelLinearBvh::build(const b3OpenCLArray<b3SapAabb>& worldSpaceAab
 		return;
 	}
 
+	//For coherent motion the order of the leaves hardly changes between frames,
+	//so the previous tree is kept and only its AABBs are updated
+	if (m_refitEnabled && m_topologyValid && numLeaves == m_numTreeLeaves)
+	{
+		B3_PROFILE("Refit BVH");
+
+		refitInternalNodeAabbs();
+		m_lastBuildWasRefit = true;
+
+		if (++m_numRefitsSinceCheck < m_qualityCheckInterval)
+			return;
+
+		m_numRefitsSinceCheck = 0;
+		m_treeCost = calculateTreeCost();
+		if (m_treeCost <= m_builtTreeCost * m_rebuildThreshold)
+			return;
+
+		//The nodes overlap too much after moving apart, so the tree is rebuilt from the separated AABBs
+	}
+	m_lastBuildWasRefit = false;
+
 	//
 	{
 		m_internalNodeAabbs.resize(numInternalNodes);
@@ -250,6 +295,7 @@ void b3GpuParallelLinearBvh::build(const b3OpenCLArray<b3SapAabb>& worldSpaceAab
 	//
 	{
 		B3_PROFILE("Sort leaves by morton codes");
+		B3_GPU_STAGE("broadphaseSort");
 
 		m_radixSorter.execute(m_mortonCodesAndAabbIndicies);
 		clFinish(m_queue);
@@ -281,9 +327,30 @@ void b3GpuParallelLinearBvh::build(const b3OpenCLArray<b3SapAabb>& worldSpaceAab
 		launcher.launch1D(numInternalNodes);
 		clFinish(m_queue);
 	}
+
+	if (m_refitEnabled)
+	{
+		int rootNodeIndex = 0;
+		m_rootNodeIndex.copyToHostPointer(&rootNodeIndex, 1);
+		m_rootNodeIndexCpu = rootNodeIndex & 0x7FFFFFFF;  //Remove the internal node marker
+
+		m_numTreeLeaves = numLeaves;
+		m_topologyValid = true;
+		m_numRefitsSinceCheck = 0;
+		m_builtTreeCost = calculateTreeCost();
+		m_treeCost = m_builtTreeCost;
+	}
 }
 
-void b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& out_overlappingPairs)
+void b3GpuParallelLinearBvh::setRefitEnabled(bool enable, float rebuildThreshold, int qualityCheckInterval)
+{
+	m_refitEnabled = enable;
+	m_rebuildThreshold = rebuildThreshold;
+	m_qualityCheckInterval = b3Max(qualityCheckInterval, 1);
+	m_topologyValid = false;
+}
+
+int b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& out_overlappingPairs, const b3OpenCLArray<b3Int2>& collisionFilters)
 {
 	int maxPairs = out_overlappingPairs.size();
 	b3OpenCLArray<int>& numPairsGpu = m_temp;
@@ -309,7 +376,8 @@ void b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& ou
 				b3BufferInfoCL(m_mortonCodesAndAabbIndicies.getBufferCL()),
 
 				b3BufferInfoCL(numPairsGpu.getBufferCL()),
-				b3BufferInfoCL(out_overlappingPairs.getBufferCL())};
+				b3BufferInfoCL(out_overlappingPairs.getBufferCL()),
+				b3BufferInfoCL(collisionFilters.getBufferCL(), true)};
 
 		b3LauncherCL launcher(m_queue, m_plbvhCalculateOverlappingPairsKernel, "m_plbvhCalculateOverlappingPairsKernel");
 		launcher.setBuffers(bufferInfo, sizeof(bufferInfo) / sizeof(b3BufferInfoCL));
@@ -333,7 +401,8 @@ void b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& ou
 				b3BufferInfoCL(m_largeAabbs.getBufferCL()),
 
 				b3BufferInfoCL(numPairsGpu.getBufferCL()),
-				b3BufferInfoCL(out_overlappingPairs.getBufferCL())};
+				b3BufferInfoCL(out_overlappingPairs.getBufferCL()),
+				b3BufferInfoCL(collisionFilters.getBufferCL(), true)};
 
 		b3LauncherCL launcher(m_queue, m_plbvhLargeAabbAabbTestKernel, "m_plbvhLargeAabbAabbTestKernel");
 		launcher.setBuffers(bufferInfo, sizeof(bufferInfo) / sizeof(b3BufferInfoCL));
@@ -348,6 +417,7 @@ void b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& ou
 	//
 	int numPairs = -1;
 	numPairsGpu.copyToHostPointer(&numPairs, 1);
+	int numPairsRequired = numPairs;
 	if (numPairs > maxPairs)
 	{
 		b3Error("Error running out of pairs: numPairs = %d, maxPairs = %d.\n", numPairs, maxPairs);
@@ -356,6 +426,7 @@ void b3GpuParallelLinearBvh::calculateOverlappingPairs(b3OpenCLArray<b3Int4>& ou
 	}
 
 	out_overlappingPairs.resize(numPairs);
+	return numPairsRequired;
 }
 
 void b3GpuParallelLinearBvh::testRaysAgainstBvhAabbs(const b3OpenCLArray<b3RayInfo>& rays,
@@ -517,19 +588,26 @@ void b3GpuParallelLinearBvh::constructBinaryRadixTree()
 		clFinish(m_queue);
 	}
 
+	{
+		B3_PROFILE("copy maxDistanceFromRoot to CPU");
+		m_maxDistanceFromRoot.copyToHostPointer(&m_maxDistanceFromRootCpu, 1);
+		clFinish(m_queue);
+	}
+
+	refitInternalNodeAabbs();
+}
+
+void b3GpuParallelLinearBvh::refitInternalNodeAabbs()
+{
+	int numInternalNodes = m_leafNodeAabbs.size() - 1;
+	int maxDistanceFromRoot = m_maxDistanceFromRootCpu;
+
 	//Starting from the internal nodes nearest to the leaf nodes, recursively move up
 	//the tree towards the root to set the AABBs of each internal node; each internal node
 	//checks its children and merges their AABBs
 	{
 		B3_PROFILE("m_buildBinaryRadixTreeAabbsRecursiveKernel");
 
-		int maxDistanceFromRoot = -1;
-		{
-			B3_PROFILE("copy maxDistanceFromRoot to CPU");
-			m_maxDistanceFromRoot.copyToHostPointer(&maxDistanceFromRoot, 1);
-			clFinish(m_queue);
-		}
-
 		for (int distanceFromRoot = maxDistanceFromRoot; distanceFromRoot >= 0; --distanceFromRoot)
 		{
 			b3BufferInfoCL bufferInfo[] =
@@ -555,3 +633,50 @@ void b3GpuParallelLinearBvh::constructBinaryRadixTree()
 		clFinish(m_queue);
 	}
 }
+
+float b3GpuParallelLinearBvh::calculateTreeCost()
+{
+	B3_PROFILE("b3GpuParallelLinearBvh::calculateTreeCost()");
+
+	int numInternalNodes = m_leafNodeAabbs.size() - 1;
+	if (numInternalNodes < 1)
+		return 0.f;
+
+	m_internalNodeSurfaceAreas.resize(numInternalNodes);
+
+	{
+		b3BufferInfoCL bufferInfo[] =
+			{
+				b3BufferInfoCL(m_internalNodeAabbs.getBufferCL()),
+				b3BufferInfoCL(m_internalNodeSurfaceAreas.getBufferCL())};
+
+		b3LauncherCL launcher(m_queue, m_computeInternalNodeSurfaceAreasKernel, "m_computeInternalNodeSurfaceAreasKernel");
+		launcher.setBuffers(bufferInfo, sizeof(bufferInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numInternalNodes);
+
+		launcher.launch1D(numInternalNodes);
+	}
+
+	for (int numAreasNeedingSum = numInternalNodes; numAreasNeedingSum >= 2;
+		 numAreasNeedingSum = numAreasNeedingSum / 2 + numAreasNeedingSum % 2)
+	{
+		b3BufferInfoCL bufferInfo[] =
+			{
+				b3BufferInfoCL(m_internalNodeSurfaceAreas.getBufferCL())  //Resulting sum is stored in m_internalNodeSurfaceAreas[0]
+			};
+
+		b3LauncherCL launcher(m_queue, m_sumSurfaceAreasKernel, "m_sumSurfaceAreasKernel");
+		launcher.setBuffers(bufferInfo, sizeof(bufferInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numAreasNeedingSum);
+
+		launcher.launch1D(numAreasNeedingSum);
+	}
+
+	float sumOfAreas = m_internalNodeSurfaceAreas.at(0);
+	b3SapAabb rootAabb = m_internalNodeAabbs.at(m_rootNodeIndexCpu);
+
+	b3Vector3 extent = rootAabb.m_maxVec - rootAabb.m_minVec;
+	float rootArea = extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+
+	return (rootArea > 0.f) ? sumOfAreas / rootArea : 0.f;
+}
@@ -46,6 +46,11 @@ subject to the following restrictions:
 ///The BVH implementation here shares many concepts with [Karras 2012], but a different method is used for constructing the tree.
 ///Instead of searching for the child nodes of each internal node, we search for the parent node of each node.
 ///Additionally, a non-atomic traversal that starts from the leaf nodes and moves towards the root node is used to set the AABBs.
+///@par
+///With refitting enabled, the tree topology is kept while the set of leaves stays the same, and build() only
+///recomputes the internal node AABBs. Since the leaves are not resorted, the tree degrades as the AABBs move;
+///the SAH cost of the tree is measured every few refits, and the tree is rebuilt once the cost exceeds the cost
+///after the last full build by the rebuild threshold.
 class b3GpuParallelLinearBvh
 {
 	cl_command_queue m_queue;
@@ -65,6 +70,10 @@ class b3GpuParallelLinearBvh
 
 	cl_kernel m_findLeafIndexRangesKernel;
 
+	//Tree quality kernels
+	cl_kernel m_computeInternalNodeSurfaceAreasKernel;
+	cl_kernel m_sumSurfaceAreasKernel;
+
 	//Traversal kernels
 	cl_kernel m_plbvhCalculateOverlappingPairsKernel;
 	cl_kernel m_plbvhRayTraverseKernel;
@@ -83,6 +92,7 @@ class b3GpuParallelLinearBvh
 	b3OpenCLArray<b3Int2> m_internalNodeLeafIndexRanges;  //x == min leaf index, y == max leaf index
 	b3OpenCLArray<b3Int2> m_internalNodeChildNodes;       //x == left child, y == right child; msb(0x80000000) is set to indicate internal node
 	b3OpenCLArray<int> m_internalNodeParentNodes;         //For parent node index, msb(0x80000000) is not set since it is always internal
+	b3OpenCLArray<float> m_internalNodeSurfaceAreas;      //Used to compute the SAH cost of the tree
 
 	//1 element per internal node; for binary radix tree construction
 	b3OpenCLArray<b3Int64> m_commonPrefixes;
@@ -98,18 +108,44 @@ class b3GpuParallelLinearBvh
 	//1 element per large AABB, which is not stored in the BVH
 	b3OpenCLArray<b3SapAabb> m_largeAabbs;
 
+	//Refit state; the topology is valid for m_numTreeLeaves leaves until invalidateTopology() is called
+	bool m_refitEnabled;
+	bool m_topologyValid;
+	int m_numTreeLeaves;
+	int m_maxDistanceFromRootCpu;
+	int m_rootNodeIndexCpu;
+	float m_rebuildThreshold;
+	int m_qualityCheckInterval;
+	int m_numRefitsSinceCheck;
+	float m_builtTreeCost;  //SAH cost right after the last full build
+	float m_treeCost;
+	bool m_lastBuildWasRefit;
+
 public:
 	b3GpuParallelLinearBvh(cl_context context, cl_device_id device, cl_command_queue queue);
 	virtual ~b3GpuParallelLinearBvh();
 
 	///Must be called before any other function
+	///With refitting enabled, the tree of the previous call is refitted if it has the same number of small AABBs
 	void build(const b3OpenCLArray<b3SapAabb>& worldSpaceAabbs, const b3OpenCLArray<int>& smallAabbIndices,
 			   const b3OpenCLArray<int>& largeAabbIndices);
 
+	///@param rebuildThreshold The tree is rebuilt when its SAH cost exceeds the cost after the last build by this factor.
+	///@param qualityCheckInterval Number of refits between two measurements of the SAH cost.
+	void setRefitEnabled(bool enable, float rebuildThreshold = 1.5f, int qualityCheckInterval = 4);
+	bool isRefitEnabled() const { return m_refitEnabled; }
+	///Must be called whenever the small AABB indices change, since build() can not detect a changed set of leaves with the same size
+	void invalidateTopology() { m_topologyValid = false; }
+	bool lastBuildWasRefit() const { return m_lastBuildWasRefit; }
+	///SAH cost of the tree at the last full build or quality check; the sum of the internal node areas relative to the root area
+	float getTreeCost() const { return m_treeCost; }
+
 	///calculateOverlappingPairs() uses the worldSpaceAabbs parameter of b3GpuParallelLinearBvh::build() as the query AABBs.
 	///@param out_overlappingPairs The size() of this array is used to determine the max number of pairs.
 	///If the number of overlapping pairs is < out_overlappingPairs.size(), out_overlappingPairs is resized.
-	void calculateOverlappingPairs(b3OpenCLArray<b3Int4>& out_overlappingPairs);
+	///@param collisionFilters Group (x) and mask (y) per rigid body index, pairs whose groups are not in each other's mask are skipped.
+	///@return The number of detected pairs; this value may be greater than out_overlappingPairs.size() if it was not large enough.
+	int calculateOverlappingPairs(b3OpenCLArray<b3Int4>& out_overlappingPairs, const b3OpenCLArray<b3Int2>& collisionFilters);
 
 	///@param out_numRigidRayPairs Array of length 1; contains the number of detected ray-rigid AABB intersections;
 	///this value may be greater than out_rayRigidPairs.size() if out_rayRigidPairs is not large enough.
@@ -120,6 +156,8 @@ public:
 
 private:
 	void constructBinaryRadixTree();
+	void refitInternalNodeAabbs();
+	float calculateTreeCost();
 };
 
 #endif
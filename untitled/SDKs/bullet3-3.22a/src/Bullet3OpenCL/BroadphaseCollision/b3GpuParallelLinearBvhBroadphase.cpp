@@ -16,11 +16,15 @@ subject to the following restrictions:
 b3GpuParallelLinearBvhBroadphase::b3GpuParallelLinearBvhBroadphase(cl_context context, cl_device_id device, cl_command_queue queue) : m_plbvh(context, device, queue),
 
 																																	  m_overlappingPairsGpu(context, queue),
+																																	  m_numOverlapRequired(0),
+																																	  m_collisionFilters(context, queue),
 
 																																	  m_aabbsGpu(context, queue),
 																																	  m_smallAabbsMappingGpu(context, queue),
 																																	  m_largeAabbsMappingGpu(context, queue)
 {
+	//The mappings only change through this class, so it can tell the tree when to rebuild
+	m_plbvh.setRefitEnabled(true);
 }
 
 void b3GpuParallelLinearBvhBroadphase::createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
@@ -35,6 +39,7 @@ void b3GpuParallelLinearBvhBroadphase::createProxy(const b3Vector3& aabbMin, con
 	aabb.m_signedMaxIndices[3] = newAabbIndex;
 
 	m_smallAabbsMappingCpu.push_back(newAabbIndex);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_aabbsCpu.push_back(aabb);
 }
@@ -50,18 +55,55 @@ void b3GpuParallelLinearBvhBroadphase::createLargeProxy(const b3Vector3& aabbMin
 	aabb.m_signedMaxIndices[3] = newAabbIndex;
 
 	m_largeAabbsMappingCpu.push_back(newAabbIndex);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_aabbsCpu.push_back(aabb);
 }
 
+void b3GpuParallelLinearBvhBroadphase::removeProxy(int proxyIndex)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_aabbsCpu.size())
+	{
+		b3Warning("removeProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+	m_collisionFilters.setFilter(m_aabbsCpu[proxyIndex].m_minIndices[3], 0, 0);
+}
+
+void b3GpuParallelLinearBvhBroadphase::insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_aabbsCpu.size())
+	{
+		b3Warning("insertProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+
+	b3SapAabb& aabb = m_aabbsCpu[proxyIndex];
+	aabb.m_minVec = aabbMin;
+	aabb.m_maxVec = aabbMax;
+	aabb.m_minIndices[3] = userPtr;
+	aabb.m_signedMaxIndices[3] = proxyIndex;
+
+	b3AlignedObjectArray<int>& mapping = largeProxy ? m_largeAabbsMappingCpu : m_smallAabbsMappingCpu;
+	if (mapping.findLinearSearch(proxyIndex) == mapping.size())
+	{
+		b3AlignedObjectArray<int>& otherMapping = largeProxy ? m_smallAabbsMappingCpu : m_largeAabbsMappingCpu;
+		otherMapping.remove(proxyIndex);
+		mapping.push_back(proxyIndex);
+		m_plbvh.invalidateTopology();
+	}
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
 void b3GpuParallelLinearBvhBroadphase::calculateOverlappingPairs(int maxPairs)
 {
-	//Reconstruct BVH
+	//Refit or reconstruct BVH
 	m_plbvh.build(m_aabbsGpu, m_smallAabbsMappingGpu, m_largeAabbsMappingGpu);
 
 	//
 	m_overlappingPairsGpu.resize(maxPairs);
-	m_plbvh.calculateOverlappingPairs(m_overlappingPairsGpu);
+	m_collisionFilters.writeChangedToGpu();
+	m_numOverlapRequired = m_plbvh.calculateOverlappingPairs(m_overlappingPairsGpu, m_collisionFilters.m_filtersGPU);
 }
 void b3GpuParallelLinearBvhBroadphase::calculateOverlappingPairsHost(int maxPairs)
 {
@@ -73,4 +115,5 @@ void b3GpuParallelLinearBvhBroadphase::writeAabbsToGpu()
 	m_aabbsGpu.copyFromHost(m_aabbsCpu);
 	m_smallAabbsMappingGpu.copyFromHost(m_smallAabbsMappingCpu);
 	m_largeAabbsMappingGpu.copyFromHost(m_largeAabbsMappingCpu);
+	m_plbvh.invalidateTopology();
 }
@@ -23,6 +23,8 @@ class b3GpuParallelLinearBvhBroadphase : public b3GpuBroadphaseInterface
 	b3GpuParallelLinearBvh m_plbvh;
 
 	b3OpenCLArray<b3Int4> m_overlappingPairsGpu;
+	int m_numOverlapRequired;
+	b3GpuCollisionFilters m_collisionFilters;
 
 	b3OpenCLArray<b3SapAabb> m_aabbsGpu;
 	b3OpenCLArray<int> m_smallAabbsMappingGpu;
@@ -38,6 +40,9 @@ public:
 
 	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
 	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	///a removed proxy keeps its slot and mapping entry, it just collides with nothing until insertProxy reuses it
+	virtual void removeProxy(int proxyIndex);
+	virtual void insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask);
 
 	virtual void calculateOverlappingPairs(int maxPairs);
 	virtual void calculateOverlappingPairsHost(int maxPairs);
@@ -46,6 +51,7 @@ public:
 	virtual void writeAabbsToGpu();
 
 	virtual int getNumOverlap() { return m_overlappingPairsGpu.size(); }
+	virtual int getNumOverlapRequired() { return m_numOverlapRequired; }
 	virtual cl_mem getOverlappingPairBuffer() { return m_overlappingPairsGpu.getBufferCL(); }
 
 	virtual cl_mem getAabbBufferWS() { return m_aabbsGpu.getBufferCL(); }
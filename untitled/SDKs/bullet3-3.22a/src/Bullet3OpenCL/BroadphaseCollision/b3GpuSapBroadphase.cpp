@@ -77,6 +77,21 @@ b3GpuSapBroadphase::b3GpuSapBroadphase(cl_context ctx, cl_device_id device, cl_c
 	  m_addedCountGPU(ctx, q),
 	  m_removedCountGPU(ctx, q),
 	  m_currentBuffer(-1),
+	  m_incrementalSort(true),
+	  m_maxIncrementalSortPasses(8),
+	  m_sortDataValid(false),
+	  m_sortAxis(0),
+	  m_framesSinceFullSort(0),
+	  m_sortStateGPU(ctx, q),
+	  m_searchedAabbsGPU(ctx, q),
+	  m_pairsValid(false),
+	  m_pairsMaxPairs(0),
+	  m_computePairDeltas(false),
+	  m_prevOverlappingPairs(ctx, q),
+	  m_pairHashGPU(ctx, q),
+	  m_pairDeltaCountGPU(ctx, q),
+	  m_addedPairsGPU(ctx, q),
+	  m_removedPairsGPU(ctx, q),
 	  m_pairCount(ctx, q),
 	  m_allAabbsGPU(ctx, q),
 	  m_sum(ctx, q),
@@ -85,6 +100,8 @@ b3GpuSapBroadphase::b3GpuSapBroadphase(cl_context ctx, cl_device_id device, cl_c
 	  m_smallAabbsMappingGPU(ctx, q),
 	  m_largeAabbsMappingGPU(ctx, q),
 	  m_overlappingPairs(ctx, q),
+	  m_numOverlapRequired(0),
+	  m_collisionFilters(ctx, q),
 	  m_gpuSmallSortData(ctx, q),
 	  m_gpuSmallSortedAabbs(ctx, q)
 {
@@ -153,6 +170,19 @@ b3GpuSapBroadphase::b3GpuSapBroadphase(cl_context ctx, cl_device_id device, cl_c
 
 	m_scatterKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "scatterKernel", &errNum, sapProg);
 
+	m_refreshSortKeysKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "refreshSortKeysKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_oddEvenSortPassKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "oddEvenSortPassKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_detectMovedAabbsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "detectMovedAabbsKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_clearPairHashKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "clearPairHashKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_insertPairHashKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "insertPairHashKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+	m_findMissingPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, sapSrc, "findMissingPairsKernel", &errNum, sapProg);
+	b3Assert(errNum == CL_SUCCESS);
+
 	m_sorter = new b3RadixSort32CL(m_context, m_device, m_queue);
 }
 
@@ -167,6 +197,12 @@ b3GpuSapBroadphase::~b3GpuSapBroadphase()
 	clReleaseKernel(m_sapKernel);
 	clReleaseKernel(m_sap2Kernel);
 	clReleaseKernel(m_prepareSumVarianceKernel);
+	clReleaseKernel(m_refreshSortKeysKernel);
+	clReleaseKernel(m_oddEvenSortPassKernel);
+	clReleaseKernel(m_detectMovedAabbsKernel);
+	clReleaseKernel(m_clearPairHashKernel);
+	clReleaseKernel(m_insertPairHashKernel);
+	clReleaseKernel(m_findMissingPairsKernel);
 }
 
 /// conservative test for overlap between two aabbs
@@ -907,7 +943,8 @@ void b3GpuSapBroadphase::calculateOverlappingPairsHost(int maxPairs)
 				b3SapAabb smallAabbj = m_allAabbsCPU[m_smallAabbsMappingCPU[j]];
 
 				if (TestAabbAgainstAabb2((b3Vector3&)smallAabbi.m_min, (b3Vector3&)smallAabbi.m_max,
-										 (b3Vector3&)smallAabbj.m_min, (b3Vector3&)smallAabbj.m_max))
+										 (b3Vector3&)smallAabbj.m_min, (b3Vector3&)smallAabbj.m_max) &&
+					m_collisionFilters.needsCollision(smallAabbi.m_minIndices[3], smallAabbj.m_minIndices[3]))
 				{
 					b3Int4 pair;
 					int a = smallAabbi.m_minIndices[3];
@@ -941,7 +978,8 @@ void b3GpuSapBroadphase::calculateOverlappingPairsHost(int maxPairs)
 			{
 				b3SapAabb largeAabbj = m_allAabbsCPU[m_largeAabbsMappingCPU[j]];
 				if (TestAabbAgainstAabb2((b3Vector3&)smallAabbi.m_min, (b3Vector3&)smallAabbi.m_max,
-										 (b3Vector3&)largeAabbj.m_min, (b3Vector3&)largeAabbj.m_max))
+										 (b3Vector3&)largeAabbj.m_min, (b3Vector3&)largeAabbj.m_max) &&
+					m_collisionFilters.needsCollision(smallAabbi.m_minIndices[3], largeAabbj.m_minIndices[3]))
 				{
 					b3Int4 pair;
 					int a = largeAabbj.m_minIndices[3];
@@ -963,6 +1001,7 @@ void b3GpuSapBroadphase::calculateOverlappingPairsHost(int maxPairs)
 		}
 	}
 
+	m_numOverlapRequired = hostPairs.size();
 	if (hostPairs.size() > maxPairs)
 	{
 		hostPairs.resize(maxPairs);
@@ -992,6 +1031,193 @@ void b3GpuSapBroadphase::reset()
 
 	m_largeAabbsMappingGPU.resize(0);
 	m_largeAabbsMappingCPU.resize(0);
+
+	m_proxyMappingCPU.resize(0);
+	m_collisionFilters.reset();
+	m_dirtyAabbs.clear();
+	m_dirtySmallAabbsMapping.clear();
+	m_dirtyLargeAabbsMapping.clear();
+
+	m_sortDataValid = false;
+	m_pairsValid = false;
+	m_searchedAabbsGPU.resize(0);
+	m_prevOverlappingPairs.resize(0);
+	m_addedPairsGPU.resize(0);
+	m_removedPairsGPU.resize(0);
+}
+
+void b3GpuSapBroadphase::setIncrementalSort(bool enable, int maxPasses)
+{
+	m_incrementalSort = enable;
+	m_maxIncrementalSortPasses = maxPasses;
+	m_sortDataValid = false;
+	m_pairsValid = false;
+}
+
+void b3GpuSapBroadphase::setComputePairDeltas(bool enable)
+{
+	m_computePairDeltas = enable;
+	m_prevOverlappingPairs.resize(0);
+	m_addedPairsGPU.resize(0);
+	m_removedPairsGPU.resize(0);
+}
+
+void b3GpuSapBroadphase::detectMovedAabbs()
+{
+	int numAabbs = m_allAabbsGPU.size();
+	int sortState[2] = {0, 0};
+	m_sortStateGPU.resize(2);
+	m_sortStateGPU.copyFromHostPointer(sortState, 2);
+
+	//new proxies get whatever the grown buffer holds, they invalidate the pairs anyway
+	m_searchedAabbsGPU.resize(numAabbs);
+	if (numAabbs)
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_searchedAabbsGPU.getBufferCL()),
+			b3BufferInfoCL(m_sortStateGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_detectMovedAabbsKernel, "m_detectMovedAabbsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numAabbs);
+		launcher.launch1D(numAabbs);
+	}
+}
+
+//returns true when an AABB changed since the last pair search
+bool b3GpuSapBroadphase::sortSmallAabbs(int numSmallAabbs, int axis, bool incremental)
+{
+	B3_GPU_STAGE("broadphaseSort");
+	bool needsFullSort = true;
+	bool aabbsMoved = true;
+
+	if (incremental)
+	{
+		B3_PROFILE("incremental sort");
+		{
+			b3BufferInfoCL bInfo[] = {
+				b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+				b3BufferInfoCL(m_smallAabbsMappingGPU.getBufferCL(), true),
+				b3BufferInfoCL(m_gpuSmallSortData.getBufferCL())};
+			b3LauncherCL launcher(m_queue, m_refreshSortKeysKernel, "m_refreshSortKeysKernel");
+			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+			launcher.setConst(numSmallAabbs);
+			launcher.setConst(axis);
+			launcher.launch1D(numSmallAabbs);
+		}
+
+		//a fixed number of passes, only the last two report swaps: when both leave the data untouched, it is sorted
+		int numPasses = b3Max(m_maxIncrementalSortPasses, 2);
+		for (int pass = 0; pass < numPasses; pass++)
+		{
+			b3BufferInfoCL bInfo[] = {
+				b3BufferInfoCL(m_gpuSmallSortData.getBufferCL()),
+				b3BufferInfoCL(m_sortStateGPU.getBufferCL())};
+			b3LauncherCL launcher(m_queue, m_oddEvenSortPassKernel, "m_oddEvenSortPassKernel");
+			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+			launcher.setConst(numSmallAabbs);
+			launcher.setConst(pass & 1);
+			launcher.setConst(pass >= numPasses - 2 ? 1 : 0);
+			launcher.launch1D((numSmallAabbs + 1) / 2);
+		}
+
+		//the only read back of the sort, it also tells whether the pair search can be skipped
+		b3AlignedObjectArray<int> sortState;
+		m_sortStateGPU.copyToHost(sortState);
+		needsFullSort = sortState[0] != 0;
+		aabbsMoved = sortState[1] != 0;
+	}
+	else
+	{
+		B3_PROFILE("flipFloatKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_smallAabbsMappingGPU.getBufferCL(), true),
+			b3BufferInfoCL(m_gpuSmallSortData.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_flipFloatKernel, "m_flipFloatKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numSmallAabbs);
+		launcher.setConst(axis);
+
+		int num = numSmallAabbs;
+		launcher.launch1D(num);
+		clFinish(m_queue);
+	}
+
+	if (needsFullSort)
+	{
+		//the radix sort is stable, so it also finishes a partially sorted sequence
+		B3_PROFILE("gpu radix sort");
+		m_sorter->execute(m_gpuSmallSortData);
+		clFinish(m_queue);
+	}
+	return aabbsMoved;
+}
+
+int b3GpuSapBroadphase::findMissingPairs(const b3OpenCLArray<b3Int4>& pairs, const b3OpenCLArray<b3Int4>& otherPairs, b3OpenCLArray<b3Int2>& missingPairsOut)
+{
+	int numPairs = pairs.size();
+	int numOtherPairs = otherPairs.size();
+	missingPairsOut.resize(numPairs);
+	if (numPairs == 0)
+		return 0;
+
+	//keep the table at most half full, so the linear probing stays short and always finds an empty slot
+	int hashSize = 2;
+	while (hashSize < numOtherPairs * 2)
+		hashSize *= 2;
+	int hashMask = hashSize - 1;
+	m_pairHashGPU.resize(hashSize, false);
+
+	{
+		b3LauncherCL launcher(m_queue, m_clearPairHashKernel, "m_clearPairHashKernel");
+		launcher.setBuffer(m_pairHashGPU.getBufferCL());
+		launcher.setConst(hashSize);
+		launcher.launch1D(hashSize);
+	}
+	if (numOtherPairs)
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(otherPairs.getBufferCL(), true),
+			b3BufferInfoCL(m_pairHashGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_insertPairHashKernel, "m_insertPairHashKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numOtherPairs);
+		launcher.setConst(hashMask);
+		launcher.launch1D(numOtherPairs);
+	}
+
+	m_pairDeltaCountGPU.resize(0);
+	m_pairDeltaCountGPU.push_back(0);
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(pairs.getBufferCL(), true),
+			b3BufferInfoCL(otherPairs.getBufferCL(), true),
+			b3BufferInfoCL(m_pairHashGPU.getBufferCL(), true),
+			b3BufferInfoCL(missingPairsOut.getBufferCL()),
+			b3BufferInfoCL(m_pairDeltaCountGPU.getBufferCL())};
+		b3LauncherCL launcher(m_queue, m_findMissingPairsKernel, "m_findMissingPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numPairs);
+		launcher.setConst(hashMask);
+		launcher.launch1D(numPairs);
+	}
+	int numMissing = m_pairDeltaCountGPU.at(0);
+	missingPairsOut.resize(numMissing);
+	return numMissing;
+}
+
+void b3GpuSapBroadphase::calculatePairDeltas()
+{
+	B3_PROFILE("calculatePairDeltas");
+	findMissingPairs(m_overlappingPairs, m_prevOverlappingPairs, m_addedPairsGPU);
+	findMissingPairs(m_prevOverlappingPairs, m_overlappingPairs, m_removedPairsGPU);
+
+	m_prevOverlappingPairs.resize(m_overlappingPairs.size(), false);
+	if (m_overlappingPairs.size())
+	{
+		m_overlappingPairs.copyToCL(m_prevOverlappingPairs.getBufferCL(), m_overlappingPairs.size());
+	}
 }
 
 void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
@@ -1010,16 +1236,30 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 	B3_PROFILE("GPU 1-axis SAP calculateOverlappingPairs");
 
 	int axis = 0;
+	bool filtersChanged = m_collisionFilters.m_dirtyFilters.size() != 0;
+	m_collisionFilters.writeChangedToGpu();
 
 	{
 		//bool syncOnHost = false;
 
 		int numSmallAabbs = m_smallAabbsMappingCPU.size();
-		if (m_prefixScanFloat4 && numSmallAabbs)
+
+		//the sorted order of the previous frame is only reused along the same axis and for the same small proxies,
+		//the best variance axis is re-evaluated with a full sort every now and then
+		bool incremental = m_incrementalSort && m_sortDataValid && (int)m_gpuSmallSortData.size() == numSmallAabbs && m_framesSinceFullSort < 64;
+		//the pairs of the last search are kept when no AABB changed since, then only the sort keys are refreshed
+		bool reusePairs = incremental && m_pairsValid && !filtersChanged && maxPairs == m_pairsMaxPairs;
+		detectMovedAabbs();
+		if (incremental)
+		{
+			axis = m_sortAxis;
+			m_framesSinceFullSort++;
+		}
+		else if (m_prefixScanFloat4 && numSmallAabbs)
 		{
 			B3_PROFILE("GPU compute best variance axis");
 
-			if (m_dst.size() != (numSmallAabbs + 1))
+			if ((int)m_dst.size() != (numSmallAabbs + 1))
 			{
 				m_dst.resize(numSmallAabbs + 128);
 				m_sum.resize(numSmallAabbs + 128);
@@ -1051,32 +1291,32 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 				axis = 2;
 		}
 
+		if (!incremental)
+		{
+			m_sortAxis = axis;
+			m_framesSinceFullSort = 0;
+		}
 		m_gpuSmallSortData.resize(numSmallAabbs);
 
 #if 1
+		bool aabbsMoved = true;
 		if (m_smallAabbsMappingGPU.size())
 		{
-			B3_PROFILE("flipFloatKernel");
-			b3BufferInfoCL bInfo[] = {
-				b3BufferInfoCL(m_allAabbsGPU.getBufferCL(), true),
-				b3BufferInfoCL(m_smallAabbsMappingGPU.getBufferCL(), true),
-				b3BufferInfoCL(m_gpuSmallSortData.getBufferCL())};
-			b3LauncherCL launcher(m_queue, m_flipFloatKernel, "m_flipFloatKernel");
-			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-			launcher.setConst(numSmallAabbs);
-			launcher.setConst(axis);
-
-			int num = numSmallAabbs;
-			launcher.launch1D(num);
-			clFinish(m_queue);
+			aabbsMoved = sortSmallAabbs(numSmallAabbs, axis, incremental);
 		}
+		m_sortDataValid = true;
 
-		if (m_gpuSmallSortData.size())
+		if (reusePairs && !aabbsMoved)
 		{
-			B3_PROFILE("gpu radix sort");
-			m_sorter->execute(m_gpuSmallSortData);
-			clFinish(m_queue);
+			//m_overlappingPairs still holds the pairs of the last search, the pipeline only rewrites their contact slots
+			if (m_computePairDeltas)
+			{
+				m_addedPairsGPU.resize(0);
+				m_removedPairsGPU.resize(0);
+			}
+			return;
 		}
+		m_numOverlapRequired = 0;
 
 		m_gpuSmallSortedAabbs.resize(numSmallAabbs);
 		if (numSmallAabbs)
@@ -1113,7 +1353,8 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 					b3BufferInfoCL(m_largeAabbsMappingGPU.getBufferCL()),
 					b3BufferInfoCL(m_smallAabbsMappingGPU.getBufferCL()),
 					b3BufferInfoCL(m_overlappingPairs.getBufferCL()),
-					b3BufferInfoCL(m_pairCount.getBufferCL())};
+					b3BufferInfoCL(m_pairCount.getBufferCL()),
+					b3BufferInfoCL(m_collisionFilters.m_filtersGPU.getBufferCL(), true)};
 				b3LauncherCL launcher(m_queue, m_sap2Kernel, "m_sap2Kernel");
 				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 				launcher.setConst(numLargeAabbs);
@@ -1124,6 +1365,7 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 				launcher.launch2D(numLargeAabbs, numSmallAabbs, 4, 64);
 
 				numPairs = m_pairCount.at(0);
+				m_numOverlapRequired = numPairs;
 				if (numPairs > maxPairs)
 				{
 					b3Error("Error running out of pairs: numPairs = %d, maxPairs = %d.\n", numPairs, maxPairs);
@@ -1134,7 +1376,7 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 		if (m_gpuSmallSortedAabbs.size())
 		{
 			B3_PROFILE("sapKernel");
-			b3BufferInfoCL bInfo[] = {b3BufferInfoCL(m_gpuSmallSortedAabbs.getBufferCL()), b3BufferInfoCL(m_overlappingPairs.getBufferCL()), b3BufferInfoCL(m_pairCount.getBufferCL())};
+			b3BufferInfoCL bInfo[] = {b3BufferInfoCL(m_gpuSmallSortedAabbs.getBufferCL()), b3BufferInfoCL(m_overlappingPairs.getBufferCL()), b3BufferInfoCL(m_pairCount.getBufferCL()), b3BufferInfoCL(m_collisionFilters.m_filtersGPU.getBufferCL(), true)};
 			b3LauncherCL launcher(m_queue, m_sapKernel, "m_sapKernel");
 			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 			launcher.setConst(numSmallAabbs);
@@ -1169,6 +1411,7 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 			clFinish(m_queue);
 
 			numPairs = m_pairCount.at(0);
+			m_numOverlapRequired = numPairs;
 			if (numPairs > maxPairs)
 			{
 				b3Error("Error running out of pairs: numPairs = %d, maxPairs = %d.\n", numPairs, maxPairs);
@@ -1225,6 +1468,13 @@ void b3GpuSapBroadphase::calculateOverlappingPairs(int maxPairs)
 #endif
 
 		m_overlappingPairs.resize(numPairs);
+		m_pairsValid = m_numOverlapRequired <= maxPairs;
+		m_pairsMaxPairs = maxPairs;
+
+		if (m_computePairDeltas)
+		{
+			calculatePairDeltas();
+		}
 
 	}  //B3_PROFILE("GPU_RADIX SORT");
 	   //init3dSap();
@@ -1236,6 +1486,47 @@ void b3GpuSapBroadphase::writeAabbsToGpu()
 	m_largeAabbsMappingGPU.copyFromHost(m_largeAabbsMappingCPU);
 
 	m_allAabbsGPU.copyFromHost(m_allAabbsCPU);  //might not be necessary, the 'setupGpuAabbsFull' already takes care of this
+
+	m_sortDataValid = false;
+	m_pairsValid = false;
+
+	m_dirtyAabbs.clear();
+	m_dirtySmallAabbsMapping.clear();
+	m_dirtyLargeAabbsMapping.clear();
+}
+
+void b3GpuSapBroadphase::writeChangedAabbsToGpu()
+{
+	bool waitForCompletion = false;
+	m_smallAabbsMappingGPU.copyDirtyFromHost(m_smallAabbsMappingCPU, m_dirtySmallAabbsMapping, waitForCompletion);
+	m_largeAabbsMappingGPU.copyDirtyFromHost(m_largeAabbsMappingCPU, m_dirtyLargeAabbsMapping, waitForCompletion);
+	m_allAabbsGPU.copyDirtyFromHost(m_allAabbsCPU, m_dirtyAabbs, waitForCompletion);
+
+	m_smallAabbsMappingGPU.sync();
+	m_largeAabbsMappingGPU.sync();
+	m_allAabbsGPU.sync();
+}
+
+void b3GpuSapBroadphase::addToMapping(int proxyIndex, bool largeProxy)
+{
+	b3AlignedObjectArray<int>& mapping = largeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+	b3DirtyElements& dirtyMapping = largeProxy ? m_dirtyLargeAabbsMapping : m_dirtySmallAabbsMapping;
+
+	if (proxyIndex >= m_proxyMappingCPU.size())
+	{
+		m_proxyMappingCPU.resize(proxyIndex + 1);
+	}
+	m_proxyMappingCPU[proxyIndex].x = largeProxy ? 1 : 0;
+	m_proxyMappingCPU[proxyIndex].y = mapping.size();
+
+	dirtyMapping.markDirty(mapping.size());
+	mapping.push_back(proxyIndex);
+	m_dirtyAabbs.markDirty(proxyIndex);
+	if (!largeProxy)
+	{
+		m_sortDataValid = false;
+	}
+	m_pairsValid = false;
 }
 
 void b3GpuSapBroadphase::createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask)
@@ -1249,7 +1540,8 @@ void b3GpuSapBroadphase::createLargeProxy(const b3Vector3& aabbMin, const b3Vect
 	}
 	aabb.m_minIndices[3] = index;
 	aabb.m_signedMaxIndices[3] = m_allAabbsCPU.size();
-	m_largeAabbsMappingCPU.push_back(m_allAabbsCPU.size());
+	addToMapping(m_allAabbsCPU.size(), true);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_allAabbsCPU.push_back(aabb);
 }
@@ -1265,11 +1557,61 @@ void b3GpuSapBroadphase::createProxy(const b3Vector3& aabbMin, const b3Vector3&
 	}
 	aabb.m_minIndices[3] = index;
 	aabb.m_signedMaxIndices[3] = m_allAabbsCPU.size();
-	m_smallAabbsMappingCPU.push_back(m_allAabbsCPU.size());
+	addToMapping(m_allAabbsCPU.size(), false);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
 
 	m_allAabbsCPU.push_back(aabb);
 }
 
+void b3GpuSapBroadphase::removeProxy(int proxyIndex)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_proxyMappingCPU.size() || m_proxyMappingCPU[proxyIndex].x < 0)
+	{
+		b3Warning("removeProxy: invalid proxy %d\n", proxyIndex);
+		return;
+	}
+
+	bool largeProxy = m_proxyMappingCPU[proxyIndex].x == 1;
+	b3AlignedObjectArray<int>& mapping = largeProxy ? m_largeAabbsMappingCPU : m_smallAabbsMappingCPU;
+	b3DirtyElements& dirtyMapping = largeProxy ? m_dirtyLargeAabbsMapping : m_dirtySmallAabbsMapping;
+
+	//move the last entry of the mapping into the hole, so the mapping stays dense
+	int position = m_proxyMappingCPU[proxyIndex].y;
+	int lastProxy = mapping[mapping.size() - 1];
+	mapping[position] = lastProxy;
+	m_proxyMappingCPU[lastProxy].y = position;
+	mapping.pop_back();
+	dirtyMapping.markDirty(position);
+	if (!largeProxy)
+	{
+		m_sortDataValid = false;
+	}
+	m_pairsValid = false;
+
+	m_proxyMappingCPU[proxyIndex].x = -1;
+	m_proxyMappingCPU[proxyIndex].y = -1;
+}
+
+void b3GpuSapBroadphase::insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (proxyIndex < 0 || proxyIndex >= m_allAabbsCPU.size() || (proxyIndex < m_proxyMappingCPU.size() && m_proxyMappingCPU[proxyIndex].x >= 0))
+	{
+		b3Warning("insertProxy: slot %d is not a removed proxy\n", proxyIndex);
+		return;
+	}
+
+	b3SapAabb& aabb = m_allAabbsCPU[proxyIndex];
+	for (int i = 0; i < 4; i++)
+	{
+		aabb.m_min[i] = aabbMin[i];
+		aabb.m_max[i] = aabbMax[i];
+	}
+	aabb.m_minIndices[3] = userPtr;
+	aabb.m_signedMaxIndices[3] = proxyIndex;
+	addToMapping(proxyIndex, largeProxy);
+	m_collisionFilters.setFilter(userPtr, collisionFilterGroup, collisionFilterMask);
+}
+
 cl_mem b3GpuSapBroadphase::getAabbBufferWS()
 {
 	return m_allAabbsGPU.getBufferCL();
@@ -1279,6 +1621,10 @@ int b3GpuSapBroadphase::getNumOverlap()
 {
 	return m_overlappingPairs.size();
 }
+int b3GpuSapBroadphase::getNumOverlapRequired()
+{
+	return m_numOverlapRequired;
+}
 cl_mem b3GpuSapBroadphase::getOverlappingPairBuffer()
 {
 	return m_overlappingPairs.getBufferCL();
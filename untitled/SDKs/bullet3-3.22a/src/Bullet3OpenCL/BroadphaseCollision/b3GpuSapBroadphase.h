@@ -22,6 +22,12 @@ class b3GpuSapBroadphase : public b3GpuBroadphaseInterface
 	cl_kernel m_sapKernel;
 	cl_kernel m_sap2Kernel;
 	cl_kernel m_prepareSumVarianceKernel;
+	cl_kernel m_refreshSortKeysKernel;
+	cl_kernel m_oddEvenSortPassKernel;
+	cl_kernel m_detectMovedAabbsKernel;
+	cl_kernel m_clearPairHashKernel;
+	cl_kernel m_insertPairHashKernel;
+	cl_kernel m_findMissingPairsKernel;
 
 	class b3RadixSort32CL* m_sorter;
 
@@ -49,6 +55,39 @@ class b3GpuSapBroadphase : public b3GpuBroadphaseInterface
 
 	int m_currentBuffer;
 
+	///per proxy: x is the mapping holding it (0 small, 1 large, -1 removed), y its position in that mapping
+	b3AlignedObjectArray<b3Int2> m_proxyMappingCPU;
+	b3DirtyElements m_dirtyAabbs;
+	b3DirtyElements m_dirtySmallAabbsMapping;
+	b3DirtyElements m_dirtyLargeAabbsMapping;
+
+	///incremental sort: m_gpuSmallSortData still holds last frame's sorted order along m_sortAxis
+	bool m_incrementalSort;
+	int m_maxIncrementalSortPasses;
+	bool m_sortDataValid;
+	int m_sortAxis;
+	int m_framesSinceFullSort;
+	///x: the last sort passes still swapped, y: an AABB changed since the last pair search. Read back once per frame
+	b3OpenCLArray<int> m_sortStateGPU;
+	b3OpenCLArray<b3SapAabb> m_searchedAabbsGPU;
+	///the pairs of the last search can be reused until a proxy or filter changes, or the search ran out of pairs
+	bool m_pairsValid;
+	int m_pairsMaxPairs;
+
+	///pair deltas against the previous call of calculateOverlappingPairs
+	bool m_computePairDeltas;
+	b3OpenCLArray<b3Int4> m_prevOverlappingPairs;
+	b3OpenCLArray<int> m_pairHashGPU;
+	b3OpenCLArray<int> m_pairDeltaCountGPU;
+	b3OpenCLArray<b3Int2> m_addedPairsGPU;
+	b3OpenCLArray<b3Int2> m_removedPairsGPU;
+
+	void addToMapping(int proxyIndex, bool largeProxy);
+	void detectMovedAabbs();
+	bool sortSmallAabbs(int numSmallAabbs, int axis, bool incremental);
+	int findMissingPairs(const b3OpenCLArray<b3Int4>& pairs, const b3OpenCLArray<b3Int4>& otherPairs, b3OpenCLArray<b3Int2>& missingPairsOut);
+	void calculatePairDeltas();
+
 public:
 	b3OpenCLArray<int> m_pairCount;
 
@@ -75,6 +114,9 @@ public:
 	b3AlignedObjectArray<int> m_largeAabbsMappingCPU;
 
 	b3OpenCLArray<b3Int4> m_overlappingPairs;
+	int m_numOverlapRequired;
+
+	b3GpuCollisionFilters m_collisionFilters;
 
 	//temporary gpu work memory
 	b3OpenCLArray<b3SortData> m_gpuSmallSortData;
@@ -118,6 +160,22 @@ public:
 	}
 
 	virtual void calculateOverlappingPairs(int maxPairs);
+
+	///re-use the previous sorted order and fix it up with maxPasses odd-even passes, instead of a full radix sort
+	///the radix sort still runs when that is not enough, and the best variance axis is only re-evaluated on a full sort
+	///when no AABB changed, as in a resting or sleeping scene, the pair search is skipped and its previous pairs are kept
+	void setIncrementalSort(bool enable, int maxPasses = 8);
+	///when enabled, calculateOverlappingPairs also reports the pairs that were added and removed since its previous call
+	void setComputePairDeltas(bool enable);
+	b3OpenCLArray<b3Int2>& getAddedPairsGPU()
+	{
+		return m_addedPairsGPU;
+	}
+	b3OpenCLArray<b3Int2>& getRemovedPairsGPU()
+	{
+		return m_removedPairsGPU;
+	}
+
 	virtual void calculateOverlappingPairsHost(int maxPairs);
 
 	void reset();
@@ -127,12 +185,16 @@ public:
 
 	virtual void createProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
 	virtual void createLargeProxy(const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, int collisionFilterGroup, int collisionFilterMask);
+	virtual void removeProxy(int proxyIndex);
+	virtual void insertProxy(int proxyIndex, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int userPtr, bool largeProxy, int collisionFilterGroup, int collisionFilterMask);
 
 	//call writeAabbsToGpu after done making all changes (createProxy etc)
 	virtual void writeAabbsToGpu();
+	virtual void writeChangedAabbsToGpu();
 
 	virtual cl_mem getAabbBufferWS();
 	virtual int getNumOverlap();
+	virtual int getNumOverlapRequired();
 	virtual cl_mem getOverlappingPairBuffer();
 
 	virtual b3OpenCLArray<b3Int4>& getOverlappingPairsGPU();
@@ -0,0 +1,86 @@
+//Scene statistics of the adaptive broadphase, each work group reduces a strided part of the small proxies
+//to one partial result, so only those partial results are read back instead of all aabbs.
+#define STATISTICS_WG_SIZE 64
+
+typedef struct
+{
+	union
+	{
+		float4	m_min;
+		float   m_minElems[4];
+		int			m_minIndices[4];
+	};
+	union
+	{
+		float4	m_max;
+		float   m_maxElems[4];
+		int			m_maxIndices[4];
+	};
+} btAabbCL;
+
+//see b3GpuBroadphaseStatisticsPartial
+typedef struct
+{
+	float4 m_boundsMin;
+	float4 m_boundsMax;
+	//x: sum of the largest extents, y: smallest largest extent, z: largest extent, w: summed volume
+	float4 m_extents;
+	int m_numProxies;
+	int m_padding[3];
+} b3BroadphaseStatisticsPartialCL;
+
+__kernel __attribute__((reqd_work_group_size(STATISTICS_WG_SIZE,1,1)))
+void gatherStatisticsKernel(__global const btAabbCL* aabbs, __global const int* proxyIndices, __global b3BroadphaseStatisticsPartialCL* partials, int numProxies)
+{
+	__local float4 boundsMinLocal[STATISTICS_WG_SIZE];
+	__local float4 boundsMaxLocal[STATISTICS_WG_SIZE];
+	__local float4 extentsLocal[STATISTICS_WG_SIZE];
+	__local int numProxiesLocal[STATISTICS_WG_SIZE];
+
+	int lid = get_local_id(0);
+	float4 boundsMin = (float4)(FLT_MAX, FLT_MAX, FLT_MAX, 0.f);
+	float4 boundsMax = (float4)(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f);
+	float4 extents = (float4)(0.f, FLT_MAX, 0.f, 0.f);
+	int count = 0;
+	for (int i = get_global_id(0); i < numProxies; i += get_global_size(0))
+	{
+		btAabbCL aabb = aabbs[proxyIndices[i]];
+		float4 extent = aabb.m_max - aabb.m_min;
+		float largestExtent = fmax(extent.x, fmax(extent.y, extent.z));
+		extents.x += largestExtent;
+		extents.y = fmin(extents.y, largestExtent);
+		extents.z = fmax(extents.z, largestExtent);
+		extents.w += extent.x * extent.y * extent.z;
+		boundsMin.xyz = fmin(boundsMin.xyz, aabb.m_min.xyz);
+		boundsMax.xyz = fmax(boundsMax.xyz, aabb.m_max.xyz);
+		count++;
+	}
+	boundsMinLocal[lid] = boundsMin;
+	boundsMaxLocal[lid] = boundsMax;
+	extentsLocal[lid] = extents;
+	numProxiesLocal[lid] = count;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int stride = STATISTICS_WG_SIZE / 2; stride > 0; stride >>= 1)
+	{
+		if (lid < stride)
+		{
+			float4 other = extentsLocal[lid + stride];
+			float4 mine = extentsLocal[lid];
+			extentsLocal[lid] = (float4)(mine.x + other.x, fmin(mine.y, other.y), fmax(mine.z, other.z), mine.w + other.w);
+			boundsMinLocal[lid] = fmin(boundsMinLocal[lid], boundsMinLocal[lid + stride]);
+			boundsMaxLocal[lid] = fmax(boundsMaxLocal[lid], boundsMaxLocal[lid + stride]);
+			numProxiesLocal[lid] += numProxiesLocal[lid + stride];
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (lid == 0)
+	{
+		int group = get_group_id(0);
+		partials[group].m_boundsMin = boundsMinLocal[0];
+		partials[group].m_boundsMax = boundsMaxLocal[0];
+		partials[group].m_extents = extentsLocal[0];
+		partials[group].m_numProxies = numProxiesLocal[0];
+	}
+}
@@ -0,0 +1,82 @@
+//this file is autogenerated using stringify.bat (premake --stringify) in the build folder of this project
+static const char* adaptiveBroadphaseCL =
+	"//Scene statistics of the adaptive broadphase, each work group reduces a strided part of the small proxies\n"
+	"//to one partial result, so only those partial results are read back instead of all aabbs.\n"
+	"#define STATISTICS_WG_SIZE 64\n"
+	"typedef struct\n"
+	"{\n"
+	"	union\n"
+	"	{\n"
+	"		float4	m_min;\n"
+	"		float   m_minElems[4];\n"
+	"		int			m_minIndices[4];\n"
+	"	};\n"
+	"	union\n"
+	"	{\n"
+	"		float4	m_max;\n"
+	"		float   m_maxElems[4];\n"
+	"		int			m_maxIndices[4];\n"
+	"	};\n"
+	"} btAabbCL;\n"
+	"//see b3GpuBroadphaseStatisticsPartial\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_boundsMin;\n"
+	"	float4 m_boundsMax;\n"
+	"	//x: sum of the largest extents, y: smallest largest extent, z: largest extent, w: summed volume\n"
+	"	float4 m_extents;\n"
+	"	int m_numProxies;\n"
+	"	int m_padding[3];\n"
+	"} b3BroadphaseStatisticsPartialCL;\n"
+	"__kernel __attribute__((reqd_work_group_size(STATISTICS_WG_SIZE,1,1)))\n"
+	"void gatherStatisticsKernel(__global const btAabbCL* aabbs, __global const int* proxyIndices, __global b3BroadphaseStatisticsPartialCL* partials, int numProxies)\n"
+	"{\n"
+	"	__local float4 boundsMinLocal[STATISTICS_WG_SIZE];\n"
+	"	__local float4 boundsMaxLocal[STATISTICS_WG_SIZE];\n"
+	"	__local float4 extentsLocal[STATISTICS_WG_SIZE];\n"
+	"	__local int numProxiesLocal[STATISTICS_WG_SIZE];\n"
+	"	int lid = get_local_id(0);\n"
+	"	float4 boundsMin = (float4)(FLT_MAX, FLT_MAX, FLT_MAX, 0.f);\n"
+	"	float4 boundsMax = (float4)(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f);\n"
+	"	float4 extents = (float4)(0.f, FLT_MAX, 0.f, 0.f);\n"
+	"	int count = 0;\n"
+	"	for (int i = get_global_id(0); i < numProxies; i += get_global_size(0))\n"
+	"	{\n"
+	"		btAabbCL aabb = aabbs[proxyIndices[i]];\n"
+	"		float4 extent = aabb.m_max - aabb.m_min;\n"
+	"		float largestExtent = fmax(extent.x, fmax(extent.y, extent.z));\n"
+	"		extents.x += largestExtent;\n"
+	"		extents.y = fmin(extents.y, largestExtent);\n"
+	"		extents.z = fmax(extents.z, largestExtent);\n"
+	"		extents.w += extent.x * extent.y * extent.z;\n"
+	"		boundsMin.xyz = fmin(boundsMin.xyz, aabb.m_min.xyz);\n"
+	"		boundsMax.xyz = fmax(boundsMax.xyz, aabb.m_max.xyz);\n"
+	"		count++;\n"
+	"	}\n"
+	"	boundsMinLocal[lid] = boundsMin;\n"
+	"	boundsMaxLocal[lid] = boundsMax;\n"
+	"	extentsLocal[lid] = extents;\n"
+	"	numProxiesLocal[lid] = count;\n"
+	"	barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	for (int stride = STATISTICS_WG_SIZE / 2; stride > 0; stride >>= 1)\n"
+	"	{\n"
+	"		if (lid < stride)\n"
+	"		{\n"
+	"			float4 other = extentsLocal[lid + stride];\n"
+	"			float4 mine = extentsLocal[lid];\n"
+	"			extentsLocal[lid] = (float4)(mine.x + other.x, fmin(mine.y, other.y), fmax(mine.z, other.z), mine.w + other.w);\n"
+	"			boundsMinLocal[lid] = fmin(boundsMinLocal[lid], boundsMinLocal[lid + stride]);\n"
+	"			boundsMaxLocal[lid] = fmax(boundsMaxLocal[lid], boundsMaxLocal[lid + stride]);\n"
+	"			numProxiesLocal[lid] += numProxiesLocal[lid + stride];\n"
+	"		}\n"
+	"		barrier(CLK_LOCAL_MEM_FENCE);\n"
+	"	}\n"
+	"	if (lid == 0)\n"
+	"	{\n"
+	"		int group = get_group_id(0);\n"
+	"		partials[group].m_boundsMin = boundsMinLocal[0];\n"
+	"		partials[group].m_boundsMax = boundsMaxLocal[0];\n"
+	"		partials[group].m_extents = extentsLocal[0];\n"
+	"		partials[group].m_numProxies = numProxiesLocal[0];\n"
+	"	}\n"
+	"}\n";
@@ -93,6 +93,8 @@ int testAABBOverlap(float4 min0, float4 max0, float4 min1, float4 max1)
 			(min0.z <= max1.z)&& (min1.z <= max0.z); 
 }
 
+#include "Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h"
+
 
 
 
@@ -107,6 +109,7 @@ void findPairsInCell(	int numObjects,
 						__global float4* pParams,
 							volatile  __global int* pairCount,
 						__global int4*   pPairBuff2,
+						__global const int2* collisionFilters,
 						int maxPairs
 						)
 {
@@ -146,7 +149,7 @@ void findPairsInCell(	int numObjects,
 				if (pairCount)
 				{
 					int handleIndex2 = as_int(min1.w);
-					if (handleIndex<handleIndex2)
+					if (handleIndex<handleIndex2 && b3NeedsCollision(collisionFilters[handleIndex], collisionFilters[handleIndex2]))
 					{
 						int curPair = atomic_add(pairCount,1);
 						if (curPair<maxPairs)
@@ -174,6 +177,7 @@ __kernel void kFindOverlappingPairs(	int numObjects,
 										__global float4* pParams ,
 										volatile  __global int* pairCount,
 										__global int4*   pPairBuff2,
+										__global const int2* collisionFilters,
 										int maxPairs
 										)
 
@@ -204,7 +208,7 @@ __kernel void kFindOverlappingPairs(	int numObjects,
             for(int x=-1; x<=1; x++) 
             {
 				gridPosB.x = gridPosA.x + x;
-                findPairsInCell(numObjects, gridPosB, index, pHash, pCellStart, allpAABB,smallAabbMapping, pParams, pairCount,pPairBuff2, maxPairs);
+                findPairsInCell(numObjects, gridPosB, index, pHash, pCellStart, allpAABB,smallAabbMapping, pParams, pairCount,pPairBuff2, collisionFilters, maxPairs);
             }
         }
     }
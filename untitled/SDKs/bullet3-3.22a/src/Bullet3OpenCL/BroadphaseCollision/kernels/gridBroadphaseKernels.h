@@ -85,6 +85,23 @@ static const char* gridBroadphaseCL =
 	"			(min0.y <= max1.y)&& (min1.y <= max0.y) && \n"
 	"			(min0.z <= max1.z)&& (min1.z <= max0.z); \n"
 	"}\n"
+	"#ifndef B3_COLLISION_FILTER_H\n"
+	"#define B3_COLLISION_FILTER_H\n"
+	"#ifndef B3_INT2_H\n"
+	"#define B3_INT2_H\n"
+	"#ifdef __cplusplus\n"
+	"#else\n"
+	"#define b3UnsignedInt2 uint2\n"
+	"#define b3Int2 int2\n"
+	"#define b3MakeInt2 (int2)\n"
+	"#endif //__cplusplus\n"
+	"#endif\n"
+	"//the collision filters hold the group (x) and the mask (y) per user index, a pair is only reported if each group is in the other mask\n"
+	"inline bool b3NeedsCollision(b3Int2 filterA, b3Int2 filterB)\n"
+	"{\n"
+	"	return (filterA.x & filterB.y) && (filterB.x & filterA.y);\n"
+	"}\n"
+	"#endif  //B3_COLLISION_FILTER_H\n"
 	"//search for AABB 'index' against other AABBs' in this cell\n"
 	"void findPairsInCell(	int numObjects,\n"
 	"						int4	gridPos,\n"
@@ -96,6 +113,7 @@ static const char* gridBroadphaseCL =
 	"						__global float4* pParams,\n"
 	"							volatile  __global int* pairCount,\n"
 	"						__global int4*   pPairBuff2,\n"
+	"						__global const int2* collisionFilters,\n"
 	"						int maxPairs\n"
 	"						)\n"
 	"{\n"
@@ -135,7 +153,7 @@ static const char* gridBroadphaseCL =
 	"				if (pairCount)\n"
 	"				{\n"
 	"					int handleIndex2 = as_int(min1.w);\n"
-	"					if (handleIndex<handleIndex2)\n"
+	"					if (handleIndex<handleIndex2 && b3NeedsCollision(collisionFilters[handleIndex], collisionFilters[handleIndex2]))\n"
 	"					{\n"
 	"						int curPair = atomic_add(pairCount,1);\n"
 	"						if (curPair<maxPairs)\n"
@@ -162,6 +180,7 @@ static const char* gridBroadphaseCL =
 	"										__global float4* pParams ,\n"
 	"										volatile  __global int* pairCount,\n"
 	"										__global int4*   pPairBuff2,\n"
+	"										__global const int2* collisionFilters,\n"
 	"										int maxPairs\n"
 	"										)\n"
 	"{\n"
@@ -191,7 +210,7 @@ static const char* gridBroadphaseCL =
 	"            for(int x=-1; x<=1; x++) \n"
 	"            {\n"
 	"				gridPosB.x = gridPosA.x + x;\n"
-	"                findPairsInCell(numObjects, gridPosB, index, pHash, pCellStart, allpAABB,smallAabbMapping, pParams, pairCount,pPairBuff2, maxPairs);\n"
+	"                findPairsInCell(numObjects, gridPosB, index, pHash, pCellStart, allpAABB,smallAabbMapping, pParams, pairCount,pPairBuff2, collisionFilters, maxPairs);\n"
 	"            }\n"
 	"        }\n"
 	"    }\n"
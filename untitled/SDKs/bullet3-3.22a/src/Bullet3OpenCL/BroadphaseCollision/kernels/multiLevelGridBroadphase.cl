@@ -0,0 +1,176 @@
+//Multi level hashed grid: the cells of level l are baseCellSize*2^l large, and each proxy is hashed into the cell
+//of its center on the finest level whose cells are at least as large as the proxy. Overlapping proxies then
+//have their centers in neighbouring cells of the coarser level, so each proxy searches the 27 cells around it
+//on its own level and on all coarser levels. Proxies larger than the coarsest cells overflow into a separate list.
+
+typedef struct
+{
+	union
+	{
+		float4	m_min;
+		float   m_minElems[4];
+		int			m_minIndices[4];
+	};
+	union
+	{
+		float4	m_max;
+		float   m_maxElems[4];
+		int			m_maxIndices[4];
+	};
+} btAabbCL;
+
+int mlgTestAabbOverlap(const btAabbCL* aabb1, const btAabbCL* aabb2)
+{
+	return	(aabb1->m_min.x <= aabb2->m_max.x) && (aabb2->m_min.x <= aabb1->m_max.x) &&
+			(aabb1->m_min.y <= aabb2->m_max.y) && (aabb2->m_min.y <= aabb1->m_max.y) &&
+			(aabb1->m_min.z <= aabb2->m_max.z) && (aabb2->m_min.z <= aabb1->m_max.z);
+}
+
+#include "Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h"
+
+//the cells wrap around every gridDim cells (a power of two), each level has its own range of gridDim^3 hashes
+int mlgCellHash(int4 cell, int level, int gridDim)
+{
+	int x = cell.x & (gridDim-1);
+	int y = cell.y & (gridDim-1);
+	int z = cell.z & (gridDim-1);
+	return ((level*gridDim + z)*gridDim + y)*gridDim + x;
+}
+
+int4 mlgCell(float4 center, float cellSize)
+{
+	int4 cell;
+	cell.x = (int)floor(center.x/cellSize);
+	cell.y = (int)floor(center.y/cellSize);
+	cell.z = (int)floor(center.z/cellSize);
+	cell.w = 0;
+	return cell;
+}
+
+//levelInfo[0] is the number of overflow proxies, levelInfo[1] a bit mask of the levels that hold proxies
+__kernel void   mlgCalcHashKernel( __global const btAabbCL* allAabbs, __global int2* hashOut, __global int* proxyLevels, volatile __global int* levelInfo, __global int* overflowProxies, int numProxies, float baseCellSize, int numLevels, int gridDim)
+{
+	int i = get_global_id(0);
+	if (i>=numProxies)
+		return;
+
+	btAabbCL aabb = allAabbs[i];
+	float4 extents = aabb.m_max - aabb.m_min;
+	float extent = max(extents.x, max(extents.y, extents.z));
+
+	int level = 0;
+	float cellSize = baseCellSize;
+	while (level<numLevels && extent>cellSize)
+	{
+		level++;
+		cellSize *= 2.f;
+	}
+	proxyLevels[i] = level;
+
+	if (level==numLevels)
+	{
+		//sorted behind all cells, in a cell that is never searched
+		hashOut[i] = (int2)(numLevels*gridDim*gridDim*gridDim, i);
+		int curOverflow = atomic_inc(&levelInfo[0]);
+		overflowProxies[curOverflow] = i;
+		return;
+	}
+
+	atomic_or(&levelInfo[1], 1<<level);
+	float4 center = (aabb.m_min+aabb.m_max)*0.5f;
+	hashOut[i] = (int2)(mlgCellHash(mlgCell(center, cellSize), level, gridDim), i);
+}
+
+__kernel void   mlgFindPairsKernel( __global const btAabbCL* allAabbs, __global const int2* sortedHash, __global const int* proxyLevels, __global const unsigned int* cellStart, __global const unsigned int* cellEnd, volatile __global int4* pairsOut, volatile __global int* pairCount, __global const int2* collisionFilters, int numProxies, float baseCellSize, int numLevels, int gridDim, int levelMask, int maxPairs)
+{
+	int i = get_global_id(0);
+	if (i>=numProxies)
+		return;
+
+	//neighbouring threads handle proxies of the same cell, so they visit the same cells
+	int proxyIndex = sortedHash[i].y;
+	int level = proxyLevels[proxyIndex];
+	if (level>=numLevels)
+		return;
+
+	btAabbCL aabb = allAabbs[proxyIndex];
+	float4 center = (aabb.m_min+aabb.m_max)*0.5f;
+	int userIndex = aabb.m_minIndices[3];
+
+	float cellSize = baseCellSize*(float)(1<<level);
+	for (int searchLevel=level;searchLevel<numLevels;searchLevel++, cellSize *= 2.f)
+	{
+		if ((levelMask & (1<<searchLevel))==0)
+			continue;
+
+		int4 cell = mlgCell(center, cellSize);
+		for (int z=-1;z<=1;z++)
+		for (int y=-1;y<=1;y++)
+		for (int x=-1;x<=1;x++)
+		{
+			int hash = mlgCellHash(cell+(int4)(x,y,z,0), searchLevel, gridDim);
+			unsigned int end = cellEnd[hash];
+			for (unsigned int j=cellStart[hash];j<end;j++)
+			{
+				int otherProxy = sortedHash[j].y;
+				//proxies of the same level find each other, only one of them reports the pair
+				if (searchLevel==level && otherProxy<=proxyIndex)
+					continue;
+
+				btAabbCL otherAabb = allAabbs[otherProxy];
+				if (!mlgTestAabbOverlap(&aabb, &otherAabb))
+					continue;
+				int otherUserIndex = otherAabb.m_minIndices[3];
+				if (!b3NeedsCollision(collisionFilters[userIndex], collisionFilters[otherUserIndex]))
+					continue;
+
+				int curPair = atomic_inc(pairCount);
+				if (curPair<maxPairs)
+				{
+					pairsOut[curPair] = (int4)(userIndex, otherUserIndex, -1, -1);
+				}
+			}
+		}
+	}
+}
+
+//overflow proxies (x) against all proxies (y)
+__kernel void   mlgOverflowPairsKernel( __global const btAabbCL* allAabbs, __global const int* proxyLevels, __global const int* overflowProxies, volatile __global int4* pairsOut, volatile __global int* pairCount, __global const int2* collisionFilters, int numOverflowProxies, int numProxies, int numLevels, int maxPairs)
+{
+	int o = get_global_id(0);
+	int i = get_global_id(1);
+	if (o>=numOverflowProxies || i>=numProxies)
+		return;
+
+	int overflowProxy = overflowProxies[o];
+	//two overflow proxies only report their pair once
+	if (i==overflowProxy || (proxyLevels[i]==numLevels && i<overflowProxy))
+		return;
+
+	btAabbCL aabb = allAabbs[overflowProxy];
+	btAabbCL otherAabb = allAabbs[i];
+	if (!mlgTestAabbOverlap(&aabb, &otherAabb))
+		return;
+	int userIndex = aabb.m_minIndices[3];
+	int otherUserIndex = otherAabb.m_minIndices[3];
+	if (!b3NeedsCollision(collisionFilters[userIndex], collisionFilters[otherUserIndex]))
+		return;
+
+	int curPair = atomic_inc(pairCount);
+	if (curPair<maxPairs)
+	{
+		pairsOut[curPair] = (int4)(userIndex, otherUserIndex, -1, -1);
+	}
+}
+
+//resets the cell ranges written this frame, so the next frame starts with empty cells without clearing all of them
+__kernel void   mlgClearCellsKernel( __global const int2* sortedHash, __global unsigned int* cellStart, __global unsigned int* cellEnd, int numProxies)
+{
+	int i = get_global_id(0);
+	if (i>=numProxies)
+		return;
+
+	int hash = sortedHash[i].x;
+	cellStart[hash] = 0;
+	cellEnd[hash] = 0;
+}
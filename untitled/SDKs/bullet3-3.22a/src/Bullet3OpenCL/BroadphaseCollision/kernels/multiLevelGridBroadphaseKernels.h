@@ -0,0 +1,171 @@
+//this file is autogenerated using stringify.bat (premake --stringify) in the build folder of this project
+static const char* multiLevelGridBroadphaseCL =
+	"//Multi level hashed grid: the cells of level l are baseCellSize*2^l large, and each proxy is hashed into the cell\n"
+	"//of its center on the finest level whose cells are at least as large as the proxy. Overlapping proxies then\n"
+	"//have their centers in neighbouring cells of the coarser level, so each proxy searches the 27 cells around it\n"
+	"//on its own level and on all coarser levels. Proxies larger than the coarsest cells overflow into a separate list.\n"
+	"typedef struct\n"
+	"{\n"
+	"	union\n"
+	"	{\n"
+	"		float4	m_min;\n"
+	"		float   m_minElems[4];\n"
+	"		int			m_minIndices[4];\n"
+	"	};\n"
+	"	union\n"
+	"	{\n"
+	"		float4	m_max;\n"
+	"		float   m_maxElems[4];\n"
+	"		int			m_maxIndices[4];\n"
+	"	};\n"
+	"} btAabbCL;\n"
+	"int mlgTestAabbOverlap(const btAabbCL* aabb1, const btAabbCL* aabb2)\n"
+	"{\n"
+	"	return	(aabb1->m_min.x <= aabb2->m_max.x) && (aabb2->m_min.x <= aabb1->m_max.x) &&\n"
+	"			(aabb1->m_min.y <= aabb2->m_max.y) && (aabb2->m_min.y <= aabb1->m_max.y) &&\n"
+	"			(aabb1->m_min.z <= aabb2->m_max.z) && (aabb2->m_min.z <= aabb1->m_max.z);\n"
+	"}\n"
+	"#ifndef B3_COLLISION_FILTER_H\n"
+	"#define B3_COLLISION_FILTER_H\n"
+	"#ifndef B3_INT2_H\n"
+	"#define B3_INT2_H\n"
+	"#ifdef __cplusplus\n"
+	"#else\n"
+	"#define b3UnsignedInt2 uint2\n"
+	"#define b3Int2 int2\n"
+	"#define b3MakeInt2 (int2)\n"
+	"#endif //__cplusplus\n"
+	"#endif\n"
+	"//the collision filters hold the group (x) and the mask (y) per user index, a pair is only reported if each group is in the other mask\n"
+	"inline bool b3NeedsCollision(b3Int2 filterA, b3Int2 filterB)\n"
+	"{\n"
+	"	return (filterA.x & filterB.y) && (filterB.x & filterA.y);\n"
+	"}\n"
+	"#endif  //B3_COLLISION_FILTER_H\n"
+	"//the cells wrap around every gridDim cells (a power of two), each level has its own range of gridDim^3 hashes\n"
+	"int mlgCellHash(int4 cell, int level, int gridDim)\n"
+	"{\n"
+	"	int x = cell.x & (gridDim-1);\n"
+	"	int y = cell.y & (gridDim-1);\n"
+	"	int z = cell.z & (gridDim-1);\n"
+	"	return ((level*gridDim + z)*gridDim + y)*gridDim + x;\n"
+	"}\n"
+	"int4 mlgCell(float4 center, float cellSize)\n"
+	"{\n"
+	"	int4 cell;\n"
+	"	cell.x = (int)floor(center.x/cellSize);\n"
+	"	cell.y = (int)floor(center.y/cellSize);\n"
+	"	cell.z = (int)floor(center.z/cellSize);\n"
+	"	cell.w = 0;\n"
+	"	return cell;\n"
+	"}\n"
+	"//levelInfo[0] is the number of overflow proxies, levelInfo[1] a bit mask of the levels that hold proxies\n"
+	"__kernel void   mlgCalcHashKernel( __global const btAabbCL* allAabbs, __global int2* hashOut, __global int* proxyLevels, volatile __global int* levelInfo, __global int* overflowProxies, int numProxies, float baseCellSize, int numLevels, int gridDim)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numProxies)\n"
+	"		return;\n"
+	"	btAabbCL aabb = allAabbs[i];\n"
+	"	float4 extents = aabb.m_max - aabb.m_min;\n"
+	"	float extent = max(extents.x, max(extents.y, extents.z));\n"
+	"	int level = 0;\n"
+	"	float cellSize = baseCellSize;\n"
+	"	while (level<numLevels && extent>cellSize)\n"
+	"	{\n"
+	"		level++;\n"
+	"		cellSize *= 2.f;\n"
+	"	}\n"
+	"	proxyLevels[i] = level;\n"
+	"	if (level==numLevels)\n"
+	"	{\n"
+	"		//sorted behind all cells, in a cell that is never searched\n"
+	"		hashOut[i] = (int2)(numLevels*gridDim*gridDim*gridDim, i);\n"
+	"		int curOverflow = atomic_inc(&levelInfo[0]);\n"
+	"		overflowProxies[curOverflow] = i;\n"
+	"		return;\n"
+	"	}\n"
+	"	atomic_or(&levelInfo[1], 1<<level);\n"
+	"	float4 center = (aabb.m_min+aabb.m_max)*0.5f;\n"
+	"	hashOut[i] = (int2)(mlgCellHash(mlgCell(center, cellSize), level, gridDim), i);\n"
+	"}\n"
+	"__kernel void   mlgFindPairsKernel( __global const btAabbCL* allAabbs, __global const int2* sortedHash, __global const int* proxyLevels, __global const unsigned int* cellStart, __global const unsigned int* cellEnd, volatile __global int4* pairsOut, volatile __global int* pairCount, __global const int2* collisionFilters, int numProxies, float baseCellSize, int numLevels, int gridDim, int levelMask, int maxPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numProxies)\n"
+	"		return;\n"
+	"	//neighbouring threads handle proxies of the same cell, so they visit the same cells\n"
+	"	int proxyIndex = sortedHash[i].y;\n"
+	"	int level = proxyLevels[proxyIndex];\n"
+	"	if (level>=numLevels)\n"
+	"		return;\n"
+	"	btAabbCL aabb = allAabbs[proxyIndex];\n"
+	"	float4 center = (aabb.m_min+aabb.m_max)*0.5f;\n"
+	"	int userIndex = aabb.m_minIndices[3];\n"
+	"	float cellSize = baseCellSize*(float)(1<<level);\n"
+	"	for (int searchLevel=level;searchLevel<numLevels;searchLevel++, cellSize *= 2.f)\n"
+	"	{\n"
+	"		if ((levelMask & (1<<searchLevel))==0)\n"
+	"			continue;\n"
+	"		int4 cell = mlgCell(center, cellSize);\n"
+	"		for (int z=-1;z<=1;z++)\n"
+	"		for (int y=-1;y<=1;y++)\n"
+	"		for (int x=-1;x<=1;x++)\n"
+	"		{\n"
+	"			int hash = mlgCellHash(cell+(int4)(x,y,z,0), searchLevel, gridDim);\n"
+	"			unsigned int end = cellEnd[hash];\n"
+	"			for (unsigned int j=cellStart[hash];j<end;j++)\n"
+	"			{\n"
+	"				int otherProxy = sortedHash[j].y;\n"
+	"				//proxies of the same level find each other, only one of them reports the pair\n"
+	"				if (searchLevel==level && otherProxy<=proxyIndex)\n"
+	"					continue;\n"
+	"				btAabbCL otherAabb = allAabbs[otherProxy];\n"
+	"				if (!mlgTestAabbOverlap(&aabb, &otherAabb))\n"
+	"					continue;\n"
+	"				int otherUserIndex = otherAabb.m_minIndices[3];\n"
+	"				if (!b3NeedsCollision(collisionFilters[userIndex], collisionFilters[otherUserIndex]))\n"
+	"					continue;\n"
+	"				int curPair = atomic_inc(pairCount);\n"
+	"				if (curPair<maxPairs)\n"
+	"				{\n"
+	"					pairsOut[curPair] = (int4)(userIndex, otherUserIndex, -1, -1);\n"
+	"				}\n"
+	"			}\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"//overflow proxies (x) against all proxies (y)\n"
+	"__kernel void   mlgOverflowPairsKernel( __global const btAabbCL* allAabbs, __global const int* proxyLevels, __global const int* overflowProxies, volatile __global int4* pairsOut, volatile __global int* pairCount, __global const int2* collisionFilters, int numOverflowProxies, int numProxies, int numLevels, int maxPairs)\n"
+	"{\n"
+	"	int o = get_global_id(0);\n"
+	"	int i = get_global_id(1);\n"
+	"	if (o>=numOverflowProxies || i>=numProxies)\n"
+	"		return;\n"
+	"	int overflowProxy = overflowProxies[o];\n"
+	"	//two overflow proxies only report their pair once\n"
+	"	if (i==overflowProxy || (proxyLevels[i]==numLevels && i<overflowProxy))\n"
+	"		return;\n"
+	"	btAabbCL aabb = allAabbs[overflowProxy];\n"
+	"	btAabbCL otherAabb = allAabbs[i];\n"
+	"	if (!mlgTestAabbOverlap(&aabb, &otherAabb))\n"
+	"		return;\n"
+	"	int userIndex = aabb.m_minIndices[3];\n"
+	"	int otherUserIndex = otherAabb.m_minIndices[3];\n"
+	"	if (!b3NeedsCollision(collisionFilters[userIndex], collisionFilters[otherUserIndex]))\n"
+	"		return;\n"
+	"	int curPair = atomic_inc(pairCount);\n"
+	"	if (curPair<maxPairs)\n"
+	"	{\n"
+	"		pairsOut[curPair] = (int4)(userIndex, otherUserIndex, -1, -1);\n"
+	"	}\n"
+	"}\n"
+	"//resets the cell ranges written this frame, so the next frame starts with empty cells without clearing all of them\n"
+	"__kernel void   mlgClearCellsKernel( __global const int2* sortedHash, __global unsigned int* cellStart, __global unsigned int* cellEnd, int numProxies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numProxies)\n"
+	"		return;\n"
+	"	int hash = sortedHash[i].x;\n"
+	"	cellStart[hash] = 0;\n"
+	"	cellEnd[hash] = 0;\n"
+	"}\n";
@@ -173,6 +173,8 @@ bool TestAabbAgainstAabb2(const b3AabbCL* aabb1, const b3AabbCL* aabb2)
 }
 //From sap.cl
 
+#include "Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h"
+
 __kernel void plbvhCalculateOverlappingPairs(__global b3AabbCL* rigidAabbs, 
 
 											__global int* rootNodeIndex, 
@@ -182,6 +184,7 @@ __kernel void plbvhCalculateOverlappingPairs(__global b3AabbCL* rigidAabbs,
 											
 											__global SortDataCL* mortonCodesAndAabbIndices,
 											__global int* out_numPairs, __global int4* out_overlappingPairs, 
+											__global const int2* collisionFilters,
 											int maxPairs, int numQueryAabbs)
 {
 	//Using get_group_id()/get_local_id() is Faster than get_global_id(0) since
@@ -219,7 +222,7 @@ __kernel void plbvhCalculateOverlappingPairs(__global b3AabbCL* rigidAabbs,
 		b3AabbCL bvhNodeAabb = (isLeaf) ? rigidAabbs[bvhRigidIndex] : internalNodeAabbs[bvhNodeIndex];
 		if( TestAabbAgainstAabb2(&queryAabb, &bvhNodeAabb) )
 		{
-			if(isLeaf)
+			if(isLeaf && b3NeedsCollision(collisionFilters[rigidAabbs[queryRigidIndex].m_minIndices[3]], collisionFilters[rigidAabbs[bvhRigidIndex].m_minIndices[3]]))
 			{
 				int4 pair;
 				pair.x = rigidAabbs[queryRigidIndex].m_minIndices[3];
@@ -370,6 +373,7 @@ __kernel void plbvhRayTraverse(__global b3AabbCL* rigidAabbs,
 
 __kernel void plbvhLargeAabbAabbTest(__global b3AabbCL* smallAabbs, __global b3AabbCL* largeAabbs, 
 									__global int* out_numPairs, __global int4* out_overlappingPairs, 
+									__global const int2* collisionFilters,
 									int maxPairs, int numLargeAabbRigids, int numSmallAabbRigids)
 {
 	int smallAabbIndex = get_global_id(0);
@@ -379,7 +383,7 @@ __kernel void plbvhLargeAabbAabbTest(__global b3AabbCL* smallAabbs, __global b3A
 	for(int i = 0; i < numLargeAabbRigids; ++i)
 	{
 		b3AabbCL largeAabb = largeAabbs[i];
-		if( TestAabbAgainstAabb2(&smallAabb, &largeAabb) )
+		if( TestAabbAgainstAabb2(&smallAabb, &largeAabb) && b3NeedsCollision(collisionFilters[largeAabb.m_minIndices[3]], collisionFilters[smallAabb.m_minIndices[3]]) )
 		{
 			int4 pair;
 			pair.x = largeAabb.m_minIndices[3];
@@ -765,3 +769,27 @@ __kernel void findLeafIndexRanges(__global int2* internalNodeChildNodes, __globa
 	//
 	out_leafIndexRanges[internalNodeIndex] = leafIndexRange;
 }
+
+//Surface area (halved) of each internal node; the sum over all nodes relative to the root area
+//approximates the SAH cost of the tree, which grows as refitted nodes start to overlap
+__kernel void computeInternalNodeSurfaceAreas(__global b3AabbCL* internalNodeAabbs, __global float* out_surfaceAreas, int numInternalNodes)
+{
+	int internalNodeIndex = get_global_id(0);
+	if(internalNodeIndex >= numInternalNodes) return;
+	
+	b3AabbCL aabb = internalNodeAabbs[internalNodeIndex];
+	b3Vector3 extent = aabb.m_max - aabb.m_min;
+	out_surfaceAreas[internalNodeIndex] = extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+//Same reduction as findAllNodesMergedAabb; the total is stored in surfaceAreas[0]
+__kernel void sumSurfaceAreas(__global float* surfaceAreas, int numAreasNeedingSum)
+{
+	int numRemainingAreas = numAreasNeedingSum / 2 + numAreasNeedingSum % 2;
+	int numSummedAreas = numAreasNeedingSum - numRemainingAreas;
+	
+	int areaIndex = get_global_id(0);
+	if(areaIndex >= numSummedAreas) return;
+	
+	surfaceAreas[areaIndex] += surfaceAreas[areaIndex + numRemainingAreas];
+}
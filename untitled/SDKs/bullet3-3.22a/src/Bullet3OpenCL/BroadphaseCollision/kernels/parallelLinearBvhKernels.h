@@ -160,6 +160,23 @@ static const char* parallelLinearBvhCL =
 	"	return overlap;\n"
 	"}\n"
 	"//From sap.cl\n"
+	"#ifndef B3_COLLISION_FILTER_H\n"
+	"#define B3_COLLISION_FILTER_H\n"
+	"#ifndef B3_INT2_H\n"
+	"#define B3_INT2_H\n"
+	"#ifdef __cplusplus\n"
+	"#else\n"
+	"#define b3UnsignedInt2 uint2\n"
+	"#define b3Int2 int2\n"
+	"#define b3MakeInt2 (int2)\n"
+	"#endif //__cplusplus\n"
+	"#endif\n"
+	"//the collision filters hold the group (x) and the mask (y) per user index, a pair is only reported if each group is in the other mask\n"
+	"inline bool b3NeedsCollision(b3Int2 filterA, b3Int2 filterB)\n"
+	"{\n"
+	"	return (filterA.x & filterB.y) && (filterB.x & filterA.y);\n"
+	"}\n"
+	"#endif  //B3_COLLISION_FILTER_H\n"
 	"__kernel void plbvhCalculateOverlappingPairs(__global b3AabbCL* rigidAabbs, \n"
 	"											__global int* rootNodeIndex, \n"
 	"											__global int2* internalNodeChildIndices, \n"
@@ -168,6 +185,7 @@ static const char* parallelLinearBvhCL =
 	"											\n"
 	"											__global SortDataCL* mortonCodesAndAabbIndices,\n"
 	"											__global int* out_numPairs, __global int4* out_overlappingPairs, \n"
+	"											__global const int2* collisionFilters,\n"
 	"											int maxPairs, int numQueryAabbs)\n"
 	"{\n"
 	"	//Using get_group_id()/get_local_id() is Faster than get_global_id(0) since\n"
@@ -205,7 +223,7 @@ static const char* parallelLinearBvhCL =
 	"		b3AabbCL bvhNodeAabb = (isLeaf) ? rigidAabbs[bvhRigidIndex] : internalNodeAabbs[bvhNodeIndex];\n"
 	"		if( TestAabbAgainstAabb2(&queryAabb, &bvhNodeAabb) )\n"
 	"		{\n"
-	"			if(isLeaf)\n"
+	"			if(isLeaf && b3NeedsCollision(collisionFilters[rigidAabbs[queryRigidIndex].m_minIndices[3]], collisionFilters[rigidAabbs[bvhRigidIndex].m_minIndices[3]]))\n"
 	"			{\n"
 	"				int4 pair;\n"
 	"				pair.x = rigidAabbs[queryRigidIndex].m_minIndices[3];\n"
@@ -348,6 +366,7 @@ static const char* parallelLinearBvhCL =
 	"}\n"
 	"__kernel void plbvhLargeAabbAabbTest(__global b3AabbCL* smallAabbs, __global b3AabbCL* largeAabbs, \n"
 	"									__global int* out_numPairs, __global int4* out_overlappingPairs, \n"
+	"									__global const int2* collisionFilters,\n"
 	"									int maxPairs, int numLargeAabbRigids, int numSmallAabbRigids)\n"
 	"{\n"
 	"	int smallAabbIndex = get_global_id(0);\n"
@@ -357,7 +376,7 @@ static const char* parallelLinearBvhCL =
 	"	for(int i = 0; i < numLargeAabbRigids; ++i)\n"
 	"	{\n"
 	"		b3AabbCL largeAabb = largeAabbs[i];\n"
-	"		if( TestAabbAgainstAabb2(&smallAabb, &largeAabb) )\n"
+	"		if( TestAabbAgainstAabb2(&smallAabb, &largeAabb) && b3NeedsCollision(collisionFilters[largeAabb.m_minIndices[3]], collisionFilters[smallAabb.m_minIndices[3]]) )\n"
 	"		{\n"
 	"			int4 pair;\n"
 	"			pair.x = largeAabb.m_minIndices[3];\n"
@@ -725,4 +744,26 @@ static const char* parallelLinearBvhCL =
 	"	\n"
 	"	//\n"
 	"	out_leafIndexRanges[internalNodeIndex] = leafIndexRange;\n"
+	"}\n"
+	"//Surface area (halved) of each internal node; the sum over all nodes relative to the root area\n"
+	"//approximates the SAH cost of the tree, which grows as refitted nodes start to overlap\n"
+	"__kernel void computeInternalNodeSurfaceAreas(__global b3AabbCL* internalNodeAabbs, __global float* out_surfaceAreas, int numInternalNodes)\n"
+	"{\n"
+	"	int internalNodeIndex = get_global_id(0);\n"
+	"	if(internalNodeIndex >= numInternalNodes) return;\n"
+	"	\n"
+	"	b3AabbCL aabb = internalNodeAabbs[internalNodeIndex];\n"
+	"	b3Vector3 extent = aabb.m_max - aabb.m_min;\n"
+	"	out_surfaceAreas[internalNodeIndex] = extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;\n"
+	"}\n"
+	"//Same reduction as findAllNodesMergedAabb; the total is stored in surfaceAreas[0]\n"
+	"__kernel void sumSurfaceAreas(__global float* surfaceAreas, int numAreasNeedingSum)\n"
+	"{\n"
+	"	int numRemainingAreas = numAreasNeedingSum / 2 + numAreasNeedingSum % 2;\n"
+	"	int numSummedAreas = numAreasNeedingSum - numRemainingAreas;\n"
+	"	\n"
+	"	int areaIndex = get_global_id(0);\n"
+	"	if(areaIndex >= numSummedAreas) return;\n"
+	"	\n"
+	"	surfaceAreas[areaIndex] += surfaceAreas[areaIndex + numRemainingAreas];\n"
 	"}\n";
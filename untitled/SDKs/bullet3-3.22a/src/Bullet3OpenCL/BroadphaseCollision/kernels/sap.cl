@@ -62,8 +62,10 @@ bool TestAabbAgainstAabb2Global(const btAabbCL* aabb1, __global const btAabbCL*
 	return overlap;
 }
 
+#include "Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h"
 
-__kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAabbs, __global const int* unsortedAabbMapping,  __global const int* unsortedAabbMapping2, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numUnsortedAabbs, int numUnSortedAabbs2, int axis, int maxPairs)
+
+__kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAabbs, __global const int* unsortedAabbMapping,  __global const int* unsortedAabbMapping2, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numUnsortedAabbs, int numUnSortedAabbs2, int axis, int maxPairs)
 {
 	int i = get_global_id(0);
 	if (i>=numUnsortedAabbs)
@@ -77,7 +79,7 @@ __kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAa
 	__global const btAabbCL* unsortedAabbPtr = &unsortedAabbs[unsortedAabbMapping[i]];
 	__global const btAabbCL* unsortedAabbPtr2 = &unsortedAabbs[unsortedAabbMapping2[j]];
 
-	if (TestAabbAgainstAabb2GlobalGlobal(unsortedAabbPtr,unsortedAabbPtr2))
+	if (TestAabbAgainstAabb2GlobalGlobal(unsortedAabbPtr,unsortedAabbPtr2) && b3NeedsCollision(collisionFilters[unsortedAabbPtr[0].m_minIndices[3]], collisionFilters[unsortedAabbPtr2[0].m_minIndices[3]]))
 	{
 		int4 myPair;
 		
@@ -106,14 +108,14 @@ __kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAa
 
 
 
-__kernel void   computePairsKernelBruteForce( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)
+__kernel void   computePairsKernelBruteForce( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)
 {
 	int i = get_global_id(0);
 	if (i>=numObjects)
 		return;
 	for (int j=i+1;j<numObjects;j++)
 	{
-		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))
+		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))
 		{
 			int4 myPair;
 			myPair.x = aabbs[i].m_minIndices[3];
@@ -130,7 +132,7 @@ __kernel void   computePairsKernelBruteForce( __global const btAabbCL* aabbs, vo
 	}
 }
 
-__kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)
+__kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)
 {
 	int i = get_global_id(0);
 	if (i>=numObjects)
@@ -141,7 +143,7 @@ __kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, vola
 		{
 			break;
 		}
-		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))
+		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))
 		{
 			int4 myPair;
 			myPair.x = aabbs[i].m_minIndices[3];
@@ -161,7 +163,7 @@ __kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, vola
 
 
 
-__kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)
+__kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)
 {
 	int i = get_global_id(0);
 	int localId = get_local_id(0);
@@ -207,7 +209,7 @@ __kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volat
 		
 		if (!localBreak)
 		{
-			if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))
+			if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))
 			{
 				int4 myPair;
 				myPair.x = aabbs[i].m_minIndices[3];
@@ -228,7 +230,7 @@ __kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volat
 }
 
 
-__kernel void   computePairsKernelLocalSharedMemory( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)
+__kernel void   computePairsKernelLocalSharedMemory( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)
 {
 	int i = get_global_id(0);
 	int localId = get_local_id(0);
@@ -285,7 +287,7 @@ __kernel void   computePairsKernelLocalSharedMemory( __global const btAabbCL* aa
 		
 		if (!localBreak)
 		{
-			if (TestAabbAgainstAabb2(&myAabb,&localAabbs[localCount+localId+1]))
+			if (TestAabbAgainstAabb2(&myAabb,&localAabbs[localCount+localId+1]) && b3NeedsCollision(collisionFilters[myAabb.m_minIndices[3]], collisionFilters[localAabbs[localCount+localId+1].m_minIndices[3]]))
 			{
 				int4 myPair;
 				myPair.x = myAabb.m_minIndices[3];
@@ -387,3 +389,106 @@ __kernel void   prepareSumVarianceKernel( __global const btAabbCL* allAabbs, __g
 	sum[i]=s;
 	sum2[i]=s*s;	
 }
+
+
+//incremental sort: refresh the keys of last frame's sorted order, it stays (nearly) sorted while the bodies barely move
+__kernel void   refreshSortKeysKernel( __global const btAabbCL* allAabbs, __global const int* smallAabbMapping, __global int2* sortData, int numObjects, int axis)
+{
+	int i = get_global_id(0);
+	if (i>=numObjects)
+		return;
+	
+	sortData[i].x = FloatFlip(allAabbs[smallAabbMapping[sortData[i].y]].m_minElems[axis]);
+}
+
+//resting and sleeping bodies keep their AABBs, searchedAabbs holds the AABBs of the last pair search
+//when no AABB changed, sortState[1] stays 0 and the pairs of that search are still valid
+__kernel void   detectMovedAabbsKernel( __global const btAabbCL* allAabbs, __global btAabbCL* searchedAabbs, __global int* sortState, int numObjects)
+{
+	int i = get_global_id(0);
+	if (i>=numObjects)
+		return;
+	
+	btAabbCL aabb = allAabbs[i];
+	btAabbCL searched = searchedAabbs[i];
+	if (aabb.m_min.x!=searched.m_min.x || aabb.m_min.y!=searched.m_min.y || aabb.m_min.z!=searched.m_min.z ||
+		aabb.m_max.x!=searched.m_max.x || aabb.m_max.y!=searched.m_max.y || aabb.m_max.z!=searched.m_max.z)
+	{
+		searchedAabbs[i] = aabb;
+		sortState[1] = 1;
+	}
+}
+
+//one odd-even transposition pass (a parallel insertion sort step), phase 0 compares (0,1),(2,3).. and phase 1 compares (1,2),(3,4)..
+//if two consecutive passes swap nothing, the sort data is sorted
+__kernel void   oddEvenSortPassKernel( __global int2* sortData, __global int* swapped, int numObjects, int phase, int reportSwaps)
+{
+	int i = get_global_id(0)*2+phase;
+	if (i+1>=numObjects)
+		return;
+	
+	int2 a = sortData[i];
+	int2 b = sortData[i+1];
+	if ((unsigned int)a.x > (unsigned int)b.x)
+	{
+		sortData[i] = b;
+		sortData[i+1] = a;
+		if (reportSwaps)
+			swapped[0] = 1;
+	}
+}
+
+//pair deltas: the pairs of one frame are put in an open addressing hash table, holding pair indices (-1 is empty)
+int pairHash(int a, int b, int hashMask);
+int pairHash(int a, int b, int hashMask)
+{
+	unsigned int h = ((unsigned int)a*73856093u) ^ ((unsigned int)b*19349663u);
+	return (int)(h & (unsigned int)hashMask);
+}
+
+__kernel void   clearPairHashKernel( __global int* hashTable, int hashSize)
+{
+	int i = get_global_id(0);
+	if (i>=hashSize)
+		return;
+	hashTable[i] = -1;
+}
+
+__kernel void   insertPairHashKernel( __global const int4* pairs, volatile __global int* hashTable, int numPairs, int hashMask)
+{
+	int i = get_global_id(0);
+	if (i>=numPairs)
+		return;
+	
+	int a = min(pairs[i].x,pairs[i].y);
+	int b = max(pairs[i].x,pairs[i].y);
+	int slot = pairHash(a,b,hashMask);
+	while (atomic_cmpxchg(&hashTable[slot],-1,i)!=-1)
+	{
+		slot = (slot+1) & hashMask;
+	}
+}
+
+//writes the pairs that are not in the hash table of the other frame
+__kernel void   findMissingPairsKernel( __global const int4* pairs, __global const int4* otherPairs, __global const int* otherHashTable, __global int2* missingPairsOut, volatile __global int* missingCount, int numPairs, int hashMask)
+{
+	int i = get_global_id(0);
+	if (i>=numPairs)
+		return;
+	
+	int a = min(pairs[i].x,pairs[i].y);
+	int b = max(pairs[i].x,pairs[i].y);
+	int slot = pairHash(a,b,hashMask);
+	int other = otherHashTable[slot];
+	while (other!=-1)
+	{
+		int4 otherPair = otherPairs[other];
+		if (min(otherPair.x,otherPair.y)==a && max(otherPair.x,otherPair.y)==b)
+			return;
+		slot = (slot+1) & hashMask;
+		other = otherHashTable[slot];
+	}
+	
+	int curMissing = atomic_inc(missingCount);
+	missingPairsOut[curMissing] = (int2)(a,b);
+}
@@ -56,7 +56,24 @@ static const char* sapCL =
 	"	overlap = (aabb1->m_min.y > aabb2->m_max.y || aabb1->m_max.y < aabb2->m_min.y) ? false : overlap;\n"
 	"	return overlap;\n"
 	"}\n"
-	"__kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAabbs, __global const int* unsortedAabbMapping,  __global const int* unsortedAabbMapping2, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numUnsortedAabbs, int numUnSortedAabbs2, int axis, int maxPairs)\n"
+	"#ifndef B3_COLLISION_FILTER_H\n"
+	"#define B3_COLLISION_FILTER_H\n"
+	"#ifndef B3_INT2_H\n"
+	"#define B3_INT2_H\n"
+	"#ifdef __cplusplus\n"
+	"#else\n"
+	"#define b3UnsignedInt2 uint2\n"
+	"#define b3Int2 int2\n"
+	"#define b3MakeInt2 (int2)\n"
+	"#endif //__cplusplus\n"
+	"#endif\n"
+	"//the collision filters hold the group (x) and the mask (y) per user index, a pair is only reported if each group is in the other mask\n"
+	"inline bool b3NeedsCollision(b3Int2 filterA, b3Int2 filterB)\n"
+	"{\n"
+	"	return (filterA.x & filterB.y) && (filterB.x & filterA.y);\n"
+	"}\n"
+	"#endif  //B3_COLLISION_FILTER_H\n"
+	"__kernel void   computePairsKernelTwoArrays( __global const btAabbCL* unsortedAabbs, __global const int* unsortedAabbMapping,  __global const int* unsortedAabbMapping2, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numUnsortedAabbs, int numUnSortedAabbs2, int axis, int maxPairs)\n"
 	"{\n"
 	"	int i = get_global_id(0);\n"
 	"	if (i>=numUnsortedAabbs)\n"
@@ -66,7 +83,7 @@ static const char* sapCL =
 	"		return;\n"
 	"	__global const btAabbCL* unsortedAabbPtr = &unsortedAabbs[unsortedAabbMapping[i]];\n"
 	"	__global const btAabbCL* unsortedAabbPtr2 = &unsortedAabbs[unsortedAabbMapping2[j]];\n"
-	"	if (TestAabbAgainstAabb2GlobalGlobal(unsortedAabbPtr,unsortedAabbPtr2))\n"
+	"	if (TestAabbAgainstAabb2GlobalGlobal(unsortedAabbPtr,unsortedAabbPtr2) && b3NeedsCollision(collisionFilters[unsortedAabbPtr[0].m_minIndices[3]], collisionFilters[unsortedAabbPtr2[0].m_minIndices[3]]))\n"
 	"	{\n"
 	"		int4 myPair;\n"
 	"		\n"
@@ -90,14 +107,14 @@ static const char* sapCL =
 	"		}\n"
 	"	}\n"
 	"}\n"
-	"__kernel void   computePairsKernelBruteForce( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)\n"
+	"__kernel void   computePairsKernelBruteForce( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)\n"
 	"{\n"
 	"	int i = get_global_id(0);\n"
 	"	if (i>=numObjects)\n"
 	"		return;\n"
 	"	for (int j=i+1;j<numObjects;j++)\n"
 	"	{\n"
-	"		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))\n"
+	"		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))\n"
 	"		{\n"
 	"			int4 myPair;\n"
 	"			myPair.x = aabbs[i].m_minIndices[3];\n"
@@ -112,7 +129,7 @@ static const char* sapCL =
 	"		}\n"
 	"	}\n"
 	"}\n"
-	"__kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)\n"
+	"__kernel void   computePairsKernelOriginal( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)\n"
 	"{\n"
 	"	int i = get_global_id(0);\n"
 	"	if (i>=numObjects)\n"
@@ -123,7 +140,7 @@ static const char* sapCL =
 	"		{\n"
 	"			break;\n"
 	"		}\n"
-	"		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))\n"
+	"		if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))\n"
 	"		{\n"
 	"			int4 myPair;\n"
 	"			myPair.x = aabbs[i].m_minIndices[3];\n"
@@ -138,7 +155,7 @@ static const char* sapCL =
 	"		}\n"
 	"	}\n"
 	"}\n"
-	"__kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)\n"
+	"__kernel void   computePairsKernelBarrier( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)\n"
 	"{\n"
 	"	int i = get_global_id(0);\n"
 	"	int localId = get_local_id(0);\n"
@@ -181,7 +198,7 @@ static const char* sapCL =
 	"		\n"
 	"		if (!localBreak)\n"
 	"		{\n"
-	"			if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]))\n"
+	"			if (TestAabbAgainstAabb2GlobalGlobal(&aabbs[i],&aabbs[j]) && b3NeedsCollision(collisionFilters[aabbs[i].m_minIndices[3]], collisionFilters[aabbs[j].m_minIndices[3]]))\n"
 	"			{\n"
 	"				int4 myPair;\n"
 	"				myPair.x = aabbs[i].m_minIndices[3];\n"
@@ -198,7 +215,7 @@ static const char* sapCL =
 	"		j++;\n"
 	"	} while (breakRequest[0]<numActiveWgItems[0]);\n"
 	"}\n"
-	"__kernel void   computePairsKernelLocalSharedMemory( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, int numObjects, int axis, int maxPairs)\n"
+	"__kernel void   computePairsKernelLocalSharedMemory( __global const btAabbCL* aabbs, volatile __global int4* pairsOut,volatile  __global int* pairCount, __global const int2* collisionFilters, int numObjects, int axis, int maxPairs)\n"
 	"{\n"
 	"	int i = get_global_id(0);\n"
 	"	int localId = get_local_id(0);\n"
@@ -254,7 +271,7 @@ static const char* sapCL =
 	"		\n"
 	"		if (!localBreak)\n"
 	"		{\n"
-	"			if (TestAabbAgainstAabb2(&myAabb,&localAabbs[localCount+localId+1]))\n"
+	"			if (TestAabbAgainstAabb2(&myAabb,&localAabbs[localCount+localId+1]) && b3NeedsCollision(collisionFilters[myAabb.m_minIndices[3]], collisionFilters[localAabbs[localCount+localId+1].m_minIndices[3]]))\n"
 	"			{\n"
 	"				int4 myPair;\n"
 	"				myPair.x = myAabb.m_minIndices[3];\n"
@@ -338,4 +355,99 @@ static const char* sapCL =
 	"	s = (smallAabb.m_max+smallAabb.m_min)*0.5f;\n"
 	"	sum[i]=s;\n"
 	"	sum2[i]=s*s;	\n"
+	"}\n"
+	"//incremental sort: refresh the keys of last frame's sorted order, it stays (nearly) sorted while the bodies barely move\n"
+	"__kernel void   refreshSortKeysKernel( __global const btAabbCL* allAabbs, __global const int* smallAabbMapping, __global int2* sortData, int numObjects, int axis)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numObjects)\n"
+	"		return;\n"
+	"	\n"
+	"	sortData[i].x = FloatFlip(allAabbs[smallAabbMapping[sortData[i].y]].m_minElems[axis]);\n"
+	"}\n"
+	"//resting and sleeping bodies keep their AABBs, searchedAabbs holds the AABBs of the last pair search\n"
+	"//when no AABB changed, sortState[1] stays 0 and the pairs of that search are still valid\n"
+	"__kernel void   detectMovedAabbsKernel( __global const btAabbCL* allAabbs, __global btAabbCL* searchedAabbs, __global int* sortState, int numObjects)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numObjects)\n"
+	"		return;\n"
+	"	\n"
+	"	btAabbCL aabb = allAabbs[i];\n"
+	"	btAabbCL searched = searchedAabbs[i];\n"
+	"	if (aabb.m_min.x!=searched.m_min.x || aabb.m_min.y!=searched.m_min.y || aabb.m_min.z!=searched.m_min.z ||\n"
+	"		aabb.m_max.x!=searched.m_max.x || aabb.m_max.y!=searched.m_max.y || aabb.m_max.z!=searched.m_max.z)\n"
+	"	{\n"
+	"		searchedAabbs[i] = aabb;\n"
+	"		sortState[1] = 1;\n"
+	"	}\n"
+	"}\n"
+	"//one odd-even transposition pass (a parallel insertion sort step), phase 0 compares (0,1),(2,3).. and phase 1 compares (1,2),(3,4)..\n"
+	"//if two consecutive passes swap nothing, the sort data is sorted\n"
+	"__kernel void   oddEvenSortPassKernel( __global int2* sortData, __global int* swapped, int numObjects, int phase, int reportSwaps)\n"
+	"{\n"
+	"	int i = get_global_id(0)*2+phase;\n"
+	"	if (i+1>=numObjects)\n"
+	"		return;\n"
+	"	\n"
+	"	int2 a = sortData[i];\n"
+	"	int2 b = sortData[i+1];\n"
+	"	if ((unsigned int)a.x > (unsigned int)b.x)\n"
+	"	{\n"
+	"		sortData[i] = b;\n"
+	"		sortData[i+1] = a;\n"
+	"		if (reportSwaps)\n"
+	"			swapped[0] = 1;\n"
+	"	}\n"
+	"}\n"
+	"//pair deltas: the pairs of one frame are put in an open addressing hash table, holding pair indices (-1 is empty)\n"
+	"int pairHash(int a, int b, int hashMask);\n"
+	"int pairHash(int a, int b, int hashMask)\n"
+	"{\n"
+	"	unsigned int h = ((unsigned int)a*73856093u) ^ ((unsigned int)b*19349663u);\n"
+	"	return (int)(h & (unsigned int)hashMask);\n"
+	"}\n"
+	"__kernel void   clearPairHashKernel( __global int* hashTable, int hashSize)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=hashSize)\n"
+	"		return;\n"
+	"	hashTable[i] = -1;\n"
+	"}\n"
+	"__kernel void   insertPairHashKernel( __global const int4* pairs, volatile __global int* hashTable, int numPairs, int hashMask)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numPairs)\n"
+	"		return;\n"
+	"	\n"
+	"	int a = min(pairs[i].x,pairs[i].y);\n"
+	"	int b = max(pairs[i].x,pairs[i].y);\n"
+	"	int slot = pairHash(a,b,hashMask);\n"
+	"	while (atomic_cmpxchg(&hashTable[slot],-1,i)!=-1)\n"
+	"	{\n"
+	"		slot = (slot+1) & hashMask;\n"
+	"	}\n"
+	"}\n"
+	"//writes the pairs that are not in the hash table of the other frame\n"
+	"__kernel void   findMissingPairsKernel( __global const int4* pairs, __global const int4* otherPairs, __global const int* otherHashTable, __global int2* missingPairsOut, volatile __global int* missingCount, int numPairs, int hashMask)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i>=numPairs)\n"
+	"		return;\n"
+	"	\n"
+	"	int a = min(pairs[i].x,pairs[i].y);\n"
+	"	int b = max(pairs[i].x,pairs[i].y);\n"
+	"	int slot = pairHash(a,b,hashMask);\n"
+	"	int other = otherHashTable[slot];\n"
+	"	while (other!=-1)\n"
+	"	{\n"
+	"		int4 otherPair = otherPairs[other];\n"
+	"		if (min(otherPair.x,otherPair.y)==a && max(otherPair.x,otherPair.y)==b)\n"
+	"			return;\n"
+	"		slot = (slot+1) & hashMask;\n"
+	"		other = otherHashTable[slot];\n"
+	"	}\n"
+	"	\n"
+	"	int curMissing = atomic_inc(missingCount);\n"
+	"	missingPairsOut[curMissing] = (int2)(a,b);\n"
 	"}\n";
@@ -26,15 +26,14 @@ subject to the following restrictions:
 #else
 #include <OpenCL/cl.h>
 #include <OpenCL/cl_ext.h>  //clLogMessagesToStderrAPPLE
+#include <OpenCL/cl_gl.h>
 #endif
 #else
 #ifdef USE_MINICL
 #include <MiniCL/cl.h>
 #else
 #include <CL/cl.h>
-#ifdef _WIN32
 #include "CL/cl_gl.h"
-#endif  //_WIN32
 #endif
 #endif  //__APPLE__
 #endif  //B3_USE_CLEW
@@ -42,9 +42,18 @@ bool gDebugSkipLoadingBinary = false;
 #define b3Assert assert
 #ifndef _WIN32
 #include <sys/stat.h>
-
+#include <unistd.h>
 #endif
 
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::atomic<int> b3AtomicCounter;
+
 static const char* sCachedBinaryPath = "cache";
 
 //Set the preferred platform vendor using the OpenCL SDK
@@ -225,7 +234,7 @@ cl_context b3OpenCLUtils_createContextFromPlatform(cl_platform_id platform, cl_d
 	cps[0] = CL_CONTEXT_PLATFORM;
 	cps[1] = (cl_context_properties)platform;
 #ifdef _WIN32
-#ifndef B3_USE_CLEW
+	//clew declares the cl_khr_gl_sharing entry points too
 	if (pGLContext && pGLDC)
 	{
 		cps[2] = CL_GL_CONTEXT_KHR;
@@ -233,7 +242,6 @@ cl_context b3OpenCLUtils_createContextFromPlatform(cl_platform_id platform, cl_d
 		cps[4] = CL_WGL_HDC_KHR;
 		cps[5] = (cl_context_properties)pGLDC;
 	}
-#endif  //B3_USE_CLEW
 #endif  //_WIN32
 	num_entries = B3_MAX_CL_DEVICES;
 
@@ -561,369 +569,488 @@ void b3OpenCLUtils_printDeviceInfo(cl_device_id device)
 			 info.m_vecWidthChar, info.m_vecWidthShort, info.m_vecWidthInt, info.m_vecWidthLong, info.m_vecWidthFloat, info.m_vecWidthDouble);
 }
 
-static const char* strip2(const char* name, const char* pattern)
+//64 bit FNV-1a hash, used as the key of the cached program binaries
+static unsigned long long b3HashBytes(unsigned long long hash, const void* data, size_t numBytes)
 {
-	size_t const patlen = strlen(pattern);
-	size_t patcnt = 0;
-	const char* oriptr;
-	const char* patloc;
-	// find how many times the pattern occurs in the original string
-	for (oriptr = name; (patloc = strstr(oriptr, pattern)); oriptr = patloc + patlen)
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < numBytes; i++)
 	{
-		patcnt++;
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
 	}
-	return oriptr;
+	return hash;
 }
 
-cl_program b3OpenCLUtils_compileCLProgramFromString(cl_context clContext, cl_device_id device, const char* kernelSourceOrg, cl_int* pErrNum, const char* additionalMacrosArg, const char* clFileNameForCaching, bool disableBinaryCaching)
+static unsigned long long b3HashString(unsigned long long hash, const char* str)
 {
-	const char* additionalMacros = additionalMacrosArg ? additionalMacrosArg : "";
+	//include the terminating zero, so consecutive strings cannot alias
+	return b3HashBytes(hash, str, strlen(str) + 1);
+}
+
+//the cached binary is only valid for the same kernel source, build options, device and driver,
+//so all of them are part of the key. Bump the version string when the file format changes.
+static unsigned long long b3GetProgramKey(cl_device_id device, const char* kernelSource, const char* compileFlags)
+{
+	char deviceName[256] = {0};
+	char deviceVendor[256] = {0};
+	char deviceVersion[256] = {0};
+	char driverVersion[256] = {0};
+	clGetDeviceInfo(device, CL_DEVICE_NAME, sizeof(deviceName) - 1, deviceName, NULL);
+	clGetDeviceInfo(device, CL_DEVICE_VENDOR, sizeof(deviceVendor) - 1, deviceVendor, NULL);
+	clGetDeviceInfo(device, CL_DEVICE_VERSION, sizeof(deviceVersion) - 1, deviceVersion, NULL);
+	clGetDeviceInfo(device, CL_DRIVER_VERSION, sizeof(driverVersion) - 1, driverVersion, NULL);
+
+	unsigned long long hash = 14695981039346656037ULL;
+	hash = b3HashString(hash, "b3OpenCLProgramCache1");
+	hash = b3HashString(hash, kernelSource);
+	hash = b3HashString(hash, compileFlags);
+	hash = b3HashString(hash, deviceName);
+	hash = b3HashString(hash, deviceVendor);
+	hash = b3HashString(hash, deviceVersion);
+	hash = b3HashString(hash, driverVersion);
+	return hash;
+}
+
+static void b3GetProgramCacheFileName(unsigned long long hash, char* binaryFileName)
+{
+#ifdef _MSC_VER
+	sprintf_s(binaryFileName, B3_MAX_STRING_LENGTH, "%s/%016llx.bin", sCachedBinaryPath, hash);
+#else
+	snprintf(binaryFileName, B3_MAX_STRING_LENGTH, "%s/%016llx.bin", sCachedBinaryPath, hash);
+#endif
+}
 
-	if (disableBinaryCaching)
+static cl_program b3LoadProgramBinary(cl_context clContext, cl_device_id device, const char* binaryFileName, const char* compileFlags)
+{
+#ifdef _MSC_VER
+	FILE* file;
+	if (fopen_s(&file, binaryFileName, "rb") != 0)
+		file = 0;
+#else
+	FILE* file = fopen(binaryFileName, "rb");
+#endif
+	if (!file)
 	{
-		//kernelSourceOrg = 0;
+		b3Printf("No cached binary: %s\n", binaryFileName);
+		return 0;
 	}
 
-	cl_program m_cpProgram = 0;
-	cl_int status;
+	fseek(file, 0L, SEEK_END);
+	long fileSize = ftell(file);
+	rewind(file);
+	if (fileSize <= 0)
+	{
+		fclose(file);
+		return 0;
+	}
+	size_t binarySize = (size_t)fileSize;
+	unsigned char* binary = (unsigned char*)malloc(binarySize);
+	size_t bytesRead = fread(binary, 1, binarySize, file);
+	fclose(file);
 
-	char binaryFileName[B3_MAX_STRING_LENGTH];
+	cl_program program = 0;
+	if (bytesRead == binarySize)
+	{
+		cl_int binaryStatus = CL_SUCCESS;
+		cl_int status = CL_SUCCESS;
+		program = clCreateProgramWithBinary(clContext, 1, &device, &binarySize, (const unsigned char**)&binary, &binaryStatus, &status);
+		if (status == CL_SUCCESS && binaryStatus == CL_SUCCESS)
+		{
+			status = clBuildProgram(program, 1, &device, compileFlags, 0, 0);
+		}
+		else if (status == CL_SUCCESS)
+		{
+			status = binaryStatus;
+		}
+
+		if (status != CL_SUCCESS)
+		{
+			//a stale or damaged binary is not fatal, the program is compiled from source instead
+			b3Warning("clBuildProgram reported failure on cached binary: %s, compiling from source\n", binaryFileName);
+			if (program)
+				clReleaseProgram(program);
+			program = 0;
+		}
+		else
+		{
+			b3Printf("clBuildProgram successfully compiled cached binary: %s\n", binaryFileName);
+		}
+	}
+	free(binary);
+	return program;
+}
 
-	char deviceName[256];
-	char driverVersion[256];
-	const char* strippedName;
-	int fileUpToDate = 0;
+//writes to a temporary file first and renames it, so concurrent writers and readers never see a partial binary
+static void b3SaveProgramBinary(cl_program program, const char* binaryFileName)
+{
+	static b3AtomicCounter sTempFileCounter;
+
+	cl_uint numAssociatedDevices = 0;
+	cl_int status = clGetProgramInfo(program, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &numAssociatedDevices, 0);
+	if (status != CL_SUCCESS || numAssociatedDevices != 1)
+		return;
+
+	size_t binarySize = 0;
+	status = clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, 0);
+	if (status != CL_SUCCESS || binarySize == 0)
+		return;
+
+	char* binary = (char*)malloc(sizeof(char) * binarySize);
+	status = clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(char*), &binary, 0);
+	if (status == CL_SUCCESS)
+	{
 #ifdef _WIN32
-	int binaryFileValid = 0;
+		CreateDirectoryA(sCachedBinaryPath, 0);
+		int processId = (int)GetCurrentProcessId();
+#else
+		mkdir(sCachedBinaryPath, 0777);
+		int processId = (int)getpid();
 #endif
-	if (!disableBinaryCaching && clFileNameForCaching)
-	{
-		clGetDeviceInfo(device, CL_DEVICE_NAME, 256, &deviceName, NULL);
-		clGetDeviceInfo(device, CL_DRIVER_VERSION, 256, &driverVersion, NULL);
+		char tempFileName[B3_MAX_STRING_LENGTH + 64];
+#ifdef _MSC_VER
+		sprintf_s(tempFileName, sizeof(tempFileName), "%s.%d.%d.tmp", binaryFileName, processId, ++sTempFileCounter);
+		FILE* file = 0;
+		if (fopen_s(&file, tempFileName, "wb") != 0)
+			file = 0;
+#else
+		snprintf(tempFileName, sizeof(tempFileName), "%s.%d.%d.tmp", binaryFileName, processId, ++sTempFileCounter);
+		FILE* file = fopen(tempFileName, "wb");
+#endif
+		if (file)
+		{
+			bool written = fwrite(binary, sizeof(char), binarySize, file) == binarySize;
+			written = (fclose(file) == 0) && written;
+#ifdef _WIN32
+			bool renamed = written && MoveFileExA(tempFileName, binaryFileName, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			bool renamed = written && rename(tempFileName, binaryFileName) == 0;
+#endif
+			if (!renamed)
+			{
+				remove(tempFileName);
+				b3Warning("cannot write file %s\n", binaryFileName);
+			}
+		}
+		else
+		{
+			b3Warning("cannot write file %s\n", tempFileName);
+		}
+	}
+	free(binary);
+}
+
+//returns the build options for clBuildProgram, to be released with free
+static char* b3CreateCompileFlags(const char* additionalMacrosArg)
+{
+	const char* additionalMacros = additionalMacrosArg ? additionalMacrosArg : "";
 
-		strippedName = strip2(clFileNameForCaching, "\\");
-		strippedName = strip2(strippedName, "/");
+#ifdef MAC  //or __APPLE__?
+	const char* flags = "-cl-mad-enable -DMAC ";
+#else
+	const char* flags = "";
+#endif
 
+	int flagsize = sizeof(char) * (strlen(additionalMacros) + strlen(flags) + 5);
+	char* compileFlags = (char*)malloc(flagsize);
 #ifdef _MSC_VER
-		sprintf_s(binaryFileName, B3_MAX_STRING_LENGTH, "%s/%s.%s.%s.bin", sCachedBinaryPath, strippedName, deviceName, driverVersion);
+	sprintf_s(compileFlags, flagsize, "%s %s", flags, additionalMacros);
 #else
-		sprintf(binaryFileName, "%s/%s.%s.%s.bin", sCachedBinaryPath, strippedName, deviceName, driverVersion);
+	sprintf(compileFlags, "%s %s", flags, additionalMacros);
 #endif
-	}
-	if (clFileNameForCaching && !(disableBinaryCaching || gDebugSkipLoadingBinary || gDebugForceLoadingFromSource))
-	{
-#ifdef _WIN32
-		char* bla = 0;
+	return compileFlags;
+}
 
-		//printf("searching for %s\n", binaryFileName);
+struct b3ProgramBuildResult
+{
+	cl_program m_program;
+	cl_int m_errNum;
+};
 
-		FILETIME modtimeBinary;
-		CreateDirectoryA(sCachedBinaryPath, 0);
+//programs started by b3OpenCLUtils_compileCLProgramsAsync, kept until b3OpenCLUtils_releasePendingPrograms
+//so every compileCLProgramFromString of the same program gets the finished build
+struct b3PendingProgram
+{
+	cl_context m_context;
+	cl_device_id m_device;
+	unsigned long long m_key;
+	std::shared_future<b3ProgramBuildResult> m_result;
+};
+
+static std::mutex sPendingProgramsMutex;
+static std::vector<b3PendingProgram> sPendingPrograms;
+
+//waits for the build of a matching pending program, returns false if there is none
+//the caller gets its own reference of the program, the pending entry keeps one until it is released
+static bool b3ClaimPendingProgram(cl_context clContext, cl_device_id device, unsigned long long key, b3ProgramBuildResult* resultOut)
+{
+	std::shared_future<b3ProgramBuildResult> result;
+	{
+		std::lock_guard<std::mutex> lock(sPendingProgramsMutex);
+		for (size_t i = 0; i < sPendingPrograms.size(); i++)
 		{
-			HANDLE binaryFileHandle = CreateFileA(binaryFileName, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-			if (binaryFileHandle == INVALID_HANDLE_VALUE)
+			const b3PendingProgram& pending = sPendingPrograms[i];
+			if (pending.m_context == clContext && pending.m_device == device && pending.m_key == key)
 			{
-				DWORD errorCode;
-				errorCode = GetLastError();
-				switch (errorCode)
-				{
-					case ERROR_FILE_NOT_FOUND:
-					{
-						b3Warning("\nCached file not found %s\n", binaryFileName);
-						break;
-					}
-					case ERROR_PATH_NOT_FOUND:
-					{
-						b3Warning("\nCached file path not found %s\n", binaryFileName);
-						break;
-					}
-					default:
-					{
-						b3Warning("\nFailed reading cached file with errorCode = %d\n", errorCode);
-					}
-				}
+				result = pending.m_result;
+				break;
 			}
-			else
+		}
+	}
+	if (!result.valid())
+		return false;
+
+	*resultOut = result.get();
+	if (resultOut->m_program)
+		clRetainProgram(resultOut->m_program);
+	return true;
+}
+
+static cl_program b3CompileProgram(cl_context clContext, cl_device_id device, const char* kernelSourceOrg, cl_int* pErrNum, const char* additionalMacros, const char* clFileNameForCaching, bool disableBinaryCaching, bool claimPendingProgram)
+{
+	cl_program m_cpProgram = 0;
+	cl_int localErrNum = CL_SUCCESS;
+
+	const char* kernelSource = kernelSourceOrg;
+	char* kernelSrcFromFile = 0;
+
+	if (!kernelSourceOrg || gDebugForceLoadingFromSource)
+	{
+		if (clFileNameForCaching)
+		{
+			FILE* file = fopen(clFileNameForCaching, "rb");
+			//in many cases the relative path is a few levels up the directory hierarchy, so try it
+			if (!file)
 			{
-				if (GetFileTime(binaryFileHandle, NULL, NULL, &modtimeBinary) == 0)
+				const char* prefix[] = {"../", "../../", "../../../", "../../../../"};
+				for (int i = 0; !file && i < 3; i++)
 				{
-					DWORD errorCode;
-					errorCode = GetLastError();
-					b3Warning("\nGetFileTime errorCode = %d\n", errorCode);
+					char relativeFileName[1024];
+					sprintf(relativeFileName, "%s%s", prefix[i], clFileNameForCaching);
+					file = fopen(relativeFileName, "rb");
 				}
-				else
-				{
-					binaryFileValid = 1;
-				}
-				CloseHandle(binaryFileHandle);
 			}
 
-			if (binaryFileValid)
+			if (file)
 			{
-				HANDLE srcFileHandle = CreateFileA(clFileNameForCaching, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-
-				if (srcFileHandle == INVALID_HANDLE_VALUE)
-				{
-					const char* prefix[] = {"./", "../", "../../", "../../../", "../../../../"};
-					for (int i = 0; (srcFileHandle == INVALID_HANDLE_VALUE) && i < 5; i++)
-					{
-						char relativeFileName[1024];
-						sprintf(relativeFileName, "%s%s", prefix[i], clFileNameForCaching);
-						srcFileHandle = CreateFileA(relativeFileName, GENERIC_READ, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
-					}
-				}
-
-				if (srcFileHandle != INVALID_HANDLE_VALUE)
-				{
-					FILETIME modtimeSrc;
-					if (GetFileTime(srcFileHandle, NULL, NULL, &modtimeSrc) == 0)
-					{
-						DWORD errorCode;
-						errorCode = GetLastError();
-						b3Warning("\nGetFileTime errorCode = %d\n", errorCode);
-					}
-					if ((modtimeSrc.dwHighDateTime < modtimeBinary.dwHighDateTime) || ((modtimeSrc.dwHighDateTime == modtimeBinary.dwHighDateTime) && (modtimeSrc.dwLowDateTime <= modtimeBinary.dwLowDateTime)))
-					{
-						fileUpToDate = 1;
-					}
-					else
-					{
-						b3Warning("\nCached binary file out-of-date (%s)\n", binaryFileName);
-					}
-					CloseHandle(srcFileHandle);
-				}
-				else
-				{
-#ifdef _DEBUG
-					DWORD errorCode;
-					errorCode = GetLastError();
-					switch (errorCode)
-					{
-						case ERROR_FILE_NOT_FOUND:
-						{
-							b3Warning("\nSrc file not found %s\n", clFileNameForCaching);
-							break;
-						}
-						case ERROR_PATH_NOT_FOUND:
-						{
-							b3Warning("\nSrc path not found %s\n", clFileNameForCaching);
-							break;
-						}
-						default:
-						{
-							b3Warning("\nnSrc file reading errorCode = %d\n", errorCode);
-						}
-					}
-
-					//we should make sure the src file exists so we can verify the timestamp with binary
-					//					assert(0);
-					b3Warning("Warning: cannot find OpenCL kernel %s to verify timestamp of binary cached kernel %s\n", clFileNameForCaching, binaryFileName);
-					fileUpToDate = true;
-#else
-					//if we cannot find the source, assume it is OK in release builds
-					fileUpToDate = true;
-#endif
-				}
+				fseek(file, 0L, SEEK_END);
+				int kernelSize = ftell(file);
+				rewind(file);
+				kernelSrcFromFile = (char*)malloc(kernelSize + 1);
+				int readBytes;
+				readBytes = fread((void*)kernelSrcFromFile, 1, kernelSize, file);
+				kernelSrcFromFile[kernelSize] = 0;
+				fclose(file);
+				kernelSource = kernelSrcFromFile;
 			}
 		}
+	}
 
-#else
-		fileUpToDate = true;
-		if (mkdir(sCachedBinaryPath, 0777) == -1)
-		{
-		}
-		else
+	char* compileFlags = b3CreateCompileFlags(additionalMacros);
+	unsigned long long key = kernelSource ? b3GetProgramKey(device, kernelSource, compileFlags) : 0;
+
+	//a build of the same program started by b3OpenCLUtils_compileCLProgramsAsync is waited for instead of repeated
+	b3ProgramBuildResult pendingResult;
+	if (kernelSource && claimPendingProgram && b3ClaimPendingProgram(clContext, device, key, &pendingResult))
+	{
+		free(compileFlags);
+		free(kernelSrcFromFile);
+		if (pErrNum)
+			*pErrNum = pendingResult.m_errNum;
+		return pendingResult.m_program;
+	}
+
+	//the cache is keyed by the content, so programs embedded as strings are cached as well
+	char binaryFileName[B3_MAX_STRING_LENGTH];
+	bool useBinaryCache = !disableBinaryCaching && kernelSource;
+	if (useBinaryCache)
+	{
+		b3GetProgramCacheFileName(key, binaryFileName);
+		if (!(gDebugSkipLoadingBinary || gDebugForceLoadingFromSource))
 		{
-			b3Printf("Succesfully created cache directory: %s\n", sCachedBinaryPath);
+			m_cpProgram = b3LoadProgramBinary(clContext, device, binaryFileName, compileFlags);
 		}
-#endif  //_WIN32
 	}
 
-	if (fileUpToDate)
+	if (!m_cpProgram)
 	{
-#ifdef _MSC_VER
-		FILE* file;
-		if (fopen_s(&file, binaryFileName, "rb") != 0)
-			file = 0;
-#else
-		FILE* file = fopen(binaryFileName, "rb");
-#endif
+		size_t program_length = kernelSource ? strlen(kernelSource) : 0;
 
-		if (file)
+		m_cpProgram = clCreateProgramWithSource(clContext, 1, (const char**)&kernelSource, &program_length, &localErrNum);
+		if (localErrNum == CL_SUCCESS)
 		{
-			size_t binarySize = 0;
-			char* binary = 0;
-
-			fseek(file, 0L, SEEK_END);
-			binarySize = ftell(file);
-			rewind(file);
-			binary = (char*)malloc(sizeof(char) * binarySize);
-			int bytesRead;
-			bytesRead = fread(binary, sizeof(char), binarySize, file);
-			fclose(file);
-
-			m_cpProgram = clCreateProgramWithBinary(clContext, 1, &device, &binarySize, (const unsigned char**)&binary, 0, &status);
-			b3Assert(status == CL_SUCCESS);
-			status = clBuildProgram(m_cpProgram, 1, &device, additionalMacros, 0, 0);
-			b3Assert(status == CL_SUCCESS);
-
-			if (status != CL_SUCCESS)
+			localErrNum = clBuildProgram(m_cpProgram, 1, &device, compileFlags, NULL, NULL);
+			if (localErrNum != CL_SUCCESS)
 			{
 				char* build_log;
 				size_t ret_val_size;
 				clGetProgramBuildInfo(m_cpProgram, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &ret_val_size);
 				build_log = (char*)malloc(sizeof(char) * (ret_val_size + 1));
 				clGetProgramBuildInfo(m_cpProgram, device, CL_PROGRAM_BUILD_LOG, ret_val_size, build_log, NULL);
+
+				// to be carefully, terminate with \0
+				// there's no information in the reference whether the string is 0 terminated or not
 				build_log[ret_val_size] = '\0';
-				b3Error("%s\n", build_log);
+
+				b3Error("Error in clBuildProgram, Line %u in file %s, Log: \n%s\n !!!\n\n", __LINE__, __FILE__, build_log);
 				free(build_log);
-				b3Assert(0);
+				clReleaseProgram(m_cpProgram);
 				m_cpProgram = 0;
-
-				b3Warning("clBuildProgram reported failure on cached binary: %s\n", binaryFileName);
 			}
-			else
+			else if (useBinaryCache)
 			{
-				b3Printf("clBuildProgram successfully compiled cached binary: %s\n", binaryFileName);
+				b3SaveProgramBinary(m_cpProgram, binaryFileName);
 			}
-			free(binary);
 		}
 		else
 		{
-			b3Warning("Cannot open cached binary: %s\n", binaryFileName);
+			m_cpProgram = 0;
 		}
 	}
 
-	if (!m_cpProgram)
+	free(compileFlags);
+	free(kernelSrcFromFile);
+
+	if (pErrNum)
+		*pErrNum = localErrNum;
+	return m_cpProgram;
+}
+
+cl_program b3OpenCLUtils_compileCLProgramFromString(cl_context clContext, cl_device_id device, const char* kernelSourceOrg, cl_int* pErrNum, const char* additionalMacros, const char* clFileNameForCaching, bool disableBinaryCaching)
+{
+	return b3CompileProgram(clContext, device, kernelSourceOrg, pErrNum, additionalMacros, clFileNameForCaching, disableBinaryCaching, true);
+}
+
+static b3ProgramBuildResult b3BuildPendingProgram(cl_context clContext, cl_device_id device, std::string kernelSource, std::string additionalMacros, std::string fileName)
+{
+	b3ProgramBuildResult result;
+	result.m_errNum = CL_SUCCESS;
+	result.m_program = b3CompileProgram(clContext, device, kernelSource.c_str(), &result.m_errNum, additionalMacros.c_str(), fileName.empty() ? 0 : fileName.c_str(), false, false);
+	return result;
+}
+
+void b3OpenCLUtils_compileCLProgramsAsync(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms)
+{
+	for (int i = 0; i < numPrograms; i++)
 	{
-		cl_int localErrNum;
-		char* compileFlags;
-		int flagsize;
+		const b3OpenCLProgramSource& src = programs[i];
+		if (!src.m_kernelSource)
+			continue;
+
+		char* compileFlags = b3CreateCompileFlags(src.m_additionalMacros);
+		b3PendingProgram pending;
+		pending.m_context = clContext;
+		pending.m_device = device;
+		pending.m_key = b3GetProgramKey(device, src.m_kernelSource, compileFlags);
+		free(compileFlags);
 
-		const char* kernelSource = kernelSourceOrg;
+		//one thread per program, most of the time is spent inside clBuildProgram of the driver
+		std::string kernelSource = src.m_kernelSource;
+		std::string additionalMacros = src.m_additionalMacros ? src.m_additionalMacros : "";
+		std::string fileName = src.m_srcFileNameForCaching ? src.m_srcFileNameForCaching : "";
+		pending.m_result = std::async(std::launch::async, b3BuildPendingProgram, clContext, device, kernelSource, additionalMacros, fileName).share();
+
+		std::lock_guard<std::mutex> lock(sPendingProgramsMutex);
+		sPendingPrograms.push_back(pending);
+	}
+}
 
-		if (!kernelSourceOrg || gDebugForceLoadingFromSource)
+void b3OpenCLUtils_releasePendingPrograms(cl_context clContext)
+{
+	std::vector<b3PendingProgram> programs;
+	{
+		std::lock_guard<std::mutex> lock(sPendingProgramsMutex);
+		for (size_t i = 0; i < sPendingPrograms.size();)
 		{
-			if (clFileNameForCaching)
+			if (sPendingPrograms[i].m_context == clContext)
 			{
-				FILE* file = fopen(clFileNameForCaching, "rb");
-				//in many cases the relative path is a few levels up the directory hierarchy, so try it
-				if (!file)
-				{
-					const char* prefix[] = {"../", "../../", "../../../", "../../../../"};
-					for (int i = 0; !file && i < 3; i++)
-					{
-						char relativeFileName[1024];
-						sprintf(relativeFileName, "%s%s", prefix[i], clFileNameForCaching);
-						file = fopen(relativeFileName, "rb");
-					}
-				}
-
-				if (file)
-				{
-					char* kernelSrc = 0;
-					fseek(file, 0L, SEEK_END);
-					int kernelSize = ftell(file);
-					rewind(file);
-					kernelSrc = (char*)malloc(kernelSize + 1);
-					int readBytes;
-					readBytes = fread((void*)kernelSrc, 1, kernelSize, file);
-					kernelSrc[kernelSize] = 0;
-					fclose(file);
-					kernelSource = kernelSrc;
-				}
+				programs.push_back(sPendingPrograms[i]);
+				sPendingPrograms.erase(sPendingPrograms.begin() + i);
+			}
+			else
+			{
+				i++;
 			}
 		}
+	}
+	for (size_t i = 0; i < programs.size(); i++)
+	{
+		b3ProgramBuildResult result = programs[i].m_result.get();
+		if (result.m_program)
+			clReleaseProgram(result.m_program);
+	}
+}
 
-		size_t program_length = kernelSource ? strlen(kernelSource) : 0;
-#ifdef MAC  //or __APPLE__?
-		char* flags = "-cl-mad-enable -DMAC ";
-#else
-		const char* flags = "";
-#endif
-
-		m_cpProgram = clCreateProgramWithSource(clContext, 1, (const char**)&kernelSource, &program_length, &localErrNum);
-		if (localErrNum != CL_SUCCESS)
+struct b3CompileProgramsTask
+{
+	cl_context m_context;
+	cl_device_id m_device;
+	const b3OpenCLProgramSource* m_programs;
+	cl_program* m_programsOut;
+	int m_numPrograms;
+	b3AtomicCounter m_nextProgram;
+	b3AtomicCounter m_numFailed;
+};
+
+static void b3CompileProgramsWorker(b3CompileProgramsTask* task)
+{
+	for (int i = task->m_nextProgram++; i < task->m_numPrograms; i = task->m_nextProgram++)
+	{
+		const b3OpenCLProgramSource& src = task->m_programs[i];
+		cl_int errNum = CL_SUCCESS;
+		cl_program program = b3OpenCLUtils_compileCLProgramFromString(task->m_context, task->m_device, src.m_kernelSource, &errNum, src.m_additionalMacros, src.m_srcFileNameForCaching, false);
+		if (!program || errNum != CL_SUCCESS)
 		{
-			if (pErrNum)
-				*pErrNum = localErrNum;
-			return 0;
+			task->m_numFailed++;
 		}
-
-		// Build the program with 'mad' Optimization option
-
-		flagsize = sizeof(char) * (strlen(additionalMacros) + strlen(flags) + 5);
-		compileFlags = (char*)malloc(flagsize);
-#ifdef _MSC_VER
-		sprintf_s(compileFlags, flagsize, "%s %s", flags, additionalMacros);
-#else
-		sprintf(compileFlags, "%s %s", flags, additionalMacros);
-#endif
-		localErrNum = clBuildProgram(m_cpProgram, 1, &device, compileFlags, NULL, NULL);
-		if (localErrNum != CL_SUCCESS)
+		if (task->m_programsOut)
 		{
-			char* build_log;
-			size_t ret_val_size;
-			clGetProgramBuildInfo(m_cpProgram, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &ret_val_size);
-			build_log = (char*)malloc(sizeof(char) * (ret_val_size + 1));
-			clGetProgramBuildInfo(m_cpProgram, device, CL_PROGRAM_BUILD_LOG, ret_val_size, build_log, NULL);
-
-			// to be carefully, terminate with \0
-			// there's no information in the reference whether the string is 0 terminated or not
-			build_log[ret_val_size] = '\0';
-
-			b3Error("Error in clBuildProgram, Line %u in file %s, Log: \n%s\n !!!\n\n", __LINE__, __FILE__, build_log);
-			free(build_log);
-			if (pErrNum)
-				*pErrNum = localErrNum;
-			return 0;
+			task->m_programsOut[i] = program;
 		}
-
-		if (!disableBinaryCaching && clFileNameForCaching)
-		{  //	write to binary
-
-			cl_uint numAssociatedDevices;
-			status = clGetProgramInfo(m_cpProgram, CL_PROGRAM_NUM_DEVICES, sizeof(cl_uint), &numAssociatedDevices, 0);
-			b3Assert(status == CL_SUCCESS);
-			if (numAssociatedDevices == 1)
-			{
-				size_t binarySize;
-				char* binary;
-
-				status = clGetProgramInfo(m_cpProgram, CL_PROGRAM_BINARY_SIZES, sizeof(size_t), &binarySize, 0);
-				b3Assert(status == CL_SUCCESS);
-
-				binary = (char*)malloc(sizeof(char) * binarySize);
-
-				status = clGetProgramInfo(m_cpProgram, CL_PROGRAM_BINARIES, sizeof(char*), &binary, 0);
-				b3Assert(status == CL_SUCCESS);
-
-				{
-					FILE* file = 0;
-#ifdef _MSC_VER
-					if (fopen_s(&file, binaryFileName, "wb") != 0)
-						file = 0;
-#else
-					file = fopen(binaryFileName, "wb");
-#endif
-					if (file)
-					{
-						fwrite(binary, sizeof(char), binarySize, file);
-						fclose(file);
-					}
-					else
-					{
-						b3Warning("cannot write file %s\n", binaryFileName);
-					}
-				}
-
-				free(binary);
-			}
+		else if (program)
+		{
+			clReleaseProgram(program);
 		}
+	}
+}
 
-		free(compileFlags);
+int b3OpenCLUtils_compileCLProgramsFromStrings(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms, cl_program* programsOut, int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
 	}
-	return m_cpProgram;
+	if (numThreads > numPrograms)
+	{
+		numThreads = numPrograms;
+	}
+	if (numThreads < 1)
+	{
+		numThreads = 1;
+	}
+
+	b3CompileProgramsTask task;
+	task.m_context = clContext;
+	task.m_device = device;
+	task.m_programs = programs;
+	task.m_programsOut = programsOut;
+	task.m_numPrograms = numPrograms;
+	task.m_nextProgram = 0;
+	task.m_numFailed = 0;
+
+	//OpenCL API calls (other than clSetKernelArg) are thread-safe, so the programs are built concurrently
+	int numWorkers = numThreads - 1;
+	std::thread* workers = numWorkers ? new std::thread[numWorkers] : 0;
+	for (int i = 0; i < numWorkers; i++)
+	{
+		workers[i] = std::thread(b3CompileProgramsWorker, &task);
+	}
+	b3CompileProgramsWorker(&task);
+	for (int i = 0; i < numWorkers; i++)
+	{
+		workers[i].join();
+	}
+	delete[] workers;
+	return task.m_numFailed;
 }
 
 cl_kernel b3OpenCLUtils_compileCLKernelFromString(cl_context clContext, cl_device_id device, const char* kernelSource, const char* kernelName, cl_int* pErrNum, cl_program prog, const char* additionalMacros)
@@ -41,8 +41,32 @@ extern "C"
 	cl_kernel b3OpenCLUtils_compileCLKernelFromString(cl_context clContext, cl_device_id device, const char* kernelSource, const char* kernelName, cl_int* pErrNum, cl_program prog, const char* additionalMacros);
 
 	//optional
+	///unless disableBinaryCaching is set, the program binary is cached in the cache path, keyed by a hash of
+	///the kernel source, build options, device and driver version (so it also works for kernels embedded as strings)
 	cl_program b3OpenCLUtils_compileCLProgramFromString(cl_context clContext, cl_device_id device, const char* kernelSource, cl_int* pErrNum, const char* additionalMacros, const char* srcFileNameForCaching, bool disableBinaryCaching);
 
+	typedef struct
+	{
+		const char* m_kernelSource;
+		const char* m_additionalMacros;
+		const char* m_srcFileNameForCaching;
+	} b3OpenCLProgramSource;
+
+	///compiles numPrograms programs concurrently on numThreads threads (0 uses all hardware threads), for example to warm up the binary cache
+	///programsOut is optional and receives the programs, in the same order, to be released with clReleaseProgram
+	///returns the number of programs that failed to compile
+	int b3OpenCLUtils_compileCLProgramsFromStrings(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms, cl_program* programsOut, int numThreads);
+
+	///starts building the programs in the background, one thread per program, and returns immediately
+	///every later b3OpenCLUtils_compileCLProgramFromString of the same source and macros waits for that build instead of starting
+	///its own, and gets its own reference to the program, which the caller releases as usual
+	void b3OpenCLUtils_compileCLProgramsAsync(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms);
+
+	///each background build of clContext keeps one reference to its program, whether it was claimed or not
+	///waits for those builds and releases that reference, the references of the claimers stay valid
+	///afterwards the builds are no longer shared, call it before releasing the context
+	void b3OpenCLUtils_releasePendingPrograms(cl_context clContext);
+
 	//the following optional APIs provide access using specific platform information
 	int b3OpenCLUtils_getNumPlatforms(cl_int* pErrNum);
 
@@ -153,6 +177,21 @@ struct b3OpenCLUtils
 		return b3OpenCLUtils_compileCLProgramFromString(clContext, device, kernelSource, pErrNum, additionalMacros, srcFileNameForCaching, disableBinaryCaching);
 	}
 
+	static inline int compileCLProgramsFromStrings(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms, cl_program* programsOut = 0, int numThreads = 0)
+	{
+		return b3OpenCLUtils_compileCLProgramsFromStrings(clContext, device, programs, numPrograms, programsOut, numThreads);
+	}
+
+	static inline void compileCLProgramsAsync(cl_context clContext, cl_device_id device, const b3OpenCLProgramSource* programs, int numPrograms)
+	{
+		b3OpenCLUtils_compileCLProgramsAsync(clContext, device, programs, numPrograms);
+	}
+
+	static inline void releasePendingPrograms(cl_context clContext)
+	{
+		b3OpenCLUtils_releasePendingPrograms(clContext);
+	}
+
 	//the following optional APIs provide access using specific platform information
 	static inline int getNumPlatforms(cl_int* pErrNum = 0)
 	{
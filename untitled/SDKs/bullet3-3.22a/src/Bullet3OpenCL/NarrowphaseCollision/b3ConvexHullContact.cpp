@@ -24,6 +24,8 @@ bool clipConvexFacesAndFindContactsCPU = false;   //false;//true;
 bool reduceConcaveContactsOnGPU = true;           //false;
 bool reduceConvexContactsOnGPU = true;            //false;
 bool findConvexClippingFacesGPU = true;
+bool sortPairsByShapeTypeGPU = true;  //sort the pairs by shape types and hull complexity, and launch each contact kernel only on its range of pairs
+int minNumPairsToSort = 512;          //below this the sort costs more than the divergence it saves
 bool useGjk = false;          ///option for CPU/host testing, when findSeparatingAxisOnGpu = false
 bool useGjkContacts = false;  //////option for CPU/host testing when findSeparatingAxisOnGpu = false
 
@@ -56,6 +58,7 @@ typedef b3AlignedObjectArray<b3Vector3> b3VertexArray;
 #include <float.h>  //for FLT_MAX
 #include "Bullet3OpenCL/Initialize/b3OpenCLUtils.h"
 #include "Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3FillCL.h"
 //#include "AdlQuaternion.h"
 
 #include "kernels/satKernels.h"
@@ -66,6 +69,7 @@ typedef b3AlignedObjectArray<b3Vector3> b3VertexArray;
 #include "kernels/satClipHullContacts.h"
 #include "kernels/bvhTraversal.h"
 #include "kernels/primitiveContacts.h"
+#include "kernels/pairClassification.h"
 
 #include "Bullet3Geometry/b3AabbUtil.h"
 
@@ -77,6 +81,7 @@ typedef b3AlignedObjectArray<b3Vector3> b3VertexArray;
 #define BT_NARROWPHASE_CLIPHULL_PATH "src/Bullet3OpenCL/NarrowphaseCollision/kernels/satClipHullContacts.cl"
 #define BT_NARROWPHASE_BVH_TRAVERSAL_PATH "src/Bullet3OpenCL/NarrowphaseCollision/kernels/bvhTraversal.cl"
 #define BT_NARROWPHASE_PRIMITIVE_CONTACT_PATH "src/Bullet3OpenCL/NarrowphaseCollision/kernels/primitiveContacts.cl"
+#define BT_NARROWPHASE_PAIR_CLASSIFICATION_PATH "src/Bullet3OpenCL/NarrowphaseCollision/kernels/pairClassification.cl"
 
 #ifndef __global
 #define __global
@@ -117,7 +122,14 @@ GpuSatCollision::GpuSatCollision(cl_context ctx, cl_device_id device, cl_command
 	  m_gpuCompoundSepNormals(m_context, m_queue),
 	  m_gpuHasCompoundSepNormals(m_context, m_queue),
 
-	  m_numCompoundPairsOut(m_context, m_queue)
+	  m_numCompoundPairsOut(m_context, m_queue),
+	  m_pairSortData(m_context, m_queue),
+	  m_sortedPairs(m_context, m_queue),
+	  m_pairClassRangesGPU(m_context, m_queue),
+	  m_numContactsRequired(0),
+	  m_numCompoundPairsRequired(0),
+	  m_numTriConvexPairsRequired(0),
+	  m_maxInternalEdgeAngle(-1.f)
 {
 	m_totalContactsOut.push_back(0);
 
@@ -260,6 +272,26 @@ GpuSatCollision::GpuSatCollision(cl_context ctx, cl_device_id device, cl_command
 		b3Assert(errNum == CL_SUCCESS);
 		b3Assert(m_processCompoundPairsPrimitivesKernel);
 	}
+
+	{
+		const char* pairClassificationSrc = pairClassificationKernelsCL;
+		cl_program pairClassificationProg = b3OpenCLUtils::compileCLProgramFromString(m_context, m_device, pairClassificationSrc, &errNum, "", BT_NARROWPHASE_PAIR_CLASSIFICATION_PATH);
+		b3Assert(errNum == CL_SUCCESS);
+
+		m_classifyPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, pairClassificationSrc, "classifyPairsKernel", &errNum, pairClassificationProg);
+		b3Assert(errNum == CL_SUCCESS);
+		m_gatherSortedPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, pairClassificationSrc, "gatherSortedPairsKernel", &errNum, pairClassificationProg);
+		b3Assert(errNum == CL_SUCCESS);
+		m_scatterSortedPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, pairClassificationSrc, "scatterSortedPairsKernel", &errNum, pairClassificationProg);
+		b3Assert(errNum == CL_SUCCESS);
+		m_findPairClassRangesKernel = b3OpenCLUtils::compileCLKernelFromString(m_context, m_device, pairClassificationSrc, "findPairClassRangesKernel", &errNum, pairClassificationProg);
+		b3Assert(errNum == CL_SUCCESS);
+		clReleaseProgram(pairClassificationProg);
+	}
+
+	m_pairSorter = new b3RadixSort32CL(m_context, m_device, m_queue);
+	m_fill = new b3FillCL(m_context, m_device, m_queue);
+	m_pairClassRanges.resize(B3_NUM_PAIR_CLASSES);
 }
 
 GpuSatCollision::~GpuSatCollision()
@@ -322,6 +354,18 @@ GpuSatCollision::~GpuSatCollision()
 
 	if (m_bvhTraversalKernel)
 		clReleaseKernel(m_bvhTraversalKernel);
+
+	if (m_classifyPairsKernel)
+		clReleaseKernel(m_classifyPairsKernel);
+	if (m_gatherSortedPairsKernel)
+		clReleaseKernel(m_gatherSortedPairsKernel);
+	if (m_scatterSortedPairsKernel)
+		clReleaseKernel(m_scatterSortedPairsKernel);
+	if (m_findPairClassRangesKernel)
+		clReleaseKernel(m_findPairClassRangesKernel);
+
+	delete m_pairSorter;
+	delete m_fill;
 }
 
 struct MyTriangleCallback : public b3NodeOverlapCallback
@@ -2555,6 +2599,92 @@ int computeContactConvexConvex2(
 	return contactIndex;
 }
 
+bool GpuSatCollision::sortPairs(const b3OpenCLArray<b3Int4>* pairs, int nPairs, const b3OpenCLArray<b3RigidBodyData>* bodyBuf,
+								const b3OpenCLArray<b3Collidable>& gpuCollidables, const b3OpenCLArray<b3ConvexPolyhedronData>& convexData)
+{
+	for (int i = 0; i < B3_NUM_PAIR_CLASSES; i++)
+	{
+		m_pairClassRanges[i] = b3MakeInt2(0, nPairs);
+	}
+
+	if (!sortPairsByShapeTypeGPU || nPairs < minNumPairsToSort)
+		return false;
+
+	B3_PROFILE("sortPairs");
+	B3_GPU_STAGE("pairSort");
+
+	m_pairSortData.resize(nPairs);
+	m_sortedPairs.resize(nPairs);
+
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(pairs->getBufferCL(), true),
+			b3BufferInfoCL(bodyBuf->getBufferCL(), true),
+			b3BufferInfoCL(gpuCollidables.getBufferCL(), true),
+			b3BufferInfoCL(convexData.getBufferCL(), true),
+			b3BufferInfoCL(m_pairSortData.getBufferCL())};
+
+		b3LauncherCL launcher(m_queue, m_classifyPairsKernel, "classifyPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nPairs);
+		launcher.launch1D(nPairs);
+	}
+
+	//class, shape types and cost use the lower 28 bits of the key
+	m_pairSorter->execute(m_pairSortData, 28);
+
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(pairs->getBufferCL(), true),
+			b3BufferInfoCL(m_pairSortData.getBufferCL(), true),
+			b3BufferInfoCL(m_sortedPairs.getBufferCL())};
+
+		b3LauncherCL launcher(m_queue, m_gatherSortedPairsKernel, "gatherSortedPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nPairs);
+		launcher.launch1D(nPairs);
+	}
+
+	{
+		b3AlignedObjectArray<b3Int2> emptyRanges;
+		emptyRanges.resize(B3_NUM_PAIR_CLASSES);
+		for (int i = 0; i < B3_NUM_PAIR_CLASSES; i++)
+		{
+			emptyRanges[i] = b3MakeInt2(0, 0);
+		}
+		m_pairClassRangesGPU.copyFromHost(emptyRanges);
+
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_pairSortData.getBufferCL(), true),
+			b3BufferInfoCL(m_pairClassRangesGPU.getBufferCL())};
+
+		b3LauncherCL launcher(m_queue, m_findPairClassRangesKernel, "findPairClassRangesKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nPairs);
+		launcher.launch1D(nPairs);
+
+		m_pairClassRangesGPU.copyToHost(m_pairClassRanges);
+	}
+	return true;
+}
+
+b3Int2 GpuSatCollision::getPairClassRange(int firstClass, int lastClass) const
+{
+	b3Int2 range = b3MakeInt2(0, 0);
+	bool found = false;
+	for (int i = firstClass; i <= lastClass; i++)
+	{
+		const b3Int2& classRange = m_pairClassRanges[i];
+		if (classRange.y > classRange.x)
+		{
+			range.x = found ? b3Min(range.x, classRange.x) : classRange.x;
+			range.y = found ? b3Max(range.y, classRange.y) : classRange.y;
+			found = true;
+		}
+	}
+	return range;
+}
+
 void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* pairs, int nPairs,
 														const b3OpenCLArray<b3RigidBodyData>* bodyBuf,
 														b3OpenCLArray<b3Contact4>* contactOut, int& nContacts,
@@ -2565,6 +2695,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 														const b3OpenCLArray<b3Vector3>& gpuVertices,
 														const b3OpenCLArray<b3Vector3>& gpuUniqueEdges,
 														const b3OpenCLArray<b3GpuFace>& gpuFaces,
+														const b3OpenCLArray<b3TriangleInfo>& triangleInfos,
 														const b3OpenCLArray<int>& gpuIndices,
 														const b3OpenCLArray<b3Collidable>& gpuCollidables,
 														const b3OpenCLArray<b3GpuChildShape>& gpuChildShapes,
@@ -2589,9 +2720,24 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 {
 	myframecount++;
 
+	m_numContactsRequired = 0;
+	m_numCompoundPairsRequired = 0;
+	m_numTriConvexPairsRequired = 0;
+
 	if (!nPairs)
 		return;
 
+	//the kernels run on the sorted pairs, which go back in broadphase order at the end, with the contact indices
+	b3OpenCLArray<b3Int4>* broadphasePairs = pairs;
+	if (sortPairs(pairs, nPairs, bodyBuf, gpuCollidables, convexData))
+	{
+		pairs = &m_sortedPairs;
+	}
+	b3Int2 convexRange = getPairClassRange(B3_PAIR_CLASS_CONVEX_CONVEX, B3_PAIR_CLASS_CONVEX_CONVEX);
+	b3Int2 primitiveRange = getPairClassRange(B3_PAIR_CLASS_PRIMITIVE, B3_PAIR_CLASS_PRIMITIVE);
+	b3Int2 compoundRange = getPairClassRange(B3_PAIR_CLASS_COMPOUND, B3_PAIR_CLASS_CONCAVE_COMPOUND);
+	b3Int2 concaveRange = getPairClassRange(B3_PAIR_CLASS_CONCAVE_COMPOUND, B3_PAIR_CLASS_CONCAVE);
+
 #ifdef CHECK_ON_HOST
 
 	b3AlignedObjectArray<b3QuantizedBvhNode> treeNodesCPU;
@@ -2769,13 +2915,18 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 			b3LauncherCL launcher(m_queue, m_primitiveContactsKernel, "m_primitiveContactsKernel");
 			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-			launcher.setConst(nPairs);
+			launcher.setConst(primitiveRange.y);
 			launcher.setConst(maxContactCapacity);
-			int num = nPairs;
-			launcher.launch1D(num);
+			launcher.launch1DRange(primitiveRange.x, primitiveRange.y - primitiveRange.x);
 			clFinish(m_queue);
 
 			nContacts = m_totalContactsOut.at(0);
+			if (nContacts > maxContactCapacity)
+			{
+				m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
+				b3Error("Error: contacts exceeds capacity (%d/%d)\n", nContacts, maxContactCapacity);
+				nContacts = maxContactCapacity;
+			}
 			contactOut->resize(nContacts);
 		}
 	}
@@ -2783,10 +2934,20 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 #endif  //CHECK_ON_HOST
 
 	B3_PROFILE("computeConvexConvexContactsGPUSAT");
+	B3_GPU_STAGE("sat");
 	// printf("nContacts = %d\n",nContacts);
 
 	m_sepNormals.resize(nPairs);
 	m_hasSeparatingNormals.resize(nPairs);
+	//the separating axis kernels only visit the convex-convex range, the clipping must skip the other pairs
+	if (convexRange.x > 0)
+	{
+		m_fill->execute(m_hasSeparatingNormals, 0, convexRange.x);
+	}
+	if (convexRange.y < nPairs)
+	{
+		m_fill->execute(m_hasSeparatingNormals, 0, nPairs - convexRange.y, convexRange.y);
+	}
 
 	int concaveCapacity = maxTriConvexPairCapacity;
 	m_concaveSepNormals.resize(concaveCapacity);
@@ -2835,10 +2996,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 						launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 
 						launcher.setConst(maxContactCapacity);
-						launcher.setConst(nPairs);
+						launcher.setConst(convexRange.y);
 
-						int num = nPairs;
-						launcher.launch1D(num);
+						launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 						clFinish(m_queue);
 						/*
 						b3AlignedObjectArray<int>hostHasSepAxis;
@@ -2851,6 +3011,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 						//	printf("nContacts (after mprPenetrationKernel) = %d\n",nContacts);
 						if (nContacts > maxContactCapacity)
 						{
+							m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
 							b3Error("Error: contacts exceeds capacity (%d/%d)\n", nContacts, maxContactCapacity);
 							nContacts = maxContactCapacity;
 						}
@@ -2879,10 +3040,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 							b3LauncherCL launcher(m_queue, m_findSeparatingAxisVertexFaceKernel, "findSeparatingAxisVertexFaceKernel");
 							launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-							launcher.setConst(nPairs);
+							launcher.setConst(convexRange.y);
 
-							int num = nPairs;
-							launcher.launch1D(num);
+							launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 							clFinish(m_queue);
 						}
 
@@ -2910,9 +3070,8 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 							b3LauncherCL launcher(m_queue, m_findSeparatingAxisEdgeEdgeKernel, "findSeparatingAxisEdgeEdgeKernel");
 							launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 							launcher.setConst(numDirections);
-							launcher.setConst(nPairs);
-							int num = nPairs;
-							launcher.launch1D(num);
+							launcher.setConst(convexRange.y);
+							launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 							clFinish(m_queue);
 						}
 					}
@@ -2935,10 +3094,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 						int numDirections = sizeof(unitSphere162) / sizeof(b3Vector3);
 						launcher.setConst(numDirections);
 
-						launcher.setConst(nPairs);
+						launcher.setConst(convexRange.y);
 
-						int num = nPairs;
-						launcher.launch1D(num);
+						launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 						clFinish(m_queue);
 					}
 				}
@@ -2961,10 +3119,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 				b3LauncherCL launcher(m_queue, m_findSeparatingAxisKernel, "m_findSeparatingAxisKernel");
 				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-				launcher.setConst(nPairs);
+				launcher.setConst(convexRange.y);
 
-				int num = nPairs;
-				launcher.launch1D(num);
+				launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 				clFinish(m_queue);
 			}
 		}
@@ -3308,11 +3465,10 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 			b3LauncherCL launcher(m_queue, m_findCompoundPairsKernel, "m_findCompoundPairsKernel");
 			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-			launcher.setConst(nPairs);
+			launcher.setConst(compoundRange.y);
 			launcher.setConst(compoundPairCapacity);
 
-			int num = nPairs;
-			launcher.launch1D(num);
+			launcher.launch1DRange(compoundRange.x, compoundRange.y - compoundRange.x);
 			clFinish(m_queue);
 
 			numCompoundPairs = m_numCompoundPairsOut.at(0);
@@ -3405,6 +3561,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 		if (numCompoundPairs > compoundPairCapacity)
 		{
+			m_numCompoundPairsRequired = numCompoundPairs;
 			b3Error("Exceeded compound pair capacity (%d/%d)\n", numCompoundPairs, compoundPairCapacity);
 			numCompoundPairs = compoundPairCapacity;
 		}
@@ -3443,6 +3600,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 			//printf("nContacts (after processCompoundPairsPrimitivesKernel) = %d\n",nContacts);
 			if (nContacts > maxContactCapacity)
 			{
+				m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
 				b3Error("Error: contacts exceeds capacity (%d/%d)\n", nContacts, maxContactCapacity);
 				nContacts = maxContactCapacity;
 			}
@@ -3504,10 +3662,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 				launcher.setBuffer(treeNodesGPU->getBufferCL());
 				launcher.setBuffer(bvhInfo->getBufferCL());
 
-				launcher.setConst(nPairs);
+				launcher.setConst(concaveRange.y);
 				launcher.setConst(maxTriConvexPairCapacity);
-				int num = nPairs;
-				launcher.launch1D(num);
+				launcher.launch1DRange(concaveRange.x, concaveRange.y - concaveRange.x);
 				clFinish(m_queue);
 				numConcavePairs = m_numConcavePairsOut.at(0);
 			}
@@ -3573,6 +3730,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 			if (numConcavePairs > maxTriConvexPairCapacity)
 			{
+				m_numTriConvexPairsRequired = numConcavePairs;
 				static int exceeded_maxTriConvexPairCapacity_count = 0;
 				b3Error("Exceeded the maxTriConvexPairCapacity (found %d but max is %d, it happened %d times)\n",
 						numConcavePairs, maxTriConvexPairCapacity, exceeded_maxTriConvexPairCapacity_count++);
@@ -3653,12 +3811,14 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 								b3BufferInfoCL(worldVertsA1GPU.getBufferCL()),
 								b3BufferInfoCL(worldNormalsAGPU.getBufferCL()),
 								b3BufferInfoCL(worldVertsB1GPU.getBufferCL()),
-								b3BufferInfoCL(m_dmins.getBufferCL())};
+								b3BufferInfoCL(m_dmins.getBufferCL()),
+								b3BufferInfoCL(triangleInfos.getBufferCL(), true)};
 
 							b3LauncherCL launcher(m_queue, m_findConcaveSeparatingAxisEdgeEdgeKernel, "m_findConcaveSeparatingAxisEdgeEdgeKernel");
 							launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 							launcher.setConst(vertexFaceCapacity);
 							launcher.setConst(numConcavePairs);
+							launcher.setConst(m_maxInternalEdgeAngle);
 
 							int num = numConcavePairs;
 							launcher.launch1D(num);
@@ -3686,12 +3846,14 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 							b3BufferInfoCL(clippingFacesOutGPU.getBufferCL()),
 							b3BufferInfoCL(worldVertsA1GPU.getBufferCL()),
 							b3BufferInfoCL(worldNormalsAGPU.getBufferCL()),
-							b3BufferInfoCL(worldVertsB1GPU.getBufferCL())};
+							b3BufferInfoCL(worldVertsB1GPU.getBufferCL()),
+							b3BufferInfoCL(triangleInfos.getBufferCL(), true)};
 
 						b3LauncherCL launcher(m_queue, m_findConcaveSeparatingAxisKernel, "m_findConcaveSeparatingAxisKernel");
 						launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 						launcher.setConst(vertexFaceCapacity);
 						launcher.setConst(numConcavePairs);
+						launcher.setConst(m_maxInternalEdgeAngle);
 
 						int num = numConcavePairs;
 						launcher.launch1D(num);
@@ -3813,6 +3975,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 			if (nContacts >= maxContactCapacity)
 			{
+				m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
 				b3Error("Error: contacts exceeds capacity (%d/%d)\n", nContacts, maxContactCapacity);
 				nContacts = maxContactCapacity;
 			}
@@ -3827,6 +3990,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 
 	if (contactClippingOnGpu)
 	{
+		B3_GPU_STAGE("clipping");
 		m_totalContactsOut.copyFromHostPointer(&nContacts, 1, 0, true);
 		//		printf("nContacts3 = %d\n",nContacts);
 
@@ -4087,9 +4251,8 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 					b3LauncherCL launcher(m_queue, m_findClippingFacesKernel, "m_findClippingFacesKernel");
 					launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 					launcher.setConst(vertexFaceCapacity);
-					launcher.setConst(nPairs);
-					int num = nPairs;
-					launcher.launch1D(num);
+					launcher.setConst(convexRange.y);
+					launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 					clFinish(m_queue);
 				}
 				else
@@ -4240,11 +4403,10 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 						launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 						launcher.setConst(vertexFaceCapacity);
 
-						launcher.setConst(nPairs);
+						launcher.setConst(convexRange.y);
 						int debugMode = 0;
 						launcher.setConst(debugMode);
-						int num = nPairs;
-						launcher.launch1D(num);
+						launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 						clFinish(m_queue);
 					}
 
@@ -4274,10 +4436,9 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 								launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
 								launcher.setConst(vertexFaceCapacity);
 								launcher.setConst(newContactCapacity);
-								launcher.setConst(nPairs);
-								int num = nPairs;
+								launcher.setConst(convexRange.y);
 
-								launcher.launch1D(num);
+								launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 							}
 							nContacts = m_totalContactsOut.at(0);
 							contactOut->resize(nContacts);
@@ -4348,16 +4509,16 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 						b3BufferInfoCL(m_totalContactsOut.getBufferCL())};
 					b3LauncherCL launcher(m_queue, m_clipHullHullKernel, "m_clipHullHullKernel");
 					launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
-					launcher.setConst(nPairs);
+					launcher.setConst(convexRange.y);
 					launcher.setConst(maxContactCapacity);
 
-					int num = nPairs;
-					launcher.launch1D(num);
+					launcher.launch1DRange(convexRange.x, convexRange.y - convexRange.x);
 					clFinish(m_queue);
 
 					nContacts = m_totalContactsOut.at(0);
 					if (nContacts >= maxContactCapacity)
 					{
+						m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
 						b3Error("Exceeded contact capacity (%d/%d)\n", nContacts, maxContactCapacity);
 						nContacts = maxContactCapacity;
 					}
@@ -4395,6 +4556,7 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 				nContacts = m_totalContactsOut.at(0);
 				if (nContacts > maxContactCapacity)
 				{
+					m_numContactsRequired = b3Max(m_numContactsRequired, nContacts);
 					b3Error("Error: contacts exceeds capacity (%d/%d)\n", nContacts, maxContactCapacity);
 					nContacts = maxContactCapacity;
 				}
@@ -4403,6 +4565,20 @@ void GpuSatCollision::computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* p
 		}
 	}  //contactClippingOnGpu
 
+	if (pairs != broadphasePairs)
+	{
+		B3_PROFILE("scatterSortedPairsKernel");
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_sortedPairs.getBufferCL(), true),
+			b3BufferInfoCL(m_pairSortData.getBufferCL(), true),
+			b3BufferInfoCL(broadphasePairs->getBufferCL())};
+
+		b3LauncherCL launcher(m_queue, m_scatterSortedPairsKernel, "scatterSortedPairsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nPairs);
+		launcher.launch1D(nPairs);
+	}
+
 	//printf("nContacts end = %d\n",nContacts);
 
 	//printf("frameCount = %d\n",frameCount++);
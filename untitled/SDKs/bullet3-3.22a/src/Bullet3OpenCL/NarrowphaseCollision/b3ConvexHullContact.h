@@ -3,11 +3,13 @@
 #define _CONVEX_HULL_CONTACT_H
 
 #include "Bullet3OpenCL/ParallelPrimitives/b3OpenCLArray.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3RadixSort32CL.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3RigidBodyData.h"
 #include "Bullet3Common/b3AlignedObjectArray.h"
 
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3ConvexPolyhedronData.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3Collidable.h"
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3TriangleInfo.h"
 #include "Bullet3Collision/NarrowPhaseCollision/b3Contact4.h"
 #include "Bullet3Common/shared/b3Int2.h"
 #include "Bullet3Common/shared/b3Int4.h"
@@ -17,6 +19,20 @@
 
 //#include "../../dynamics/basic_demo/Stubs/ChNarrowPhase.h"
 
+///the pairs are sorted by these classes before the contact kernels run, each kernel only runs on the range of its classes
+///keep in sync with kernels/pairClassification.cl
+enum b3NarrowphasePairClass
+{
+	B3_PAIR_CLASS_CONVEX_CONVEX = 0,
+	B3_PAIR_CLASS_PRIMITIVE,
+	B3_PAIR_CLASS_COMPOUND,
+	B3_PAIR_CLASS_CONCAVE_COMPOUND,
+	B3_PAIR_CLASS_CONCAVE,
+	///pairs of fixed bodies and unsupported shape combinations
+	B3_PAIR_CLASS_NONE,
+	B3_NUM_PAIR_CLASSES
+};
+
 struct GpuSatCollision
 {
 	cl_context m_context;
@@ -52,6 +68,13 @@ struct GpuSatCollision
 
 	cl_kernel m_processCompoundPairsPrimitivesKernel;
 
+	cl_kernel m_classifyPairsKernel;
+	cl_kernel m_gatherSortedPairsKernel;
+	cl_kernel m_scatterSortedPairsKernel;
+	cl_kernel m_findPairClassRangesKernel;
+	class b3RadixSort32CL* m_pairSorter;
+	class b3FillCL* m_fill;
+
 	b3OpenCLArray<b3Vector3> m_unitSphereDirections;
 
 	b3OpenCLArray<int> m_totalContactsOut;
@@ -68,9 +91,30 @@ struct GpuSatCollision
 	b3OpenCLArray<int> m_gpuHasCompoundSepNormals;
 	b3OpenCLArray<int> m_numCompoundPairsOut;
 
+	b3OpenCLArray<b3SortData> m_pairSortData;
+	b3OpenCLArray<b3Int4> m_sortedPairs;
+	b3OpenCLArray<b3Int2> m_pairClassRangesGPU;
+	///first pair and one past the last pair of each b3NarrowphasePairClass in the pairs the kernels run on
+	b3AlignedObjectArray<b3Int2> m_pairClassRanges;
+
+	///counts the last computeConvexConvexContactsGPUSAT call needed but had to drop, because they exceeded the
+	///maxContactCapacity, compoundPairCapacity or maxTriConvexPairCapacity passed in (0 when nothing was dropped)
+	int m_numContactsRequired;
+	int m_numCompoundPairsRequired;
+	int m_numTriConvexPairsRequired;
+
+	///see b3Config::m_maxInternalEdgeAngle, a negative angle turns the internal edge filtering of concave meshes off
+	float m_maxInternalEdgeAngle;
+
 	GpuSatCollision(cl_context ctx, cl_device_id device, cl_command_queue q);
 	virtual ~GpuSatCollision();
 
+	///sorts the pairs into m_sortedPairs and fills m_pairClassRanges, returns false if the pairs are used unsorted
+	bool sortPairs(const b3OpenCLArray<b3Int4>* pairs, int nPairs, const b3OpenCLArray<b3RigidBodyData>* bodyBuf,
+				   const b3OpenCLArray<b3Collidable>& gpuCollidables, const b3OpenCLArray<b3ConvexPolyhedronData>& convexData);
+	///first pair and one past the last pair of the classes firstClass to lastClass, which are contiguous after the sort
+	b3Int2 getPairClassRange(int firstClass, int lastClass) const;
+
 	void computeConvexConvexContactsGPUSAT(b3OpenCLArray<b3Int4>* pairs, int nPairs,
 										   const b3OpenCLArray<b3RigidBodyData>* bodyBuf,
 										   b3OpenCLArray<b3Contact4>* contactOut, int& nContacts,
@@ -81,6 +125,7 @@ struct GpuSatCollision
 										   const b3OpenCLArray<b3Vector3>& vertices,
 										   const b3OpenCLArray<b3Vector3>& uniqueEdges,
 										   const b3OpenCLArray<b3GpuFace>& faces,
+										   const b3OpenCLArray<b3TriangleInfo>& triangleInfos,
 										   const b3OpenCLArray<int>& indices,
 										   const b3OpenCLArray<b3Collidable>& gpuCollidables,
 										   const b3OpenCLArray<b3GpuChildShape>& gpuChildShapes,
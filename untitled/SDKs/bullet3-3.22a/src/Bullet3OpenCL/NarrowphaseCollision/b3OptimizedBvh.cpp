@@ -25,7 +25,7 @@ b3OptimizedBvh::~b3OptimizedBvh()
 {
 }
 
-void b3OptimizedBvh::build(b3StridingMeshInterface* triangles, bool useQuantizedAabbCompression, const b3Vector3& bvhAabbMin, const b3Vector3& bvhAabbMax)
+void b3OptimizedBvh::build(b3StridingMeshInterface* triangles, bool useQuantizedAabbCompression, const b3Vector3& bvhAabbMin, const b3Vector3& bvhAabbMax, int numThreads)
 {
 	m_useQuantization = useQuantizedAabbCompression;
 
@@ -166,9 +166,7 @@ void b3OptimizedBvh::build(b3StridingMeshInterface* triangles, bool useQuantized
 		m_contiguousNodes.resize(2 * numLeafNodes);
 	}
 
-	m_curNodeIndex = 0;
-
-	buildTree(0, numLeafNodes);
+	buildTreeFromLeafNodes(numLeafNodes, numThreads);
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if (m_useQuantization && !m_SubtreeHeaders.size())
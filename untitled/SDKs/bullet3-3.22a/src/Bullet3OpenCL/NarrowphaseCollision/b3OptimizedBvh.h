@@ -35,7 +35,8 @@ public:
 
 	virtual ~b3OptimizedBvh();
 
-	void build(b3StridingMeshInterface * triangles, bool useQuantizedAabbCompression, const b3Vector3& bvhAabbMin, const b3Vector3& bvhAabbMax);
+	///numThreads threads build the quantized tree (0 uses all hardware threads), the result does not depend on it
+	void build(b3StridingMeshInterface * triangles, bool useQuantizedAabbCompression, const b3Vector3& bvhAabbMin, const b3Vector3& bvhAabbMax, int numThreads = 0);
 
 	void refit(b3StridingMeshInterface * triangles, const b3Vector3& aabbMin, const b3Vector3& aabbMax);
 
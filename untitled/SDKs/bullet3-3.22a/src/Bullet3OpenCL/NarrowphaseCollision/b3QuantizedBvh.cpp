@@ -16,6 +16,7 @@ subject to the following restrictions:
 #include "b3QuantizedBvh.h"
 
 #include "Bullet3Geometry/b3AabbUtil.h"
+#include <thread>
 
 #define RAYAABB2
 
@@ -31,7 +32,7 @@ b3QuantizedBvh::b3QuantizedBvh() : m_bulletVersion(B3_BULLET_VERSION),
 	m_bvhAabbMax.setValue(B3_INFINITY, B3_INFINITY, B3_INFINITY);
 }
 
-void b3QuantizedBvh::buildInternal()
+void b3QuantizedBvh::buildInternal(int numThreads)
 {
 	///assumes that caller filled in the m_quantizedLeafNodes
 	m_useQuantization = true;
@@ -45,9 +46,7 @@ void b3QuantizedBvh::buildInternal()
 		m_quantizedContiguousNodes.resize(2 * numLeafNodes);
 	}
 
-	m_curNodeIndex = 0;
-
-	buildTree(0, numLeafNodes);
+	buildTreeFromLeafNodes(numLeafNodes, numThreads);
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if (m_useQuantization && !m_SubtreeHeaders.size())
@@ -175,6 +174,84 @@ void b3QuantizedBvh::buildTree(int startIndex, int endIndex)
 	setInternalNodeEscapeIndex(internalNodeIndex, escapeIndex);
 }
 
+void b3QuantizedBvh::buildTreeFromLeafNodes(int numLeafNodes, int numThreads)
+{
+	if (numThreads <= 0)
+	{
+		numThreads = (int)std::thread::hardware_concurrency();
+	}
+
+	m_curNodeIndex = 0;
+
+	if (!m_useQuantization || numThreads <= 1 || numLeafNodes < B3_MIN_PARALLEL_BUILD_LEAVES)
+	{
+		buildTree(0, numLeafNodes);
+		return;
+	}
+
+	buildTreeParallel(0, numLeafNodes, 0, numThreads);
+	m_curNodeIndex = 2 * numLeafNodes - 1;
+	buildSubtreeHeaders(0);
+}
+
+void b3QuantizedBvh::buildTreeParallel(int startIndex, int endIndex, int nodeIndex, int numThreads)
+{
+	int numIndices = endIndex - startIndex;
+	b3Assert(numIndices > 0);
+
+	if (numIndices == 1)
+	{
+		assignInternalNodeFromLeafNode(nodeIndex, startIndex);
+		return;
+	}
+
+	//the same split as buildTree, so the leaves end up in the same order
+	int splitAxis = calcSplittingAxis(startIndex, endIndex);
+	int splitIndex = sortAndCalcSplittingIndex(startIndex, endIndex, splitAxis);
+
+	setInternalNodeAabbMin(nodeIndex, m_bvhAabbMax);
+	setInternalNodeAabbMax(nodeIndex, m_bvhAabbMin);
+	for (int i = startIndex; i < endIndex; i++)
+	{
+		mergeInternalNodeAabb(nodeIndex, getAabbMin(i), getAabbMax(i));
+	}
+
+	int leftChildNodeIndex = nodeIndex + 1;
+	int rightChildNodeIndex = leftChildNodeIndex + 2 * (splitIndex - startIndex) - 1;
+
+	if (numThreads > 1 && numIndices >= B3_MIN_PARALLEL_BUILD_LEAVES)
+	{
+		//the subtrees write disjoint ranges of the leaf and node arrays
+		int numLeftThreads = numThreads / 2;
+		std::thread leftBuilder(&b3QuantizedBvh::buildTreeParallel, this, startIndex, splitIndex, leftChildNodeIndex, numLeftThreads);
+		buildTreeParallel(splitIndex, endIndex, rightChildNodeIndex, numThreads - numLeftThreads);
+		leftBuilder.join();
+	}
+	else
+	{
+		buildTreeParallel(startIndex, splitIndex, leftChildNodeIndex, 1);
+		buildTreeParallel(splitIndex, endIndex, rightChildNodeIndex, 1);
+	}
+
+	setInternalNodeEscapeIndex(nodeIndex, 2 * numIndices - 1);
+}
+
+//visits the nodes in the order buildTree finishes them, so the headers are added in the same order
+void b3QuantizedBvh::buildSubtreeHeaders(int nodeIndex)
+{
+	const b3QuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode() || node.getEscapeIndex() * static_cast<int>(sizeof(b3QuantizedBvhNode)) <= MAX_SUBTREE_SIZE_IN_BYTES)
+		return;
+
+	int leftChildNodeIndex = nodeIndex + 1;
+	const b3QuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[leftChildNodeIndex];
+	int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+
+	buildSubtreeHeaders(leftChildNodeIndex);
+	buildSubtreeHeaders(rightChildNodeIndex);
+	updateSubtreeHeaders(leftChildNodeIndex, rightChildNodeIndex);
+}
+
 void b3QuantizedBvh::updateSubtreeHeaders(int leftChildNodexIndex, int rightChildNodexIndex)
 {
 	b3Assert(m_useQuantization);
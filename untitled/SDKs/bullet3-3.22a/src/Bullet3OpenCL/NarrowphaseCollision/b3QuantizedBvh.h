@@ -49,6 +49,9 @@ class b3Serializer;
 //Note: currently we have 16 bytes per quantized node
 #define MAX_SUBTREE_SIZE_IN_BYTES 2048
 
+//subtrees with fewer leaves are built by a single thread
+#define B3_MIN_PARALLEL_BUILD_LEAVES 4096
+
 // 10 gives the potential for 1024 parts, with at most 2^21 (2097152) (minus one
 // actually) triangles each (since the sign bit is reserved
 #define MAX_NUM_PARTS_IN_BITS 10
@@ -272,6 +275,14 @@ protected:
 protected:
 	void buildTree(int startIndex, int endIndex);
 
+	///builds the tree of the first numLeafNodes leaves, on numThreads threads for quantized trees (0 uses all hardware threads)
+	///the nodes and subtree headers are the same as the ones of the single threaded buildTree
+	void buildTreeFromLeafNodes(int numLeafNodes, int numThreads);
+	///a subtree of n leaves has 2n-1 nodes, so the right child of nodeIndex is known before the left subtree is built
+	///and both subtrees are built concurrently, the subtree headers are added afterwards by buildSubtreeHeaders
+	void buildTreeParallel(int startIndex, int endIndex, int nodeIndex, int numThreads);
+	void buildSubtreeHeaders(int nodeIndex);
+
 	int calcSplittingAxis(int startIndex, int endIndex);
 
 	int sortAndCalcSplittingIndex(int startIndex, int endIndex, int splitAxis);
@@ -304,7 +315,7 @@ public:
 	void setQuantizationValues(const b3Vector3& bvhAabbMin, const b3Vector3& bvhAabbMax, b3Scalar quantizationMargin = b3Scalar(1.0));
 	QuantizedNodeArray& getLeafNodeArray() { return m_quantizedLeafNodes; }
 	///buildInternal is expert use only: assumes that setQuantizationValues and LeafNodeArray are initialized
-	void buildInternal();
+	void buildInternal(int numThreads = 0);
 	///***************************************** expert/internal use only *************************
 
 	void reportAabbOverlappingNodex(b3NodeOverlapCallback * nodeCallback, const b3Vector3& aabbMin, const b3Vector3& aabbMax) const;
@@ -0,0 +1,188 @@
+//The narrowphase pairs are sorted by pair class, shape type combination and hull complexity before the contact kernels
+//run, so each kernel is launched only on the contiguous range of pairs it handles, and neighbouring work items take
+//the same branches and loop about as often.
+
+#define SHAPE_CONVEX_HULL 3
+#define SHAPE_PLANE 4
+#define SHAPE_CONCAVE_TRIMESH 5
+#define SHAPE_COMPOUND_OF_CONVEX_HULLS 6
+#define SHAPE_SPHERE 7
+
+//keep in sync with b3NarrowphasePairClass in b3ConvexHullContact.h
+#define B3_PAIR_CLASS_CONVEX_CONVEX 0
+#define B3_PAIR_CLASS_PRIMITIVE 1
+#define B3_PAIR_CLASS_COMPOUND 2
+#define B3_PAIR_CLASS_CONCAVE_COMPOUND 3
+#define B3_PAIR_CLASS_CONCAVE 4
+#define B3_PAIR_CLASS_NONE 5
+
+#define B3_PAIR_CLASS_SHIFT 24
+#define B3_PAIR_SHAPE_TYPES_SHIFT 16
+#define B3_PAIR_MAX_COST 0xffff
+
+typedef struct
+{
+	unsigned int m_key;
+	unsigned int m_value;
+} SortData;
+
+typedef struct
+{
+	float4 m_pos;
+	float4 m_quat;
+	float4 m_linVel;
+	float4 m_angVel;
+
+	int m_collidableIdx;
+	float m_invMass;
+	float m_restituitionCoeff;
+	float m_frictionCoeff;
+} Body;
+
+typedef struct
+{
+	int m_numChildShapes;
+	float m_radius;
+	int m_shapeType;
+	int m_shapeIndex;
+} Collidable;
+
+typedef struct
+{
+	float4 m_localCenter;
+	float4 m_extents;
+	float4 mC;
+	float4 mE;
+
+	float m_radius;
+	int m_faceOffset;
+	int m_numFaces;
+	int m_numVertices;
+
+	int m_vertexOffset;
+	int m_uniqueEdgesOffset;
+	int m_numUniqueEdges;
+	int m_unused;
+} ConvexPolyhedron;
+
+int isPrimitiveShape(int shapeType)
+{
+	return shapeType == SHAPE_SPHERE || shapeType == SHAPE_PLANE;
+}
+
+//the pair classes follow the contact kernels: convex-convex pairs go through sat and clipping, the primitive pairs
+//through primitiveContactsKernel, the compound pairs through findCompoundPairsKernel and the concave pairs through
+//bvhTraversalKernel. Concave-compound pairs sit between the compound and concave classes, both kernels see them.
+int getPairClass(int shapeTypeA, int shapeTypeB, int staticPair)
+{
+	int compound = shapeTypeA == SHAPE_COMPOUND_OF_CONVEX_HULLS || shapeTypeB == SHAPE_COMPOUND_OF_CONVEX_HULLS;
+	int concave = shapeTypeA == SHAPE_CONCAVE_TRIMESH || shapeTypeB == SHAPE_CONCAVE_TRIMESH;
+
+	//primitiveContactsKernel does not skip pairs of fixed bodies, so they keep their class
+	if ((isPrimitiveShape(shapeTypeA) && (isPrimitiveShape(shapeTypeB) || shapeTypeB == SHAPE_CONVEX_HULL)) ||
+		(isPrimitiveShape(shapeTypeB) && shapeTypeA == SHAPE_CONVEX_HULL))
+		return B3_PAIR_CLASS_PRIMITIVE;
+
+	//all other kernels skip them
+	if (staticPair)
+		return B3_PAIR_CLASS_NONE;
+
+	if (shapeTypeA == SHAPE_CONVEX_HULL && shapeTypeB == SHAPE_CONVEX_HULL)
+		return B3_PAIR_CLASS_CONVEX_CONVEX;
+	if (compound && concave)
+		return B3_PAIR_CLASS_CONCAVE_COMPOUND;
+	if (compound)
+		return B3_PAIR_CLASS_COMPOUND;
+	if (concave)
+		return B3_PAIR_CLASS_CONCAVE;
+	return B3_PAIR_CLASS_NONE;
+}
+
+//rough number of feature tests of the pair
+int getPairCost(__global const Collidable* collidables, __global const ConvexPolyhedron* convexShapes, int collidableIndexA, int collidableIndexB, int pairClass)
+{
+	int shapeTypeA = collidables[collidableIndexA].m_shapeType;
+	int shapeTypeB = collidables[collidableIndexB].m_shapeType;
+	if (pairClass == B3_PAIR_CLASS_CONVEX_CONVEX)
+	{
+		__global const ConvexPolyhedron* hullA = &convexShapes[collidables[collidableIndexA].m_shapeIndex];
+		__global const ConvexPolyhedron* hullB = &convexShapes[collidables[collidableIndexB].m_shapeIndex];
+		return hullA->m_numFaces * hullB->m_numVertices + hullB->m_numFaces * hullA->m_numVertices + hullA->m_numUniqueEdges * hullB->m_numUniqueEdges;
+	}
+	if (pairClass == B3_PAIR_CLASS_PRIMITIVE)
+	{
+		int cost = 0;
+		if (shapeTypeA == SHAPE_CONVEX_HULL)
+			cost += convexShapes[collidables[collidableIndexA].m_shapeIndex].m_numFaces;
+		if (shapeTypeB == SHAPE_CONVEX_HULL)
+			cost += convexShapes[collidables[collidableIndexB].m_shapeIndex].m_numFaces;
+		return cost;
+	}
+	if (pairClass == B3_PAIR_CLASS_COMPOUND)
+	{
+		int numChildrenA = shapeTypeA == SHAPE_COMPOUND_OF_CONVEX_HULLS ? collidables[collidableIndexA].m_numChildShapes : 1;
+		int numChildrenB = shapeTypeB == SHAPE_COMPOUND_OF_CONVEX_HULLS ? collidables[collidableIndexB].m_numChildShapes : 1;
+		return numChildrenA * numChildrenB;
+	}
+	return 0;
+}
+
+__kernel void classifyPairsKernel(__global const int4* pairs, __global const Body* bodies, __global const Collidable* collidables, __global const ConvexPolyhedron* convexShapes, __global SortData* sortData, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		int bodyIndexA = pairs[i].x;
+		int bodyIndexB = pairs[i].y;
+		int collidableIndexA = bodies[bodyIndexA].m_collidableIdx;
+		int collidableIndexB = bodies[bodyIndexB].m_collidableIdx;
+		int shapeTypeA = collidables[collidableIndexA].m_shapeType;
+		int shapeTypeB = collidables[collidableIndexB].m_shapeType;
+		int staticPair = bodies[bodyIndexA].m_invMass == 0.f && bodies[bodyIndexB].m_invMass == 0.f;
+
+		int pairClass = getPairClass(shapeTypeA, shapeTypeB, staticPair);
+		int cost = min(getPairCost(collidables, convexShapes, collidableIndexA, collidableIndexB, pairClass), B3_PAIR_MAX_COST);
+		//the kernels branch on the order of the shapes too, so the shape types are part of the key in pair order
+		unsigned int shapeTypes = ((shapeTypeA & 0xf) << 4) | (shapeTypeB & 0xf);
+
+		sortData[i].m_key = ((unsigned int)pairClass << B3_PAIR_CLASS_SHIFT) | (shapeTypes << B3_PAIR_SHAPE_TYPES_SHIFT) | (unsigned int)cost;
+		sortData[i].m_value = i;
+	}
+}
+
+__kernel void gatherSortedPairsKernel(__global const int4* pairs, __global const SortData* sortData, __global int4* sortedPairs, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		sortedPairs[i] = pairs[sortData[i].m_value];
+	}
+}
+
+//writes the pairs back in broadphase order, with the contact index the narrowphase stored in z
+__kernel void scatterSortedPairsKernel(__global const int4* sortedPairs, __global const SortData* sortData, __global int4* pairs, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		pairs[sortData[i].m_value] = sortedPairs[i];
+	}
+}
+
+//x is the first sorted pair of the class, y one past its last pair, classes without pairs keep (0,0)
+__kernel void findPairClassRangesKernel(__global const SortData* sortData, __global int2* classRanges, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		unsigned int pairClass = sortData[i].m_key >> B3_PAIR_CLASS_SHIFT;
+		if (i == 0 || (sortData[i - 1].m_key >> B3_PAIR_CLASS_SHIFT) != pairClass)
+		{
+			classRanges[pairClass].x = i;
+		}
+		if (i == numPairs - 1 || (sortData[i + 1].m_key >> B3_PAIR_CLASS_SHIFT) != pairClass)
+		{
+			classRanges[pairClass].y = i + 1;
+		}
+	}
+}
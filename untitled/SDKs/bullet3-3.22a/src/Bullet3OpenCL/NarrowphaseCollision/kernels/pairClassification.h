@@ -0,0 +1,168 @@
+//this file is autogenerated using stringify.bat (premake --stringify) in the build folder of this project
+static const char* pairClassificationKernelsCL =
+	"//The narrowphase pairs are sorted by pair class, shape type combination and hull complexity before the contact kernels\n"
+	"//run, so each kernel is launched only on the contiguous range of pairs it handles, and neighbouring work items take\n"
+	"//the same branches and loop about as often.\n"
+	"#define SHAPE_CONVEX_HULL 3\n"
+	"#define SHAPE_PLANE 4\n"
+	"#define SHAPE_CONCAVE_TRIMESH 5\n"
+	"#define SHAPE_COMPOUND_OF_CONVEX_HULLS 6\n"
+	"#define SHAPE_SPHERE 7\n"
+	"//keep in sync with b3NarrowphasePairClass in b3ConvexHullContact.h\n"
+	"#define B3_PAIR_CLASS_CONVEX_CONVEX 0\n"
+	"#define B3_PAIR_CLASS_PRIMITIVE 1\n"
+	"#define B3_PAIR_CLASS_COMPOUND 2\n"
+	"#define B3_PAIR_CLASS_CONCAVE_COMPOUND 3\n"
+	"#define B3_PAIR_CLASS_CONCAVE 4\n"
+	"#define B3_PAIR_CLASS_NONE 5\n"
+	"#define B3_PAIR_CLASS_SHIFT 24\n"
+	"#define B3_PAIR_SHAPE_TYPES_SHIFT 16\n"
+	"#define B3_PAIR_MAX_COST 0xffff\n"
+	"typedef struct\n"
+	"{\n"
+	"	unsigned int m_key;\n"
+	"	unsigned int m_value;\n"
+	"} SortData;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_pos;\n"
+	"	float4 m_quat;\n"
+	"	float4 m_linVel;\n"
+	"	float4 m_angVel;\n"
+	"	int m_collidableIdx;\n"
+	"	float m_invMass;\n"
+	"	float m_restituitionCoeff;\n"
+	"	float m_frictionCoeff;\n"
+	"} Body;\n"
+	"typedef struct\n"
+	"{\n"
+	"	int m_numChildShapes;\n"
+	"	float m_radius;\n"
+	"	int m_shapeType;\n"
+	"	int m_shapeIndex;\n"
+	"} Collidable;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_localCenter;\n"
+	"	float4 m_extents;\n"
+	"	float4 mC;\n"
+	"	float4 mE;\n"
+	"	float m_radius;\n"
+	"	int m_faceOffset;\n"
+	"	int m_numFaces;\n"
+	"	int m_numVertices;\n"
+	"	int m_vertexOffset;\n"
+	"	int m_uniqueEdgesOffset;\n"
+	"	int m_numUniqueEdges;\n"
+	"	int m_unused;\n"
+	"} ConvexPolyhedron;\n"
+	"int isPrimitiveShape(int shapeType)\n"
+	"{\n"
+	"	return shapeType == SHAPE_SPHERE || shapeType == SHAPE_PLANE;\n"
+	"}\n"
+	"//the pair classes follow the contact kernels: convex-convex pairs go through sat and clipping, the primitive pairs\n"
+	"//through primitiveContactsKernel, the compound pairs through findCompoundPairsKernel and the concave pairs through\n"
+	"//bvhTraversalKernel. Concave-compound pairs sit between the compound and concave classes, both kernels see them.\n"
+	"int getPairClass(int shapeTypeA, int shapeTypeB, int staticPair)\n"
+	"{\n"
+	"	int compound = shapeTypeA == SHAPE_COMPOUND_OF_CONVEX_HULLS || shapeTypeB == SHAPE_COMPOUND_OF_CONVEX_HULLS;\n"
+	"	int concave = shapeTypeA == SHAPE_CONCAVE_TRIMESH || shapeTypeB == SHAPE_CONCAVE_TRIMESH;\n"
+	"	//primitiveContactsKernel does not skip pairs of fixed bodies, so they keep their class\n"
+	"	if ((isPrimitiveShape(shapeTypeA) && (isPrimitiveShape(shapeTypeB) || shapeTypeB == SHAPE_CONVEX_HULL)) ||\n"
+	"		(isPrimitiveShape(shapeTypeB) && shapeTypeA == SHAPE_CONVEX_HULL))\n"
+	"		return B3_PAIR_CLASS_PRIMITIVE;\n"
+	"	//all other kernels skip them\n"
+	"	if (staticPair)\n"
+	"		return B3_PAIR_CLASS_NONE;\n"
+	"	if (shapeTypeA == SHAPE_CONVEX_HULL && shapeTypeB == SHAPE_CONVEX_HULL)\n"
+	"		return B3_PAIR_CLASS_CONVEX_CONVEX;\n"
+	"	if (compound && concave)\n"
+	"		return B3_PAIR_CLASS_CONCAVE_COMPOUND;\n"
+	"	if (compound)\n"
+	"		return B3_PAIR_CLASS_COMPOUND;\n"
+	"	if (concave)\n"
+	"		return B3_PAIR_CLASS_CONCAVE;\n"
+	"	return B3_PAIR_CLASS_NONE;\n"
+	"}\n"
+	"//rough number of feature tests of the pair\n"
+	"int getPairCost(__global const Collidable* collidables, __global const ConvexPolyhedron* convexShapes, int collidableIndexA, int collidableIndexB, int pairClass)\n"
+	"{\n"
+	"	int shapeTypeA = collidables[collidableIndexA].m_shapeType;\n"
+	"	int shapeTypeB = collidables[collidableIndexB].m_shapeType;\n"
+	"	if (pairClass == B3_PAIR_CLASS_CONVEX_CONVEX)\n"
+	"	{\n"
+	"		__global const ConvexPolyhedron* hullA = &convexShapes[collidables[collidableIndexA].m_shapeIndex];\n"
+	"		__global const ConvexPolyhedron* hullB = &convexShapes[collidables[collidableIndexB].m_shapeIndex];\n"
+	"		return hullA->m_numFaces * hullB->m_numVertices + hullB->m_numFaces * hullA->m_numVertices + hullA->m_numUniqueEdges * hullB->m_numUniqueEdges;\n"
+	"	}\n"
+	"	if (pairClass == B3_PAIR_CLASS_PRIMITIVE)\n"
+	"	{\n"
+	"		int cost = 0;\n"
+	"		if (shapeTypeA == SHAPE_CONVEX_HULL)\n"
+	"			cost += convexShapes[collidables[collidableIndexA].m_shapeIndex].m_numFaces;\n"
+	"		if (shapeTypeB == SHAPE_CONVEX_HULL)\n"
+	"			cost += convexShapes[collidables[collidableIndexB].m_shapeIndex].m_numFaces;\n"
+	"		return cost;\n"
+	"	}\n"
+	"	if (pairClass == B3_PAIR_CLASS_COMPOUND)\n"
+	"	{\n"
+	"		int numChildrenA = shapeTypeA == SHAPE_COMPOUND_OF_CONVEX_HULLS ? collidables[collidableIndexA].m_numChildShapes : 1;\n"
+	"		int numChildrenB = shapeTypeB == SHAPE_COMPOUND_OF_CONVEX_HULLS ? collidables[collidableIndexB].m_numChildShapes : 1;\n"
+	"		return numChildrenA * numChildrenB;\n"
+	"	}\n"
+	"	return 0;\n"
+	"}\n"
+	"__kernel void classifyPairsKernel(__global const int4* pairs, __global const Body* bodies, __global const Collidable* collidables, __global const ConvexPolyhedron* convexShapes, __global SortData* sortData, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		int bodyIndexA = pairs[i].x;\n"
+	"		int bodyIndexB = pairs[i].y;\n"
+	"		int collidableIndexA = bodies[bodyIndexA].m_collidableIdx;\n"
+	"		int collidableIndexB = bodies[bodyIndexB].m_collidableIdx;\n"
+	"		int shapeTypeA = collidables[collidableIndexA].m_shapeType;\n"
+	"		int shapeTypeB = collidables[collidableIndexB].m_shapeType;\n"
+	"		int staticPair = bodies[bodyIndexA].m_invMass == 0.f && bodies[bodyIndexB].m_invMass == 0.f;\n"
+	"		int pairClass = getPairClass(shapeTypeA, shapeTypeB, staticPair);\n"
+	"		int cost = min(getPairCost(collidables, convexShapes, collidableIndexA, collidableIndexB, pairClass), B3_PAIR_MAX_COST);\n"
+	"		//the kernels branch on the order of the shapes too, so the shape types are part of the key in pair order\n"
+	"		unsigned int shapeTypes = ((shapeTypeA & 0xf) << 4) | (shapeTypeB & 0xf);\n"
+	"		sortData[i].m_key = ((unsigned int)pairClass << B3_PAIR_CLASS_SHIFT) | (shapeTypes << B3_PAIR_SHAPE_TYPES_SHIFT) | (unsigned int)cost;\n"
+	"		sortData[i].m_value = i;\n"
+	"	}\n"
+	"}\n"
+	"__kernel void gatherSortedPairsKernel(__global const int4* pairs, __global const SortData* sortData, __global int4* sortedPairs, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		sortedPairs[i] = pairs[sortData[i].m_value];\n"
+	"	}\n"
+	"}\n"
+	"//writes the pairs back in broadphase order, with the contact index the narrowphase stored in z\n"
+	"__kernel void scatterSortedPairsKernel(__global const int4* sortedPairs, __global const SortData* sortData, __global int4* pairs, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		pairs[sortData[i].m_value] = sortedPairs[i];\n"
+	"	}\n"
+	"}\n"
+	"//x is the first sorted pair of the class, y one past its last pair, classes without pairs keep (0,0)\n"
+	"__kernel void findPairClassRangesKernel(__global const SortData* sortData, __global int2* classRanges, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		unsigned int pairClass = sortData[i].m_key >> B3_PAIR_CLASS_SHIFT;\n"
+	"		if (i == 0 || (sortData[i - 1].m_key >> B3_PAIR_CLASS_SHIFT) != pairClass)\n"
+	"		{\n"
+	"			classRanges[pairClass].x = i;\n"
+	"		}\n"
+	"		if (i == numPairs - 1 || (sortData[i + 1].m_key >> B3_PAIR_CLASS_SHIFT) != pairClass)\n"
+	"		{\n"
+	"			classRanges[pairClass].y = i + 1;\n"
+	"		}\n"
+	"	}\n"
+	"}\n";
@@ -174,6 +174,7 @@ typedef struct
 
 #include "Bullet3Collision/BroadPhaseCollision/shared/b3Aabb.h"
 #include "Bullet3Common/shared/b3Int2.h"
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3InternalEdgeAxis.h"
 
 
 
@@ -184,6 +185,9 @@ typedef struct
 	int m_numIndices;
 } btGpuFace;
 
+//one per face
+typedef b3TriangleInfo_t TriangleInfo;
+
 #define make_float4 (float4)
 
 
@@ -1729,8 +1733,10 @@ __kernel void   findConcaveSeparatingAxisKernel( __global int4* concavePairs,
 																					__global float4* worldVertsA1GPU,
 																					__global float4*  worldNormalsAGPU,
 																					__global float4* worldVertsB1GPU,
+																					__global const TriangleInfo* triangleInfos,
 																					int vertexFaceCapacity,
-																					int numConcavePairs
+																					int numConcavePairs,
+																					float maxInternalEdgeAngle
 																					)
 {
 
@@ -1970,6 +1976,26 @@ __kernel void   findConcaveSeparatingAxisKernel( __global int4* concavePairs,
 		
 		if (hasSeparatingAxis)
 		{
+			if (maxInternalEdgeAngle >= 0.f)
+			{
+				float4 normalWS = qtRotate(ornA, normal);
+				normalWS.w = 0.f;
+				float4 verticesWS[3];
+				for (int k = 0; k < 3; k++)
+				{
+					verticesWS[k] = transform(&verticesA[k], &posA, &ornA);
+				}
+				TriangleInfo triangleInfo = triangleInfos[convexShapes[shapeIndexA].m_faceOffset + f];
+				//the triangle normal only replaces the axis when the convex still overlaps the triangle along it
+				float4 adjustedAxis;
+				float depth;
+				if (b3AdjustInternalEdgeAxis(sepAxis, normalWS, verticesWS, &triangleInfo, maxInternalEdgeAngle, &adjustedAxis) &&
+					TestSepAxisLocalA(&convexPolyhedronA, &convexShapes[shapeIndexB], posA, ornA, posB, ornB, &adjustedAxis, verticesA, vertices, &depth))
+				{
+					sepAxis = adjustedAxis;
+					dmin = depth;
+				}
+			}
 			sepAxis.w = dmin;
 			concaveSeparatingNormalsOut[pairIdx]=sepAxis;
 			concaveHasSeparatingNormals[i]=1;
@@ -488,12 +488,76 @@ static const char* satConcaveKernelsCL =
 	"#define b3MakeInt2 (int2)\n"
 	"#endif //__cplusplus\n"
 	"#endif\n"
+	"#ifndef B3_INTERNAL_EDGE_AXIS_H\n"
+	"#define B3_INTERNAL_EDGE_AXIS_H\n"
+	"#ifndef B3_FLOAT4_H\n"
+	"#ifdef __cplusplus\n"
+	"#else\n"
+	"#endif\n"
+	"#endif  //B3_FLOAT4_H\n"
+	"#ifndef B3_TRIANGLE_INFO_H\n"
+	"#define B3_TRIANGLE_INFO_H\n"
+	"///the edge has no neighbour triangle (or more than one), contacts at it are never corrected\n"
+	"#define B3_TRIANGLE_EDGE_V0V1_BORDER 1\n"
+	"#define B3_TRIANGLE_EDGE_V1V2_BORDER 2\n"
+	"#define B3_TRIANGLE_EDGE_V2V0_BORDER 4\n"
+	"#define B3_TRIANGLE_EDGE_ALL_BORDERS 7\n"
+	"///edge information of a concave mesh triangle for internal edge filtering, like btTriangleInfo of Bullet 2\n"
+	"///there is one per face (b3GpuFace), the faces of convex hulls have all border flags set\n"
+	"typedef struct b3TriangleInfo b3TriangleInfo_t;\n"
+	"struct b3TriangleInfo\n"
+	"{\n"
+	"	int m_flags;\n"
+	"	///angle in radians at which the neighbour triangle folds away from the plane of this triangle at the edge\n"
+	"	///0 when both are coplanar, negative when it folds towards the back side (a convex edge seen from the front)\n"
+	"	float m_edgeV0V1Angle;\n"
+	"	float m_edgeV1V2Angle;\n"
+	"	float m_edgeV2V0Angle;\n"
+	"};\n"
+	"#endif  //B3_TRIANGLE_INFO_H\n"
+	"//internal edge filtering, like btAdjustInternalEdgeContacts of Bullet 2. The separating axis points from the convex to the\n"
+	"//triangle. When it tilts from the triangle normal towards edges where the neighbour triangle continues the surface, or folds\n"
+	"//away by at most maxInternalEdgeAngle, the neighbour produces the contacts there, so the axis becomes the triangle normal and\n"
+	"//a convex sliding over the mesh does not bump on the edges between its triangles.\n"
+	"//Returns true and writes the triangle normal to adjustedAxis when the axis should be replaced, the caller still has to\n"
+	"//test the new axis against the convex before it uses it.\n"
+	"inline bool b3AdjustInternalEdgeAxis(b3Float4ConstArg sepAxis, b3Float4ConstArg normalWS, const b3Float4* verticesWS, const b3TriangleInfo_t* info, float maxInternalEdgeAngle, b3Float4* adjustedAxis)\n"
+	"{\n"
+	"	if (maxInternalEdgeAngle < 0.f || info->m_flags == B3_TRIANGLE_EDGE_ALL_BORDERS)\n"
+	"		return false;\n"
+	"	b3Float4 towardsConvex = -sepAxis;\n"
+	"	towardsConvex.w = 0.f;\n"
+	"	//the triangles are two sided, the convex is on the side the axis points to\n"
+	"	float side = b3Dot3F4(towardsConvex, normalWS) < 0.f ? -1.f : 1.f;\n"
+	"	b3Float4 sideNormal = normalWS * side;\n"
+	"	if (b3Dot3F4(towardsConvex, sideNormal) > 0.9999f)\n"
+	"		return false;\n"
+	"	float edgeAngles[3];\n"
+	"	edgeAngles[0] = info->m_edgeV0V1Angle;\n"
+	"	edgeAngles[1] = info->m_edgeV1V2Angle;\n"
+	"	edgeAngles[2] = info->m_edgeV2V0Angle;\n"
+	"	for (int k = 0; k < 3; k++)\n"
+	"	{\n"
+	"		b3Float4 edgeNormal = b3Normalized(b3Cross3(verticesWS[(k + 1) % 3] - verticesWS[k], normalWS));\n"
+	"		if (b3Dot3F4(towardsConvex, edgeNormal) > 1e-4f)\n"
+	"		{\n"
+	"			//a border, or an edge that is convex by more than the threshold seen from the side of the convex\n"
+	"			if ((info->m_flags & (B3_TRIANGLE_EDGE_V0V1_BORDER << k)) || -side * edgeAngles[k] > maxInternalEdgeAngle)\n"
+	"				return false;\n"
+	"		}\n"
+	"	}\n"
+	"	*adjustedAxis = -sideNormal;\n"
+	"	return true;\n"
+	"}\n"
+	"#endif  //B3_INTERNAL_EDGE_AXIS_H\n"
 	"typedef struct\n"
 	"{\n"
 	"	float4 m_plane;\n"
 	"	int m_indexOffset;\n"
 	"	int m_numIndices;\n"
 	"} btGpuFace;\n"
+	"//one per face\n"
+	"typedef b3TriangleInfo_t TriangleInfo;\n"
 	"#define make_float4 (float4)\n"
 	"__inline\n"
 	"float4 cross3(float4 a, float4 b)\n"
@@ -1203,8 +1267,10 @@ static const char* satConcaveKernelsCL =
 	"                                                          __global float4*  worldNormalsAGPU,\n"
 	"                                                          __global float4* worldVertsB1GPU,\n"
 	"                                                          __global float* dmins,\n"
+	"                                                          __global const TriangleInfo* triangleInfos,\n"
 	"                                                          int vertexFaceCapacity,\n"
-	"                                                          int numConcavePairs\n"
+	"                                                          int numConcavePairs,\n"
+	"                                                          float maxInternalEdgeAngle\n"
 	"                                                          )\n"
 	"{\n"
 	"    \n"
@@ -1413,6 +1479,26 @@ static const char* satConcaveKernelsCL =
 	"		\n"
 	"		if (hasSeparatingAxis)\n"
 	"		{\n"
+	"			if (maxInternalEdgeAngle >= 0.f)\n"
+	"			{\n"
+	"				float4 normalWS = qtRotate(ornA, normal);\n"
+	"				normalWS.w = 0.f;\n"
+	"				float4 verticesWS[3];\n"
+	"				for (int k = 0; k < 3; k++)\n"
+	"				{\n"
+	"					verticesWS[k] = transform(&verticesA[k], &posA, &ornA);\n"
+	"				}\n"
+	"				TriangleInfo triangleInfo = triangleInfos[convexShapes[shapeIndexA].m_faceOffset + f];\n"
+	"				//the triangle normal only replaces the axis when the convex still overlaps the triangle along it\n"
+	"				float4 adjustedAxis;\n"
+	"				float depth;\n"
+	"				if (b3AdjustInternalEdgeAxis(sepAxis, normalWS, verticesWS, &triangleInfo, maxInternalEdgeAngle, &adjustedAxis) &&\n"
+	"					TestSepAxisLocalA(&convexPolyhedronA, &convexShapes[shapeIndexB], posA, ornA, posB, ornB, &adjustedAxis, verticesA, vertices, &depth))\n"
+	"				{\n"
+	"					sepAxis = adjustedAxis;\n"
+	"					dmin = depth;\n"
+	"				}\n"
+	"			}\n"
 	"			sepAxis.w = dmin;\n"
 	"            dmins[i] = dmin;\n"
 	"			concaveSeparatingNormalsOut[pairIdx]=sepAxis;\n"
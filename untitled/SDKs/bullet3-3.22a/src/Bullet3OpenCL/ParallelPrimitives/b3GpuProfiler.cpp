@@ -0,0 +1,199 @@
+#include "b3GpuProfiler.h"
+#include "Bullet3Common/b3Logging.h"
+#include <stdio.h>
+#include <string.h>
+
+static b3GpuProfiler* gGpuProfiler = 0;
+
+b3GpuProfiler* b3GetGpuProfiler()
+{
+	return gGpuProfiler;
+}
+
+void b3SetGpuProfiler(b3GpuProfiler* profiler)
+{
+	gGpuProfiler = profiler;
+}
+
+b3GpuProfiler::b3GpuProfiler(cl_command_queue queue)
+	: m_queue(queue),
+	  m_enabled(false),
+	  m_inFrame(false),
+	  m_frame(0),
+	  m_frameTimeMs(0.f),
+	  m_maxTraceRecords(256 * 1024)
+{
+	//kernels launched outside of any stage
+	m_stageNames.push_back("other");
+	m_stageTimesMs.push_back(0.f);
+}
+
+b3GpuProfiler::~b3GpuProfiler()
+{
+	for (int i = 0; i < m_pendingEvents.size(); i++)
+	{
+		clReleaseEvent(m_pendingEvents[i].m_event);
+	}
+	if (b3GetGpuProfiler() == this)
+	{
+		b3SetGpuProfiler(0);
+	}
+}
+
+bool b3GpuProfiler::isProfilingQueue(cl_command_queue queue)
+{
+	cl_command_queue_properties properties = 0;
+	cl_int ciErrNum = clGetCommandQueueInfo(queue, CL_QUEUE_PROPERTIES, sizeof(properties), &properties, 0);
+	return ciErrNum == CL_SUCCESS && (properties & CL_QUEUE_PROFILING_ENABLE);
+}
+
+bool b3GpuProfiler::setEnabled(bool enable)
+{
+	if (enable && !isProfilingQueue(m_queue))
+	{
+		b3Warning("b3GpuProfiler: the command queue was created without CL_QUEUE_PROFILING_ENABLE\n");
+		enable = false;
+	}
+	m_enabled = enable;
+	return m_enabled;
+}
+
+void b3GpuProfiler::beginFrame()
+{
+	if (m_enabled)
+	{
+		m_inFrame = true;
+		m_frameThread = std::this_thread::get_id();
+	}
+}
+
+int b3GpuProfiler::findStage(const char* stageName) const
+{
+	for (int i = 0; i < m_stageNames.size(); i++)
+	{
+		if (m_stageNames[i] == stageName || strcmp(m_stageNames[i], stageName) == 0)
+			return i;
+	}
+	return -1;
+}
+
+void b3GpuProfiler::pushStage(const char* stageName)
+{
+	int stage = findStage(stageName);
+	if (stage < 0)
+	{
+		stage = m_stageNames.size();
+		m_stageNames.push_back(stageName);
+		m_stageTimesMs.push_back(0.f);
+	}
+	m_stageStack.push_back(stage);
+}
+
+void b3GpuProfiler::popStage()
+{
+	b3Assert(m_stageStack.size());
+	if (m_stageStack.size())
+	{
+		m_stageStack.pop_back();
+	}
+}
+
+void b3GpuProfiler::addKernelEvent(const char* kernelName, cl_event evt)
+{
+	b3GpuKernelEvent kernelEvent;
+	kernelEvent.m_kernelName = kernelName;
+	kernelEvent.m_stage = m_stageStack.size() ? m_stageStack[m_stageStack.size() - 1] : 0;
+	kernelEvent.m_event = evt;
+	m_pendingEvents.push_back(kernelEvent);
+}
+
+void b3GpuProfiler::endFrame()
+{
+	if (!m_inFrame)
+		return;
+	m_inFrame = false;
+	m_stageStack.resize(0);
+
+	for (int i = 0; i < m_stageTimesMs.size(); i++)
+	{
+		m_stageTimesMs[i] = 0.f;
+	}
+	m_frameTimeMs = 0.f;
+
+	for (int i = 0; i < m_pendingEvents.size(); i++)
+	{
+		const b3GpuKernelEvent& kernelEvent = m_pendingEvents[i];
+		cl_ulong start = 0, end = 0;
+		cl_int ciErrNum = clWaitForEvents(1, &kernelEvent.m_event);
+		if (ciErrNum == CL_SUCCESS)
+			ciErrNum = clGetEventProfilingInfo(kernelEvent.m_event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, 0);
+		if (ciErrNum == CL_SUCCESS)
+			ciErrNum = clGetEventProfilingInfo(kernelEvent.m_event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, 0);
+		clReleaseEvent(kernelEvent.m_event);
+		if (ciErrNum != CL_SUCCESS || end < start)
+			continue;
+
+		float timeMs = float(end - start) * 1e-6f;
+		m_stageTimesMs[kernelEvent.m_stage] += timeMs;
+		m_frameTimeMs += timeMs;
+
+		if (m_trace.size() < m_maxTraceRecords)
+		{
+			b3GpuKernelRecord record;
+			record.m_kernelName = kernelEvent.m_kernelName;
+			record.m_stage = kernelEvent.m_stage;
+			record.m_frame = m_frame;
+			record.m_start = start;
+			record.m_end = end;
+			m_trace.push_back(record);
+		}
+	}
+	m_pendingEvents.resize(0);
+	m_frame++;
+}
+
+float b3GpuProfiler::getStageTimeMs(const char* stageName) const
+{
+	int stage = findStage(stageName);
+	return stage >= 0 ? m_stageTimesMs[stage] : 0.f;
+}
+
+void b3GpuProfiler::clearTrace()
+{
+	m_trace.resize(0);
+}
+
+bool b3GpuProfiler::writeChromeTrace(const char* fileName) const
+{
+	FILE* f = fopen(fileName, "w");
+	if (!f)
+	{
+		b3Warning("b3GpuProfiler: cannot write %s\n", fileName);
+		return false;
+	}
+
+	cl_ulong traceStart = 0;
+	for (int i = 0; i < m_trace.size(); i++)
+	{
+		if (i == 0 || m_trace[i].m_start < traceStart)
+			traceStart = m_trace[i].m_start;
+	}
+
+	fprintf(f, "{\"traceEvents\":[\n");
+	for (int i = 0; i < m_stageNames.size(); i++)
+	{
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}\n", i ? "," : "", i, m_stageNames[i]);
+	}
+	for (int i = 0; i < m_trace.size(); i++)
+	{
+		const b3GpuKernelRecord& record = m_trace[i];
+		//device timestamps are in nanoseconds, the trace uses microseconds
+		double ts = double(record.m_start - traceStart) * 1e-3;
+		double dur = double(record.m_end - record.m_start) * 1e-3;
+		fprintf(f, ",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frame\":%d}}\n",
+				record.m_kernelName, m_stageNames[record.m_stage], record.m_stage, ts, dur, record.m_frame);
+	}
+	fprintf(f, "],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+	return true;
+}
@@ -0,0 +1,139 @@
+#ifndef B3_GPU_PROFILER_H
+#define B3_GPU_PROFILER_H
+
+#include "Bullet3OpenCL/Initialize/b3OpenCLInclude.h"
+#include "Bullet3Common/b3AlignedObjectArray.h"
+#include <thread>
+
+///device time of the kernels launched through b3LauncherCL, from OpenCL profiling events
+///kernels are grouped into the innermost stage (see B3_GPU_STAGE) active when they were launched
+///the command queue has to be created with CL_QUEUE_PROFILING_ENABLE
+///only the kernels launched between beginFrame and endFrame by the thread that called beginFrame are recorded,
+///so launches of other threads on the same queue (such as the renderer) do not end up in the frame
+class b3GpuProfiler
+{
+	struct b3GpuKernelEvent
+	{
+		const char* m_kernelName;
+		int m_stage;
+		cl_event m_event;
+	};
+
+	struct b3GpuKernelRecord
+	{
+		const char* m_kernelName;
+		int m_stage;
+		int m_frame;
+		cl_ulong m_start;
+		cl_ulong m_end;
+	};
+
+	cl_command_queue m_queue;
+	bool m_enabled;
+	bool m_inFrame;
+	std::thread::id m_frameThread;
+	int m_frame;
+
+	b3AlignedObjectArray<const char*> m_stageNames;
+	b3AlignedObjectArray<int> m_stageStack;
+	b3AlignedObjectArray<b3GpuKernelEvent> m_pendingEvents;
+	///device time per stage of the last frame, in milliseconds
+	b3AlignedObjectArray<float> m_stageTimesMs;
+	float m_frameTimeMs;
+
+	b3AlignedObjectArray<b3GpuKernelRecord> m_trace;
+	int m_maxTraceRecords;
+
+	int findStage(const char* stageName) const;
+
+public:
+	b3GpuProfiler(cl_command_queue queue);
+	virtual ~b3GpuProfiler();
+
+	static bool isProfilingQueue(cl_command_queue queue);
+
+	///returns false (and stays disabled) if the queue was created without CL_QUEUE_PROFILING_ENABLE
+	bool setEnabled(bool enable);
+	bool isEnabled() const
+	{
+		return m_enabled;
+	}
+	bool isRecordingThread() const
+	{
+		return m_inFrame && std::this_thread::get_id() == m_frameThread;
+	}
+	bool isRecording(cl_command_queue queue) const
+	{
+		return queue == m_queue && isRecordingThread();
+	}
+
+	///stage names are not copied, use string literals
+	void pushStage(const char* stageName);
+	void popStage();
+
+	///called by b3LauncherCL, the profiler releases the event
+	void addKernelEvent(const char* kernelName, cl_event evt);
+
+	///does nothing while the profiler is disabled
+	void beginFrame();
+	///waits for the kernels of the frame, sums their device time per stage and appends them to the trace
+	void endFrame();
+
+	///stages seen so far, in order of their first use, with their device time in the last frame
+	int getNumStages() const
+	{
+		return m_stageNames.size();
+	}
+	const char* getStageName(int stageIndex) const
+	{
+		return m_stageNames[stageIndex];
+	}
+	float getStageTimeMs(int stageIndex) const
+	{
+		return m_stageTimesMs[stageIndex];
+	}
+	///0 if the stage did not run yet
+	float getStageTimeMs(const char* stageName) const;
+	///summed device time of all kernels of the last frame
+	float getFrameTimeMs() const
+	{
+		return m_frameTimeMs;
+	}
+
+	///the trace keeps the kernels of consecutive frames until maxRecords kernels are recorded
+	void setMaxTraceRecords(int maxRecords)
+	{
+		m_maxTraceRecords = maxRecords;
+	}
+	void clearTrace();
+	///writes the trace in the Chrome trace event format (chrome://tracing, Perfetto), one track per stage
+	bool writeChromeTrace(const char* fileName) const;
+};
+
+///the profiler b3LauncherCL reports to, 0 if none is installed
+b3GpuProfiler* b3GetGpuProfiler();
+void b3SetGpuProfiler(b3GpuProfiler* profiler);
+
+class b3GpuProfileStage
+{
+	b3GpuProfiler* m_profiler;
+
+public:
+	b3GpuProfileStage(const char* stageName)
+	{
+		m_profiler = b3GetGpuProfiler();
+		if (m_profiler && m_profiler->isRecordingThread())
+			m_profiler->pushStage(stageName);
+		else
+			m_profiler = 0;
+	}
+	~b3GpuProfileStage()
+	{
+		if (m_profiler)
+			m_profiler->popStage();
+	}
+};
+
+#define B3_GPU_STAGE(name) b3GpuProfileStage __gpuStage(name)
+
+#endif  //B3_GPU_PROFILER_H
@@ -5,6 +5,7 @@
 #include "b3BufferInfoCL.h"
 #include "Bullet3Common/b3MinMax.h"
 #include "b3OpenCLArray.h"
+#include "b3GpuProfiler.h"
 #include <stdio.h>
 
 #define B3_DEBUG_SERIALIZE_CL
@@ -38,6 +39,8 @@ class b3LauncherCL
 
 	const char* m_name;
 
+	b3AlignedObjectArray<cl_event> m_waitEvents;
+
 public:
 	b3AlignedObjectArray<b3OpenCLArray<unsigned char>*> m_arrays;
 
@@ -92,14 +95,50 @@ public:
 
 		cl_int status = clSetKernelArg(m_kernel, m_idx++, sz, &consts);
 		b3Assert(status == CL_SUCCESS);
+		(void)status;
+	}
+
+	///the next launch waits for this event, for example returned by b3OpenCLArray::copyFromHostPointerAsync
+	///the launcher does not take ownership of the event
+	void addWaitEvent(cl_event evt)
+	{
+		if (evt)
+		{
+			m_waitEvents.push_back(evt);
+		}
+	}
+
+	///the next launch waits for all non-blocking transfers of the array that were not synced yet
+	template <typename T>
+	void addWaitEvents(const b3OpenCLArray<T>& array)
+	{
+		for (int i = 0; i < array.getNumPendingTransfers(); i++)
+		{
+			addWaitEvent(array.getPendingTransfer(i));
+		}
 	}
 
-    inline void launch1D(int numThreads, int localSize = 64)
+	///if launchEvent is not null, the launch is non-blocking and *launchEvent receives an event that the caller has to release
+	///otherwise the launch waits for completion of the kernel
+	inline void launch1D(int numThreads, int localSize = 64, cl_event* launchEvent = 0)
 	{
-		launch2D(numThreads, 1, localSize, 1);
+		launch2D(numThreads, 1, localSize, 1, launchEvent);
 	}
 
-	inline void launch2D(int numThreadsX, int numThreadsY, int localSizeX, int localSizeY)
+	///like launch1D, but the work items get the global ids firstThread to firstThread+numThreads-1
+	///so a kernel that checks get_global_id(0) against a count runs on a sub range of its data (needs OpenCL 1.1)
+	inline void launch1DRange(int firstThread, int numThreads, int localSize = 64, cl_event* launchEvent = 0)
+	{
+		size_t gOffset[2] = {(size_t)firstThread, 0};
+		launch2DOffset(gOffset, numThreads, 1, localSize, 1, launchEvent);
+	}
+
+	inline void launch2D(int numThreadsX, int numThreadsY, int localSizeX, int localSizeY, cl_event* launchEvent = 0)
+	{
+		launch2DOffset(NULL, numThreadsX, numThreadsY, localSizeX, localSizeY, launchEvent);
+	}
+
+	inline void launch2DOffset(const size_t* gOffset, int numThreadsX, int numThreadsY, int localSizeX, int localSizeY, cl_event* launchEvent = 0)
 	{
         size_t gRange[2] = {1, 1};
         size_t lRange[2] = {1, 1};
@@ -110,15 +149,35 @@ public:
 		gRange[1] = b3Max((size_t)1, (numThreadsY / lRange[1]) + (!(numThreadsY % lRange[1]) ? 0 : 1));
 		gRange[1] *= lRange[1];
 
-        cl_int status = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, NULL, gRange, lRange, 0, 0, 0);
+		//with a recording b3GpuProfiler the launch always gets an event, the profiler reads its device time later
+		b3GpuProfiler* profiler = b3GetGpuProfiler();
+		bool profile = profiler && profiler->isRecording(m_commandQueue);
+		cl_event profileEvent = 0;
+		cl_event* kernelEvent = launchEvent ? launchEvent : (profile ? &profileEvent : 0);
+
+		cl_uint numWaitEvents = m_waitEvents.size();
+		const cl_event* waitEvents = numWaitEvents ? &m_waitEvents[0] : 0;
+		cl_int status = clEnqueueNDRangeKernel(m_commandQueue, m_kernel, 2, gOffset, gRange, lRange, numWaitEvents, waitEvents, kernelEvent);
 		if (status != CL_SUCCESS)
 		{
 			printf("Error: OpenCL status = %d\n", status);
 		}
 		b3Assert(status == CL_SUCCESS);
+		if (profile && status == CL_SUCCESS)
+		{
+			if (launchEvent)
+			{
+				clRetainEvent(*launchEvent);
+			}
+			profiler->addKernelEvent(m_name, *kernelEvent);
+		}
+		m_waitEvents.resize(0);
 
         clFlush(m_commandQueue);
-        clFinish(m_commandQueue);
+		if (!launchEvent)
+		{
+			clFinish(m_commandQueue);
+		}
 	}
 
 	void enableSerialization(bool serialize)
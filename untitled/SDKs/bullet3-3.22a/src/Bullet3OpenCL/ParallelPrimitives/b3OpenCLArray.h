@@ -4,6 +4,70 @@
 #include "Bullet3Common/b3AlignedObjectArray.h"
 #include "Bullet3OpenCL/Initialize/b3OpenCLInclude.h"
 
+///indices of host array elements that changed since the last upload, see b3OpenCLArray::copyDirtyFromHost
+class b3DirtyElements
+{
+	b3AlignedObjectArray<int> m_indices;
+	b3AlignedObjectArray<unsigned char> m_isDirty;
+
+	struct b3LessIndex
+	{
+		bool operator()(int a, int b) const
+		{
+			return a < b;
+		}
+	};
+
+public:
+	void markDirty(int index)
+	{
+		b3Assert(index >= 0);
+		if (index >= m_isDirty.size())
+		{
+			int newSize = m_isDirty.size() * 2 > index + 1 ? m_isDirty.size() * 2 : index + 1;
+			m_isDirty.resize(newSize, 0);
+		}
+		if (!m_isDirty[index])
+		{
+			m_isDirty[index] = 1;
+			m_indices.push_back(index);
+		}
+	}
+
+	void markDirty(int firstIndex, int numElements)
+	{
+		for (int i = 0; i < numElements; i++)
+		{
+			markDirty(firstIndex + i);
+		}
+	}
+
+	void clear()
+	{
+		for (int i = 0; i < m_indices.size(); i++)
+		{
+			m_isDirty[m_indices[i]] = 0;
+		}
+		m_indices.resize(0);
+	}
+
+	///sorts the indices in increasing order, so neighbouring indices form contiguous runs
+	void sort()
+	{
+		m_indices.quickSort(b3LessIndex());
+	}
+
+	int size() const
+	{
+		return m_indices.size();
+	}
+
+	int operator[](int i) const
+	{
+		return m_indices[i];
+	}
+};
+
 template <typename T>
 class b3OpenCLArray
 {
@@ -18,8 +82,12 @@ class b3OpenCLArray
 
 	bool m_allowGrowingCapacity;
 
+	//events of non-blocking transfers that have been enqueued but not yet waited for, see sync()
+	mutable b3AlignedObjectArray<cl_event> m_pendingEvents;
+
 	void deallocate()
 	{
+		sync();
 		if (m_clBuffer && m_ownsMemory)
 		{
 			clReleaseMemObject(m_clBuffer);
@@ -76,7 +144,8 @@ public:
 		m_capacity = 0;
 	}
 
-	B3_FORCE_INLINE bool push_back(const T& _Val, bool waitForCompletion = true)
+	///always a blocking upload, _Val is usually a temporary of the caller
+	B3_FORCE_INLINE bool push_back(const T& _Val)
 	{
 		bool result = true;
 		size_t sz = size();
@@ -84,11 +153,43 @@ public:
 		{
 			result = reserve(allocSize(size()));
 		}
-		copyFromHostPointer(&_Val, 1, sz, waitForCompletion);
+		copyFromHostPointer(&_Val, 1, sz);
 		m_size++;
 		return result;
 	}
 
+	///wait until all non-blocking transfers of this array have finished and release their events
+	void sync() const
+	{
+		if (m_pendingEvents.size())
+		{
+			cl_int status = clWaitForEvents(m_pendingEvents.size(), &m_pendingEvents[0]);
+			b3Assert(status == CL_SUCCESS);
+			(void)status;
+			for (int i = 0; i < m_pendingEvents.size(); i++)
+			{
+				clReleaseEvent(m_pendingEvents[i]);
+			}
+			m_pendingEvents.resize(0);
+		}
+	}
+
+	bool hasPendingTransfers() const
+	{
+		return m_pendingEvents.size() != 0;
+	}
+
+	///the events of the pending transfers stay owned by this array, see b3LauncherCL::addWaitEvents
+	int getNumPendingTransfers() const
+	{
+		return m_pendingEvents.size();
+	}
+
+	cl_event getPendingTransfer(int i) const
+	{
+		return m_pendingEvents[i];
+	}
+
 	B3_FORCE_INLINE T forcedAt(size_t n) const
 	{
 		b3Assert(n >= 0);
@@ -227,6 +328,7 @@ public:
 									 srcOffsetBytes, dstOffsetInBytes, sizeof(T) * numElements, 0, 0, 0);
 
 		b3Assert(status == CL_SUCCESS);
+		(void)status;
         clFlush(m_commandQueue);
         clFinish(m_commandQueue);
 	}
@@ -241,20 +343,65 @@ public:
 			copyFromHostPointer(&srcArray[0], newSize, 0, waitForCompletion);
 	}
 
+	///resizes to srcArray and uploads only its dirty elements, see copyDirtyFromHostPointer
+	void copyDirtyFromHost(const b3AlignedObjectArray<T>& srcArray, b3DirtyElements& dirtyElements, bool waitForCompletion = true)
+	{
+		copyDirtyFromHostPointer(srcArray.size() ? &srcArray[0] : 0, srcArray.size(), dirtyElements, waitForCompletion);
+	}
+
+	///resizes to numElems and uploads only the dirty elements, one transfer per contiguous run, then clears dirtyElements
+	///elements in between runs are left untouched, so device-side changes to them survive
+	void copyDirtyFromHostPointer(const T* src, size_t numElems, b3DirtyElements& dirtyElements, bool waitForCompletion = true)
+	{
+		if (numElems > capacity())
+		{
+			reserve(numElems > capacity() * 2 ? numElems : capacity() * 2);
+		}
+		resize(numElems);
+
+		dirtyElements.sort();
+		int numDirty = dirtyElements.size();
+		int i = 0;
+		while (i < numDirty)
+		{
+			size_t begin = dirtyElements[i++];
+			size_t end = begin + 1;
+			while (i < numDirty && size_t(dirtyElements[i]) == end)
+			{
+				end++;
+				i++;
+			}
+			if (begin >= numElems)
+				break;
+			if (end > numElems)
+				end = numElems;
+			copyFromHostPointerAsync(&src[begin], end - begin, begin);
+		}
+		dirtyElements.clear();
+
+		if (waitForCompletion)
+			sync();
+	}
+
 	void copyFromHostPointer(const T* src, size_t numElems, size_t destFirstElem = 0, bool waitForCompletion = true)
 	{
+		if (!waitForCompletion)
+		{
+			copyFromHostPointerAsync(src, numElems, destFirstElem);
+			return;
+		}
+
 		b3Assert(numElems + destFirstElem <= capacity());
 
 		if (numElems + destFirstElem)
 		{
 			cl_int status = 0;
 			size_t sizeInBytes = sizeof(T) * numElems;
-			status = clEnqueueWriteBuffer(m_commandQueue, m_clBuffer, 0, sizeof(T) * destFirstElem, sizeInBytes,
+			//a blocking write only waits for itself (and the commands before it), not for the rest of the queue
+			status = clEnqueueWriteBuffer(m_commandQueue, m_clBuffer, CL_TRUE, sizeof(T) * destFirstElem, sizeInBytes,
 										  src, 0, 0, 0);
 			b3Assert(status == CL_SUCCESS);
-            //if (waitForCompletion)
-            clFlush(m_commandQueue);
-            clFinish(m_commandQueue);
+			(void)status;
 		}
 		else
 		{
@@ -262,6 +409,36 @@ public:
 		}
 	}
 
+	///non-blocking upload: the source memory must stay valid until the returned event completed (or until sync() returns)
+	///the event is owned by this array and released in sync(), use clRetainEvent to keep it longer
+	///it can be passed to b3LauncherCL::addWaitEvent to let a kernel wait on the upload
+	cl_event copyFromHostPointerAsync(const T* src, size_t numElems, size_t destFirstElem = 0, cl_uint numEventsInWaitList = 0, const cl_event* eventWaitList = 0)
+	{
+		b3Assert(numElems + destFirstElem <= capacity());
+
+		cl_event evt = 0;
+		if (numElems && (numElems + destFirstElem <= capacity()))
+		{
+			cl_int status = clEnqueueWriteBuffer(m_commandQueue, m_clBuffer, CL_FALSE, sizeof(T) * destFirstElem, sizeof(T) * numElems,
+												 src, numEventsInWaitList, eventWaitList, &evt);
+			b3Assert(status == CL_SUCCESS);
+			if (status == CL_SUCCESS)
+			{
+				m_pendingEvents.push_back(evt);
+				clFlush(m_commandQueue);
+			}
+			else
+			{
+				evt = 0;
+			}
+		}
+		else if (numElems)
+		{
+			b3Error("copyFromHostPointerAsync invalid range\n");
+		}
+		return evt;
+	}
+
 	void copyToHost(b3AlignedObjectArray<T>& destArray, bool waitForCompletion = true) const
 	{
 		destArray.resize(this->size());
@@ -271,18 +448,21 @@ public:
 
 	void copyToHostPointer(T* destPtr, size_t numElem, size_t srcFirstElem = 0, bool waitForCompletion = true) const
 	{
+		if (!waitForCompletion)
+		{
+			copyToHostPointerAsync(destPtr, numElem, srcFirstElem);
+			return;
+		}
+
 		b3Assert(numElem + srcFirstElem <= capacity());
 
 		if (numElem + srcFirstElem <= capacity())
 		{
 			cl_int status = 0;
-			status = clEnqueueReadBuffer(m_commandQueue, m_clBuffer, 0, sizeof(T) * srcFirstElem, sizeof(T) * numElem,
+			status = clEnqueueReadBuffer(m_commandQueue, m_clBuffer, CL_TRUE, sizeof(T) * srcFirstElem, sizeof(T) * numElem,
 										 destPtr, 0, 0, 0);
 			b3Assert(status == CL_SUCCESS);
-
-            //if (waitForCompletion)
-            clFlush(m_commandQueue);
-            clFinish(m_commandQueue);
+			(void)status;
 		}
 		else
 		{
@@ -290,6 +470,35 @@ public:
 		}
 	}
 
+	///non-blocking readback: destPtr is only valid after the returned event completed (or after sync() returned)
+	///the event is owned by this array and released in sync(), use clRetainEvent to keep it longer
+	cl_event copyToHostPointerAsync(T* destPtr, size_t numElem, size_t srcFirstElem = 0, cl_uint numEventsInWaitList = 0, const cl_event* eventWaitList = 0) const
+	{
+		b3Assert(numElem + srcFirstElem <= capacity());
+
+		cl_event evt = 0;
+		if (numElem && (numElem + srcFirstElem <= capacity()))
+		{
+			cl_int status = clEnqueueReadBuffer(m_commandQueue, m_clBuffer, CL_FALSE, sizeof(T) * srcFirstElem, sizeof(T) * numElem,
+												destPtr, numEventsInWaitList, eventWaitList, &evt);
+			b3Assert(status == CL_SUCCESS);
+			if (status == CL_SUCCESS)
+			{
+				m_pendingEvents.push_back(evt);
+				clFlush(m_commandQueue);
+			}
+			else
+			{
+				evt = 0;
+			}
+		}
+		else if (numElem)
+		{
+			b3Error("copyToHostPointerAsync invalid range\n");
+		}
+		return evt;
+	}
+
 	void copyFromOpenCLArray(const b3OpenCLArray& src)
 	{
 		size_t newSize = src.size();
@@ -0,0 +1,50 @@
+#ifndef B3_GPU_COOKED_SHAPE_H
+#define B3_GPU_COOKED_SHAPE_H
+
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3Collidable.h"
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3ConvexPolyhedronData.h"
+#include "Bullet3OpenCL/BroadphaseCollision/b3SapAabb.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/b3BvhInfo.h"
+
+#define B3_COOKED_SHAPE_MAGIC 0x6b6f6f63  //"cook"
+///increase it when the layout of the cooked data or the way the shapes are built changes
+#define B3_COOKED_SHAPE_VERSION 4
+
+///a cooked shape holds the collision data of one convex hull or concave mesh collidable in the layout of the narrowphase
+///buffers, so b3GpuNarrowPhase::registerCookedShape appends it without building the hull or the bvh again
+///it starts with this header, the arrays follow at the 16 byte aligned byte offsets (from the start of the header) below
+///the offsets stored in the polyhedron, the faces and the bvh info count from the start of the shape's own arrays
+///the data is not endian swapped, a cooked shape only loads on a platform with the same byte order and struct layout
+B3_ATTRIBUTE_ALIGNED16(struct)
+b3CookedShapeHeader
+{
+	int m_magic;
+	int m_version;
+	int m_sizeInBytes;
+	int m_numIndices;
+
+	//struct sizes of the build that cooked the shape, another layout (double precision for example) is rejected
+	int m_sizeOfVector3;
+	int m_sizeOfPolyhedron;
+	int m_sizeOfFace;
+	int m_sizeOfTreeNode;
+
+	b3Collidable m_collidable;
+	b3SapAabb m_localAabb;
+	b3ConvexPolyhedronData m_polyhedron;
+	///only used by concave meshes
+	b3BvhInfo m_bvhInfo;
+
+	int m_uniqueEdgesOffset;
+	int m_facesOffset;
+	int m_indicesOffset;
+	int m_verticesOffset;
+	int m_treeNodesOffset;
+	int m_subTreesOffset;
+	///one b3TriangleInfo per face, only used by concave meshes
+	int m_triangleInfosOffset;
+	///chosen by the caller, such as a hash of the transform the source was loaded with, registerCookedShape rejects another one
+	unsigned int m_sourceKey;
+};
+
+#endif  //B3_GPU_COOKED_SHAPE_H
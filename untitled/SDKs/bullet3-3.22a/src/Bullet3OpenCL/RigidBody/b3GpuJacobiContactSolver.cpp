@@ -58,6 +58,7 @@ b3GpuJacobiContactSolver::b3GpuJacobiContactSolver(cl_context ctx, cl_device_id
 	m_data->m_contactConstraints = new b3OpenCLArray<b3GpuConstraint4>(m_context, m_queue);
 	m_data->m_deltaLinearVelocities = new b3OpenCLArray<b3Vector3>(m_context, m_queue);
 	m_data->m_deltaAngularVelocities = new b3OpenCLArray<b3Vector3>(m_context, m_queue);
+	reserveCapacity(0, pairCapacity);
 
 	cl_int pErrNum;
 	const char* additionalMacros = "";
@@ -108,6 +109,17 @@ b3GpuJacobiContactSolver::~b3GpuJacobiContactSolver()
 	delete m_data;
 }
 
+void b3GpuJacobiContactSolver::reserveCapacity(int bodyCapacity, int contactCapacity)
+{
+	m_data->m_bodyCount->reserve(bodyCapacity);
+	m_data->m_offsetSplitBodies->reserve(bodyCapacity);
+	m_data->m_contactConstraintOffsets->reserve(contactCapacity);
+	m_data->m_contactConstraints->reserve(contactCapacity);
+	//each manifold splits at most its two bodies
+	m_data->m_deltaLinearVelocities->reserve(2 * contactCapacity);
+	m_data->m_deltaAngularVelocities->reserve(2 * contactCapacity);
+}
+
 b3Vector3 make_float4(float v)
 {
 	return b3MakeVector3(v, v, v);
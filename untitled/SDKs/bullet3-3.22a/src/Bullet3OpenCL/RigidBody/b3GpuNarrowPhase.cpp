@@ -1,6 +1,7 @@
 #include "b3GpuNarrowPhase.h"
 
 #include "Bullet3OpenCL/ParallelPrimitives/b3OpenCLArray.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3ConvexPolyhedronData.h"
 #include "Bullet3OpenCL/NarrowphaseCollision/b3ConvexHullContact.h"
 #include "Bullet3OpenCL/BroadphaseCollision/b3SapAabb.h"
@@ -14,6 +15,8 @@
 #include "b3GpuNarrowPhaseInternalData.h"
 #include "Bullet3OpenCL/NarrowphaseCollision/b3QuantizedBvh.h"
 #include "Bullet3Collision/NarrowPhaseCollision/b3ConvexUtility.h"
+#include "b3GpuCookedShape.h"
+#include "Bullet3Geometry/b3GeometryUtil.h"
 
 b3GpuNarrowPhase::b3GpuNarrowPhase(cl_context ctx, cl_device_id device, cl_command_queue queue, const b3Config& config)
 	: m_data(0), m_planeBodyIndex(-1), m_static0Index(-1), m_context(ctx), m_device(device), m_queue(queue)
@@ -27,6 +30,9 @@ b3GpuNarrowPhase::b3GpuNarrowPhase(cl_context ctx, cl_device_id device, cl_comma
 
 	m_data->m_gpuSatCollision = new GpuSatCollision(ctx, device, queue);
 
+	//unless the capacities are fixed, the buffers sized by m_maxConvexBodies and m_maxConvexShapes grow on registration
+	bool allowGrowingCapacity = config.m_capacityGrowthPolicy != B3_CAPACITY_FIXED;
+
 	m_data->m_triangleConvexPairs = new b3OpenCLArray<b3Int4>(m_context, m_queue, config.m_maxTriConvexPairCapacity);
 
 	//m_data->m_convexPairsOutGPU = new b3OpenCLArray<b3Int2>(ctx,queue,config.m_maxBroadphasePairs,false);
@@ -43,7 +49,7 @@ b3GpuNarrowPhase::b3GpuNarrowPhase(cl_context ctx, cl_device_id device, cl_comma
 	m_data->m_pBufContactBuffersGPU[0] = new b3OpenCLArray<b3Contact4>(ctx, queue, config.m_maxContactCapacity, true);
 	m_data->m_pBufContactBuffersGPU[1] = new b3OpenCLArray<b3Contact4>(ctx, queue, config.m_maxContactCapacity, true);
 
-	m_data->m_inertiaBufferGPU = new b3OpenCLArray<b3InertiaData>(ctx, queue, config.m_maxConvexBodies, false);
+	m_data->m_inertiaBufferGPU = new b3OpenCLArray<b3InertiaData>(ctx, queue, config.m_maxConvexBodies, allowGrowingCapacity);
 	m_data->m_collidablesGPU = new b3OpenCLArray<b3Collidable>(ctx, queue, config.m_maxConvexShapes);
 	m_data->m_collidablesCPU.reserve(config.m_maxConvexShapes);
 
@@ -51,14 +57,17 @@ b3GpuNarrowPhase::b3GpuNarrowPhase(cl_context ctx, cl_device_id device, cl_comma
 	m_data->m_localShapeAABBGPU = new b3OpenCLArray<b3SapAabb>(ctx, queue, config.m_maxConvexShapes);
 
 	//m_data->m_solverDataGPU = adl::Solver<adl::TYPE_CL>::allocate(ctx,queue, config.m_maxBroadphasePairs,false);
-	m_data->m_bodyBufferGPU = new b3OpenCLArray<b3RigidBodyData>(ctx, queue, config.m_maxConvexBodies, false);
+	m_data->m_bodyBufferGPU = new b3OpenCLArray<b3RigidBodyData>(ctx, queue, config.m_maxConvexBodies, allowGrowingCapacity);
 
-	m_data->m_convexFacesGPU = new b3OpenCLArray<b3GpuFace>(ctx, queue, config.m_maxConvexShapes * config.m_maxFacesPerShape, false);
+	m_data->m_convexFacesGPU = new b3OpenCLArray<b3GpuFace>(ctx, queue, config.m_maxConvexShapes * config.m_maxFacesPerShape, allowGrowingCapacity);
 	m_data->m_convexFaces.reserve(config.m_maxConvexShapes * config.m_maxFacesPerShape);
+	m_data->m_triangleInfosGPU = new b3OpenCLArray<b3TriangleInfo>(ctx, queue, config.m_maxConvexShapes * config.m_maxFacesPerShape, allowGrowingCapacity);
+	m_data->m_triangleInfos.reserve(config.m_maxConvexShapes * config.m_maxFacesPerShape);
+	m_data->m_gpuSatCollision->m_maxInternalEdgeAngle = config.m_enableInternalEdgeFiltering ? config.m_maxInternalEdgeAngle : -1.f;
 
-	m_data->m_gpuChildShapes = new b3OpenCLArray<b3GpuChildShape>(ctx, queue, config.m_maxCompoundChildShapes, false);
+	m_data->m_gpuChildShapes = new b3OpenCLArray<b3GpuChildShape>(ctx, queue, config.m_maxCompoundChildShapes, allowGrowingCapacity);
 
-	m_data->m_convexPolyhedraGPU = new b3OpenCLArray<b3ConvexPolyhedronData>(ctx, queue, config.m_maxConvexShapes, false);
+	m_data->m_convexPolyhedraGPU = new b3OpenCLArray<b3ConvexPolyhedronData>(ctx, queue, config.m_maxConvexShapes, allowGrowingCapacity);
 	m_data->m_convexPolyhedra.reserve(config.m_maxConvexShapes);
 
 	m_data->m_uniqueEdgesGPU = new b3OpenCLArray<b3Vector3>(ctx, queue, config.m_maxConvexUniqueEdges, true);
@@ -111,6 +120,7 @@ b3GpuNarrowPhase::~b3GpuNarrowPhase()
 	delete m_data->m_localShapeAABBGPU;
 	delete m_data->m_bodyBufferGPU;
 	delete m_data->m_convexFacesGPU;
+	delete m_data->m_triangleInfosGPU;
 	delete m_data->m_gpuChildShapes;
 	delete m_data->m_convexPolyhedraGPU;
 	delete m_data->m_uniqueEdgesGPU;
@@ -144,6 +154,10 @@ b3GpuNarrowPhase::~b3GpuNarrowPhase()
 int b3GpuNarrowPhase::allocateCollidable()
 {
 	int curSize = m_data->m_collidablesCPU.size();
+	if (curSize >= m_data->m_config.m_maxConvexShapes && m_data->m_config.m_capacityGrowthPolicy != B3_CAPACITY_FIXED)
+	{
+		m_data->m_config.m_maxConvexShapes = b3GrowCapacity(m_data->m_config.m_maxConvexShapes, curSize + 1);
+	}
 	if (curSize < m_data->m_config.m_maxConvexShapes)
 	{
 		m_data->m_collidablesCPU.expand();
@@ -509,7 +523,7 @@ int b3GpuNarrowPhase::registerCompoundShape(b3AlignedObjectArray<b3GpuChildShape
 		m_data->m_subTreesCPU.push_back(bvh->getSubtreeInfoArray()[i]);
 	}
 	int numNewTreeNodes = bvh->getQuantizedNodeArray().size();
-
+	m_data->m_treeNodesCPU.reserve(m_data->m_treeNodesCPU.size() + numNewTreeNodes);
 	for (int i = 0; i < numNewTreeNodes; i++)
 	{
 		m_data->m_treeNodesCPU.push_back(bvh->getQuantizedNodeArray()[i]);
@@ -598,7 +612,7 @@ int b3GpuNarrowPhase::registerConcaveMesh(b3AlignedObjectArray<b3Vector3>* verti
 		m_data->m_subTreesCPU.push_back(bvh->getSubtreeInfoArray()[i]);
 	}
 	int numNewTreeNodes = bvh->getQuantizedNodeArray().size();
-
+	m_data->m_treeNodesCPU.reserve(m_data->m_treeNodesCPU.size() + numNewTreeNodes);
 	for (int i = 0; i < numNewTreeNodes; i++)
 	{
 		m_data->m_treeNodesCPU.push_back(bvh->getQuantizedNodeArray()[i]);
@@ -630,7 +644,8 @@ int b3GpuNarrowPhase::registerConcaveMeshShape(b3AlignedObjectArray<b3Vector3>*
 
 	convex.m_numFaces = indices->size() / 3;
 	m_data->m_convexFaces.resize(faceOffset + convex.m_numFaces);
-	m_data->m_convexIndices.reserve(convex.m_numFaces * 3);
+	//resize only reserves what it needs, without room for all faces every face would copy the indices of all shapes
+	m_data->m_convexIndices.reserve(m_data->m_convexIndices.size() + convex.m_numFaces * 3);
 	for (int i = 0; i < convex.m_numFaces; i++)
 	{
 		if (i % 256 == 0)
@@ -668,9 +683,293 @@ int b3GpuNarrowPhase::registerConcaveMeshShape(b3AlignedObjectArray<b3Vector3>*
 
 	(*m_data->m_convexData)[m_data->m_numAcceleratedShapes] = 0;
 
+	computeTriangleInfos(*vertices, *indices, scaling);
+
 	return m_data->m_numAcceleratedShapes++;
 }
 
+///fills the triangle infos of the faces just appended by registerConcaveMeshShape
+void b3GpuNarrowPhase::computeTriangleInfos(const b3AlignedObjectArray<b3Vector3>& vertices, const b3AlignedObjectArray<int>& indices, const b3Vector3& scaling)
+{
+	int numTriangles = indices.size() / 3;
+	int faceOffset = m_data->m_convexFaces.size() - numTriangles;
+	syncTriangleInfos();
+
+	b3AlignedObjectArray<int> adjacency;
+	b3GeometryUtil::computeTriangleAdjacency(indices, adjacency);
+
+	for (int t = 0; t < numTriangles; t++)
+	{
+		b3TriangleInfo& info = m_data->m_triangleInfos[faceOffset + t];
+		info.m_flags = 0;
+		float edgeAngles[3];
+
+		b3Vector3 normal = m_data->m_convexFaces[faceOffset + t].m_plane;
+		normal.w = 0.f;
+		for (int k = 0; k < 3; k++)
+		{
+			edgeAngles[k] = 0.f;
+			int neighbour = adjacency[t * 3 + k];
+			b3Vector3 v0 = vertices[indices[t * 3 + k]] * scaling;
+			b3Vector3 v1 = vertices[indices[t * 3 + (k + 1) % 3]] * scaling;
+			b3Vector3 edge = v1 - v0;
+			if (neighbour < 0 || edge.length2() < B3_EPSILON || normal.length2() < 0.5f)
+			{
+				info.m_flags |= B3_TRIANGLE_EDGE_V0V1_BORDER << k;
+				continue;
+			}
+			edge.normalize();
+
+			//the direction from the edge into the neighbour, in the frame of the outward edge normal and the triangle normal
+			int neighbourTriangle = neighbour / 3;
+			int opposite = indices[neighbourTriangle * 3 + (neighbour % 3 + 2) % 3];
+			b3Vector3 toOpposite = vertices[opposite] * scaling - v0;
+			toOpposite -= edge * edge.dot(toOpposite);
+			if (toOpposite.length2() < B3_EPSILON)
+			{
+				info.m_flags |= B3_TRIANGLE_EDGE_V0V1_BORDER << k;
+				continue;
+			}
+			b3Vector3 edgeNormal = edge.cross(normal);
+			edgeAngles[k] = b3Atan2(toOpposite.dot(normal), toOpposite.dot(edgeNormal));
+		}
+		info.m_edgeV0V1Angle = edgeAngles[0];
+		info.m_edgeV1V2Angle = edgeAngles[1];
+		info.m_edgeV2V0Angle = edgeAngles[2];
+	}
+}
+
+///the triangle infos are parallel to the faces, the faces of convex hulls and other shapes get infos without any edges
+void b3GpuNarrowPhase::syncTriangleInfos()
+{
+	b3TriangleInfo noEdges;
+	noEdges.m_flags = B3_TRIANGLE_EDGE_ALL_BORDERS;
+	noEdges.m_edgeV0V1Angle = 0.f;
+	noEdges.m_edgeV1V2Angle = 0.f;
+	noEdges.m_edgeV2V0Angle = 0.f;
+	if (m_data->m_triangleInfos.size() < m_data->m_convexFaces.size())
+	{
+		m_data->m_triangleInfos.reserve(m_data->m_convexFaces.capacity());
+		m_data->m_triangleInfos.resize(m_data->m_convexFaces.size(), noEdges);
+	}
+}
+
+static int b3AlignCookedOffset(int offset)
+{
+	return (offset + 15) & ~15;
+}
+
+template <typename T>
+static void b3WriteCookedArray(b3AlignedObjectArray<unsigned char>& cookedData, int offset, const b3AlignedObjectArray<T>& source, int first, int count)
+{
+	if (count)
+	{
+		memcpy(&cookedData[offset], &source[first], count * sizeof(T));
+	}
+}
+
+static bool b3IsCookedArrayInside(int offset, int count, int elementSize, int sizeInBytes)
+{
+	return offset >= 0 && count >= 0 && offset == b3AlignCookedOffset(offset) && (long long)offset + (long long)count * elementSize <= sizeInBytes;
+}
+
+template <typename T>
+static void b3AppendCookedArray(b3AlignedObjectArray<T>& target, const unsigned char* cookedData, int offset, int count)
+{
+	int first = target.size();
+	target.resizeNoInitialize(first + count);
+	if (count)
+	{
+		memcpy(&target[first], cookedData + offset, count * sizeof(T));
+	}
+}
+
+bool b3GpuNarrowPhase::cookShape(int collidableIndex, b3AlignedObjectArray<unsigned char>& cookedData, unsigned int sourceKey) const
+{
+	if (collidableIndex < 0 || collidableIndex >= m_data->m_collidablesCPU.size())
+	{
+		b3Error("cookShape: invalid collidable index %d\n", collidableIndex);
+		return false;
+	}
+	const b3Collidable& col = m_data->m_collidablesCPU[collidableIndex];
+	if (col.m_shapeType != SHAPE_CONVEX_HULL && col.m_shapeType != SHAPE_CONCAVE_TRIMESH)
+	{
+		b3Warning("cookShape: only convex hulls and concave meshes can be cooked, collidable %d has shape type %d\n", collidableIndex, col.m_shapeType);
+		return false;
+	}
+	bool concave = col.m_shapeType == SHAPE_CONCAVE_TRIMESH;
+
+	const b3ConvexPolyhedronData& polyhedron = m_data->m_convexPolyhedra[col.m_shapeIndex];
+	//the indices of the faces of a shape are stored one after the other
+	int firstIndex = 0;
+	int numIndices = 0;
+	if (polyhedron.m_numFaces)
+	{
+		const b3GpuFace& lastFace = m_data->m_convexFaces[polyhedron.m_faceOffset + polyhedron.m_numFaces - 1];
+		firstIndex = m_data->m_convexFaces[polyhedron.m_faceOffset].m_indexOffset;
+		numIndices = lastFace.m_indexOffset + lastFace.m_numIndices - firstIndex;
+	}
+
+	b3CookedShapeHeader header;
+	memset(&header, 0, sizeof(header));
+	header.m_magic = B3_COOKED_SHAPE_MAGIC;
+	header.m_version = B3_COOKED_SHAPE_VERSION;
+	header.m_numIndices = numIndices;
+	header.m_sizeOfVector3 = sizeof(b3Vector3);
+	header.m_sizeOfPolyhedron = sizeof(b3ConvexPolyhedronData);
+	header.m_sizeOfFace = sizeof(b3GpuFace);
+	header.m_sizeOfTreeNode = sizeof(b3QuantizedBvhNode);
+	header.m_sourceKey = sourceKey;
+
+	header.m_collidable = col;
+	header.m_collidable.m_shapeIndex = -1;
+	header.m_localAabb = m_data->m_localShapeAABBCPU->at(collidableIndex);
+	header.m_polyhedron = polyhedron;
+	header.m_polyhedron.m_faceOffset = 0;
+	header.m_polyhedron.m_vertexOffset = 0;
+	header.m_polyhedron.m_uniqueEdgesOffset = 0;
+	if (concave)
+	{
+		header.m_collidable.m_bvhIndex = -1;
+		header.m_bvhInfo = m_data->m_bvhInfoCPU[col.m_bvhIndex];
+		header.m_bvhInfo.m_nodeOffset = 0;
+		header.m_bvhInfo.m_subTreeOffset = 0;
+	}
+
+	int offset = b3AlignCookedOffset(sizeof(b3CookedShapeHeader));
+	header.m_uniqueEdgesOffset = offset;
+	offset = b3AlignCookedOffset(offset + polyhedron.m_numUniqueEdges * sizeof(b3Vector3));
+	header.m_facesOffset = offset;
+	offset = b3AlignCookedOffset(offset + polyhedron.m_numFaces * sizeof(b3GpuFace));
+	header.m_indicesOffset = offset;
+	offset = b3AlignCookedOffset(offset + numIndices * sizeof(int));
+	header.m_verticesOffset = offset;
+	offset = b3AlignCookedOffset(offset + polyhedron.m_numVertices * sizeof(b3Vector3));
+	header.m_treeNodesOffset = offset;
+	offset = b3AlignCookedOffset(offset + header.m_bvhInfo.m_numNodes * sizeof(b3QuantizedBvhNode));
+	header.m_subTreesOffset = offset;
+	offset = b3AlignCookedOffset(offset + header.m_bvhInfo.m_numSubTrees * sizeof(b3BvhSubtreeInfo));
+	header.m_triangleInfosOffset = offset;
+	offset = b3AlignCookedOffset(offset + (concave ? polyhedron.m_numFaces : 0) * sizeof(b3TriangleInfo));
+	header.m_sizeInBytes = offset;
+
+	cookedData.resize(0);
+	cookedData.resize(header.m_sizeInBytes, 0);
+	memcpy(&cookedData[0], &header, sizeof(header));
+	b3WriteCookedArray(cookedData, header.m_uniqueEdgesOffset, m_data->m_uniqueEdges, polyhedron.m_uniqueEdgesOffset, polyhedron.m_numUniqueEdges);
+	b3WriteCookedArray(cookedData, header.m_facesOffset, m_data->m_convexFaces, polyhedron.m_faceOffset, polyhedron.m_numFaces);
+	b3WriteCookedArray(cookedData, header.m_indicesOffset, m_data->m_convexIndices, firstIndex, numIndices);
+	b3WriteCookedArray(cookedData, header.m_verticesOffset, m_data->m_convexVertices, polyhedron.m_vertexOffset, polyhedron.m_numVertices);
+	if (concave)
+	{
+		const b3BvhInfo& bvhInfo = m_data->m_bvhInfoCPU[col.m_bvhIndex];
+		b3WriteCookedArray(cookedData, header.m_treeNodesOffset, m_data->m_treeNodesCPU, bvhInfo.m_nodeOffset, bvhInfo.m_numNodes);
+		b3WriteCookedArray(cookedData, header.m_subTreesOffset, m_data->m_subTreesCPU, bvhInfo.m_subTreeOffset, bvhInfo.m_numSubTrees);
+		b3WriteCookedArray(cookedData, header.m_triangleInfosOffset, m_data->m_triangleInfos, polyhedron.m_faceOffset, polyhedron.m_numFaces);
+	}
+
+	b3GpuFace* faces = (b3GpuFace*)&cookedData[header.m_facesOffset];
+	for (int i = 0; i < polyhedron.m_numFaces; i++)
+	{
+		faces[i].m_indexOffset -= firstIndex;
+	}
+	return true;
+}
+
+int b3GpuNarrowPhase::registerCookedShape(const void* cookedData, int sizeInBytes, unsigned int sourceKey)
+{
+	const unsigned char* data = (const unsigned char*)cookedData;
+	if (!data || sizeInBytes < (int)sizeof(b3CookedShapeHeader))
+	{
+		b3Error("registerCookedShape: the data is too small for a cooked shape\n");
+		return -1;
+	}
+
+	b3CookedShapeHeader header;
+	memcpy(&header, data, sizeof(header));
+	if (header.m_magic != B3_COOKED_SHAPE_MAGIC || header.m_version != B3_COOKED_SHAPE_VERSION)
+	{
+		b3Warning("registerCookedShape: not a cooked shape of version %d\n", B3_COOKED_SHAPE_VERSION);
+		return -1;
+	}
+	if (header.m_sourceKey != sourceKey)
+	{
+		b3Warning("registerCookedShape: the shape was cooked from other inputs\n");
+		return -1;
+	}
+	if (header.m_sizeOfVector3 != sizeof(b3Vector3) || header.m_sizeOfPolyhedron != sizeof(b3ConvexPolyhedronData) ||
+		header.m_sizeOfFace != sizeof(b3GpuFace) || header.m_sizeOfTreeNode != sizeof(b3QuantizedBvhNode))
+	{
+		b3Warning("registerCookedShape: the shape was cooked with another struct layout\n");
+		return -1;
+	}
+	bool concave = header.m_collidable.m_shapeType == SHAPE_CONCAVE_TRIMESH;
+	int size = header.m_sizeInBytes;
+	int numNodes = concave ? header.m_bvhInfo.m_numNodes : 0;
+	int numSubTrees = concave ? header.m_bvhInfo.m_numSubTrees : 0;
+	int numTriangleInfos = concave ? header.m_polyhedron.m_numFaces : 0;
+	if ((!concave && header.m_collidable.m_shapeType != SHAPE_CONVEX_HULL) || size > sizeInBytes ||
+		!b3IsCookedArrayInside(header.m_uniqueEdgesOffset, header.m_polyhedron.m_numUniqueEdges, sizeof(b3Vector3), size) ||
+		!b3IsCookedArrayInside(header.m_facesOffset, header.m_polyhedron.m_numFaces, sizeof(b3GpuFace), size) ||
+		!b3IsCookedArrayInside(header.m_indicesOffset, header.m_numIndices, sizeof(int), size) ||
+		!b3IsCookedArrayInside(header.m_verticesOffset, header.m_polyhedron.m_numVertices, sizeof(b3Vector3), size) ||
+		!b3IsCookedArrayInside(header.m_treeNodesOffset, numNodes, sizeof(b3QuantizedBvhNode), size) ||
+		!b3IsCookedArrayInside(header.m_subTreesOffset, numSubTrees, sizeof(b3BvhSubtreeInfo), size) ||
+		!b3IsCookedArrayInside(header.m_triangleInfosOffset, numTriangleInfos, sizeof(b3TriangleInfo), size))
+	{
+		b3Error("registerCookedShape: the cooked shape is damaged or truncated\n");
+		return -1;
+	}
+
+	int collidableIndex = allocateCollidable();
+	if (collidableIndex < 0)
+		return collidableIndex;
+
+	b3ConvexPolyhedronData polyhedron = header.m_polyhedron;
+	polyhedron.m_faceOffset = m_data->m_convexFaces.size();
+	polyhedron.m_vertexOffset = m_data->m_convexVertices.size();
+	polyhedron.m_uniqueEdgesOffset = m_data->m_uniqueEdges.size();
+	int firstIndex = m_data->m_convexIndices.size();
+
+	//the infos of the faces before this shape have to exist, the ones of a convex hull are added by the next sync
+	syncTriangleInfos();
+	b3AppendCookedArray(m_data->m_triangleInfos, data, header.m_triangleInfosOffset, numTriangleInfos);
+	b3AppendCookedArray(m_data->m_uniqueEdges, data, header.m_uniqueEdgesOffset, polyhedron.m_numUniqueEdges);
+	b3AppendCookedArray(m_data->m_convexFaces, data, header.m_facesOffset, polyhedron.m_numFaces);
+	b3AppendCookedArray(m_data->m_convexIndices, data, header.m_indicesOffset, header.m_numIndices);
+	b3AppendCookedArray(m_data->m_convexVertices, data, header.m_verticesOffset, polyhedron.m_numVertices);
+	for (int i = 0; i < polyhedron.m_numFaces; i++)
+	{
+		m_data->m_convexFaces[polyhedron.m_faceOffset + i].m_indexOffset += firstIndex;
+	}
+
+	int shapeIndex = m_data->m_numAcceleratedShapes++;
+	m_data->m_convexPolyhedra.resize(shapeIndex + 1);
+	m_data->m_convexPolyhedra[shapeIndex] = polyhedron;
+	//a cooked shape has no b3ConvexUtility, the same as a concave mesh, only the buffers above are used for collisions
+	m_data->m_convexData->resize(shapeIndex + 1);
+	(*m_data->m_convexData)[shapeIndex] = 0;
+
+	b3Collidable& col = getCollidableCpu(collidableIndex);
+	col = header.m_collidable;
+	col.m_shapeIndex = shapeIndex;
+	if (concave)
+	{
+		b3BvhInfo bvhInfo = header.m_bvhInfo;
+		bvhInfo.m_nodeOffset = m_data->m_treeNodesCPU.size();
+		bvhInfo.m_subTreeOffset = m_data->m_subTreesCPU.size();
+		b3AppendCookedArray(m_data->m_treeNodesCPU, data, header.m_treeNodesOffset, bvhInfo.m_numNodes);
+		b3AppendCookedArray(m_data->m_subTreesCPU, data, header.m_subTreesOffset, bvhInfo.m_numSubTrees);
+		col.m_bvhIndex = m_data->m_bvhInfoCPU.size();
+		m_data->m_bvhInfoCPU.push_back(bvhInfo);
+		//the cooked nodes replace the b3OptimizedBvh, a null entry keeps m_bvhData parallel to m_bvhInfoCPU
+		m_data->m_bvhData.push_back(0);
+	}
+
+	m_data->m_localShapeAABBCPU->push_back(header.m_localAabb);
+	return collidableIndex;
+}
+
 cl_mem b3GpuNarrowPhase::getBodiesGpu()
 {
 	return (cl_mem)m_data->m_bodyBufferGPU->getBufferCL();
@@ -740,6 +1039,11 @@ int b3GpuNarrowPhase::getNumContactsGpu() const
 {
 	return m_data->m_pBufContactBuffersGPU[m_data->m_currentContactBuffer]->size();
 }
+
+const b3Config& b3GpuNarrowPhase::getConfig() const
+{
+	return m_data->m_config;
+}
 cl_mem b3GpuNarrowPhase::getContactsGpu()
 {
 	return m_data->m_pBufContactBuffersGPU[m_data->m_currentContactBuffer]->getBufferCL();
@@ -751,15 +1055,60 @@ const b3Contact4* b3GpuNarrowPhase::getContactsCPU() const
 	return &m_data->m_pBufContactOutCPU->at(0);
 }
 
-void b3GpuNarrowPhase::computeContacts(cl_mem broadphasePairs, int numBroadphasePairs, cl_mem aabbsWorldSpace, int numObjects)
+//grows the capacities that the last computeConvexConvexContactsGPUSAT ran out of, returns true if any of them grew
+static bool growContactCapacities(b3GpuNarrowPhaseInternalData* data)
 {
-	cl_mem aabbsLocalSpace = m_data->m_localShapeAABBGPU->getBufferCL();
+	b3Config& config = data->m_config;
+	if (config.m_capacityGrowthPolicy == B3_CAPACITY_FIXED)
+		return false;
 
-	int nContactOut = 0;
+	const GpuSatCollision* sat = data->m_gpuSatCollision;
+	bool grown = false;
 
+	if (sat->m_numContactsRequired > config.m_maxContactCapacity)
+	{
+		config.m_maxContactCapacity = b3GrowCapacity(config.m_maxContactCapacity, sat->m_numContactsRequired);
+		//the other buffer still holds the contacts of the previous step, keep them
+		data->m_pBufContactBuffersGPU[0]->reserve(config.m_maxContactCapacity);
+		data->m_pBufContactBuffersGPU[1]->reserve(config.m_maxContactCapacity);
+		grown = true;
+	}
+	if (sat->m_numCompoundPairsRequired > config.m_compoundPairCapacity)
+	{
+		config.m_compoundPairCapacity = b3GrowCapacity(config.m_compoundPairCapacity, sat->m_numCompoundPairsRequired);
+		grown = true;
+	}
+	if (sat->m_numTriConvexPairsRequired > config.m_maxTriConvexPairCapacity)
+	{
+		config.m_maxTriConvexPairCapacity = b3GrowCapacity(config.m_maxTriConvexPairCapacity, sat->m_numTriConvexPairsRequired);
+		data->m_triangleConvexPairs->reserve(config.m_maxTriConvexPairCapacity, false);
+		grown = true;
+	}
+	return grown;
+}
+
+void b3GpuNarrowPhase::computeContacts(cl_mem broadphasePairs, int numBroadphasePairs, cl_mem aabbsWorldSpace, int numObjects)
+{
 	//swap buffer
 	m_data->m_currentContactBuffer = 1 - m_data->m_currentContactBuffer;
 
+	//B3_CAPACITY_GROW_DEFERRED only grows for the next step, B3_CAPACITY_GROW_RERUN computes the contacts again,
+	//growing the compound or triangle-convex pairs can in turn overflow the contacts, so allow a few attempts
+	int maxAttempts = m_data->m_config.m_capacityGrowthPolicy == B3_CAPACITY_GROW_RERUN ? 3 : 1;
+	for (int attempt = 0; attempt < maxAttempts; attempt++)
+	{
+		computeContactsInternal(broadphasePairs, numBroadphasePairs, aabbsWorldSpace, numObjects);
+		if (!growContactCapacities(m_data))
+			break;
+	}
+}
+
+void b3GpuNarrowPhase::computeContactsInternal(cl_mem broadphasePairs, int numBroadphasePairs, cl_mem aabbsWorldSpace, int numObjects)
+{
+	cl_mem aabbsLocalSpace = m_data->m_localShapeAABBGPU->getBufferCL();
+
+	int nContactOut = 0;
+
 	//int curSize = m_data->m_pBufContactBuffersGPU[m_data->m_currentContactBuffer]->size();
 
 	int maxTriConvexPairCapacity = m_data->m_config.m_maxTriConvexPairCapacity;
@@ -786,6 +1135,7 @@ void b3GpuNarrowPhase::computeContacts(cl_mem broadphasePairs, int numBroadphase
 		*m_data->m_convexVerticesGPU,
 		*m_data->m_uniqueEdgesGPU,
 		*m_data->m_convexFacesGPU,
+		*m_data->m_triangleInfosGPU,
 		*m_data->m_convexIndicesGPU,
 		*m_data->m_collidablesGPU,
 		*m_data->m_gpuChildShapes,
@@ -816,20 +1166,33 @@ const b3SapAabb& b3GpuNarrowPhase::getLocalSpaceAabb(int collidableIndex) const
 	return m_data->m_localShapeAABBCPU->at(collidableIndex);
 }
 
-int b3GpuNarrowPhase::registerRigidBody(int collidableIndex, float mass, const float* position, const float* orientation, const float* aabbMinPtr, const float* aabbMaxPtr, bool writeToGpu)
+bool b3GpuNarrowPhase::reserveRigidBodies(int numBodies)
 {
-	b3Vector3 aabbMin = b3MakeVector3(aabbMinPtr[0], aabbMinPtr[1], aabbMinPtr[2]);
-	b3Vector3 aabbMax = b3MakeVector3(aabbMaxPtr[0], aabbMaxPtr[1], aabbMaxPtr[2]);
+	int required = m_data->m_numAcceleratedRigidBodies + numBodies;
 
-	if (m_data->m_numAcceleratedRigidBodies >= (m_data->m_config.m_maxConvexBodies))
+	if (required > m_data->m_config.m_maxConvexBodies && m_data->m_config.m_capacityGrowthPolicy != B3_CAPACITY_FIXED)
 	{
-		b3Error("registerRigidBody: exceeding the number of rigid bodies, %d > %d \n", m_data->m_numAcceleratedRigidBodies, m_data->m_config.m_maxConvexBodies);
-		return -1;
+		int newCapacity = b3GrowCapacity(m_data->m_config.m_maxConvexBodies, required);
+		m_data->m_inertiaBufferCPU->resize(newCapacity);
+		m_data->m_bodyBufferGPU->reserve(newCapacity);
+		m_data->m_inertiaBufferGPU->reserve(newCapacity);
+		m_data->m_config.m_maxConvexBodies = newCapacity;
 	}
 
-	m_data->m_bodyBufferCPU->resize(m_data->m_numAcceleratedRigidBodies + 1);
+	if (required > m_data->m_config.m_maxConvexBodies)
+	{
+		b3Error("registerRigidBody: exceeding the number of rigid bodies, %d > %d \n", required, m_data->m_config.m_maxConvexBodies);
+		return false;
+	}
+	return true;
+}
 
-	b3RigidBodyData& body = m_data->m_bodyBufferCPU->at(m_data->m_numAcceleratedRigidBodies);
+void b3GpuNarrowPhase::initRigidBody(int bodyIndex, int collidableIndex, float mass, const float* position, const float* orientation, const float* aabbMinPtr, const float* aabbMaxPtr)
+{
+	b3Vector3 aabbMin = b3MakeVector3(aabbMinPtr[0], aabbMinPtr[1], aabbMinPtr[2]);
+	b3Vector3 aabbMax = b3MakeVector3(aabbMaxPtr[0], aabbMaxPtr[1], aabbMaxPtr[2]);
+
+	b3RigidBodyData& body = m_data->m_bodyBufferCPU->at(bodyIndex);
 
 	float friction = 1.f;
 	float restitution = 0.f;
@@ -848,22 +1211,17 @@ int b3GpuNarrowPhase::registerRigidBody(int collidableIndex, float mass, const f
 	else
 	{
 		//	body.m_shapeType = CollisionShape::SHAPE_PLANE;
-		m_planeBodyIndex = m_data->m_numAcceleratedRigidBodies;
+		m_planeBodyIndex = bodyIndex;
 	}
 	//body.m_shapeType = shapeType;
 
 	body.m_invMass = mass ? 1.f / mass : 0.f;
 
-	if (writeToGpu)
-	{
-		m_data->m_bodyBufferGPU->copyFromHostPointer(&body, 1, m_data->m_numAcceleratedRigidBodies);
-	}
-
-	b3InertiaData& shapeInfo = m_data->m_inertiaBufferCPU->at(m_data->m_numAcceleratedRigidBodies);
+	b3InertiaData& shapeInfo = m_data->m_inertiaBufferCPU->at(bodyIndex);
 
 	if (mass == 0.f)
 	{
-		if (m_data->m_numAcceleratedRigidBodies == 0)
+		if (bodyIndex == 0)
 			m_static0Index = 0;
 
 		shapeInfo.m_initInvInertia.setValue(0, 0, 0, 0, 0, 0, 0, 0, 0);
@@ -903,11 +1261,142 @@ int b3GpuNarrowPhase::registerRigidBody(int collidableIndex, float mass, const f
 
 		shapeInfo.m_invInertiaWorld = m.scaled(invLocalInertia) * m.transpose();
 	}
+}
+
+int b3GpuNarrowPhase::registerRigidBody(int collidableIndex, float mass, const float* position, const float* orientation, const float* aabbMinPtr, const float* aabbMaxPtr, bool writeToGpu)
+{
+	syncBodyUploads();
+	int bodyIndex = -1;
+	if (m_data->m_freeBodySlots.size())
+	{
+		bodyIndex = m_data->m_freeBodySlots[m_data->m_freeBodySlots.size() - 1];
+		m_data->m_freeBodySlots.pop_back();
+		m_data->m_bodyRemoved[bodyIndex] = 0;
+	}
+	else
+	{
+		if (!reserveRigidBodies(1))
+			return -1;
+
+		bodyIndex = m_data->m_numAcceleratedRigidBodies++;
+		m_data->m_bodyBufferCPU->resize(bodyIndex + 1);
+	}
+
+	initRigidBody(bodyIndex, collidableIndex, mass, position, orientation, aabbMinPtr, aabbMaxPtr);
 
 	if (writeToGpu)
-		m_data->m_inertiaBufferGPU->copyFromHostPointer(&shapeInfo, 1, m_data->m_numAcceleratedRigidBodies);
+	{
+		m_data->m_bodyBufferGPU->copyFromHostPointer(&m_data->m_bodyBufferCPU->at(bodyIndex), 1, bodyIndex);
+		m_data->m_inertiaBufferGPU->copyFromHostPointer(&m_data->m_inertiaBufferCPU->at(bodyIndex), 1, bodyIndex);
+	}
+	else
+	{
+		m_data->m_dirtyBodies.markDirty(bodyIndex);
+		m_data->m_dirtyInertias.markDirty(bodyIndex);
+	}
 
-	return m_data->m_numAcceleratedRigidBodies++;
+	return bodyIndex;
+}
+
+int b3GpuNarrowPhase::registerRigidBodies(int numBodies, const int* collidableIndices, const float* masses, const float* positions, const float* orientations, const float* aabbMins, const float* aabbMaxs, bool writeToGpu, int* bodyIndices)
+{
+	if (numBodies <= 0)
+		return -1;
+	syncBodyUploads();
+
+	//reuse the slots of removed bodies first, like registerRigidBody, and append the rest as one range
+	int numReused = b3Min(numBodies, m_data->m_freeBodySlots.size());
+	int numAppended = numBodies - numReused;
+	if (numAppended && !reserveRigidBodies(numAppended))
+		return -1;
+
+	for (int i = 0; i < numReused; i++)
+	{
+		int bodyIndex = m_data->m_freeBodySlots[m_data->m_freeBodySlots.size() - 1];
+		m_data->m_freeBodySlots.pop_back();
+		m_data->m_bodyRemoved[bodyIndex] = 0;
+		bodyIndices[i] = bodyIndex;
+	}
+
+	int firstBody = m_data->m_numAcceleratedRigidBodies;
+	m_data->m_bodyBufferCPU->resize(firstBody + numAppended);
+	for (int i = 0; i < numAppended; i++)
+	{
+		bodyIndices[numReused + i] = firstBody + i;
+	}
+	m_data->m_numAcceleratedRigidBodies += numAppended;
+
+	for (int i = 0; i < numBodies; i++)
+	{
+		initRigidBody(bodyIndices[i], collidableIndices[i], masses[i], &positions[i * 4], &orientations[i * 4], &aabbMins[i * 4], &aabbMaxs[i * 4]);
+	}
+
+	if (writeToGpu)
+	{
+		bool waitForCompletion = false;
+		for (int i = 0; i < numReused; i++)
+		{
+			int bodyIndex = bodyIndices[i];
+			m_data->m_bodyBufferGPU->copyFromHostPointer(&m_data->m_bodyBufferCPU->at(bodyIndex), 1, bodyIndex, waitForCompletion);
+			m_data->m_inertiaBufferGPU->copyFromHostPointer(&m_data->m_inertiaBufferCPU->at(bodyIndex), 1, bodyIndex, waitForCompletion);
+		}
+		if (numAppended)
+		{
+			m_data->m_bodyBufferGPU->resize(firstBody + numAppended);
+			m_data->m_inertiaBufferGPU->resize(firstBody + numAppended);
+			m_data->m_bodyBufferGPU->copyFromHostPointer(&m_data->m_bodyBufferCPU->at(firstBody), numAppended, firstBody, waitForCompletion);
+			m_data->m_inertiaBufferGPU->copyFromHostPointer(&m_data->m_inertiaBufferCPU->at(firstBody), numAppended, firstBody, waitForCompletion);
+		}
+		m_data->m_bodyBufferGPU->sync();
+		m_data->m_inertiaBufferGPU->sync();
+	}
+	else
+	{
+		for (int i = 0; i < numReused; i++)
+		{
+			m_data->m_dirtyBodies.markDirty(bodyIndices[i]);
+			m_data->m_dirtyInertias.markDirty(bodyIndices[i]);
+		}
+		m_data->m_dirtyBodies.markDirty(firstBody, numAppended);
+		m_data->m_dirtyInertias.markDirty(firstBody, numAppended);
+	}
+
+	return numReused;
+}
+
+void b3GpuNarrowPhase::removeRigidBody(int bodyIndex)
+{
+	syncBodyUploads();
+	if (bodyIndex < 0 || bodyIndex >= m_data->m_numAcceleratedRigidBodies || isRigidBodyRemoved(bodyIndex))
+	{
+		b3Warning("removeRigidBody: invalid body %d\n", bodyIndex);
+		return;
+	}
+
+	//the collidable stays valid, so kernels that still visit the slot (aabb update, integration) are safe
+	b3RigidBodyData& body = m_data->m_bodyBufferCPU->at(bodyIndex);
+	body.m_invMass = 0.f;
+	body.m_linVel = b3MakeVector3(0, 0, 0);
+	body.m_angVel = b3MakeVector3(0, 0, 0);
+
+	b3InertiaData& shapeInfo = m_data->m_inertiaBufferCPU->at(bodyIndex);
+	shapeInfo.m_initInvInertia.setValue(0, 0, 0, 0, 0, 0, 0, 0, 0);
+	shapeInfo.m_invInertiaWorld.setValue(0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+	m_data->m_dirtyBodies.markDirty(bodyIndex);
+	m_data->m_dirtyInertias.markDirty(bodyIndex);
+
+	if (bodyIndex >= m_data->m_bodyRemoved.size())
+	{
+		m_data->m_bodyRemoved.resize(m_data->m_bodyBufferCPU->size(), 0);
+	}
+	m_data->m_bodyRemoved[bodyIndex] = 1;
+	m_data->m_freeBodySlots.push_back(bodyIndex);
+}
+
+bool b3GpuNarrowPhase::isRigidBodyRemoved(int bodyIndex) const
+{
+	return bodyIndex < m_data->m_bodyRemoved.size() && m_data->m_bodyRemoved[bodyIndex];
 }
 
 int b3GpuNarrowPhase::getNumRigidBodies() const
@@ -917,39 +1406,127 @@ int b3GpuNarrowPhase::getNumRigidBodies() const
 
 void b3GpuNarrowPhase::writeAllBodiesToGpu()
 {
+	//enqueue all uploads without blocking, so the transfers can overlap, and wait once at the end
+	bool waitForCompletion = false;
+
 	if (m_data->m_localShapeAABBCPU->size())
 	{
-		m_data->m_localShapeAABBGPU->copyFromHost(*m_data->m_localShapeAABBCPU);
+		m_data->m_localShapeAABBGPU->copyFromHost(*m_data->m_localShapeAABBCPU, waitForCompletion);
 	}
 
-	m_data->m_gpuChildShapes->copyFromHost(m_data->m_cpuChildShapes);
-	m_data->m_convexFacesGPU->copyFromHost(m_data->m_convexFaces);
-	m_data->m_convexPolyhedraGPU->copyFromHost(m_data->m_convexPolyhedra);
-	m_data->m_uniqueEdgesGPU->copyFromHost(m_data->m_uniqueEdges);
-	m_data->m_convexVerticesGPU->copyFromHost(m_data->m_convexVertices);
-	m_data->m_convexIndicesGPU->copyFromHost(m_data->m_convexIndices);
-	m_data->m_bvhInfoGPU->copyFromHost(m_data->m_bvhInfoCPU);
-	m_data->m_treeNodesGPU->copyFromHost(m_data->m_treeNodesCPU);
-	m_data->m_subTreesGPU->copyFromHost(m_data->m_subTreesCPU);
+	m_data->m_gpuChildShapes->copyFromHost(m_data->m_cpuChildShapes, waitForCompletion);
+	m_data->m_convexFacesGPU->copyFromHost(m_data->m_convexFaces, waitForCompletion);
+	syncTriangleInfos();
+	m_data->m_triangleInfosGPU->copyFromHost(m_data->m_triangleInfos, waitForCompletion);
+	m_data->m_convexPolyhedraGPU->copyFromHost(m_data->m_convexPolyhedra, waitForCompletion);
+	m_data->m_uniqueEdgesGPU->copyFromHost(m_data->m_uniqueEdges, waitForCompletion);
+	m_data->m_convexVerticesGPU->copyFromHost(m_data->m_convexVertices, waitForCompletion);
+	m_data->m_convexIndicesGPU->copyFromHost(m_data->m_convexIndices, waitForCompletion);
+	m_data->m_bvhInfoGPU->copyFromHost(m_data->m_bvhInfoCPU, waitForCompletion);
+	m_data->m_treeNodesGPU->copyFromHost(m_data->m_treeNodesCPU, waitForCompletion);
+	m_data->m_subTreesGPU->copyFromHost(m_data->m_subTreesCPU, waitForCompletion);
 
 	m_data->m_bodyBufferGPU->resize(m_data->m_numAcceleratedRigidBodies);
 	m_data->m_inertiaBufferGPU->resize(m_data->m_numAcceleratedRigidBodies);
 
 	if (m_data->m_numAcceleratedRigidBodies)
 	{
-		m_data->m_bodyBufferGPU->copyFromHostPointer(&m_data->m_bodyBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies);
-		m_data->m_inertiaBufferGPU->copyFromHostPointer(&m_data->m_inertiaBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies);
+		m_data->m_bodyBufferGPU->copyFromHostPointer(&m_data->m_bodyBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies, 0, waitForCompletion);
+		m_data->m_inertiaBufferGPU->copyFromHostPointer(&m_data->m_inertiaBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies, 0, waitForCompletion);
 	}
 	if (m_data->m_collidablesCPU.size())
 	{
-		m_data->m_collidablesGPU->copyFromHost(m_data->m_collidablesCPU);
+		m_data->m_collidablesGPU->copyFromHost(m_data->m_collidablesCPU, waitForCompletion);
+	}
+	m_data->m_dirtyBodies.clear();
+	m_data->m_dirtyInertias.clear();
+
+	m_data->m_localShapeAABBGPU->sync();
+	m_data->m_gpuChildShapes->sync();
+	m_data->m_convexFacesGPU->sync();
+	m_data->m_triangleInfosGPU->sync();
+	m_data->m_convexPolyhedraGPU->sync();
+	m_data->m_uniqueEdgesGPU->sync();
+	m_data->m_convexVerticesGPU->sync();
+	m_data->m_convexIndicesGPU->sync();
+	m_data->m_bvhInfoGPU->sync();
+	m_data->m_treeNodesGPU->sync();
+	m_data->m_subTreesGPU->sync();
+	m_data->m_bodyBufferGPU->sync();
+	m_data->m_inertiaBufferGPU->sync();
+	m_data->m_collidablesGPU->sync();
+}
+
+///uploads the elements appended to hostArray since the last upload, shape data is only ever appended
+template <typename T>
+static void b3WriteAppendedToGpu(const b3AlignedObjectArray<T>& hostArray, b3OpenCLArray<T>* deviceArray)
+{
+	int numUploaded = deviceArray->size();
+	if (hostArray.size() > numUploaded)
+	{
+		deviceArray->resize(hostArray.size());
+		deviceArray->copyFromHostPointerAsync(&hostArray[numUploaded], hostArray.size() - numUploaded, numUploaded);
 	}
 }
 
+void b3GpuNarrowPhase::writeChangedBodiesToGpu()
+{
+	b3WriteAppendedToGpu(*m_data->m_localShapeAABBCPU, m_data->m_localShapeAABBGPU);
+	b3WriteAppendedToGpu(m_data->m_cpuChildShapes, m_data->m_gpuChildShapes);
+	b3WriteAppendedToGpu(m_data->m_convexFaces, m_data->m_convexFacesGPU);
+	syncTriangleInfos();
+	b3WriteAppendedToGpu(m_data->m_triangleInfos, m_data->m_triangleInfosGPU);
+	b3WriteAppendedToGpu(m_data->m_convexPolyhedra, m_data->m_convexPolyhedraGPU);
+	b3WriteAppendedToGpu(m_data->m_uniqueEdges, m_data->m_uniqueEdgesGPU);
+	b3WriteAppendedToGpu(m_data->m_convexVertices, m_data->m_convexVerticesGPU);
+	b3WriteAppendedToGpu(m_data->m_convexIndices, m_data->m_convexIndicesGPU);
+	b3WriteAppendedToGpu(m_data->m_bvhInfoCPU, m_data->m_bvhInfoGPU);
+	b3WriteAppendedToGpu(m_data->m_treeNodesCPU, m_data->m_treeNodesGPU);
+	b3WriteAppendedToGpu(m_data->m_subTreesCPU, m_data->m_subTreesGPU);
+	b3WriteAppendedToGpu(m_data->m_collidablesCPU, m_data->m_collidablesGPU);
+
+	//the device owns the simulated state, so only the touched bodies are written, never the ranges in between
+	bool waitForCompletion = false;
+	int numBodies = m_data->m_numAcceleratedRigidBodies;
+	const b3RigidBodyData* bodies = numBodies ? &m_data->m_bodyBufferCPU->at(0) : 0;
+	const b3InertiaData* inertias = numBodies ? &m_data->m_inertiaBufferCPU->at(0) : 0;
+	m_data->m_bodyBufferGPU->copyDirtyFromHostPointer(bodies, numBodies, m_data->m_dirtyBodies, waitForCompletion);
+	m_data->m_inertiaBufferGPU->copyDirtyFromHostPointer(inertias, numBodies, m_data->m_dirtyInertias, waitForCompletion);
+
+	m_data->m_localShapeAABBGPU->sync();
+	m_data->m_gpuChildShapes->sync();
+	m_data->m_convexFacesGPU->sync();
+	m_data->m_triangleInfosGPU->sync();
+	m_data->m_convexPolyhedraGPU->sync();
+	m_data->m_uniqueEdgesGPU->sync();
+	m_data->m_convexVerticesGPU->sync();
+	m_data->m_convexIndicesGPU->sync();
+	m_data->m_bvhInfoGPU->sync();
+	m_data->m_treeNodesGPU->sync();
+	m_data->m_subTreesGPU->sync();
+	m_data->m_collidablesGPU->sync();
+}
+
+void b3GpuNarrowPhase::addBodyUploadWaitEvents(b3LauncherCL& launcher) const
+{
+	launcher.addWaitEvents(*m_data->m_bodyBufferGPU);
+	launcher.addWaitEvents(*m_data->m_inertiaBufferGPU);
+}
+
+void b3GpuNarrowPhase::syncBodyUploads()
+{
+	m_data->m_bodyBufferGPU->sync();
+	m_data->m_inertiaBufferGPU->sync();
+}
+
 void b3GpuNarrowPhase::reset()
 {
 	m_data->m_numAcceleratedShapes = 0;
 	m_data->m_numAcceleratedRigidBodies = 0;
+	m_data->m_freeBodySlots.resize(0);
+	m_data->m_bodyRemoved.resize(0);
+	m_data->m_dirtyBodies.clear();
+	m_data->m_dirtyInertias.clear();
 	this->m_static0Index = -1;
 	m_data->m_uniqueEdges.resize(0);
 	m_data->m_convexVertices.resize(0);
@@ -957,6 +1534,7 @@ void b3GpuNarrowPhase::reset()
 	m_data->m_convexIndices.resize(0);
 	m_data->m_cpuChildShapes.resize(0);
 	m_data->m_convexFaces.resize(0);
+	m_data->m_triangleInfos.resize(0);
 	m_data->m_collidablesCPU.resize(0);
 	m_data->m_localShapeAABBCPU->resize(0);
 	m_data->m_bvhData.resize(0);
@@ -965,17 +1543,24 @@ void b3GpuNarrowPhase::reset()
 	m_data->m_bvhInfoCPU.resize(0);
 }
 
-void b3GpuNarrowPhase::readbackAllBodiesToCpu()
+void b3GpuNarrowPhase::readbackAllBodiesToCpu(bool waitForCompletion)
+{
+	m_data->m_bodyBufferGPU->copyToHostPointer(&m_data->m_bodyBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies, 0, waitForCompletion);
+}
+
+void b3GpuNarrowPhase::waitForBodyReadback()
 {
-	m_data->m_bodyBufferGPU->copyToHostPointer(&m_data->m_bodyBufferCPU->at(0), m_data->m_numAcceleratedRigidBodies);
+	m_data->m_bodyBufferGPU->sync();
 }
 
 void b3GpuNarrowPhase::setObjectTransformCpu(float* position, float* orientation, int bodyIndex)
 {
+	syncBodyUploads();
 	if (bodyIndex >= 0 && bodyIndex < m_data->m_bodyBufferCPU->size())
 	{
 		m_data->m_bodyBufferCPU->at(bodyIndex).m_pos = b3MakeVector3(position[0], position[1], position[2]);
 		m_data->m_bodyBufferCPU->at(bodyIndex).m_quat.setValue(orientation[0], orientation[1], orientation[2], orientation[3]);
+		m_data->m_dirtyBodies.markDirty(bodyIndex);
 	}
 	else
 	{
@@ -984,10 +1569,12 @@ void b3GpuNarrowPhase::setObjectTransformCpu(float* position, float* orientation
 }
 void b3GpuNarrowPhase::setObjectVelocityCpu(float* linVel, float* angVel, int bodyIndex)
 {
+	syncBodyUploads();
 	if (bodyIndex >= 0 && bodyIndex < m_data->m_bodyBufferCPU->size())
 	{
 		m_data->m_bodyBufferCPU->at(bodyIndex).m_linVel = b3MakeVector3(linVel[0], linVel[1], linVel[2]);
 		m_data->m_bodyBufferCPU->at(bodyIndex).m_angVel = b3MakeVector3(angVel[0], angVel[1], angVel[2]);
+		m_data->m_dirtyBodies.markDirty(bodyIndex);
 	}
 	else
 	{
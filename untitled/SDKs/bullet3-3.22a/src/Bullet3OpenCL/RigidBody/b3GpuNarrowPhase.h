@@ -20,6 +20,11 @@ protected:
 
 	int registerConvexHullShapeInternal(class b3ConvexUtility* convexPtr, b3Collidable& col);
 	int registerConcaveMeshShape(b3AlignedObjectArray<b3Vector3>* vertices, b3AlignedObjectArray<int>* indices, b3Collidable& col, const float* scaling);
+	void computeTriangleInfos(const b3AlignedObjectArray<b3Vector3>& vertices, const b3AlignedObjectArray<int>& indices, const b3Vector3& scaling);
+	void syncTriangleInfos();
+	void computeContactsInternal(cl_mem broadphasePairs, int numBroadphasePairs, cl_mem aabbsWorldSpace, int numObjects);
+	bool reserveRigidBodies(int numBodies);
+	void initRigidBody(int bodyIndex, int collidableIndex, float mass, const float* position, const float* orientation, const float* aabbMin, const float* aabbMax);
 
 public:
 	b3GpuNarrowPhase(cl_context vtx, cl_device_id dev, cl_command_queue q, const struct b3Config& config);
@@ -39,12 +44,37 @@ public:
 	int registerConvexHullShape(b3ConvexUtility* utilPtr);
 	int registerConvexHullShape(const float* vertices, int strideInBytes, int numVertices, const float* scaling);
 
+	///writes the collision data of a convex hull or concave mesh collidable into cookedData, see b3GpuCookedShape.h
+	///sourceKey identifies the inputs the shape was built from, such as a hash of the scaling of its vertices
+	bool cookShape(int collidableIndex, b3AlignedObjectArray<unsigned char>& cookedData, unsigned int sourceKey = 0) const;
+	///registers a shape written by cookShape, for example straight from a memory mapped file, without building it again
+	///returns the collidable index, or -1 when the data is not a cooked shape of this version and struct layout,
+	///or was cooked with another sourceKey, then the inputs changed and the shape has to be cooked again
+	int registerCookedShape(const void* cookedData, int sizeInBytes, unsigned int sourceKey = 0);
+
 	int registerRigidBody(int collidableIndex, float mass, const float* position, const float* orientation, const float* aabbMin, const float* aabbMax, bool writeToGpu);
+	///registers numBodies bodies at once, reusing the free slots first and growing the buffers a single time for the rest
+	///positions, orientations, aabbMins and aabbMaxs hold 4 floats per body, the index of each body is written to bodyIndices
+	///returns how many of them reused the slot of a removed body (those come first in bodyIndices), or -1 on failure
+	int registerRigidBodies(int numBodies, const int* collidableIndices, const float* masses, const float* positions, const float* orientations, const float* aabbMins, const float* aabbMaxs, bool writeToGpu, int* bodyIndices);
+	///turns the body into an inert static body and puts its slot on the free list, the next registerRigidBody reuses it
+	///the body keeps its index, so it has to be removed from the broadphase as well to stop it from colliding
+	void removeRigidBody(int bodyIndex);
+	bool isRigidBodyRemoved(int bodyIndex) const;
 	void setObjectTransform(const float* position, const float* orientation, int bodyIndex);
 
 	void writeAllBodiesToGpu();
+	///uploads only the bodies registered, removed or changed on the cpu since the last upload, and the shapes registered since then
+	///the body and inertia uploads are left in flight, see addBodyUploadWaitEvents
+	void writeChangedBodiesToGpu();
+	///lets the next launch of the launcher wait for the body uploads still in flight
+	void addBodyUploadWaitEvents(class b3LauncherCL& launcher) const;
+	///waits for the body uploads, the functions that change the bodies on the cpu call it first
+	void syncBodyUploads();
 	void reset();
-	void readbackAllBodiesToCpu();
+	///with waitForCompletion false the readback is only enqueued, call waitForBodyReadback before accessing the bodies on the CPU
+	void readbackAllBodiesToCpu(bool waitForCompletion = true);
+	void waitForBodyReadback();
 	bool getObjectTransformFromCpu(float* position, float* orientation, int bodyIndex) const;
 
 	void setObjectTransformCpu(float* position, float* orientation, int bodyIndex);
@@ -72,6 +102,9 @@ public:
 	cl_mem getContactsGpu();
 	int getNumContactsGpu() const;
 
+	///the config with the capacities grown so far, see b3Config::m_capacityGrowthPolicy
+	const struct b3Config& getConfig() const;
+
 	cl_mem getAabbLocalSpaceBufferGpu();
 
 	int getNumRigidBodies() const;
@@ -6,6 +6,7 @@
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3ConvexPolyhedronData.h"
 #include "Bullet3Collision/NarrowPhaseCollision/b3Config.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3Collidable.h"
+#include "Bullet3Collision/NarrowPhaseCollision/shared/b3TriangleInfo.h"
 
 #include "Bullet3OpenCL/Initialize/b3OpenCLInclude.h"
 #include "Bullet3Common/b3AlignedObjectArray.h"
@@ -48,6 +49,10 @@ struct b3GpuNarrowPhaseInternalData
 	b3AlignedObjectArray<b3GpuFace> m_convexFaces;
 	b3OpenCLArray<b3GpuFace>* m_convexFacesGPU;
 
+	///one per face, only the triangles of concave meshes have edge information, see syncTriangleInfos
+	b3AlignedObjectArray<b3TriangleInfo> m_triangleInfos;
+	b3OpenCLArray<b3TriangleInfo>* m_triangleInfosGPU;
+
 	struct GpuSatCollision* m_gpuSatCollision;
 
 	b3OpenCLArray<b3Int4>* m_triangleConvexPairs;
@@ -65,12 +70,20 @@ struct b3GpuNarrowPhaseInternalData
 	int m_numAcceleratedShapes;
 	int m_numAcceleratedRigidBodies;
 
+	///slots of removed bodies, reused by registerRigidBody
+	b3AlignedObjectArray<int> m_freeBodySlots;
+	b3AlignedObjectArray<unsigned char> m_bodyRemoved;
+	///bodies changed on the host since the last upload, see writeChangedBodiesToGpu
+	b3DirtyElements m_dirtyBodies;
+	b3DirtyElements m_dirtyInertias;
+
 	b3AlignedObjectArray<b3Collidable> m_collidablesCPU;
 	b3OpenCLArray<b3Collidable>* m_collidablesGPU;
 
 	b3OpenCLArray<b3SapAabb>* m_localShapeAABBGPU;
 	b3AlignedObjectArray<b3SapAabb>* m_localShapeAABBCPU;
 
+	//parallel to m_bvhInfoCPU, null for meshes registered from cooked data
 	b3AlignedObjectArray<class b3OptimizedBvh*> m_bvhData;
 	b3AlignedObjectArray<class b3TriangleIndexVertexArray*> m_meshInterfaces;
 
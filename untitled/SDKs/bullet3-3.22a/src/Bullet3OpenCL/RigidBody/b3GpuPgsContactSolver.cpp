@@ -36,6 +36,17 @@ bool optionalSortContactsDeterminism = true;
 #include "kernels/batchingKernels.h"
 #include "kernels/batchingKernelsNew.h"
 
+//the last colors are merged into the serial batch as long as it stays this small, their own launches would cost more
+#define B3_MAX_SERIAL_COLOR_SIZE 64
+//work items of the launch of one color, the kernels loop over the contacts of larger colors
+#define B3_MAX_COLOR_WORK_ITEMS (16 * 1024)
+//a color holds at most as many contacts as its launch has work items, the rest wait for the next rounds
+#define B3_MAX_COLOR_SIZE B3_MAX_COLOR_WORK_ITEMS
+//the cap ranks the winners of a round with b3PrefixScanCL, which scans at most this many elements
+#define B3_MAX_CAPPED_COLOR_CONTACTS (2048 * 256)
+//limit of the rounds sized from the body degree, the overflow color still fits the 8 bit sort
+#define B3_MAX_SOLVER_COLORS 255
+
 struct b3GpuBatchingPgsSolverInternalData
 {
 	cl_context m_context;
@@ -61,11 +72,28 @@ struct b3GpuBatchingPgsSolverInternalData
 	cl_kernel m_reorderContactKernel;
 	cl_kernel m_copyConstraintKernel;
 
+	cl_kernel m_clearContactCacheKernel;
+	cl_kernel m_buildContactCacheKernel;
+	cl_kernel m_warmStartContactsKernel;
+	cl_kernel m_warmStartContactKernel;
+
 	cl_kernel m_setDeterminismSortDataBodyAKernel;
 	cl_kernel m_setDeterminismSortDataBodyBKernel;
 	cl_kernel m_setDeterminismSortDataChildShapeAKernel;
 	cl_kernel m_setDeterminismSortDataChildShapeBKernel;
 
+	cl_kernel m_resetContactColorsKernel;
+	cl_kernel m_resetBodyClaimsKernel;
+	cl_kernel m_countBodyDegreesKernel;
+	cl_kernel m_claimContactBodiesKernel;
+	cl_kernel m_assignContactColorKernel;
+	cl_kernel m_markColorWinnersKernel;
+	cl_kernel m_assignCappedContactColorKernel;
+	cl_kernel m_setColorSortDataKernel;
+	cl_kernel m_solveColorContactKernel;
+	cl_kernel m_solveColorFrictionKernel;
+	cl_kernel m_warmStartColorContactKernel;
+
 	class b3RadixSort32CL* m_sort32;
 	class b3BoundSearchCL* m_search;
 	class b3PrefixScanCL* m_scan;
@@ -86,6 +114,27 @@ struct b3GpuBatchingPgsSolverInternalData
 
 	b3AlignedObjectArray<int> m_batchSizes;
 	b3OpenCLArray<int>* m_batchSizesGpu;
+
+	//contacts and solved constraints of the previous step, in the same order, for warm starting
+	b3OpenCLArray<b3Contact4>* m_prevContactsGPU;
+	b3OpenCLArray<b3GpuConstraint4>* m_prevConstraintsGPU;
+	b3OpenCLArray<int>* m_contactCacheGPU;
+	int m_numPrevContacts;
+	bool m_warmStarted;
+
+	//graph coloring of the contacts, see colorContacts
+	b3OpenCLArray<int>* m_contactColorsGPU;
+	b3OpenCLArray<unsigned int>* m_bodyClaimsGPU;
+	//the counts of the colors and of the overflow, followed by the largest number of contacts of a dynamic body
+	b3OpenCLArray<int>* m_colorCountsGPU;
+	b3AlignedObjectArray<int> m_colorCounts;
+	b3OpenCLArray<unsigned int>* m_colorWinnersGPU;
+	b3OpenCLArray<unsigned int>* m_colorRanksGPU;
+	//degree of the previous step, it sizes the rounds of the next one
+	int m_maxBodyDegree;
+	//x offset, y number of contacts, z work items of the launch (1 for the serial batch)
+	b3AlignedObjectArray<b3Int4> m_colorBatches;
+	b3SolverBatchStats m_batchStats;
 };
 
 b3GpuPgsContactSolver::b3GpuPgsContactSolver(cl_context ctx, cl_device_id device, cl_command_queue q, int pairCapacity)
@@ -105,7 +154,21 @@ b3GpuPgsContactSolver::b3GpuPgsContactSolver(cl_context ctx, cl_device_id device
 	m_data->m_pBufContactOutGPUCopy = new b3OpenCLArray<b3Contact4>(ctx, q);
 	m_data->m_contactKeyValues = new b3OpenCLArray<b3SortData>(ctx, q);
 
-	m_data->m_solverGPU = new b3Solver(ctx, device, q, 512 * 1024);
+	m_data->m_prevContactsGPU = new b3OpenCLArray<b3Contact4>(ctx, q);
+	m_data->m_prevConstraintsGPU = new b3OpenCLArray<b3GpuConstraint4>(ctx, q);
+	m_data->m_contactCacheGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_numPrevContacts = 0;
+	m_data->m_warmStarted = false;
+
+	m_data->m_contactColorsGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_bodyClaimsGPU = new b3OpenCLArray<unsigned int>(ctx, q);
+	m_data->m_colorCountsGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_colorWinnersGPU = new b3OpenCLArray<unsigned int>(ctx, q);
+	m_data->m_colorRanksGPU = new b3OpenCLArray<unsigned int>(ctx, q);
+	m_data->m_maxBodyDegree = 0;
+	memset(&m_data->m_batchStats, 0, sizeof(b3SolverBatchStats));
+
+	m_data->m_solverGPU = new b3Solver(ctx, device, q, pairCapacity);
 
 	m_data->m_sort32 = new b3RadixSort32CL(ctx, device, m_data->m_queue);
 	m_data->m_scan = new b3PrefixScanCL(ctx, device, m_data->m_queue, B3_SOLVER_N_CELLS);
@@ -157,12 +220,29 @@ b3GpuPgsContactSolver::b3GpuPgsContactSolver(cl_context ctx, cl_device_id device
 		m_data->m_solveSingleContactKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveContactSource, "solveSingleContactKernel", &pErrNum, solveContactProg, additionalMacros);
 		b3Assert(m_data->m_solveSingleContactKernel);
 
+		m_data->m_warmStartContactKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveContactSource, "BatchWarmStartKernelContact", &pErrNum, solveContactProg, additionalMacros);
+		b3Assert(m_data->m_warmStartContactKernel);
+
 		m_data->m_solveSingleFrictionKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveFrictionSource, "solveSingleFrictionKernel", &pErrNum, solveFrictionProg, additionalMacros);
 		b3Assert(m_data->m_solveSingleFrictionKernel);
 
+		m_data->m_solveColorContactKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveContactSource, "SolveColorContactKernel", &pErrNum, solveContactProg, additionalMacros);
+		b3Assert(m_data->m_solveColorContactKernel);
+		m_data->m_warmStartColorContactKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveContactSource, "WarmStartColorContactKernel", &pErrNum, solveContactProg, additionalMacros);
+		b3Assert(m_data->m_warmStartColorContactKernel);
+		m_data->m_solveColorFrictionKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solveFrictionSource, "SolveColorFrictionKernel", &pErrNum, solveFrictionProg, additionalMacros);
+		b3Assert(m_data->m_solveColorFrictionKernel);
+
 		m_data->m_contactToConstraintKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetupSource, "ContactToConstraintKernel", &pErrNum, solverSetupProg, additionalMacros);
 		b3Assert(m_data->m_contactToConstraintKernel);
 
+		m_data->m_clearContactCacheKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetupSource, "ClearContactCacheKernel", &pErrNum, solverSetupProg, additionalMacros);
+		b3Assert(m_data->m_clearContactCacheKernel);
+		m_data->m_buildContactCacheKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetupSource, "BuildContactCacheKernel", &pErrNum, solverSetupProg, additionalMacros);
+		b3Assert(m_data->m_buildContactCacheKernel);
+		m_data->m_warmStartContactsKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetupSource, "WarmStartContactsKernel", &pErrNum, solverSetupProg, additionalMacros);
+		b3Assert(m_data->m_warmStartContactsKernel);
+
 		m_data->m_setSortDataKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "SetSortDataKernel", &pErrNum, solverSetup2Prog, additionalMacros);
 		b3Assert(m_data->m_setSortDataKernel);
 
@@ -183,6 +263,23 @@ b3GpuPgsContactSolver::b3GpuPgsContactSolver(cl_context ctx, cl_device_id device
 
 		m_data->m_copyConstraintKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "CopyConstraintKernel", &pErrNum, solverSetup2Prog, additionalMacros);
 		b3Assert(m_data->m_copyConstraintKernel);
+
+		m_data->m_resetContactColorsKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "ResetContactColorsKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_resetContactColorsKernel);
+		m_data->m_resetBodyClaimsKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "ResetBodyClaimsKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_resetBodyClaimsKernel);
+		m_data->m_countBodyDegreesKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "CountBodyDegreesKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_countBodyDegreesKernel);
+		m_data->m_claimContactBodiesKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "ClaimContactBodiesKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_claimContactBodiesKernel);
+		m_data->m_assignContactColorKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "AssignContactColorKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_assignContactColorKernel);
+		m_data->m_markColorWinnersKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "MarkColorWinnersKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_markColorWinnersKernel);
+		m_data->m_assignCappedContactColorKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "AssignCappedContactColorKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_assignCappedContactColorKernel);
+		m_data->m_setColorSortDataKernel = b3OpenCLUtils::compileCLKernelFromString(ctx, device, solverSetup2Source, "SetColorSortDataKernel", &pErrNum, solverSetup2Prog, additionalMacros);
+		b3Assert(m_data->m_setColorSortDataKernel);
 	}
 
 	{
@@ -211,6 +308,16 @@ b3GpuPgsContactSolver::~b3GpuPgsContactSolver()
 	delete m_data->m_pBufContactOutGPUCopy;
 	delete m_data->m_contactKeyValues;
 
+	delete m_data->m_prevContactsGPU;
+	delete m_data->m_prevConstraintsGPU;
+	delete m_data->m_contactCacheGPU;
+
+	delete m_data->m_contactColorsGPU;
+	delete m_data->m_bodyClaimsGPU;
+	delete m_data->m_colorCountsGPU;
+	delete m_data->m_colorWinnersGPU;
+	delete m_data->m_colorRanksGPU;
+
 	delete m_data->m_contactCGPU;
 	delete m_data->m_numConstraints;
 	delete m_data->m_offsets;
@@ -234,11 +341,28 @@ b3GpuPgsContactSolver::~b3GpuPgsContactSolver()
 	clReleaseKernel(m_data->m_reorderContactKernel);
 	clReleaseKernel(m_data->m_copyConstraintKernel);
 
+	clReleaseKernel(m_data->m_clearContactCacheKernel);
+	clReleaseKernel(m_data->m_buildContactCacheKernel);
+	clReleaseKernel(m_data->m_warmStartContactsKernel);
+	clReleaseKernel(m_data->m_warmStartContactKernel);
+
 	clReleaseKernel(m_data->m_setDeterminismSortDataBodyAKernel);
 	clReleaseKernel(m_data->m_setDeterminismSortDataBodyBKernel);
 	clReleaseKernel(m_data->m_setDeterminismSortDataChildShapeAKernel);
 	clReleaseKernel(m_data->m_setDeterminismSortDataChildShapeBKernel);
 
+	clReleaseKernel(m_data->m_resetContactColorsKernel);
+	clReleaseKernel(m_data->m_resetBodyClaimsKernel);
+	clReleaseKernel(m_data->m_countBodyDegreesKernel);
+	clReleaseKernel(m_data->m_claimContactBodiesKernel);
+	clReleaseKernel(m_data->m_assignContactColorKernel);
+	clReleaseKernel(m_data->m_markColorWinnersKernel);
+	clReleaseKernel(m_data->m_assignCappedContactColorKernel);
+	clReleaseKernel(m_data->m_setColorSortDataKernel);
+	clReleaseKernel(m_data->m_solveColorContactKernel);
+	clReleaseKernel(m_data->m_solveColorFrictionKernel);
+	clReleaseKernel(m_data->m_warmStartColorContactKernel);
+
 	delete m_data;
 }
 
@@ -330,6 +454,32 @@ void b3GpuPgsContactSolver::solveContactConstraint(const b3OpenCLArray<b3RigidBo
 		adl::b3OpenCLArray<SolverDebugInfo> gpuDebugInfo(data->m_device, numWorkItems);
 #endif
 
+		if (m_data->m_warmStarted)
+		{
+			B3_PROFILE("m_warmStartContactKernel");
+			for (int ib = 0; ib < B3_SOLVER_N_BATCHES; ib++)
+			{
+				b3BufferInfoCL bInfo[] = {
+					b3BufferInfoCL(bodyBuf->getBufferCL()),
+					b3BufferInfoCL(shapeBuf->getBufferCL()),
+					b3BufferInfoCL(constraint->getBufferCL()),
+					b3BufferInfoCL(m_data->m_solverGPU->m_numConstraints->getBufferCL()),
+					b3BufferInfoCL(m_data->m_solverGPU->m_offsets->getBufferCL())};
+
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_warmStartContactKernel, "m_warmStartContactKernel");
+				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+				launcher.setBuffer(m_data->m_solverGPU->m_batchSizes.getBufferCL());
+				launcher.setConst(cdata.y);
+				launcher.setConst(ib);
+				b3Int4 nSplit;
+				nSplit.x = B3_SOLVER_N_SPLIT_X;
+				nSplit.y = B3_SOLVER_N_SPLIT_Y;
+				nSplit.z = B3_SOLVER_N_SPLIT_Z;
+				launcher.setConst(nSplit);
+				launcher.launch1D(numWorkItems, 64);
+			}
+		}
+
 		{
 			B3_PROFILE("m_batchSolveKernel iterations");
 			for (int iter = 0; iter < numIterations; iter++)
@@ -569,9 +719,11 @@ void SetSortDataCPU(b3Contact4* gContact, b3RigidBodyData* gBodies, b3SortData*
 void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem inertiaBuf, int numContacts, cl_mem contactBuf, const b3Config& config, int static0Index)
 {
 	B3_PROFILE("solveContacts");
+	B3_GPU_STAGE("solve");
 	m_data->m_bodyBufferGPU->setFromOpenCLBuffer(bodyBuf, numBodies);
 	m_data->m_inertiaBufferGPU->setFromOpenCLBuffer(inertiaBuf, numBodies);
 	m_data->m_pBufContactOutGPU->setFromOpenCLBuffer(contactBuf, numContacts);
+	reserveContactCapacity(numContacts);
 
 	if (optionalSortContactsDeterminism)
 	{
@@ -685,6 +837,13 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
 
 		int maxNumBatches = 0;
 
+		//the host fallbacks below only work with the spatial grid batches
+		bool useGraphColoring = config.m_enableGraphColoring && !gUseLargeBatches && !gCpuBatchContacts && !gCpuSolveConstraint &&
+								!gCpuSetSortData && !gCpuRadixSort && !gUseScanHost && !gReorderContactsOnCpu;
+		memset(&m_data->m_batchStats, 0, sizeof(b3SolverBatchStats));
+		m_data->m_batchStats.m_numConstraints = nContacts;
+		m_data->m_colorBatches.resize(0);
+
 		if (!gUseLargeBatches)
 		{
 			if (m_data->m_solverGPU->m_contactBuffer2)
@@ -701,8 +860,19 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
             clFlush(m_data->m_queue);
             clFinish(m_data->m_queue);
 
+			if (useGraphColoring)
+			{
+				B3_PROFILE("graph coloring");
+				B3_GPU_STAGE("batching");
+				if (nContacts)
+				{
+					colorContacts(m_data->m_pBufContactOutGPU, nContacts, numBodies, csCfg.m_staticIdx, config.m_maxSolverColors);
+				}
+			}
+			else
 			{
 				B3_PROFILE("batching");
+				B3_GPU_STAGE("batching");
 				//@todo: just reserve it, without copy of original contact (unless we use warmstarting)
 
 				//const b3OpenCLArray<b3RigidBodyData>* bodyNative = bodyBuf;
@@ -1049,9 +1219,17 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
 			clFinish(m_data->m_queue);
 		}
 
+		//the impulses are only applied to the bodies by the batched GPU solver
+		bool warmStarting = config.m_enableWarmStarting && !gUseLargeBatches && !gCpuSolveConstraint;
+		m_data->m_warmStarted = false;
+		if (nContacts && warmStarting)
+		{
+			warmStartContacts(m_data->m_solverGPU->m_contactBuffer2, contactConstraintOut, nContacts, config);
+		}
+
 		if (1)
 		{
-			int numIter = 4;
+			int numIter = config.m_numSolverIterations;
 
 			m_data->m_solverGPU->m_nIterations = numIter;  //10
 			if (!gCpuSolveConstraint)
@@ -1068,7 +1246,11 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
 
 				//m_data->m_batchSizesGpu->copyFromHost(m_data->m_batchSizes);
 
-				if (gUseLargeBatches)
+				if (useGraphColoring)
+				{
+					solveColoredContactConstraint(m_data->m_bodyBufferGPU, m_data->m_inertiaBufferGPU, m_data->m_contactCGPU, numIter);
+				}
+				else if (gUseLargeBatches)
 				{
 					solveContactConstraintBatchSizes(m_data->m_bodyBufferGPU,
 													 m_data->m_inertiaBufferGPU,
@@ -1094,6 +1276,15 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
 			}
 		}
 
+		if (warmStarting)
+		{
+			storeContactCache(m_data->m_solverGPU->m_contactBuffer2, contactConstraintOut, nContacts);
+		}
+		else
+		{
+			m_data->m_numPrevContacts = 0;
+		}
+
 #if 0
         if (0)
         {
@@ -1107,6 +1298,357 @@ void b3GpuPgsContactSolver::solveContacts(int numBodies, cl_mem bodyBuf, cl_mem
 	}
 }
 
+void b3GpuPgsContactSolver::warmStartContacts(b3OpenCLArray<b3Contact4>* contacts, b3OpenCLArray<b3GpuConstraint4>* constraints, int nContacts, const b3Config& config)
+{
+	if (m_data->m_numPrevContacts == 0)
+		return;
+
+	B3_PROFILE("gpu warmStartContacts");
+
+	//a contact normal that turned by more than about 18 degrees hardly shares any impulse with the previous step
+	float minNormalDot = 0.95f;
+	float maxDistanceSq = config.m_warmStartingMaxDistance * config.m_warmStartingMaxDistance;
+	int hashMask = m_data->m_contactCacheGPU->size() - 1;
+
+	b3BufferInfoCL bInfo[] = {
+		b3BufferInfoCL(contacts->getBufferCL()),
+		b3BufferInfoCL(constraints->getBufferCL()),
+		b3BufferInfoCL(m_data->m_prevContactsGPU->getBufferCL(), true),
+		b3BufferInfoCL(m_data->m_prevConstraintsGPU->getBufferCL(), true),
+		b3BufferInfoCL(m_data->m_contactCacheGPU->getBufferCL(), true)};
+
+	b3LauncherCL launcher(m_data->m_queue, m_data->m_warmStartContactsKernel, "m_warmStartContactsKernel");
+	launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+	launcher.setConst(nContacts);
+	launcher.setConst(hashMask);
+	launcher.setConst(maxDistanceSq);
+	launcher.setConst(minNormalDot);
+	launcher.setConst(config.m_warmStartingFactor);
+	launcher.launch1D(nContacts, 64);
+
+	m_data->m_warmStarted = true;
+}
+
+void b3GpuPgsContactSolver::storeContactCache(b3OpenCLArray<b3Contact4>* contacts, b3OpenCLArray<b3GpuConstraint4>* constraints, int nContacts)
+{
+	B3_PROFILE("gpu storeContactCache");
+
+	m_data->m_numPrevContacts = nContacts;
+	if (nContacts == 0)
+		return;
+
+	m_data->m_prevContactsGPU->resize(nContacts, false);
+	m_data->m_prevConstraintsGPU->resize(nContacts, false);
+	contacts->copyToCL(m_data->m_prevContactsGPU->getBufferCL(), nContacts);
+	constraints->copyToCL(m_data->m_prevConstraintsGPU->getBufferCL(), nContacts);
+
+	//at most half full, so the linear probing stays short
+	int hashTableSize = 1;
+	while (hashTableSize < 2 * nContacts)
+	{
+		hashTableSize *= 2;
+	}
+	m_data->m_contactCacheGPU->resize(hashTableSize, false);
+
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_clearContactCacheKernel, "m_clearContactCacheKernel");
+		launcher.setBuffer(m_data->m_contactCacheGPU->getBufferCL());
+		launcher.setConst(hashTableSize);
+		launcher.launch1D(hashTableSize);
+	}
+	{
+		int hashMask = hashTableSize - 1;
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_buildContactCacheKernel, "m_buildContactCacheKernel");
+		launcher.setBuffer(m_data->m_prevContactsGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_contactCacheGPU->getBufferCL());
+		launcher.setConst(nContacts);
+		launcher.setConst(hashMask);
+		launcher.launch1D(nContacts);
+	}
+}
+
+void b3GpuPgsContactSolver::colorContacts(b3OpenCLArray<b3Contact4>* contacts, int nContacts, int numBodies, int staticIdx, int maxColors)
+{
+	B3_PROFILE("gpu colorContacts");
+
+	//heuristic: a round colors the local priority minima, so the rounds needed follow the longest chain of decreasing
+	//priorities, which the degree d of the busiest dynamic body only hints at. 2d-1 rounds cover most scenes, the cap
+	//adds rounds for the contacts it turns away and the overflow batch catches the rest. maxColors is the minimum,
+	//the degree is the one of the previous step
+	bool capColors = nContacts > B3_MAX_COLOR_SIZE && nContacts <= B3_MAX_CAPPED_COLOR_CONTACTS;
+	int numColors = b3Max(b3Max(maxColors, 1), 2 * m_data->m_maxBodyDegree - 1);
+	if (capColors)
+	{
+		numColors += nContacts / B3_MAX_COLOR_SIZE;
+	}
+	numColors = b3Min(numColors, B3_MAX_SOLVER_COLORS);
+	int overflowColor = numColors;
+	int maxDegreeSlot = numColors + 1;
+	int numColorCounts = numColors + 2;
+
+	m_data->m_contactColorsGPU->resize(nContacts);
+	m_data->m_bodyClaimsGPU->resize(numBodies);
+	m_data->m_colorCountsGPU->resize(numColorCounts);
+	if (capColors)
+	{
+		m_data->m_colorWinnersGPU->resize(nContacts);
+	}
+
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_colorCountsGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_resetContactColorsKernel, "m_resetContactColorsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nContacts);
+		launcher.setConst(numColorCounts);
+		launcher.launch1D(b3Max(nContacts, numColorCounts), 64);
+	}
+
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_resetBodyClaimsKernel, "m_resetBodyClaimsKernel");
+		launcher.setBuffer(m_data->m_bodyClaimsGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.setConst(0u);
+		launcher.launch1D(numBodies, 64);
+	}
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(contacts->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_bodyClaimsGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_colorCountsGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_countBodyDegreesKernel, "m_countBodyDegreesKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nContacts);
+		launcher.setConst(staticIdx);
+		launcher.setConst(maxDegreeSlot);
+		launcher.launch1D(nContacts, 64);
+	}
+
+	//every round colors at least the uncolored contact with the lowest priority, in practice a large share of them
+	//the rounds after all contacts are colored return right away, so nothing is read back to stop early
+	for (int color = 0; color < numColors; color++)
+	{
+		{
+			b3LauncherCL launcher(m_data->m_queue, m_data->m_resetBodyClaimsKernel, "m_resetBodyClaimsKernel");
+			launcher.setBuffer(m_data->m_bodyClaimsGPU->getBufferCL());
+			launcher.setConst(numBodies);
+			launcher.setConst(0xffffffffu);
+			launcher.launch1D(numBodies, 64);
+		}
+		{
+			b3BufferInfoCL bInfo[] = {
+				b3BufferInfoCL(contacts->getBufferCL(), true),
+				b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL(), true),
+				b3BufferInfoCL(m_data->m_bodyClaimsGPU->getBufferCL())};
+			b3LauncherCL launcher(m_data->m_queue, m_data->m_claimContactBodiesKernel, "m_claimContactBodiesKernel");
+			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+			launcher.setConst(nContacts);
+			launcher.setConst(staticIdx);
+			launcher.launch1D(nContacts, 64);
+		}
+		if (capColors)
+		{
+			//the winners are fixed by the priorities of the contact indices, so the ones within the cap are the same every run
+			{
+				b3BufferInfoCL bInfo[] = {
+					b3BufferInfoCL(contacts->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_bodyClaimsGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_colorWinnersGPU->getBufferCL())};
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_markColorWinnersKernel, "m_markColorWinnersKernel");
+				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+				launcher.setConst(nContacts);
+				launcher.setConst(staticIdx);
+				launcher.launch1D(nContacts, 64);
+			}
+			m_data->m_scan->execute(*m_data->m_colorWinnersGPU, *m_data->m_colorRanksGPU, nContacts);
+			{
+				b3BufferInfoCL bInfo[] = {
+					b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL()),
+					b3BufferInfoCL(m_data->m_colorWinnersGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_colorRanksGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_colorCountsGPU->getBufferCL())};
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_assignCappedContactColorKernel, "m_assignCappedContactColorKernel");
+				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+				launcher.setConst(nContacts);
+				launcher.setConst(color);
+				launcher.setConst(B3_MAX_COLOR_SIZE);
+				launcher.launch1D(nContacts, 64);
+			}
+		}
+		else
+		{
+			b3BufferInfoCL bInfo[] = {
+				b3BufferInfoCL(contacts->getBufferCL(), true),
+				b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL()),
+				b3BufferInfoCL(m_data->m_bodyClaimsGPU->getBufferCL(), true),
+				b3BufferInfoCL(m_data->m_colorCountsGPU->getBufferCL())};
+			b3LauncherCL launcher(m_data->m_queue, m_data->m_assignContactColorKernel, "m_assignContactColorKernel");
+			launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+			launcher.setConst(nContacts);
+			launcher.setConst(staticIdx);
+			launcher.setConst(color);
+			launcher.launch1D(nContacts, 64);
+		}
+	}
+
+	b3OpenCLArray<b3SortData>& sortData = *m_data->m_solverGPU->m_sortDataBuffer;
+	sortData.resize(nContacts);
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_data->m_contactColorsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_colorCountsGPU->getBufferCL()),
+			b3BufferInfoCL(sortData.getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_setColorSortDataKernel, "m_setColorSortDataKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(nContacts);
+		launcher.setConst(overflowColor);
+		launcher.launch1D(nContacts, 64);
+	}
+
+	//the radix sort is stable, so the contacts of a color keep the order of the determinism sort
+	//it needs an even number of 4 bit passes
+	int sortBits = 8;
+	while (sortBits < 32 && (overflowColor >> sortBits))
+	{
+		sortBits += 8;
+	}
+	m_data->m_solverGPU->m_sort32->execute(sortData, sortBits);
+
+	{
+		b3Int4 cdata;
+		cdata.x = nContacts;
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(contacts->getBufferCL()),
+			b3BufferInfoCL(m_data->m_solverGPU->m_contactBuffer2->getBufferCL()),
+			b3BufferInfoCL(sortData.getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_solverGPU->m_reorderContactKernel, "m_reorderContactKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(cdata);
+		launcher.launch1D(nContacts, 64);
+	}
+
+	//the only read back of the batching, the launches of the solver need the size of each color
+	m_data->m_colorCountsGPU->copyToHost(m_data->m_colorCounts);
+	m_data->m_maxBodyDegree = m_data->m_colorCounts[maxDegreeSlot];
+
+	//the last colors are usually tiny, they join the overflow in the serial batch while it stays small
+	int numSerial = m_data->m_colorCounts[overflowColor];
+	int firstSerialColor = numColors;
+	while (firstSerialColor > 0 && numSerial + m_data->m_colorCounts[firstSerialColor - 1] <= B3_MAX_SERIAL_COLOR_SIZE)
+	{
+		firstSerialColor--;
+		numSerial += m_data->m_colorCounts[firstSerialColor];
+	}
+
+	b3SolverBatchStats& stats = m_data->m_batchStats;
+	int offset = 0;
+	int numParallel = 0;
+	for (int color = 0; color < firstSerialColor; color++)
+	{
+		int numInColor = m_data->m_colorCounts[color];
+		if (numInColor)
+		{
+			m_data->m_colorBatches.push_back(b3MakeInt4(offset, numInColor, b3Min(numInColor, B3_MAX_COLOR_WORK_ITEMS), 0));
+			stats.m_largestBatch = b3Max(stats.m_largestBatch, numInColor);
+			stats.m_smallestBatch = stats.m_numBatches ? b3Min(stats.m_smallestBatch, numInColor) : numInColor;
+			stats.m_numBatches++;
+			numParallel += numInColor;
+			offset += numInColor;
+		}
+	}
+	if (numSerial)
+	{
+		m_data->m_colorBatches.push_back(b3MakeInt4(offset, numSerial, 1, 0));
+	}
+	stats.m_numSerialConstraints = numSerial;
+	stats.m_numUncoloredConstraints = m_data->m_colorCounts[overflowColor];
+	stats.m_numColors = numColors;
+	stats.m_maxBodyDegree = m_data->m_maxBodyDegree;
+	stats.m_occupancy = stats.m_numBatches ? float(numParallel) / float(stats.m_numBatches * stats.m_largestBatch) : 0.f;
+}
+
+void b3GpuPgsContactSolver::solveColoredContactConstraint(const b3OpenCLArray<b3RigidBodyData>* bodyBuf, const b3OpenCLArray<b3InertiaData>* shapeBuf,
+														  b3OpenCLArray<b3GpuConstraint4>* constraint, int numIterations)
+{
+	int numBatches = m_data->m_colorBatches.size();
+
+	if (m_data->m_warmStarted)
+	{
+		B3_PROFILE("m_warmStartColorContactKernel");
+		for (int ib = 0; ib < numBatches; ib++)
+		{
+			const b3Int4& batch = m_data->m_colorBatches[ib];
+			b3LauncherCL launcher(m_data->m_queue, m_data->m_warmStartColorContactKernel, "m_warmStartColorContactKernel");
+			launcher.setBuffer(bodyBuf->getBufferCL());
+			launcher.setBuffer(shapeBuf->getBufferCL());
+			launcher.setBuffer(constraint->getBufferCL());
+			launcher.setConst(batch.x);
+			launcher.setConst(batch.y);
+			launcher.launch1D(batch.z, batch.z > 1 ? 64 : 1);
+		}
+	}
+
+	{
+		B3_PROFILE("m_solveColorContactKernel iterations");
+		for (int iter = 0; iter < numIterations; iter++)
+		{
+			for (int ib = 0; ib < numBatches; ib++)
+			{
+				const b3Int4& batch = m_data->m_colorBatches[ib];
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_solveColorContactKernel, "m_solveColorContactKernel");
+				launcher.setBuffer(bodyBuf->getBufferCL());
+				launcher.setBuffer(shapeBuf->getBufferCL());
+				launcher.setBuffer(constraint->getBufferCL());
+				launcher.setConst(batch.x);
+				launcher.setConst(batch.y);
+				launcher.launch1D(batch.z, batch.z > 1 ? 64 : 1);
+			}
+		}
+	}
+
+	{
+		B3_PROFILE("m_solveColorFrictionKernel iterations");
+		for (int iter = 0; iter < numIterations; iter++)
+		{
+			for (int ib = 0; ib < numBatches; ib++)
+			{
+				const b3Int4& batch = m_data->m_colorBatches[ib];
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_solveColorFrictionKernel, "m_solveColorFrictionKernel");
+				launcher.setBuffer(bodyBuf->getBufferCL());
+				launcher.setBuffer(shapeBuf->getBufferCL());
+				launcher.setBuffer(constraint->getBufferCL());
+				launcher.setConst(batch.x);
+				launcher.setConst(batch.y);
+				launcher.launch1D(batch.z, batch.z > 1 ? 64 : 1);
+			}
+		}
+	}
+}
+
+void b3GpuPgsContactSolver::reserveContactCapacity(int contactCapacity)
+{
+	if (contactCapacity <= m_data->m_pairCapacity)
+		return;
+
+	//the set sort data kernels write up to the next multiple of the sort alignment
+	const int sortSize = B3NEXTMULTIPLEOF(contactCapacity, 512);
+	m_data->m_pairCapacity = contactCapacity;
+	m_data->m_sortDataBuffer->reserve(sortSize);
+	m_data->m_solverGPU->m_sortDataBuffer->reserve(sortSize);
+	m_data->m_contactCGPU->reserve(contactCapacity);
+	if (m_data->m_solverGPU->m_contactBuffer2)
+	{
+		m_data->m_solverGPU->m_contactBuffer2->reserve(contactCapacity);
+	}
+}
+
+const b3SolverBatchStats& b3GpuPgsContactSolver::getBatchStats() const
+{
+	return m_data->m_batchStats;
+}
+
 void b3GpuPgsContactSolver::batchContacts(b3OpenCLArray<b3Contact4>* contacts, int nContacts, b3OpenCLArray<unsigned int>* n, b3OpenCLArray<unsigned int>* offsets, int staticIdx)
 {
 }
@@ -8,6 +8,25 @@
 #include "Bullet3Collision/NarrowPhaseCollision/b3Contact4.h"
 #include "b3GpuConstraint4.h"
 
+///batches of the contact solver in the last step, only filled when b3Config::m_enableGraphColoring is used
+struct b3SolverBatchStats
+{
+	int m_numConstraints;
+	///parallel batches (colors), each is one launch per solver iteration
+	int m_numBatches;
+	int m_largestBatch;
+	int m_smallestBatch;
+	///contacts of the last colors and of the overflow, solved by a single work item
+	int m_numSerialConstraints;
+	///contacts still uncolored after the last round, coloring failures that end up in the serial batch
+	int m_numUncoloredConstraints;
+	///coloring rounds of the step and the largest number of contacts of a dynamic body, which sizes the rounds of the next step
+	int m_numColors;
+	int m_maxBodyDegree;
+	///average size of the parallel batches divided by the largest, 1 when all batches have the same size
+	float m_occupancy;
+};
+
 class b3GpuPgsContactSolver
 {
 protected:
@@ -27,11 +46,26 @@ protected:
 	void solveContactConstraint(const b3OpenCLArray<b3RigidBodyData>* bodyBuf, const b3OpenCLArray<b3InertiaData>* shapeBuf,
 								b3OpenCLArray<b3GpuConstraint4>* constraint, void* additionalData, int n, int maxNumBatches, int numIterations, const b3AlignedObjectArray<int>* batchSizes);  //const b3OpenCLArray<int>* gpuBatchSizes);
 
+	///seeds the applied impulses of the constraints with those of the matching contacts of the previous step
+	void warmStartContacts(b3OpenCLArray<b3Contact4>* contacts, b3OpenCLArray<b3GpuConstraint4>* constraints, int nContacts, const struct b3Config& config);
+	///keeps the solved contacts for warm starting the next step
+	void storeContactCache(b3OpenCLArray<b3Contact4>* contacts, b3OpenCLArray<b3GpuConstraint4>* constraints, int nContacts);
+
+	///colors the contacts on the GPU and sorts them by color into the solver's contact buffer, fills the batches and the stats
+	void colorContacts(b3OpenCLArray<b3Contact4>* contacts, int nContacts, int numBodies, int staticIdx, int maxColors);
+	void solveColoredContactConstraint(const b3OpenCLArray<b3RigidBodyData>* bodyBuf, const b3OpenCLArray<b3InertiaData>* shapeBuf,
+									   b3OpenCLArray<b3GpuConstraint4>* constraint, int numIterations);
+
 public:
 	b3GpuPgsContactSolver(cl_context ctx, cl_device_id device, cl_command_queue q, int pairCapacity);
 	virtual ~b3GpuPgsContactSolver();
 
 	void solveContacts(int numBodies, cl_mem bodyBuf, cl_mem inertiaBuf, int numContacts, cl_mem contactBuf, const struct b3Config& config, int static0Index);
+
+	///grows the constraint and sort buffers, solveContacts also grows them to the number of contacts it gets
+	void reserveContactCapacity(int contactCapacity);
+
+	const b3SolverBatchStats& getBatchStats() const;
 };
 
 #endif  //B3_GPU_BATCHING_PGS_SOLVER_H
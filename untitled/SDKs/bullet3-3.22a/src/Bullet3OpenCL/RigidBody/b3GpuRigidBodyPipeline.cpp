@@ -17,6 +17,34 @@ subject to the following restrictions:
 #include "b3GpuRigidBodyPipelineInternalData.h"
 #include "kernels/integrateKernel.h"
 #include "kernels/updateAabbsKernel.h"
+#include "kernels/islandKernels.h"
+#include "kernels/ccdKernels.h"
+#include "kernels/solverSetup.h"
+#include "kernels/solverSetup2.h"
+#include "kernels/solveContact.h"
+#include "kernels/solveFriction.h"
+#include "kernels/batchingKernels.h"
+#include "kernels/batchingKernelsNew.h"
+#include "kernels/solverUtils.h"
+#include "kernels/jointSolver.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/satKernels.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/mprKernels.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/satConcaveKernels.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/satClipHullContacts.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/bvhTraversal.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/primitiveContacts.h"
+#include "Bullet3OpenCL/NarrowphaseCollision/kernels/pairClassification.h"
+#include "Bullet3OpenCL/BroadphaseCollision/kernels/sapKernels.h"
+#include "Bullet3OpenCL/BroadphaseCollision/kernels/gridBroadphaseKernels.h"
+#include "Bullet3OpenCL/BroadphaseCollision/kernels/parallelLinearBvhKernels.h"
+#include "Bullet3OpenCL/BroadphaseCollision/kernels/multiLevelGridBroadphaseKernels.h"
+#include "Bullet3OpenCL/BroadphaseCollision/kernels/adaptiveBroadphaseKernels.h"
+#include "Bullet3OpenCL/ParallelPrimitives/kernels/RadixSort32KernelsCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/kernels/PrefixScanKernelsCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/kernels/PrefixScanKernelsFloat4CL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/kernels/FillKernelsCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/kernels/BoundSearchKernelsCL.h"
+#include "Bullet3OpenCL/Raycast/kernels/rayCastKernels.h"
 
 #include "Bullet3OpenCL/Initialize/b3OpenCLUtils.h"
 #include "b3GpuNarrowPhase.h"
@@ -24,14 +52,18 @@ subject to the following restrictions:
 #include "Bullet3OpenCL/BroadphaseCollision/b3SapAabb.h"
 #include "Bullet3OpenCL/BroadphaseCollision/b3GpuBroadphaseInterface.h"
 #include "Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3GpuProfiler.h"
 #include "Bullet3Dynamics/ConstraintSolver/b3PgsJacobiSolver.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3UpdateAabbs.h"
 #include "Bullet3Collision/BroadPhaseCollision/b3DynamicBvhBroadphase.h"
+#include <string.h>
 
 //#define TEST_OTHER_GPU_SOLVER
 
 #define B3_RIGIDBODY_INTEGRATE_PATH "src/Bullet3OpenCL/RigidBody/kernels/integrateKernel.cl"
 #define B3_RIGIDBODY_UPDATEAABB_PATH "src/Bullet3OpenCL/RigidBody/kernels/updateAabbsKernel.cl"
+#define B3_RIGIDBODY_ISLAND_PATH "src/Bullet3OpenCL/RigidBody/kernels/islandKernels.cl"
+#define B3_RIGIDBODY_CCD_PATH "src/Bullet3OpenCL/RigidBody/kernels/ccdKernels.cl"
 
 bool useBullet2CpuSolver = true;
 
@@ -98,6 +130,10 @@ b3GpuRigidBodyPipeline::b3GpuRigidBodyPipeline(cl_context ctx, cl_device_id devi
 		b3Assert(errNum == CL_SUCCESS);
 		m_data->m_integrateTransformsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, integrateKernelCL, "integrateTransformsKernel", &errNum, prog);
 		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_copyTransformsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, integrateKernelCL, "copyTransformsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_writeWorldMatricesKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, integrateKernelCL, "writeWorldMatricesKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
 		clReleaseProgram(prog);
 	}
 	{
@@ -111,6 +147,109 @@ b3GpuRigidBodyPipeline::b3GpuRigidBodyPipeline(cl_context ctx, cl_device_id devi
 
 		clReleaseProgram(prog);
 	}
+	{
+		cl_program prog = b3OpenCLUtils::compileCLProgramFromString(m_data->m_context, m_data->m_device, islandKernelsCL, &errNum, "", B3_RIGIDBODY_ISLAND_PATH);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_resetSleepStateKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "resetSleepStateKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_filterSleepingPairsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "filterSleepingPairsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_initIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "initIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_wakePairIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "wakePairIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_wakeConstraintIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "wakeConstraintIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_wakeIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "wakeIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_updateSleepTimersKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "updateSleepTimersKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_uniteContactIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "uniteContactIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_uniteConstraintIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "uniteConstraintIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_compressIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "compressIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_islandSleepTimersKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "islandSleepTimersKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_sleepIslandsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, islandKernelsCL, "sleepIslandsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		clReleaseProgram(prog);
+	}
+	{
+		cl_program prog = b3OpenCLUtils::compileCLProgramFromString(m_data->m_context, m_data->m_device, ccdKernelsCL, &errNum, "", B3_RIGIDBODY_CCD_PATH);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_resetCcdHitFractionsKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, ccdKernelsCL, "resetCcdHitFractionsKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_sweepTrianglesKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, ccdKernelsCL, "sweepTrianglesKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		m_data->m_clampCcdMotionKernel = b3OpenCLUtils::compileCLKernelFromString(m_data->m_context, m_data->m_device, ccdKernelsCL, "clampCcdMotionKernel", &errNum, prog);
+		b3Assert(errNum == CL_SUCCESS);
+		clReleaseProgram(prog);
+	}
+
+	m_data->m_bodySleepingGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_sleepTimersGPU = new b3OpenCLArray<float>(ctx, q);
+	m_data->m_bodyIslandsGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_islandParentsGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_islandTimersGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_islandWakeGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_islandCountersGPU = new b3OpenCLArray<int>(ctx, q, 1);
+	m_data->m_numSleepingBodies = 0;
+	m_data->m_refreshSleepingAabbs = true;
+	m_data->m_lastAabbBufferWS = 0;
+	m_data->m_ccdHitFractionsGPU = new b3OpenCLArray<int>(ctx, q);
+
+	m_data->m_transformsGPU = new b3OpenCLArray<b3GpuBodyTransform>(ctx, q);
+	m_data->m_transformWriteSlot = 0;
+	m_data->m_transformLatestSlot = -1;
+	setNumTransformReadbackBuffers(2);
+
+	m_data->m_renderInstanceBodiesGPU = new b3OpenCLArray<int>(ctx, q);
+	m_data->m_renderInstanceBufferGL = 0;
+	m_data->m_createEventFromGLsync = 0;
+
+	m_data->m_gpuProfiler = new b3GpuProfiler(q);
+}
+
+//the sources and build options have to match the ones used by the constructors, they are part of the program key
+static const b3OpenCLProgramSource sPipelinePrograms[] = {
+	//the largest programs first, so they start compiling right away
+	{satKernelsCL, "", 0},
+	{satClipKernelsCL, "", 0},
+	{satConcaveKernelsCL, "", 0},
+	{mprKernelsCL, "", 0},
+	{primitiveContactsKernelsCL, "", 0},
+	{pairClassificationKernelsCL, "", 0},
+	{bvhTraversalKernelCL, "", 0},
+	{solverSetupCL, "", 0},
+	{solverSetup2CL, "", 0},
+	{solveContactCL, "", 0},
+	{solveFrictionCL, "", 0},
+	{batchingKernelsCL, "", 0},
+	{batchingKernelsNewCL, "", 0},
+	{solverUtilsCL, "", 0},
+	{solveConstraintRowsCL, "", 0},
+	{integrateKernelCL, "", 0},
+	{updateAabbsKernelCL, "", 0},
+	{islandKernelsCL, "", 0},
+	{ccdKernelsCL, "", 0},
+	{sapCL, "", 0},
+	{gridBroadphaseCL, "", 0},
+	{multiLevelGridBroadphaseCL, "", 0},
+	{adaptiveBroadphaseCL, "", 0},
+	{parallelLinearBvhCL, "", 0},
+	{radixSort32KernelsCL, "", 0},
+	{prefixScanKernelsCL, "", 0},
+	{prefixScanKernelsFloat4CL, "", 0},
+	{fillKernelsCL, "", 0},
+	{boundSearchKernelsCL, "", 0},
+	{rayCastKernelCL, "", 0}};
+
+void b3GpuRigidBodyPipeline::compileProgramsAsync(cl_context ctx, cl_device_id device)
+{
+	int numPrograms = sizeof(sPipelinePrograms) / sizeof(b3OpenCLProgramSource);
+	b3OpenCLUtils::compileCLProgramsAsync(ctx, device, sPipelinePrograms, numPrograms);
 }
 
 b3GpuRigidBodyPipeline::~b3GpuRigidBodyPipeline()
@@ -123,6 +262,56 @@ b3GpuRigidBodyPipeline::~b3GpuRigidBodyPipeline()
 
 	if (m_data->m_clearOverlappingPairsKernel)
 		clReleaseKernel(m_data->m_clearOverlappingPairsKernel);
+
+	if (m_data->m_copyTransformsKernel)
+		clReleaseKernel(m_data->m_copyTransformsKernel);
+
+	if (m_data->m_writeWorldMatricesKernel)
+		clReleaseKernel(m_data->m_writeWorldMatricesKernel);
+
+	cl_kernel islandKernels[] = {
+		m_data->m_resetSleepStateKernel,
+		m_data->m_filterSleepingPairsKernel,
+		m_data->m_initIslandsKernel,
+		m_data->m_wakePairIslandsKernel,
+		m_data->m_wakeConstraintIslandsKernel,
+		m_data->m_wakeIslandsKernel,
+		m_data->m_updateSleepTimersKernel,
+		m_data->m_uniteContactIslandsKernel,
+		m_data->m_uniteConstraintIslandsKernel,
+		m_data->m_compressIslandsKernel,
+		m_data->m_islandSleepTimersKernel,
+		m_data->m_sleepIslandsKernel};
+	for (int i = 0; i < int(sizeof(islandKernels) / sizeof(cl_kernel)); i++)
+	{
+		if (islandKernels[i])
+			clReleaseKernel(islandKernels[i]);
+	}
+	delete m_data->m_bodySleepingGPU;
+	delete m_data->m_sleepTimersGPU;
+	delete m_data->m_bodyIslandsGPU;
+	delete m_data->m_islandParentsGPU;
+	delete m_data->m_islandTimersGPU;
+	delete m_data->m_islandWakeGPU;
+	delete m_data->m_islandCountersGPU;
+
+	cl_kernel ccdKernels[] = {
+		m_data->m_resetCcdHitFractionsKernel,
+		m_data->m_sweepTrianglesKernel,
+		m_data->m_clampCcdMotionKernel};
+	for (int i = 0; i < int(sizeof(ccdKernels) / sizeof(cl_kernel)); i++)
+	{
+		if (ccdKernels[i])
+			clReleaseKernel(ccdKernels[i]);
+	}
+	delete m_data->m_ccdHitFractionsGPU;
+
+	setNumTransformReadbackBuffers(0);
+	delete m_data->m_transformsGPU;
+
+	if (m_data->m_renderInstanceBufferGL)
+		clReleaseMemObject(m_data->m_renderInstanceBufferGL);
+	delete m_data->m_renderInstanceBodiesGPU;
 	delete m_data->m_raycaster;
 	delete m_data->m_solver;
 	delete m_data->m_allAabbsGPU;
@@ -135,6 +324,8 @@ b3GpuRigidBodyPipeline::~b3GpuRigidBodyPipeline()
 
 	delete m_data->m_solver2;
 
+	delete m_data->m_gpuProfiler;
+
 	delete m_data;
 }
 
@@ -144,6 +335,11 @@ void b3GpuRigidBodyPipeline::reset()
 	m_data->m_cpuConstraints.resize(0);
 	m_data->m_allAabbsGPU->resize(0);
 	m_data->m_allAabbsCPU.resize(0);
+	m_data->m_bodySleepingGPU->resize(0);
+	m_data->m_sleepTimersGPU->resize(0);
+	m_data->m_bodyIslandsGPU->resize(0);
+	m_data->m_numSleepingBodies = 0;
+	m_data->m_refreshSleepingAabbs = true;
 }
 
 void b3GpuRigidBodyPipeline::addConstraint(b3TypedConstraint* constraint)
@@ -220,10 +416,19 @@ int b3GpuRigidBodyPipeline::createFixedConstraint(int bodyA, int bodyB, const fl
 
 void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 {
+	bool sleepingEnabled = isSleepingEnabled();
+	if (!sleepingEnabled && m_data->m_numSleepingBodies)
+	{
+		wakeUpAllBodies();
+	}
+
+	m_data->m_gpuProfiler->beginFrame();
+
 	//update worldspace AABBs from local AABB/worldtransform
 	{
 		B3_PROFILE("setupGpuAabbs");
-		setupGpuAabbsFull();
+		B3_GPU_STAGE("aabbs");
+		setupGpuAabbsFull(isCcdEnabled() ? deltaTime : 0.f);
 	}
 
 	int numPairs = 0;
@@ -237,6 +442,9 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 				m_data->m_allAabbsGPU->copyToHost(m_data->m_allAabbsCPU);
 				for (int i = 0; i < m_data->m_allAabbsCPU.size(); i++)
 				{
+					//removePhysicsInstance destroyed the proxy, registering a body in the slot creates it again
+					if (m_data->m_narrowphase->isRigidBodyRemoved(i))
+						continue;
 					b3Vector3 aabbMin = b3MakeVector3(m_data->m_allAabbsCPU[i].m_min[0], m_data->m_allAabbsCPU[i].m_min[1], m_data->m_allAabbsCPU[i].m_min[2]);
 					b3Vector3 aabbMax = b3MakeVector3(m_data->m_allAabbsCPU[i].m_max[0], m_data->m_allAabbsCPU[i].m_max[1], m_data->m_allAabbsCPU[i].m_max[2]);
 					m_data->m_broadphaseDbvt->setAabb(i, aabbMin, aabbMax, 0);
@@ -251,13 +459,24 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 		}
 		else
 		{
-			if (gUseCalculateOverlappingPairsHost)
+			//B3_CAPACITY_GROW_RERUN calculates the pairs again when they did not fit, see b3CapacityGrowthPolicy
+			int maxAttempts = m_data->m_config.m_capacityGrowthPolicy == B3_CAPACITY_GROW_RERUN ? 2 : 1;
+			for (int attempt = 0; attempt < maxAttempts; attempt++)
 			{
-				m_data->m_broadphaseSap->calculateOverlappingPairsHost(m_data->m_config.m_maxBroadphasePairs);
-			}
-			else
-			{
-				m_data->m_broadphaseSap->calculateOverlappingPairs(m_data->m_config.m_maxBroadphasePairs);
+				B3_GPU_STAGE("pairFind");
+				if (gUseCalculateOverlappingPairsHost)
+				{
+					m_data->m_broadphaseSap->calculateOverlappingPairsHost(m_data->m_config.m_maxBroadphasePairs);
+				}
+				else
+				{
+					m_data->m_broadphaseSap->calculateOverlappingPairs(m_data->m_config.m_maxBroadphasePairs);
+				}
+
+				int numPairsRequired = m_data->m_broadphaseSap->getNumOverlapRequired();
+				if (numPairsRequired <= m_data->m_config.m_maxBroadphasePairs || m_data->m_config.m_capacityGrowthPolicy == B3_CAPACITY_FIXED)
+					break;
+				m_data->m_config.m_maxBroadphasePairs = b3GrowCapacity(m_data->m_config.m_maxBroadphasePairs, numPairsRequired);
 			}
 			numPairs = m_data->m_broadphaseSap->getNumOverlap();
 		}
@@ -289,6 +508,22 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 
 		m_data->m_overlappingPairsGPU->resize(numPairs);
 
+		//an awake body near a sleeping one wakes its island before the pairs are filtered,
+		//so the narrowphase creates the contacts of the woken bodies and the solver never sees a sleeping body
+		if (sleepingEnabled)
+		{
+			B3_PROFILE("wakeTouchedIslands");
+			B3_GPU_STAGE("islands");
+			wakeTouchedIslands(pairs, numPairs);
+		}
+
+		//pairs of sleeping and fixed bodies need no contacts, the narrowphase only gets the pairs with an awake body
+		if (sleepingEnabled && m_data->m_numSleepingBodies)
+		{
+			numPairs = filterSleepingPairs(pairs, numPairs);
+			pairs = m_data->m_overlappingPairsGPU->getBufferCL();
+		}
+
 		//mark the contacts for each pair as 'unused'
 		if (numPairs)
 		{
@@ -321,8 +556,13 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 			}
 		}
 
-		m_data->m_narrowphase->computeContacts(pairs, numPairs, aabbsWS, numBodies);
-		numContacts = m_data->m_narrowphase->getNumContactsGpu();
+		if (numPairs)
+		{
+			B3_GPU_STAGE("narrowphase");
+			m_data->m_narrowphase->computeContacts(pairs, numPairs, aabbsWS, numBodies);
+			numContacts = m_data->m_narrowphase->getNumContactsGpu();
+			syncGrownCapacities();
+		}
 
 		if (gUseDbvt)
 		{
@@ -346,6 +586,13 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 			printf("totalPoints=%d\n", totalPoints);
 		}
 	}
+	else if (sleepingEnabled)
+	{
+		//without pairs only the joints can wake an island
+		B3_PROFILE("wakeTouchedIslands");
+		B3_GPU_STAGE("islands");
+		wakeTouchedIslands(0, 0);
+	}
 
 	//convert contact points to contact constraints
 
@@ -370,6 +617,7 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 			//m_data->m_solver->solveContacts(m_data->m_narrowphase->getNumBodiesGpu(),&hostBodies[0],&hostInertias[0],numContacts,contacts,numJoints, joints);
 			if (useGpu)
 			{
+				B3_GPU_STAGE("joints");
 				m_data->m_gpuSolver->solveJoints(m_data->m_narrowphase->getNumRigidBodies(), &gpuBodies, &gpuInertias, numJoints, m_data->m_gpuConstraints);
 			}
 			else
@@ -459,7 +707,27 @@ void b3GpuRigidBodyPipeline::stepSimulation(float deltaTime)
 		}
 	}
 
-	integrate(deltaTime);
+	//the triangle-convex pairs are only valid when the narrowphase ran this step
+	if (isCcdEnabled() && numPairs)
+	{
+		B3_PROFILE("clampFastBodyMotion");
+		B3_GPU_STAGE("ccd");
+		clampFastBodyMotion(deltaTime, m_data->m_narrowphase->getInternalData()->m_triangleConvexPairs->size());
+	}
+
+	{
+		B3_GPU_STAGE("integrate");
+		integrate(deltaTime);
+	}
+
+	if (sleepingEnabled)
+	{
+		B3_PROFILE("updateSleeping");
+		B3_GPU_STAGE("islands");
+		updateSleeping(deltaTime, numContacts);
+	}
+
+	m_data->m_gpuProfiler->endFrame();
 }
 
 void b3GpuRigidBodyPipeline::integrate(float timeStep)
@@ -467,6 +735,7 @@ void b3GpuRigidBodyPipeline::integrate(float timeStep)
 	//integrate
 	int numBodies = m_data->m_narrowphase->getNumRigidBodies();
 	float angularDamp = 0.99f;
+	reserveSleepState(numBodies);
 
 	if (gIntegrateOnCpu)
 	{
@@ -474,12 +743,17 @@ void b3GpuRigidBodyPipeline::integrate(float timeStep)
 		{
 			b3GpuNarrowPhaseInternalData* npData = m_data->m_narrowphase->getInternalData();
 			npData->m_bodyBufferGPU->copyToHost(*npData->m_bodyBufferCPU);
+			b3AlignedObjectArray<int> bodySleeping;
+			m_data->m_bodySleepingGPU->copyToHost(bodySleeping);
 
 			b3RigidBodyData_t* bodies = &npData->m_bodyBufferCPU->at(0);
 
 			for (int nodeID = 0; nodeID < numBodies; nodeID++)
 			{
-				integrateSingleTransform(bodies, nodeID, timeStep, angularDamp, m_data->m_gravity);
+				if (!bodySleeping[nodeID])
+				{
+					integrateSingleTransform(bodies, nodeID, timeStep, angularDamp, m_data->m_gravity);
+				}
 			}
 			npData->m_bodyBufferGPU->copyFromHost(*npData->m_bodyBufferCPU);
 		}
@@ -493,20 +767,23 @@ void b3GpuRigidBodyPipeline::integrate(float timeStep)
 		launcher.setConst(timeStep);
 		launcher.setConst(angularDamp);
 		launcher.setConst(m_data->m_gravity);
+		launcher.setBuffer(m_data->m_bodySleepingGPU->getBufferCL());
 		launcher.launch1D(numBodies);
 	}
 }
 
-void b3GpuRigidBodyPipeline::setupGpuAabbsFull()
+void b3GpuRigidBodyPipeline::setupGpuAabbsFull(float timeStep)
 {
 	cl_int ciErrNum = 0;
 
 	int numBodies = m_data->m_narrowphase->getNumRigidBodies();
 	if (!numBodies)
 		return;
+	reserveSleepState(numBodies);
 
 	if (gCalcWorldSpaceAabbOnCpu)
 	{
+		m_data->m_narrowphase->syncBodyUploads();
 		if (numBodies)
 		{
 			if (gUseDbvt)
@@ -554,7 +831,19 @@ void b3GpuRigidBodyPipeline::setupGpuAabbsFull()
 			worldAabbs = m_data->m_broadphaseSap->getAabbBufferWS();
 		}
 		launcher.setBuffer(worldAabbs);
+		launcher.setBuffer(m_data->m_bodySleepingGPU->getBufferCL());
+		//a new broadphase buffer or one written from the host has no valid aabbs for the sleeping bodies
+		int updateSleepingBodies = m_data->m_refreshSleepingAabbs || worldAabbs != m_data->m_lastAabbBufferWS ? 1 : 0;
+		m_data->m_refreshSleepingAabbs = false;
+		m_data->m_lastAabbBufferWS = worldAabbs;
+		launcher.setConst(updateSleepingBodies);
+		launcher.setConst(timeStep);
+		launcher.setConst(m_data->m_config.m_ccdMotionThreshold);
+		//the first kernel of the step to read the bodies, it waits for the uploads of writeChangedInstancesToGpu
+		//which overlapped with whatever the host did since
+		m_data->m_narrowphase->addBodyUploadWaitEvents(launcher);
 		launcher.launch1D(numBodies);
+		m_data->m_narrowphase->syncBodyUploads();
 
 		oclCHECKERROR(ciErrNum, CL_SUCCESS);
 	}
@@ -574,6 +863,534 @@ void b3GpuRigidBodyPipeline::setupGpuAabbsFull()
 	*/
 }
 
+bool b3GpuRigidBodyPipeline::isCcdEnabled() const
+{
+	//the aabbs computed on the cpu are not swept, so the bvh traversal would miss most of the triangles
+	return m_data->m_config.m_enableCcd && !gCalcWorldSpaceAabbOnCpu;
+}
+
+void b3GpuRigidBodyPipeline::clampFastBodyMotion(float timeStep, int numTriangleConvexPairs)
+{
+	int numBodies = m_data->m_narrowphase->getNumRigidBodies();
+	if (!numBodies || !numTriangleConvexPairs)
+		return;
+
+	b3GpuNarrowPhaseInternalData* npData = m_data->m_narrowphase->getInternalData();
+	m_data->m_ccdHitFractionsGPU->resize(numBodies);
+
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_resetCcdHitFractionsKernel, "m_resetCcdHitFractionsKernel");
+		launcher.setBuffer(m_data->m_ccdHitFractionsGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies);
+	}
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(npData->m_triangleConvexPairs->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_narrowphase->getBodiesGpu(), true),
+			b3BufferInfoCL(m_data->m_narrowphase->getCollidablesGpu(), true),
+			b3BufferInfoCL(m_data->m_narrowphase->getAabbLocalSpaceBufferGpu(), true),
+			b3BufferInfoCL(npData->m_convexPolyhedraGPU->getBufferCL(), true),
+			b3BufferInfoCL(npData->m_convexFacesGPU->getBufferCL(), true),
+			b3BufferInfoCL(npData->m_convexIndicesGPU->getBufferCL(), true),
+			b3BufferInfoCL(npData->m_convexVerticesGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_ccdHitFractionsGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_sweepTrianglesKernel, "m_sweepTrianglesKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numTriangleConvexPairs);
+		launcher.setConst(timeStep);
+		launcher.setConst(m_data->m_config.m_ccdMotionThreshold);
+		launcher.launch1D(numTriangleConvexPairs);
+	}
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_clampCcdMotionKernel, "m_clampCcdMotionKernel");
+		launcher.setBuffer(m_data->m_narrowphase->getBodiesGpu());
+		launcher.setBuffer(m_data->m_ccdHitFractionsGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.setConst(timeStep);
+		launcher.launch1D(numBodies);
+	}
+}
+
+//the narrowphase grows its own copy of the config, the broadphase and solver buffers have to follow the body and contact capacity
+void b3GpuRigidBodyPipeline::syncGrownCapacities()
+{
+	const b3Config& config = m_data->m_narrowphase->getConfig();
+	m_data->m_config.m_maxConvexBodies = config.m_maxConvexBodies;
+	m_data->m_config.m_maxConvexShapes = config.m_maxConvexShapes;
+	m_data->m_config.m_maxContactCapacity = config.m_maxContactCapacity;
+	m_data->m_config.m_compoundPairCapacity = config.m_compoundPairCapacity;
+	m_data->m_config.m_maxTriConvexPairCapacity = config.m_maxTriConvexPairCapacity;
+	m_data->m_solver2->reserveContactCapacity(m_data->m_config.m_maxContactCapacity);
+#ifdef TEST_OTHER_GPU_SOLVER
+	m_data->m_solver3->reserveCapacity(m_data->m_config.m_maxConvexBodies, m_data->m_config.m_maxContactCapacity);
+#endif  //TEST_OTHER_GPU_SOLVER
+	m_data->m_allAabbsGPU->reserve(m_data->m_config.m_maxConvexBodies);
+	if (m_data->m_broadphaseDbvt)
+		m_data->m_broadphaseDbvt->reserveProxies(m_data->m_config.m_maxConvexBodies);
+}
+
+bool b3GpuRigidBodyPipeline::isSleepingEnabled() const
+{
+	//the islands only know the joints on the gpu, the b3TypedConstraint joints are solved on the cpu for all bodies
+	//and the dbvt broadphase keeps its own pair cache, so there the pairs of sleeping bodies cannot be filtered
+	return m_data->m_config.m_enableSleeping && m_data->m_joints.size() == 0 && !gUseDbvt;
+}
+
+void b3GpuRigidBodyPipeline::reserveSleepState(int numBodies)
+{
+	int oldNumBodies = m_data->m_bodySleepingGPU->size();
+	if (numBodies <= oldNumBodies)
+		return;
+
+	m_data->m_bodySleepingGPU->resize(numBodies);
+	m_data->m_sleepTimersGPU->resize(numBodies);
+	m_data->m_bodyIslandsGPU->resize(numBodies);
+	m_data->m_islandParentsGPU->resize(numBodies, false);
+	m_data->m_islandTimersGPU->resize(numBodies, false);
+	m_data->m_islandWakeGPU->resize(numBodies, false);
+	resetSleepState(oldNumBodies, numBodies);
+}
+
+void b3GpuRigidBodyPipeline::resetSleepState(int firstBody, int endBody)
+{
+	endBody = b3Min(endBody, (int)m_data->m_bodySleepingGPU->size());
+	if (firstBody >= endBody)
+		return;
+
+	b3LauncherCL launcher(m_data->m_queue, m_data->m_resetSleepStateKernel, "m_resetSleepStateKernel");
+	launcher.setBuffer(m_data->m_bodySleepingGPU->getBufferCL());
+	launcher.setBuffer(m_data->m_sleepTimersGPU->getBufferCL());
+	launcher.setConst(firstBody);
+	launcher.setConst(endBody);
+	launcher.launch1D(endBody - firstBody);
+}
+
+int b3GpuRigidBodyPipeline::filterSleepingPairs(cl_mem pairs, int numPairs)
+{
+	B3_PROFILE("filterSleepingPairs");
+	B3_GPU_STAGE("islands");
+
+	int numAwakePairs = 0;
+	m_data->m_islandCountersGPU->copyFromHostPointer(&numAwakePairs, 1);
+
+	b3BufferInfoCL bInfo[] = {
+		b3BufferInfoCL(pairs, true),
+		b3BufferInfoCL(m_data->m_overlappingPairsGPU->getBufferCL()),
+		b3BufferInfoCL(m_data->m_islandCountersGPU->getBufferCL()),
+		b3BufferInfoCL(m_data->m_narrowphase->getBodiesGpu(), true),
+		b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true)};
+	b3LauncherCL launcher(m_data->m_queue, m_data->m_filterSleepingPairsKernel, "m_filterSleepingPairsKernel");
+	launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+	launcher.setConst(numPairs);
+	launcher.launch1D(numPairs);
+
+	numAwakePairs = m_data->m_islandCountersGPU->at(0);
+	return numAwakePairs;
+}
+
+void b3GpuRigidBodyPipeline::wakeTouchedIslands(cl_mem pairs, int numPairs)
+{
+	int numBodies = m_data->m_narrowphase->getNumRigidBodies();
+	if (!numBodies || !m_data->m_numSleepingBodies)
+		return;
+	reserveSleepState(numBodies);
+
+	cl_mem bodies = m_data->m_narrowphase->getBodiesGpu();
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_initIslandsKernel, "m_initIslandsKernel");
+		launcher.setBuffer(m_data->m_islandParentsGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_islandTimersGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_islandWakeGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies);
+	}
+	if (numPairs)
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(pairs, true),
+			b3BufferInfoCL(bodies, true),
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_bodyIslandsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandWakeGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_wakePairIslandsKernel, "m_wakePairIslandsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numPairs);
+		launcher.launch1D(numPairs);
+	}
+	int numConstraints = m_data->m_gpuConstraints->size();
+	if (numConstraints)
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_data->m_gpuConstraints->getBufferCL(), true),
+			b3BufferInfoCL(bodies, true),
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_bodyIslandsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandWakeGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_wakeConstraintIslandsKernel, "m_wakeConstraintIslandsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numConstraints);
+		launcher.launch1D(numConstraints);
+	}
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_sleepTimersGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_bodyIslandsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandWakeGPU->getBufferCL(), true)};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_wakeIslandsKernel, "m_wakeIslandsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies);
+	}
+}
+
+void b3GpuRigidBodyPipeline::updateSleeping(float timeStep, int numContacts)
+{
+	int numBodies = m_data->m_narrowphase->getNumRigidBodies();
+	if (!numBodies)
+		return;
+	reserveSleepState(numBodies);
+
+	cl_mem bodies = m_data->m_narrowphase->getBodiesGpu();
+	{
+		float linearThreshold = m_data->m_config.m_linearSleepingThreshold;
+		float angularThreshold = m_data->m_config.m_angularSleepingThreshold;
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(bodies, true),
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_sleepTimersGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_updateSleepTimersKernel, "m_updateSleepTimersKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numBodies);
+		launcher.setConst(timeStep);
+		launcher.setConst(linearThreshold * linearThreshold);
+		launcher.setConst(angularThreshold * angularThreshold);
+		launcher.launch1D(numBodies);
+	}
+	{
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_initIslandsKernel, "m_initIslandsKernel");
+		launcher.setBuffer(m_data->m_islandParentsGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_islandTimersGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_islandWakeGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies);
+	}
+
+	//union find over the contact and joint graph of the awake bodies
+	//a pass can lose hooks to concurrent ones, so it repeats until a pass changes nothing, usually a few passes
+	int numConstraints = m_data->m_gpuConstraints->size();
+	if (numContacts || numConstraints)
+	{
+		B3_PROFILE("buildIslands");
+		const int maxPasses = 64;
+		for (int pass = 0; pass < maxPasses; pass++)
+		{
+			int changed = 0;
+			m_data->m_islandCountersGPU->copyFromHostPointer(&changed, 1);
+			if (numContacts)
+			{
+				b3BufferInfoCL bInfo[] = {
+					b3BufferInfoCL(m_data->m_narrowphase->getContactsGpu(), true),
+					b3BufferInfoCL(bodies, true),
+					b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_islandParentsGPU->getBufferCL()),
+					b3BufferInfoCL(m_data->m_islandCountersGPU->getBufferCL())};
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_uniteContactIslandsKernel, "m_uniteContactIslandsKernel");
+				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+				launcher.setConst(numContacts);
+				launcher.launch1D(numContacts);
+			}
+			if (numConstraints)
+			{
+				b3BufferInfoCL bInfo[] = {
+					b3BufferInfoCL(m_data->m_gpuConstraints->getBufferCL(), true),
+					b3BufferInfoCL(bodies, true),
+					b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+					b3BufferInfoCL(m_data->m_islandParentsGPU->getBufferCL()),
+					b3BufferInfoCL(m_data->m_islandCountersGPU->getBufferCL())};
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_uniteConstraintIslandsKernel, "m_uniteConstraintIslandsKernel");
+				launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+				launcher.setConst(numConstraints);
+				launcher.launch1D(numConstraints);
+			}
+			{
+				b3LauncherCL launcher(m_data->m_queue, m_data->m_compressIslandsKernel, "m_compressIslandsKernel");
+				launcher.setBuffer(m_data->m_islandParentsGPU->getBufferCL());
+				launcher.setConst(numBodies);
+				launcher.launch1D(numBodies);
+			}
+			changed = m_data->m_islandCountersGPU->at(0);
+			if (!changed)
+				break;
+		}
+	}
+
+	{
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(bodies, true),
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_sleepTimersGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandParentsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandTimersGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_islandSleepTimersKernel, "m_islandSleepTimersKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies);
+	}
+	{
+		int numSleepingBodies = 0;
+		m_data->m_islandCountersGPU->copyFromHostPointer(&numSleepingBodies, 1);
+
+		b3BufferInfoCL bInfo[] = {
+			b3BufferInfoCL(bodies),
+			b3BufferInfoCL(m_data->m_bodySleepingGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_islandParentsGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_islandTimersGPU->getBufferCL(), true),
+			b3BufferInfoCL(m_data->m_bodyIslandsGPU->getBufferCL()),
+			b3BufferInfoCL(m_data->m_islandCountersGPU->getBufferCL())};
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_sleepIslandsKernel, "m_sleepIslandsKernel");
+		launcher.setBuffers(bInfo, sizeof(bInfo) / sizeof(b3BufferInfoCL));
+		launcher.setConst(numBodies);
+		launcher.setConst(m_data->m_config.m_timeToSleep);
+		launcher.launch1D(numBodies);
+
+		m_data->m_numSleepingBodies = m_data->m_islandCountersGPU->at(0);
+	}
+}
+
+void b3GpuRigidBodyPipeline::wakeUpBody(int bodyIndex)
+{
+	resetSleepState(bodyIndex, bodyIndex + 1);
+}
+
+void b3GpuRigidBodyPipeline::wakeUpAllBodies()
+{
+	resetSleepState(0, m_data->m_bodySleepingGPU->size());
+	m_data->m_numSleepingBodies = 0;
+}
+
+int b3GpuRigidBodyPipeline::getNumSleepingBodies() const
+{
+	return m_data->m_numSleepingBodies;
+}
+
+const b3SolverBatchStats& b3GpuRigidBodyPipeline::getSolverBatchStats() const
+{
+	return m_data->m_solver2->getBatchStats();
+}
+
+bool b3GpuRigidBodyPipeline::setGpuProfilingEnabled(bool enable)
+{
+	bool enabled = m_data->m_gpuProfiler->setEnabled(enable);
+	if (enabled)
+	{
+		b3SetGpuProfiler(m_data->m_gpuProfiler);
+	}
+	else if (b3GetGpuProfiler() == m_data->m_gpuProfiler)
+	{
+		b3SetGpuProfiler(0);
+	}
+	return enabled;
+}
+
+b3GpuProfiler* b3GpuRigidBodyPipeline::getGpuProfiler()
+{
+	return m_data->m_gpuProfiler;
+}
+
+static void b3ReleasePinnedTransformBuffer(cl_command_queue queue, b3PinnedTransformBuffer& buf)
+{
+	if (buf.m_readEvent)
+	{
+		clWaitForEvents(1, &buf.m_readEvent);
+		clReleaseEvent(buf.m_readEvent);
+		buf.m_readEvent = 0;
+	}
+	if (buf.m_buffer)
+	{
+		if (buf.m_hostPtr)
+		{
+			clEnqueueUnmapMemObject(queue, buf.m_buffer, buf.m_hostPtr, 0, 0, 0);
+			clFinish(queue);
+		}
+		clReleaseMemObject(buf.m_buffer);
+	}
+	buf.m_buffer = 0;
+	buf.m_hostPtr = 0;
+	buf.m_numBodies = 0;
+	buf.m_capacity = 0;
+}
+
+static bool b3ReservePinnedTransformBuffer(cl_context ctx, cl_command_queue queue, b3PinnedTransformBuffer& buf, int numBodies)
+{
+	if (buf.m_capacity >= numBodies)
+		return true;
+
+	b3ReleasePinnedTransformBuffer(queue, buf);
+
+	cl_int ciErrNum = 0;
+	size_t sizeInBytes = sizeof(b3GpuBodyTransform) * numBodies;
+	buf.m_buffer = clCreateBuffer(ctx, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, sizeInBytes, 0, &ciErrNum);
+	if (ciErrNum != CL_SUCCESS)
+	{
+		b3Error("OpenCL out-of-memory allocating pinned transform buffer\n");
+		buf.m_buffer = 0;
+		return false;
+	}
+	buf.m_hostPtr = (b3GpuBodyTransform*)clEnqueueMapBuffer(queue, buf.m_buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, sizeInBytes, 0, 0, 0, &ciErrNum);
+	if (ciErrNum != CL_SUCCESS)
+	{
+		b3Error("clEnqueueMapBuffer failed for pinned transform buffer\n");
+		b3ReleasePinnedTransformBuffer(queue, buf);
+		return false;
+	}
+	buf.m_capacity = numBodies;
+	return true;
+}
+
+void b3GpuRigidBodyPipeline::setNumTransformReadbackBuffers(int numBuffers)
+{
+	for (int i = 0; i < m_data->m_transformReadbackBuffers.size(); i++)
+	{
+		b3ReleasePinnedTransformBuffer(m_data->m_queue, m_data->m_transformReadbackBuffers[i]);
+	}
+	m_data->m_transformReadbackBuffers.resize(numBuffers);
+	for (int i = 0; i < numBuffers; i++)
+	{
+		b3PinnedTransformBuffer& buf = m_data->m_transformReadbackBuffers[i];
+		buf.m_buffer = 0;
+		buf.m_hostPtr = 0;
+		buf.m_readEvent = 0;
+		buf.m_numBodies = 0;
+		buf.m_capacity = 0;
+	}
+	m_data->m_transformWriteSlot = 0;
+	m_data->m_transformLatestSlot = -1;
+}
+
+void b3GpuRigidBodyPipeline::readbackTransformsAsync()
+{
+	int numBodies = getNumBodies();
+	int numBuffers = m_data->m_transformReadbackBuffers.size();
+	if (!numBodies || !numBuffers)
+		return;
+
+	b3PinnedTransformBuffer& buf = m_data->m_transformReadbackBuffers[m_data->m_transformWriteSlot];
+
+	//the slot might still be in flight, if the renderer did not consume the previous frames yet
+	if (buf.m_readEvent)
+	{
+		clWaitForEvents(1, &buf.m_readEvent);
+		clReleaseEvent(buf.m_readEvent);
+		buf.m_readEvent = 0;
+	}
+
+	//the renderer can no longer use this slot
+	if (m_data->m_transformLatestSlot == m_data->m_transformWriteSlot)
+	{
+		m_data->m_transformLatestSlot = -1;
+	}
+
+	if (!b3ReservePinnedTransformBuffer(m_data->m_context, m_data->m_queue, buf, numBodies))
+		return;
+
+	m_data->m_transformsGPU->resize(numBodies, false);
+
+	cl_event packEvent = 0;
+	{
+		B3_PROFILE("copyTransformsKernel");
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_copyTransformsKernel, "m_copyTransformsKernel");
+		launcher.setBuffer(m_data->m_narrowphase->getBodiesGpu());
+		launcher.setBuffer(m_data->m_transformsGPU->getBufferCL());
+		launcher.setConst(numBodies);
+		launcher.launch1D(numBodies, 64, &packEvent);
+	}
+
+	cl_int status = clEnqueueReadBuffer(m_data->m_queue, m_data->m_transformsGPU->getBufferCL(), CL_FALSE, 0, sizeof(b3GpuBodyTransform) * numBodies,
+										buf.m_hostPtr, 1, &packEvent, &buf.m_readEvent);
+	b3Assert(status == CL_SUCCESS);
+	clReleaseEvent(packEvent);
+	clFlush(m_data->m_queue);
+
+	if (status != CL_SUCCESS)
+	{
+		buf.m_readEvent = 0;
+		return;
+	}
+	buf.m_numBodies = numBodies;
+	m_data->m_transformWriteSlot = (m_data->m_transformWriteSlot + 1) % numBuffers;
+}
+
+const b3GpuBodyTransform* b3GpuRigidBodyPipeline::getTransformsCpu(int* numBodies, bool waitForNewest)
+{
+	int numBuffers = m_data->m_transformReadbackBuffers.size();
+
+	if (waitForNewest && numBuffers)
+	{
+		int slot = (m_data->m_transformWriteSlot - 1 + numBuffers) % numBuffers;
+		b3PinnedTransformBuffer& buf = m_data->m_transformReadbackBuffers[slot];
+		if (buf.m_readEvent)
+		{
+			clWaitForEvents(1, &buf.m_readEvent);
+			clReleaseEvent(buf.m_readEvent);
+			buf.m_readEvent = 0;
+		}
+	}
+
+	//walk from the newest to the oldest readback and use the newest one that is complete
+	//if the newest is still in flight, the renderer uses the older one (frame N-1)
+	int newestSlot = -1;
+	for (int i = 1; i <= numBuffers; i++)
+	{
+		int slot = (m_data->m_transformWriteSlot - i + numBuffers) % numBuffers;
+		b3PinnedTransformBuffer& buf = m_data->m_transformReadbackBuffers[slot];
+		if (!buf.m_hostPtr || !buf.m_numBodies)
+			continue;
+		if (newestSlot < 0)
+			newestSlot = slot;
+
+		if (buf.m_readEvent)
+		{
+			cl_int execStatus = CL_QUEUED;
+			clGetEventInfo(buf.m_readEvent, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int), &execStatus, 0);
+			if (execStatus != CL_COMPLETE)
+			{
+				continue;
+			}
+			clReleaseEvent(buf.m_readEvent);
+			buf.m_readEvent = 0;
+		}
+		m_data->m_transformLatestSlot = slot;
+		break;
+	}
+
+	if (m_data->m_transformLatestSlot < 0 && newestSlot >= 0)
+	{
+		//nothing completed yet, wait for the newest readback
+		b3PinnedTransformBuffer& buf = m_data->m_transformReadbackBuffers[newestSlot];
+		if (buf.m_readEvent)
+		{
+			clWaitForEvents(1, &buf.m_readEvent);
+			clReleaseEvent(buf.m_readEvent);
+			buf.m_readEvent = 0;
+		}
+		m_data->m_transformLatestSlot = newestSlot;
+	}
+
+	if (m_data->m_transformLatestSlot < 0)
+	{
+		if (numBodies)
+			*numBodies = 0;
+		return 0;
+	}
+
+	const b3PinnedTransformBuffer& latest = m_data->m_transformReadbackBuffers[m_data->m_transformLatestSlot];
+	if (numBodies)
+		*numBodies = latest.m_numBodies;
+	return latest.m_hostPtr;
+}
+
 cl_mem b3GpuRigidBodyPipeline::getBodyBuffer()
 {
 	return m_data->m_narrowphase->getBodiesGpu();
@@ -598,9 +1415,44 @@ void b3GpuRigidBodyPipeline::writeAllInstancesToGpu()
 {
 	m_data->m_allAabbsGPU->copyFromHost(m_data->m_allAabbsCPU);
 	m_data->m_gpuConstraints->copyFromHost(m_data->m_cpuConstraints);
+	wakeUpAllBodies();
+	m_data->m_refreshSleepingAabbs = true;
 }
 
-int b3GpuRigidBodyPipeline::registerPhysicsInstance(float mass, const float* position, const float* orientation, int collidableIndex, int userIndex, bool writeInstanceToGpu)
+void b3GpuRigidBodyPipeline::removePhysicsInstance(int bodyIndex)
+{
+	if (bodyIndex < 0 || bodyIndex >= m_data->m_narrowphase->getNumRigidBodies() || m_data->m_narrowphase->isRigidBodyRemoved(bodyIndex))
+	{
+		b3Warning("removePhysicsInstance: invalid body %d\n", bodyIndex);
+		return;
+	}
+
+	if (gUseDbvt)
+	{
+		m_data->m_broadphaseDbvt->destroyProxy(&m_data->m_broadphaseDbvt->m_proxies[bodyIndex], 0);
+	}
+	else
+	{
+		m_data->m_broadphaseSap->removeProxy(bodyIndex);
+	}
+	m_data->m_narrowphase->removeRigidBody(bodyIndex);
+}
+
+void b3GpuRigidBodyPipeline::writeChangedInstancesToGpu()
+{
+	m_data->m_narrowphase->writeChangedBodiesToGpu();
+	if (gUseDbvt)
+	{
+		m_data->m_allAabbsGPU->copyFromHost(m_data->m_allAabbsCPU);
+	}
+	else
+	{
+		m_data->m_broadphaseSap->writeChangedAabbsToGpu();
+	}
+	m_data->m_refreshSleepingAabbs = true;
+}
+
+int b3GpuRigidBodyPipeline::registerPhysicsInstance(float mass, const float* position, const float* orientation, int collidableIndex, int userIndex, bool writeInstanceToGpu, int collisionFilterGroup, int collisionFilterMask)
 {
 	b3Vector3 aabbMin = b3MakeVector3(0, 0, 0), aabbMax = b3MakeVector3(0, 0, 0);
 
@@ -629,33 +1481,16 @@ int b3GpuRigidBodyPipeline::registerPhysicsInstance(float mass, const float* pos
 
 	if (bodyIndex >= 0)
 	{
-		if (gUseDbvt)
+		//the body buffers may have grown on registration
+		syncGrownCapacities();
+		insertBroadphaseProxy(bodyIndex, mass, aabbMin, aabbMax, collisionFilterGroup, collisionFilterMask);
+		if (gUseDbvt && writeInstanceToGpu)
 		{
-			m_data->m_broadphaseDbvt->createProxy(aabbMin, aabbMax, bodyIndex, 0, 1, 1);
-			b3SapAabb aabb;
-			for (int i = 0; i < 3; i++)
-			{
-				aabb.m_min[i] = aabbMin[i];
-				aabb.m_max[i] = aabbMax[i];
-				aabb.m_minIndices[3] = bodyIndex;
-			}
-			m_data->m_allAabbsCPU.push_back(aabb);
-			if (writeInstanceToGpu)
-			{
-				m_data->m_allAabbsGPU->copyFromHost(m_data->m_allAabbsCPU);
-			}
-		}
-		else
-		{
-			if (mass)
-			{
-				m_data->m_broadphaseSap->createProxy(aabbMin, aabbMax, bodyIndex, 1, 1);  //m_dispatcher);
-			}
-			else
-			{
-				m_data->m_broadphaseSap->createLargeProxy(aabbMin, aabbMax, bodyIndex, 1, 1);  //m_dispatcher);
-			}
+			m_data->m_allAabbsGPU->copyFromHost(m_data->m_allAabbsCPU);
 		}
+
+		//a reused slot may still hold the sleep state of the removed body
+		wakeUpBody(bodyIndex);
 	}
 
 	/*
@@ -668,6 +1503,124 @@ int b3GpuRigidBodyPipeline::registerPhysicsInstance(float mass, const float* pos
 	return bodyIndex;
 }
 
+void b3GpuRigidBodyPipeline::insertBroadphaseProxy(int bodyIndex, float mass, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int collisionFilterGroup, int collisionFilterMask)
+{
+	if (gUseDbvt)
+	{
+		m_data->m_broadphaseDbvt->createProxy(aabbMin, aabbMax, bodyIndex, 0, collisionFilterGroup, collisionFilterMask);
+		b3SapAabb aabb;
+		for (int i = 0; i < 3; i++)
+		{
+			aabb.m_min[i] = aabbMin[i];
+			aabb.m_max[i] = aabbMax[i];
+		}
+		aabb.m_minIndices[3] = bodyIndex;
+		//the narrowphase reuses the slots of removed bodies
+		if (bodyIndex < m_data->m_allAabbsCPU.size())
+		{
+			m_data->m_allAabbsCPU[bodyIndex] = aabb;
+		}
+		else
+		{
+			m_data->m_allAabbsCPU.push_back(aabb);
+		}
+	}
+	else
+	{
+		if (bodyIndex < m_data->m_broadphaseSap->getAllAabbsCPU().size())
+		{
+			bool largeProxy = mass == 0.f;
+			m_data->m_broadphaseSap->insertProxy(bodyIndex, aabbMin, aabbMax, bodyIndex, largeProxy, collisionFilterGroup, collisionFilterMask);
+		}
+		else if (mass)
+		{
+			m_data->m_broadphaseSap->createProxy(aabbMin, aabbMax, bodyIndex, collisionFilterGroup, collisionFilterMask);  //m_dispatcher);
+		}
+		else
+		{
+			m_data->m_broadphaseSap->createLargeProxy(aabbMin, aabbMax, bodyIndex, collisionFilterGroup, collisionFilterMask);  //m_dispatcher);
+		}
+	}
+}
+
+int b3GpuRigidBodyPipeline::registerPhysicsInstances(int numInstances, const float* masses, const float* positions, const float* orientations, const int* collidableIndices, bool writeInstancesToGpu, int* bodyIndices, const int* collisionFilterGroups, const int* collisionFilterMasks)
+{
+	if (numInstances <= 0)
+		return -1;
+
+	b3AlignedObjectArray<b3Vector3> aabbMins;
+	b3AlignedObjectArray<b3Vector3> aabbMaxs;
+	aabbMins.resize(numInstances);
+	aabbMaxs.resize(numInstances);
+
+	b3Scalar margin = 0.01f;
+	for (int i = 0; i < numInstances; i++)
+	{
+		int collidableIndex = collidableIndices[i];
+		if (collidableIndex < 0)
+		{
+			b3Error("registerPhysicsInstances using invalid collidableIndex\n");
+			return -1;
+		}
+
+		const float* position = &positions[i * 4];
+		const float* orientation = &orientations[i * 4];
+
+		const b3SapAabb& localAabb = m_data->m_narrowphase->getLocalSpaceAabb(collidableIndex);
+		b3Vector3 localAabbMin = b3MakeVector3(localAabb.m_min[0], localAabb.m_min[1], localAabb.m_min[2]);
+		b3Vector3 localAabbMax = b3MakeVector3(localAabb.m_max[0], localAabb.m_max[1], localAabb.m_max[2]);
+
+		b3Transform t;
+		t.setIdentity();
+		t.setOrigin(b3MakeVector3(position[0], position[1], position[2]));
+		t.setRotation(b3Quaternion(orientation[0], orientation[1], orientation[2], orientation[3]));
+		b3TransformAabb(localAabbMin, localAabbMax, margin, t, aabbMins[i], aabbMaxs[i]);
+	}
+
+	int numReused = m_data->m_narrowphase->registerRigidBodies(numInstances, collidableIndices, masses, positions, orientations, &aabbMins[0].getX(), &aabbMaxs[0].getX(), writeInstancesToGpu, bodyIndices);
+	if (numReused < 0)
+		return -1;
+	syncGrownCapacities();
+
+	if (gUseDbvt)
+	{
+		m_data->m_allAabbsCPU.reserve(m_data->m_allAabbsCPU.size() + numInstances - numReused);
+	}
+	else
+	{
+		b3AlignedObjectArray<b3SapAabb>& allAabbs = m_data->m_broadphaseSap->getAllAabbsCPU();
+		allAabbs.reserve(allAabbs.size() + numInstances - numReused);
+	}
+
+	for (int i = 0; i < numInstances; i++)
+	{
+		int group = collisionFilterGroups ? collisionFilterGroups[i] : 1;
+		int mask = collisionFilterMasks ? collisionFilterMasks[i] : -1;
+		insertBroadphaseProxy(bodyIndices[i], masses[i], aabbMins[i], aabbMaxs[i], group, mask);
+	}
+
+	if (writeInstancesToGpu)
+	{
+		if (gUseDbvt)
+		{
+			m_data->m_allAabbsGPU->copyFromHost(m_data->m_allAabbsCPU);
+		}
+		else
+		{
+			m_data->m_broadphaseSap->writeAabbsToGpu();
+		}
+	}
+
+	//the reused slots may still hold the sleep state of the removed bodies, the appended ones start awake
+	reserveSleepState(m_data->m_narrowphase->getNumRigidBodies());
+	for (int i = 0; i < numReused; i++)
+	{
+		wakeUpBody(bodyIndices[i]);
+	}
+
+	return numInstances;
+}
+
 void b3GpuRigidBodyPipeline::castRays(const b3AlignedObjectArray<b3RayInfo>& rays, b3AlignedObjectArray<b3RayHit>& hitResults)
 {
 	this->m_data->m_raycaster->castRays(rays, hitResults,
@@ -675,3 +1628,118 @@ void b3GpuRigidBodyPipeline::castRays(const b3AlignedObjectArray<b3RayInfo>& ray
 										m_data->m_narrowphase->getNumCollidablesGpu(), m_data->m_narrowphase->getCollidablesCpu(),
 										m_data->m_narrowphase->getInternalData(), m_data->m_broadphaseSap);
 }
+
+void b3GpuRigidBodyPipeline::setRenderInstances(const int* bodyIndices, int numInstances)
+{
+	m_data->m_renderInstanceBodiesGPU->resize(numInstances);
+	if (numInstances)
+	{
+		m_data->m_renderInstanceBodiesGPU->copyFromHostPointer(bodyIndices, numInstances);
+	}
+}
+
+bool b3GpuRigidBodyPipeline::setRenderInstanceBufferGL(unsigned int glBuffer)
+{
+	if (m_data->m_renderInstanceBufferGL)
+	{
+		clReleaseMemObject(m_data->m_renderInstanceBufferGL);
+		m_data->m_renderInstanceBufferGL = 0;
+	}
+
+	if (!glBuffer)
+		return false;
+
+	b3OpenCLDeviceInfo info;
+	b3OpenCLUtils::getDeviceInfo(m_data->m_device, &info);
+	if (!strstr(info.m_deviceExtensions, "cl_khr_gl_sharing"))
+		return false;
+
+	//fails with CL_INVALID_CONTEXT if the context was not created with the GL context
+	cl_int ciErrNum = 0;
+	cl_mem buffer = clCreateFromGLBuffer(m_data->m_context, CL_MEM_WRITE_ONLY, glBuffer, &ciErrNum);
+	if (ciErrNum != CL_SUCCESS)
+	{
+		b3Warning("clCreateFromGLBuffer failed (%d), using the copy path for render instances\n", ciErrNum);
+		return false;
+	}
+
+	size_t sizeInBytes = 0;
+	clGetMemObjectInfo(buffer, CL_MEM_SIZE, sizeof(size_t), &sizeInBytes, 0);
+	if (sizeInBytes < sizeof(b3Vector4) * 4 * getNumRenderInstances())
+	{
+		b3Warning("GL instance buffer is too small (%d bytes) for %d render instances\n", (int)sizeInBytes, getNumRenderInstances());
+		clReleaseMemObject(buffer);
+		return false;
+	}
+
+	m_data->m_renderInstanceBufferGL = buffer;
+
+	if (strstr(info.m_deviceExtensions, "cl_khr_gl_event"))
+	{
+		*(void**)&m_data->m_createEventFromGLsync = clGetExtensionFunctionAddress("clCreateEventFromGLsyncKHR");
+	}
+	return true;
+}
+
+bool b3GpuRigidBodyPipeline::isGLSyncSupported() const
+{
+	return m_data->m_renderInstanceBufferGL != 0 && m_data->m_createEventFromGLsync != 0;
+}
+
+cl_event b3GpuRigidBodyPipeline::createEventFromGLSync(void* glSync) const
+{
+	if (!isGLSyncSupported() || !glSync)
+		return 0;
+
+	cl_int ciErrNum = 0;
+	cl_event event = m_data->m_createEventFromGLsync(m_data->m_context, glSync, &ciErrNum);
+	if (ciErrNum != CL_SUCCESS)
+	{
+		b3Warning("clCreateEventFromGLsyncKHR failed (%d)\n", ciErrNum);
+		return 0;
+	}
+	return event;
+}
+
+bool b3GpuRigidBodyPipeline::isRenderInstanceBufferShared() const
+{
+	return m_data->m_renderInstanceBufferGL != 0;
+}
+
+void b3GpuRigidBodyPipeline::writeRenderInstancesGpu(cl_event glDoneEvent)
+{
+	int numInstances = getNumRenderInstances();
+	if (!numInstances || !m_data->m_renderInstanceBufferGL)
+		return;
+
+	//the device waits for the GL commands that still read the buffer, the host does not
+	cl_int status = clEnqueueAcquireGLObjects(m_data->m_queue, 1, &m_data->m_renderInstanceBufferGL, glDoneEvent ? 1 : 0, glDoneEvent ? &glDoneEvent : 0, 0);
+	if (status != CL_SUCCESS)
+	{
+		b3Error("clEnqueueAcquireGLObjects failed (%d)\n", status);
+		return;
+	}
+
+	{
+		B3_PROFILE("writeWorldMatricesKernel");
+		b3LauncherCL launcher(m_data->m_queue, m_data->m_writeWorldMatricesKernel, "m_writeWorldMatricesKernel");
+		launcher.setBuffer(m_data->m_narrowphase->getBodiesGpu());
+		launcher.setBuffer(m_data->m_renderInstanceBodiesGPU->getBufferCL());
+		launcher.setBuffer(m_data->m_renderInstanceBufferGL);
+		launcher.setConst(numInstances);
+		launcher.launch1D(numInstances);
+	}
+
+	//GL may use the buffer once the release has completed
+	status = clEnqueueReleaseGLObjects(m_data->m_queue, 1, &m_data->m_renderInstanceBufferGL, 0, 0, 0);
+	if (status != CL_SUCCESS)
+	{
+		b3Error("clEnqueueReleaseGLObjects failed (%d)\n", status);
+	}
+	clFinish(m_data->m_queue);
+}
+
+int b3GpuRigidBodyPipeline::getNumRenderInstances() const
+{
+	return m_data->m_renderInstanceBodiesGPU->size();
+}
@@ -22,6 +22,13 @@ subject to the following restrictions:
 #include "Bullet3Common/b3AlignedObjectArray.h"
 #include "Bullet3Collision/NarrowPhaseCollision/b3RaycastInfo.h"
 
+///position and orientation of a rigid body, as read back for rendering by readbackTransformsAsync
+struct b3GpuBodyTransform
+{
+	float m_position[4];
+	float m_orientation[4];
+};
+
 class b3GpuRigidBodyPipeline
 {
 protected:
@@ -29,13 +36,31 @@ protected:
 
 	int allocateCollidable();
 
+	bool isSleepingEnabled() const;
+	void reserveSleepState(int numBodies);
+	void resetSleepState(int firstBody, int endBody);
+	int filterSleepingPairs(cl_mem pairs, int numPairs);
+	void wakeTouchedIslands(cl_mem pairs, int numPairs);
+	void updateSleeping(float timeStep, int numContacts);
+	bool isCcdEnabled() const;
+	void clampFastBodyMotion(float timeStep, int numTriangleConvexPairs);
+	void syncGrownCapacities();
+	void insertBroadphaseProxy(int bodyIndex, float mass, const b3Vector3& aabbMin, const b3Vector3& aabbMax, int collisionFilterGroup, int collisionFilterMask);
+
 public:
 	b3GpuRigidBodyPipeline(cl_context ctx, cl_device_id device, cl_command_queue q, class b3GpuNarrowPhase* narrowphase, class b3GpuBroadphaseInterface* broadphaseSap, struct b3DynamicBvhBroadphase* broadphaseDbvt, const b3Config& config);
 	virtual ~b3GpuRigidBodyPipeline();
 
+	///starts building the OpenCL programs of the pipeline and of the narrowphase, broadphases, solvers and parallel primitives
+	///it uses concurrently in the background and returns immediately, call it before constructing b3GpuNarrowPhase and the broadphase
+	///the constructors then only wait for the programs they use, so construction takes about as long as the slowest program
+	///call b3OpenCLUtils::releasePendingPrograms before releasing the context
+	static void compileProgramsAsync(cl_context ctx, cl_device_id device);
+
 	void stepSimulation(float deltaTime);
 	void integrate(float timeStep);
-	void setupGpuAabbsFull();
+	///with a timeStep the aabbs of fast bodies are swept along their motion, see b3Config::m_enableCcd
+	void setupGpuAabbsFull(float timeStep = 0.f);
 
 	int registerConvexPolyhedron(class b3ConvexUtility* convex);
 
@@ -46,9 +71,21 @@ public:
 	//int		registerConcaveMesh(b3AlignedObjectArray<b3Vector3>* vertices, b3AlignedObjectArray<int>* indices, const float* scaling);
 	//int		registerCompoundShape(b3AlignedObjectArray<b3GpuChildShape>* childShapes);
 
-	int registerPhysicsInstance(float mass, const float* position, const float* orientation, int collisionShapeIndex, int userData, bool writeInstanceToGpu);
+	///the broadphase only reports a pair when the group of each body is in the mask of the other one
+	int registerPhysicsInstance(float mass, const float* position, const float* orientation, int collisionShapeIndex, int userData, bool writeInstanceToGpu, int collisionFilterGroup = 1, int collisionFilterMask = -1);
+	///registers numInstances bodies in one pass, positions and orientations hold 4 floats per instance
+	///like registerPhysicsInstance the bodies reuse the slots of removed bodies first, so the index of each one is written to bodyIndices
+	///returns numInstances, or -1 on failure
+	///collisionFilterGroups and collisionFilterMasks are optional, without them the bodies use group 1 and collide with everything
+	int registerPhysicsInstances(int numInstances, const float* masses, const float* positions, const float* orientations, const int* collisionShapeIndices, bool writeInstancesToGpu, int* bodyIndices, const int* collisionFilterGroups = 0, const int* collisionFilterMasks = 0);
 	//if you passed "writeInstanceToGpu" false in the registerPhysicsInstance method (for performance) you need to call writeAllInstancesToGpu after all instances are registered
 	void writeAllInstancesToGpu();
+	///removes the body from the broadphase and frees its slot, a later registerPhysicsInstance may reuse the index
+	///constraints attached to the body are not removed
+	void removePhysicsInstance(int bodyIndex);
+	///uploads only the instances added, removed or changed since the last upload, instead of everything like writeAllInstancesToGpu
+	///the body uploads do not block, the next stepSimulation waits for them in its first kernel
+	void writeChangedInstancesToGpu();
 	void copyConstraintsToHost();
 	void setGravity(const float* grav);
 	void reset();
@@ -62,9 +99,51 @@ public:
 
 	void castRays(const b3AlignedObjectArray<b3RayInfo>& rays, b3AlignedObjectArray<b3RayHit>& hitResults);
 
+	///use a ring of numBuffers pinned host buffers (2 or 3) for readbackTransformsAsync
+	void setNumTransformReadbackBuffers(int numBuffers);
+	///packs position and orientation of all bodies on the device and enqueues a non-blocking readback into the next pinned buffer
+	void readbackTransformsAsync();
+	///returns the most recent readback that has completed, without waiting for the one that is still in flight (if possible)
+	///with waitForNewest true it waits for the last readbackTransformsAsync instead
+	///the pointer stays valid during the next numBuffers-1 calls to readbackTransformsAsync
+	const b3GpuBodyTransform* getTransformsCpu(int* numBodies = 0, bool waitForNewest = false);
+
+	///render instances: writeRenderInstancesGpu writes one column major 4x4 world matrix per entry of bodyIndices
+	void setRenderInstances(const int* bodyIndices, int numInstances);
+	///shares the GL buffer object glBuffer (at least numInstances*64 bytes) with OpenCL, using cl_khr_gl_sharing
+	///the context has to be created with the GL context (see b3OpenCLUtils::createContextFromType)
+	///returns false if sharing is not available (such as on a CPU OpenCL runtime), use readbackTransformsAsync instead then
+	bool setRenderInstanceBufferGL(unsigned int glBuffer);
+	bool isRenderInstanceBufferShared() const;
+	///cl_khr_gl_event: createEventFromGLSync wraps a GL fence (a GLsync from glFenceSync after the draws that read the
+	///shared buffer, flushed) in an event that writeRenderInstancesGpu waits for on the device, so GL needs no glFinish
+	///it only reads state set by setRenderInstanceBufferGL, so the render thread may call it, it returns 0 without the extension
+	bool isGLSyncSupported() const;
+	cl_event createEventFromGLSync(void* glSync) const;
+	///writes the world matrices of the current body state into the shared GL buffer and waits until they are written
+	///call it from the thread that steps the simulation, after GL finished using the buffer: pass the event of its
+	///GL fence as glDoneEvent, or glFinish before this call when there is none
+	void writeRenderInstancesGpu(cl_event glDoneEvent = 0);
+	int getNumRenderInstances() const;
+
 	cl_mem getBodyBuffer();
 
 	int getNumBodies() const;
+
+	///wakes a sleeping body, the rest of its island wakes up in the next step when the body touches it
+	///call it for bodies changed from the host, writeAllInstancesToGpu wakes all bodies
+	void wakeUpBody(int bodyIndex);
+	void wakeUpAllBodies();
+	///number of sleeping bodies after the last stepSimulation, see b3Config::m_enableSleeping
+	int getNumSleepingBodies() const;
+	///sizes of the contact solver batches of the last stepSimulation, see b3Config::m_enableGraphColoring
+	const struct b3SolverBatchStats& getSolverBatchStats() const;
+
+	///records the device time of every kernel of stepSimulation, per stage (aabbs, pairFind, broadphaseSort, narrowphase,
+	///sat, clipping, joints, batching, solve, integrate, islands), see b3GpuProfiler for the query API and the Chrome trace
+	///the command queue has to be created with CL_QUEUE_PROFILING_ENABLE, returns false otherwise
+	bool setGpuProfilingEnabled(bool enable);
+	class b3GpuProfiler* getGpuProfiler();
 };
 
 #endif  //B3_GPU_RIGIDBODY_PIPELINE_H
\ No newline at end of file
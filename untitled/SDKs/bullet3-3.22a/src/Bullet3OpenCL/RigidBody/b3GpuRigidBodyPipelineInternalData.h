@@ -28,6 +28,17 @@ subject to the following restrictions:
 
 #include "Bullet3Collision/BroadPhaseCollision/b3OverlappingPair.h"
 #include "Bullet3OpenCL/RigidBody/b3GpuGenericConstraint.h"
+#include "Bullet3OpenCL/RigidBody/b3GpuRigidBodyPipeline.h"
+
+///host buffer allocated with CL_MEM_ALLOC_HOST_PTR and kept mapped, so readbacks go through pinned memory
+struct b3PinnedTransformBuffer
+{
+	cl_mem m_buffer;
+	b3GpuBodyTransform* m_hostPtr;
+	cl_event m_readEvent;
+	int m_numBodies;
+	int m_capacity;
+};
 
 struct b3GpuRigidBodyPipelineInternalData
 {
@@ -38,6 +49,8 @@ struct b3GpuRigidBodyPipelineInternalData
 	cl_kernel m_integrateTransformsKernel;
 	cl_kernel m_updateAabbsKernel;
 	cl_kernel m_clearOverlappingPairsKernel;
+	cl_kernel m_copyTransformsKernel;
+	cl_kernel m_writeWorldMatricesKernel;
 
 	class b3PgsJacobiSolver* m_solver;
 
@@ -62,7 +75,55 @@ struct b3GpuRigidBodyPipelineInternalData
 	class b3GpuNarrowPhase* m_narrowphase;
 	b3Vector3 m_gravity;
 
+	b3OpenCLArray<b3GpuBodyTransform>* m_transformsGPU;
+	b3AlignedObjectArray<b3PinnedTransformBuffer> m_transformReadbackBuffers;
+	int m_transformWriteSlot;
+	int m_transformLatestSlot;
+
+	b3OpenCLArray<int>* m_renderInstanceBodiesGPU;
+	cl_mem m_renderInstanceBufferGL;
+	///clCreateEventFromGLsyncKHR of cl_khr_gl_event, 0 if the device does not have it (clew does not load extensions)
+	cl_event(CL_API_CALL* m_createEventFromGLsync)(cl_context context, void* glSync, cl_int* errcode_ret);
+
 	b3Config m_config;
+
+	///island detection and sleeping, see kernels/islandKernels.cl
+	cl_kernel m_resetSleepStateKernel;
+	cl_kernel m_filterSleepingPairsKernel;
+	cl_kernel m_initIslandsKernel;
+	cl_kernel m_wakePairIslandsKernel;
+	cl_kernel m_wakeConstraintIslandsKernel;
+	cl_kernel m_wakeIslandsKernel;
+	cl_kernel m_updateSleepTimersKernel;
+	cl_kernel m_uniteContactIslandsKernel;
+	cl_kernel m_uniteConstraintIslandsKernel;
+	cl_kernel m_compressIslandsKernel;
+	cl_kernel m_islandSleepTimersKernel;
+	cl_kernel m_sleepIslandsKernel;
+
+	//per body
+	b3OpenCLArray<int>* m_bodySleepingGPU;
+	b3OpenCLArray<float>* m_sleepTimersGPU;
+	///island a sleeping body fell asleep in
+	b3OpenCLArray<int>* m_bodyIslandsGPU;
+	//per island root, rebuilt every step
+	b3OpenCLArray<int>* m_islandParentsGPU;
+	b3OpenCLArray<int>* m_islandTimersGPU;
+	b3OpenCLArray<int>* m_islandWakeGPU;
+	b3OpenCLArray<int>* m_islandCountersGPU;
+	int m_numSleepingBodies;
+	///the aabbs of sleeping bodies are computed again when the broadphase buffer changed or was written from the host
+	bool m_refreshSleepingAabbs;
+	cl_mem m_lastAabbBufferWS;
+
+	///continuous collision detection against concave meshes, see kernels/ccdKernels.cl
+	cl_kernel m_resetCcdHitFractionsKernel;
+	cl_kernel m_sweepTrianglesKernel;
+	cl_kernel m_clampCcdMotionKernel;
+	///per body, the fraction of the step it may move, as the bits of a float
+	b3OpenCLArray<int>* m_ccdHitFractionsGPU;
+
+	class b3GpuProfiler* m_gpuProfiler;
 };
 
 #endif  //B3_GPU_RIGIDBODY_PIPELINE_INTERNAL_DATA_H
@@ -0,0 +1,173 @@
+//Continuous collision detection against concave meshes. A body that moves more than ccdMotionThreshold times its
+//smallest half extent in a step has a swept aabb (see updateAabbsKernel.cl), so the bvh traversal reports the triangles
+//it would pass through. Each such triangle is tested against a sphere of that half extent moving along the body's
+//motion, and the first time of impact clamps the motion of the step. The velocity is kept, so the next step produces
+//regular contacts with the triangle and the solver removes the approaching velocity.
+
+typedef struct
+{
+	float4 m_pos;
+	float4 m_quat;
+	float4 m_linVel;
+	float4 m_angVel;
+
+	int m_collidableIdx;
+	float m_invMass;
+	float m_restituitionCoeff;
+	float m_frictionCoeff;
+} Body;
+
+typedef struct
+{
+	int m_numChildShapes;
+	float m_radius;
+	int m_shapeType;
+	int m_shapeIndex;
+} Collidable;
+
+typedef struct
+{
+	float4 m_min;
+	float4 m_max;
+} Aabb;
+
+typedef struct
+{
+	float4 m_localCenter;
+	float4 m_extents;
+	float4 mC;
+	float4 mE;
+
+	float m_radius;
+	int m_faceOffset;
+	int m_numFaces;
+	int m_numVertices;
+
+	int m_vertexOffset;
+	int m_uniqueEdgesOffset;
+	int m_numUniqueEdges;
+	int m_unused;
+} ConvexPolyhedron;
+
+typedef struct
+{
+	float4 m_plane;
+	int m_indexOffset;
+	int m_numIndices;
+	int m_unusedPadding1;
+	int m_unusedPadding2;
+} Face;
+
+float4 ccdQuatRotate(float4 q, float4 v)
+{
+	float4 qv = (float4)(q.x, q.y, q.z, 0.f);
+	float4 t = 2.f * cross(qv, v);
+	return v + q.w * t + cross(qv, t);
+}
+
+//the hit fractions are stored as the bits of a float in [0,1], which order like ints, so atomic_min finds the first hit
+__kernel void resetCcdHitFractionsKernel(__global int* hitFractions, int numBodies)
+{
+	int i = get_global_id(0);
+	if (i < numBodies)
+	{
+		hitFractions[i] = as_int(1.f);
+	}
+}
+
+//pairs are the triangle-convex pairs of the bvh traversal: x the concave body, y the other body, z the triangle
+__kernel void sweepTrianglesKernel(__global const int4* pairs, __global const Body* bodies, __global const Collidable* collidables, __global const Aabb* localShapeAabbs, __global const ConvexPolyhedron* convexShapes, __global const Face* faces, __global const int* indices, __global const float4* vertices, volatile __global int* hitFractions, int numPairs, float timeStep, float ccdMotionThreshold)
+{
+	int i = get_global_id(0);
+	if (i >= numPairs)
+		return;
+
+	int bodyIndexA = pairs[i].x;
+	int bodyIndexB = pairs[i].y;
+	int triangleIndex = pairs[i].z;
+	if (bodies[bodyIndexB].m_invMass == 0.f)
+		return;
+
+	int collidableIndexB = bodies[bodyIndexB].m_collidableIdx;
+	Aabb localAabbB = localShapeAabbs[collidableIndexB];
+	float4 localExtentsB = localAabbB.m_max - localAabbB.m_min;
+	float radius = 0.5f * min(localExtentsB.x, min(localExtentsB.y, localExtentsB.z));
+
+	float4 motion = (bodies[bodyIndexB].m_linVel - bodies[bodyIndexA].m_linVel) * timeStep;
+	motion.w = 0.f;
+	float motionThreshold = ccdMotionThreshold * radius;
+	if (radius <= 0.f || dot(motion, motion) <= motionThreshold * motionThreshold)
+		return;
+
+	float4 localCenterB = 0.5f * (localAabbB.m_max + localAabbB.m_min);
+	localCenterB.w = 0.f;
+	float4 center = bodies[bodyIndexB].m_pos + ccdQuatRotate(bodies[bodyIndexB].m_quat, localCenterB);
+	center.w = 0.f;
+
+	__global const ConvexPolyhedron* hullA = &convexShapes[collidables[bodies[bodyIndexA].m_collidableIdx].m_shapeIndex];
+	Face face = faces[hullA->m_faceOffset + triangleIndex];
+	float4 posA = bodies[bodyIndexA].m_pos;
+	posA.w = 0.f;
+	float4 triangle[3];
+	for (int k = 0; k < 3; k++)
+	{
+		float4 localVertex = vertices[hullA->m_vertexOffset + indices[face.m_indexOffset + k]];
+		localVertex.w = 0.f;
+		triangle[k] = posA + ccdQuatRotate(bodies[bodyIndexA].m_quat, localVertex);
+	}
+
+	float4 triangleNormal = cross(triangle[1] - triangle[0], triangle[2] - triangle[0]);
+	float area = length(triangleNormal);
+	if (area < 1e-12f)
+		return;
+	triangleNormal /= area;
+
+	//the triangles are two sided, the sphere approaches from the side its center starts on
+	float startDistance = dot(center - triangle[0], triangleNormal);
+	float4 sideNormal = startDistance < 0.f ? -triangleNormal : triangleNormal;
+	startDistance = fabs(startDistance);
+	float endDistance = dot(center + motion - triangle[0], sideNormal);
+
+	float hitFraction;
+	float4 contactPoint;
+	if (startDistance >= radius)
+	{
+		if (endDistance >= radius)
+			return;
+		hitFraction = (startDistance - radius) / (startDistance - endDistance);
+		contactPoint = center + motion * hitFraction - sideNormal * radius;
+	}
+	else
+	{
+		//already touching the plane, only a center passing through the triangle is a hit, the contacts handle the rest
+		if (endDistance >= 0.f)
+			return;
+		hitFraction = 0.f;
+		contactPoint = center + motion * (startDistance / (startDistance - endDistance));
+	}
+
+	for (int k = 0; k < 3; k++)
+	{
+		float4 edge = triangle[(k + 1) % 3] - triangle[k];
+		if (dot(cross(edge, contactPoint - triangle[k]), triangleNormal) < 0.f)
+			return;
+	}
+
+	atomic_min(&hitFractions[bodyIndexB], as_int(clamp(hitFraction, 0.f, 1.f)));
+}
+
+//runs before integrateTransformsKernel, which moves the bodies by linVel*timeStep, so they end up at the hit fraction
+__kernel void clampCcdMotionKernel(__global Body* bodies, __global const int* hitFractions, int numBodies, float timeStep)
+{
+	int i = get_global_id(0);
+	if (i < numBodies)
+	{
+		float hitFraction = as_float(hitFractions[i]);
+		if (hitFraction < 1.f)
+		{
+			float4 motion = bodies[i].m_linVel * timeStep;
+			motion.w = 0.f;
+			bodies[i].m_pos -= motion * (1.f - hitFraction);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+//this file is autogenerated using stringify.bat (premake --stringify) in the build folder of this project
+static const char* ccdKernelsCL =
+	"//Continuous collision detection against concave meshes. A body that moves more than ccdMotionThreshold times its\n"
+	"//smallest half extent in a step has a swept aabb (see updateAabbsKernel.cl), so the bvh traversal reports the triangles\n"
+	"//it would pass through. Each such triangle is tested against a sphere of that half extent moving along the body's\n"
+	"//motion, and the first time of impact clamps the motion of the step. The velocity is kept, so the next step produces\n"
+	"//regular contacts with the triangle and the solver removes the approaching velocity.\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_pos;\n"
+	"	float4 m_quat;\n"
+	"	float4 m_linVel;\n"
+	"	float4 m_angVel;\n"
+	"	int m_collidableIdx;\n"
+	"	float m_invMass;\n"
+	"	float m_restituitionCoeff;\n"
+	"	float m_frictionCoeff;\n"
+	"} Body;\n"
+	"typedef struct\n"
+	"{\n"
+	"	int m_numChildShapes;\n"
+	"	float m_radius;\n"
+	"	int m_shapeType;\n"
+	"	int m_shapeIndex;\n"
+	"} Collidable;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_min;\n"
+	"	float4 m_max;\n"
+	"} Aabb;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_localCenter;\n"
+	"	float4 m_extents;\n"
+	"	float4 mC;\n"
+	"	float4 mE;\n"
+	"	float m_radius;\n"
+	"	int m_faceOffset;\n"
+	"	int m_numFaces;\n"
+	"	int m_numVertices;\n"
+	"	int m_vertexOffset;\n"
+	"	int m_uniqueEdgesOffset;\n"
+	"	int m_numUniqueEdges;\n"
+	"	int m_unused;\n"
+	"} ConvexPolyhedron;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_plane;\n"
+	"	int m_indexOffset;\n"
+	"	int m_numIndices;\n"
+	"	int m_unusedPadding1;\n"
+	"	int m_unusedPadding2;\n"
+	"} Face;\n"
+	"float4 ccdQuatRotate(float4 q, float4 v)\n"
+	"{\n"
+	"	float4 qv = (float4)(q.x, q.y, q.z, 0.f);\n"
+	"	float4 t = 2.f * cross(qv, v);\n"
+	"	return v + q.w * t + cross(qv, t);\n"
+	"}\n"
+	"//the hit fractions are stored as the bits of a float in [0,1], which order like ints, so atomic_min finds the first hit\n"
+	"__kernel void resetCcdHitFractionsKernel(__global int* hitFractions, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies)\n"
+	"	{\n"
+	"		hitFractions[i] = as_int(1.f);\n"
+	"	}\n"
+	"}\n"
+	"//pairs are the triangle-convex pairs of the bvh traversal: x the concave body, y the other body, z the triangle\n"
+	"__kernel void sweepTrianglesKernel(__global const int4* pairs, __global const Body* bodies, __global const Collidable* collidables, __global const Aabb* localShapeAabbs, __global const ConvexPolyhedron* convexShapes, __global const Face* faces, __global const int* indices, __global const float4* vertices, volatile __global int* hitFractions, int numPairs, float timeStep, float ccdMotionThreshold)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i >= numPairs)\n"
+	"		return;\n"
+	"	int bodyIndexA = pairs[i].x;\n"
+	"	int bodyIndexB = pairs[i].y;\n"
+	"	int triangleIndex = pairs[i].z;\n"
+	"	if (bodies[bodyIndexB].m_invMass == 0.f)\n"
+	"		return;\n"
+	"	int collidableIndexB = bodies[bodyIndexB].m_collidableIdx;\n"
+	"	Aabb localAabbB = localShapeAabbs[collidableIndexB];\n"
+	"	float4 localExtentsB = localAabbB.m_max - localAabbB.m_min;\n"
+	"	float radius = 0.5f * min(localExtentsB.x, min(localExtentsB.y, localExtentsB.z));\n"
+	"	float4 motion = (bodies[bodyIndexB].m_linVel - bodies[bodyIndexA].m_linVel) * timeStep;\n"
+	"	motion.w = 0.f;\n"
+	"	float motionThreshold = ccdMotionThreshold * radius;\n"
+	"	if (radius <= 0.f || dot(motion, motion) <= motionThreshold * motionThreshold)\n"
+	"		return;\n"
+	"	float4 localCenterB = 0.5f * (localAabbB.m_max + localAabbB.m_min);\n"
+	"	localCenterB.w = 0.f;\n"
+	"	float4 center = bodies[bodyIndexB].m_pos + ccdQuatRotate(bodies[bodyIndexB].m_quat, localCenterB);\n"
+	"	center.w = 0.f;\n"
+	"	__global const ConvexPolyhedron* hullA = &convexShapes[collidables[bodies[bodyIndexA].m_collidableIdx].m_shapeIndex];\n"
+	"	Face face = faces[hullA->m_faceOffset + triangleIndex];\n"
+	"	float4 posA = bodies[bodyIndexA].m_pos;\n"
+	"	posA.w = 0.f;\n"
+	"	float4 triangle[3];\n"
+	"	for (int k = 0; k < 3; k++)\n"
+	"	{\n"
+	"		float4 localVertex = vertices[hullA->m_vertexOffset + indices[face.m_indexOffset + k]];\n"
+	"		localVertex.w = 0.f;\n"
+	"		triangle[k] = posA + ccdQuatRotate(bodies[bodyIndexA].m_quat, localVertex);\n"
+	"	}\n"
+	"	float4 triangleNormal = cross(triangle[1] - triangle[0], triangle[2] - triangle[0]);\n"
+	"	float area = length(triangleNormal);\n"
+	"	if (area < 1e-12f)\n"
+	"		return;\n"
+	"	triangleNormal /= area;\n"
+	"	//the triangles are two sided, the sphere approaches from the side its center starts on\n"
+	"	float startDistance = dot(center - triangle[0], triangleNormal);\n"
+	"	float4 sideNormal = startDistance < 0.f ? -triangleNormal : triangleNormal;\n"
+	"	startDistance = fabs(startDistance);\n"
+	"	float endDistance = dot(center + motion - triangle[0], sideNormal);\n"
+	"	float hitFraction;\n"
+	"	float4 contactPoint;\n"
+	"	if (startDistance >= radius)\n"
+	"	{\n"
+	"		if (endDistance >= radius)\n"
+	"			return;\n"
+	"		hitFraction = (startDistance - radius) / (startDistance - endDistance);\n"
+	"		contactPoint = center + motion * hitFraction - sideNormal * radius;\n"
+	"	}\n"
+	"	else\n"
+	"	{\n"
+	"		//already touching the plane, only a center passing through the triangle is a hit, the contacts handle the rest\n"
+	"		if (endDistance >= 0.f)\n"
+	"			return;\n"
+	"		hitFraction = 0.f;\n"
+	"		contactPoint = center + motion * (startDistance / (startDistance - endDistance));\n"
+	"	}\n"
+	"	for (int k = 0; k < 3; k++)\n"
+	"	{\n"
+	"		float4 edge = triangle[(k + 1) % 3] - triangle[k];\n"
+	"		if (dot(cross(edge, contactPoint - triangle[k]), triangleNormal) < 0.f)\n"
+	"			return;\n"
+	"	}\n"
+	"	atomic_min(&hitFractions[bodyIndexB], as_int(clamp(hitFraction, 0.f, 1.f)));\n"
+	"}\n"
+	"//runs before integrateTransformsKernel, which moves the bodies by linVel*timeStep, so they end up at the hit fraction\n"
+	"__kernel void clampCcdMotionKernel(__global Body* bodies, __global const int* hitFractions, int numBodies, float timeStep)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies)\n"
+	"	{\n"
+	"		float hitFraction = as_float(hitFractions[i]);\n"
+	"		if (hitFraction < 1.f)\n"
+	"		{\n"
+	"			float4 motion = bodies[i].m_linVel * timeStep;\n"
+	"			motion.w = 0.f;\n"
+	"			bodies[i].m_pos -= motion * (1.f - hitFraction);\n"
+	"		}\n"
+	"	}\n"
+	"}\n";
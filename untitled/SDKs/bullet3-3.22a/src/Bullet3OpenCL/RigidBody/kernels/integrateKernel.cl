@@ -20,13 +20,50 @@ subject to the following restrictions:
 
 
 
+///sleeping bodies (bodySleeping[nodeID] != 0) keep their transform and do not gain velocity from gravity
 __kernel void 
-  integrateTransformsKernel( __global b3RigidBodyData_t* bodies,const int numNodes, float timeStep, float angularDamping, float4 gravityAcceleration)
+  integrateTransformsKernel( __global b3RigidBodyData_t* bodies,const int numNodes, float timeStep, float angularDamping, float4 gravityAcceleration, __global const int* bodySleeping)
 {
 	int nodeID = get_global_id(0);
 	
-	if( nodeID < numNodes)
+	if( nodeID < numNodes && !bodySleeping[nodeID])
 	{
 		integrateSingleTransform(bodies,nodeID, timeStep, angularDamping,gravityAcceleration);
 	}
 }
+
+///packs position and orientation of each body, so the host only needs to read back 32 bytes per body for rendering
+__kernel void 
+  copyTransformsKernel( __global const b3RigidBodyData_t* bodies, __global float4* transformsOut, const int numNodes)
+{
+	int nodeID = get_global_id(0);
+	
+	if( nodeID < numNodes)
+	{
+		transformsOut[nodeID*2] = bodies[nodeID].m_pos;
+		transformsOut[nodeID*2+1] = bodies[nodeID].m_quat;
+	}
+}
+
+///writes a column major 4x4 world matrix (as in OpenGL) per render instance, for example into a shared GL instance buffer
+__kernel void 
+  writeWorldMatricesKernel( __global const b3RigidBodyData_t* bodies, __global const int* bodyIndices, __global float4* matricesOut, const int numInstances)
+{
+	int instanceID = get_global_id(0);
+	
+	if( instanceID < numInstances)
+	{
+		int bodyIndex = bodyIndices[instanceID];
+		float4 q = bodies[bodyIndex].m_quat;
+		float4 pos = bodies[bodyIndex].m_pos;
+		
+		float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+		float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+		float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+		
+		matricesOut[instanceID*4]   = (float4)(1.f-2.f*(yy+zz), 2.f*(xy+wz), 2.f*(xz-wy), 0.f);
+		matricesOut[instanceID*4+1] = (float4)(2.f*(xy-wz), 1.f-2.f*(xx+zz), 2.f*(yz+wx), 0.f);
+		matricesOut[instanceID*4+2] = (float4)(2.f*(xz+wy), 2.f*(yz-wx), 1.f-2.f*(xx+yy), 0.f);
+		matricesOut[instanceID*4+3] = (float4)(pos.x, pos.y, pos.z, 1.f);
+	}
+}
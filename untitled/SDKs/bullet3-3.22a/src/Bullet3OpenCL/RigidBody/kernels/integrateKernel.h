@@ -420,13 +420,48 @@ static const char* integrateKernelCL =
 	"	}\n"
 	"	\n"
 	"}\n"
+	"///sleeping bodies (bodySleeping[nodeID] != 0) keep their transform and do not gain velocity from gravity\n"
 	"__kernel void \n"
-	"  integrateTransformsKernel( __global b3RigidBodyData_t* bodies,const int numNodes, float timeStep, float angularDamping, float4 gravityAcceleration)\n"
+	"  integrateTransformsKernel( __global b3RigidBodyData_t* bodies,const int numNodes, float timeStep, float angularDamping, float4 gravityAcceleration, __global const int* bodySleeping)\n"
 	"{\n"
 	"	int nodeID = get_global_id(0);\n"
 	"	\n"
-	"	if( nodeID < numNodes)\n"
+	"	if( nodeID < numNodes && !bodySleeping[nodeID])\n"
 	"	{\n"
 	"		integrateSingleTransform(bodies,nodeID, timeStep, angularDamping,gravityAcceleration);\n"
 	"	}\n"
+	"}\n"
+	"///packs position and orientation of each body, so the host only needs to read back 32 bytes per body for rendering\n"
+	"__kernel void \n"
+	"  copyTransformsKernel( __global const b3RigidBodyData_t* bodies, __global float4* transformsOut, const int numNodes)\n"
+	"{\n"
+	"	int nodeID = get_global_id(0);\n"
+	"	\n"
+	"	if( nodeID < numNodes)\n"
+	"	{\n"
+	"		transformsOut[nodeID*2] = bodies[nodeID].m_pos;\n"
+	"		transformsOut[nodeID*2+1] = bodies[nodeID].m_quat;\n"
+	"	}\n"
+	"}\n"
+	"///writes a column major 4x4 world matrix (as in OpenGL) per render instance, for example into a shared GL instance buffer\n"
+	"__kernel void \n"
+	"  writeWorldMatricesKernel( __global const b3RigidBodyData_t* bodies, __global const int* bodyIndices, __global float4* matricesOut, const int numInstances)\n"
+	"{\n"
+	"	int instanceID = get_global_id(0);\n"
+	"	\n"
+	"	if( instanceID < numInstances)\n"
+	"	{\n"
+	"		int bodyIndex = bodyIndices[instanceID];\n"
+	"		float4 q = bodies[bodyIndex].m_quat;\n"
+	"		float4 pos = bodies[bodyIndex].m_pos;\n"
+	"		\n"
+	"		float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;\n"
+	"		float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;\n"
+	"		float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;\n"
+	"		\n"
+	"		matricesOut[instanceID*4]   = (float4)(1.f-2.f*(yy+zz), 2.f*(xy+wz), 2.f*(xz-wy), 0.f);\n"
+	"		matricesOut[instanceID*4+1] = (float4)(2.f*(xy-wz), 1.f-2.f*(xx+zz), 2.f*(yz+wx), 0.f);\n"
+	"		matricesOut[instanceID*4+2] = (float4)(2.f*(xz+wy), 2.f*(yz-wx), 1.f-2.f*(xx+yy), 0.f);\n"
+	"		matricesOut[instanceID*4+3] = (float4)(pos.x, pos.y, pos.z, 1.f);\n"
+	"	}\n"
 	"}\n";
@@ -0,0 +1,253 @@
+//Islands are the groups of dynamic bodies connected by contacts or joints. They are built every step with a parallel
+//union find, and an island falls asleep once all of its bodies have been slower than the thresholds for a while.
+//A sleeping body remembers the island it fell asleep in (bodyIslands), so a moving body touching any body of a
+//sleeping pile wakes the whole pile, even though the pile itself produces no contacts anymore.
+
+#define B3_CONSTRAINT_FLAG_ENABLED 1
+
+typedef struct
+{
+	float4 m_pos;
+	float4 m_quat;
+	float4 m_linVel;
+	float4 m_angVel;
+
+	int m_collidableIdx;
+	float m_invMass;
+	float m_restituitionCoeff;
+	float m_frictionCoeff;
+} Body;
+
+typedef struct
+{
+	float4 m_worldPosB[4];
+	float4 m_worldNormalOnB;	//	w: m_nPoints
+	unsigned short m_restituitionCoeffCmp;
+	unsigned short m_frictionCoeffCmp;
+	int m_batchIdx;
+	int m_bodyAPtrAndSignBit;
+	int m_bodyBPtrAndSignBit;
+
+	int m_childIndexA;
+	int m_childIndexB;
+	int m_unused1;
+	int m_unused2;
+} Contact4;
+
+typedef struct
+{
+	int m_constraintType;
+	int m_rbA;
+	int m_rbB;
+	float m_breakingImpulseThreshold;
+
+	float4 m_pivotInA;
+	float4 m_pivotInB;
+	float4 m_relTargetAB;
+
+	int m_flags;
+	int m_uid;
+	int m_padding[2];
+} GenericConstraint;
+
+//awake dynamic body, fixed bodies never join an island
+int isBodyActive(__global const Body* bodies, __global const int* bodySleeping, int bodyIndex)
+{
+	return bodies[bodyIndex].m_invMass != 0.f && !bodySleeping[bodyIndex];
+}
+
+int findIslandRoot(volatile __global int* islandParents, int bodyIndex)
+{
+	int parent = islandParents[bodyIndex];
+	while (parent != bodyIndex)
+	{
+		bodyIndex = parent;
+		parent = islandParents[bodyIndex];
+	}
+	return bodyIndex;
+}
+
+//hooks the larger root below the smaller one, parents only ever decrease so there are no cycles
+//a hook can be overwritten by a concurrent one, the host repeats the pass until nothing changes
+void uniteIslands(volatile __global int* islandParents, volatile __global int* changed, int bodyA, int bodyB)
+{
+	int rootA = findIslandRoot(islandParents, bodyA);
+	int rootB = findIslandRoot(islandParents, bodyB);
+	if (rootA != rootB)
+	{
+		atomic_min(&islandParents[max(rootA, rootB)], min(rootA, rootB));
+		*changed = 1;
+	}
+}
+
+//a body that sleeps and is touched by an awake body wakes the island it fell asleep in
+void wakeTouchedIsland(__global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int bodyA, int bodyB)
+{
+	if (bodySleeping[bodyA] && isBodyActive(bodies, bodySleeping, bodyB))
+	{
+		islandWake[bodyIslands[bodyA]] = 1;
+	}
+	if (bodySleeping[bodyB] && isBodyActive(bodies, bodySleeping, bodyA))
+	{
+		islandWake[bodyIslands[bodyB]] = 1;
+	}
+}
+
+__kernel void resetSleepStateKernel(__global int* bodySleeping, __global float* sleepTimers, int firstBody, int numBodies)
+{
+	int i = get_global_id(0) + firstBody;
+	if (i < numBodies)
+	{
+		bodySleeping[i] = 0;
+		sleepTimers[i] = 0.f;
+	}
+}
+
+//keeps the broadphase pairs that have at least one awake dynamic body, the others need no contacts
+__kernel void filterSleepingPairsKernel(__global const int4* pairs, __global int4* pairsOut, volatile __global int* pairCount, __global const Body* bodies, __global const int* bodySleeping, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		int4 pair = pairs[i];
+		if (isBodyActive(bodies, bodySleeping, pair.x) || isBodyActive(bodies, bodySleeping, pair.y))
+		{
+			int curPair = atomic_inc(pairCount);
+			pairsOut[curPair] = pair;
+		}
+	}
+}
+
+__kernel void initIslandsKernel(__global int* islandParents, __global int* islandTimers, __global int* islandWake, int numBodies)
+{
+	int i = get_global_id(0);
+	if (i < numBodies)
+	{
+		islandParents[i] = i;
+		islandTimers[i] = 0x7fffffff;
+		islandWake[i] = 0;
+	}
+}
+
+//runs on the broadphase pairs before they are filtered, every contact comes from one of them
+__kernel void wakePairIslandsKernel(__global const int4* pairs, __global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int numPairs)
+{
+	int i = get_global_id(0);
+	if (i < numPairs)
+	{
+		int4 pair = pairs[i];
+		wakeTouchedIsland(bodies, bodySleeping, bodyIslands, islandWake, pair.x, pair.y);
+	}
+}
+
+__kernel void wakeConstraintIslandsKernel(__global const GenericConstraint* constraints, __global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int numConstraints)
+{
+	int i = get_global_id(0);
+	if (i < numConstraints && (constraints[i].m_flags & B3_CONSTRAINT_FLAG_ENABLED))
+	{
+		wakeTouchedIsland(bodies, bodySleeping, bodyIslands, islandWake, constraints[i].m_rbA, constraints[i].m_rbB);
+	}
+}
+
+__kernel void wakeIslandsKernel(__global int* bodySleeping, __global float* sleepTimers, __global const int* bodyIslands, __global const int* islandWake, int numBodies)
+{
+	int i = get_global_id(0);
+	if (i < numBodies && bodySleeping[i] && islandWake[bodyIslands[i]])
+	{
+		bodySleeping[i] = 0;
+		sleepTimers[i] = 0.f;
+	}
+}
+
+//a body counts how long it has been slow, any fast step starts the count again
+__kernel void updateSleepTimersKernel(__global const Body* bodies, __global const int* bodySleeping, __global float* sleepTimers, int numBodies, float timeStep, float linearThresholdSqr, float angularThresholdSqr)
+{
+	int i = get_global_id(0);
+	if (i < numBodies && isBodyActive(bodies, bodySleeping, i))
+	{
+		float4 linVel = bodies[i].m_linVel;
+		float4 angVel = bodies[i].m_angVel;
+		linVel.w = 0.f;
+		angVel.w = 0.f;
+		if (dot(linVel, linVel) < linearThresholdSqr && dot(angVel, angVel) < angularThresholdSqr)
+		{
+			sleepTimers[i] += timeStep;
+		}
+		else
+		{
+			sleepTimers[i] = 0.f;
+		}
+	}
+}
+
+__kernel void uniteContactIslandsKernel(__global const Contact4* contacts, __global const Body* bodies, __global const int* bodySleeping, volatile __global int* islandParents, volatile __global int* changed, int numContacts)
+{
+	int i = get_global_id(0);
+	if (i < numContacts)
+	{
+		int bodyA = abs(contacts[i].m_bodyAPtrAndSignBit);
+		int bodyB = abs(contacts[i].m_bodyBPtrAndSignBit);
+		if (isBodyActive(bodies, bodySleeping, bodyA) && isBodyActive(bodies, bodySleeping, bodyB))
+		{
+			uniteIslands(islandParents, changed, bodyA, bodyB);
+		}
+	}
+}
+
+__kernel void uniteConstraintIslandsKernel(__global const GenericConstraint* constraints, __global const Body* bodies, __global const int* bodySleeping, volatile __global int* islandParents, volatile __global int* changed, int numConstraints)
+{
+	int i = get_global_id(0);
+	if (i < numConstraints && (constraints[i].m_flags & B3_CONSTRAINT_FLAG_ENABLED))
+	{
+		int bodyA = constraints[i].m_rbA;
+		int bodyB = constraints[i].m_rbB;
+		if (isBodyActive(bodies, bodySleeping, bodyA) && isBodyActive(bodies, bodySleeping, bodyB))
+		{
+			uniteIslands(islandParents, changed, bodyA, bodyB);
+		}
+	}
+}
+
+//points each body directly at its root, which also shortens the paths for the next union pass
+__kernel void compressIslandsKernel(volatile __global int* islandParents, int numBodies)
+{
+	int i = get_global_id(0);
+	if (i < numBodies)
+	{
+		islandParents[i] = findIslandRoot(islandParents, i);
+	}
+}
+
+//the timers are not negative, so their bits compare like integers
+__kernel void islandSleepTimersKernel(__global const Body* bodies, __global const int* bodySleeping, __global const float* sleepTimers, __global const int* islandParents, volatile __global int* islandTimers, int numBodies)
+{
+	int i = get_global_id(0);
+	if (i < numBodies && isBodyActive(bodies, bodySleeping, i))
+	{
+		atomic_min(&islandTimers[islandParents[i]], as_int(sleepTimers[i]));
+	}
+}
+
+//the whole island falls asleep when its most recently moving body has been slow for timeToSleep
+__kernel void sleepIslandsKernel(__global Body* bodies, __global int* bodySleeping, __global const int* islandParents, __global const int* islandTimers, __global int* bodyIslands, volatile __global int* numSleepingBodies, int numBodies, float timeToSleep)
+{
+	int i = get_global_id(0);
+	if (i < numBodies && bodies[i].m_invMass != 0.f)
+	{
+		if (!bodySleeping[i])
+		{
+			int island = islandParents[i];
+			if (as_float(islandTimers[island]) >= timeToSleep)
+			{
+				bodySleeping[i] = 1;
+				bodyIslands[i] = island;
+				bodies[i].m_linVel = (float4)(0.f, 0.f, 0.f, 0.f);
+				bodies[i].m_angVel = (float4)(0.f, 0.f, 0.f, 0.f);
+			}
+		}
+		if (bodySleeping[i])
+		{
+			atomic_inc(numSleepingBodies);
+		}
+	}
+}
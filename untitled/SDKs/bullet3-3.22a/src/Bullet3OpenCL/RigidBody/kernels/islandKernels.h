@@ -0,0 +1,231 @@
+//this file is autogenerated using stringify.bat (premake --stringify) in the build folder of this project
+static const char* islandKernelsCL =
+	"//Islands are the groups of dynamic bodies connected by contacts or joints. They are built every step with a parallel\n"
+	"//union find, and an island falls asleep once all of its bodies have been slower than the thresholds for a while.\n"
+	"//A sleeping body remembers the island it fell asleep in (bodyIslands), so a moving body touching any body of a\n"
+	"//sleeping pile wakes the whole pile, even though the pile itself produces no contacts anymore.\n"
+	"#define B3_CONSTRAINT_FLAG_ENABLED 1\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_pos;\n"
+	"	float4 m_quat;\n"
+	"	float4 m_linVel;\n"
+	"	float4 m_angVel;\n"
+	"	int m_collidableIdx;\n"
+	"	float m_invMass;\n"
+	"	float m_restituitionCoeff;\n"
+	"	float m_frictionCoeff;\n"
+	"} Body;\n"
+	"typedef struct\n"
+	"{\n"
+	"	float4 m_worldPosB[4];\n"
+	"	float4 m_worldNormalOnB;	//	w: m_nPoints\n"
+	"	unsigned short m_restituitionCoeffCmp;\n"
+	"	unsigned short m_frictionCoeffCmp;\n"
+	"	int m_batchIdx;\n"
+	"	int m_bodyAPtrAndSignBit;\n"
+	"	int m_bodyBPtrAndSignBit;\n"
+	"	int m_childIndexA;\n"
+	"	int m_childIndexB;\n"
+	"	int m_unused1;\n"
+	"	int m_unused2;\n"
+	"} Contact4;\n"
+	"typedef struct\n"
+	"{\n"
+	"	int m_constraintType;\n"
+	"	int m_rbA;\n"
+	"	int m_rbB;\n"
+	"	float m_breakingImpulseThreshold;\n"
+	"	float4 m_pivotInA;\n"
+	"	float4 m_pivotInB;\n"
+	"	float4 m_relTargetAB;\n"
+	"	int m_flags;\n"
+	"	int m_uid;\n"
+	"	int m_padding[2];\n"
+	"} GenericConstraint;\n"
+	"//awake dynamic body, fixed bodies never join an island\n"
+	"int isBodyActive(__global const Body* bodies, __global const int* bodySleeping, int bodyIndex)\n"
+	"{\n"
+	"	return bodies[bodyIndex].m_invMass != 0.f && !bodySleeping[bodyIndex];\n"
+	"}\n"
+	"int findIslandRoot(volatile __global int* islandParents, int bodyIndex)\n"
+	"{\n"
+	"	int parent = islandParents[bodyIndex];\n"
+	"	while (parent != bodyIndex)\n"
+	"	{\n"
+	"		bodyIndex = parent;\n"
+	"		parent = islandParents[bodyIndex];\n"
+	"	}\n"
+	"	return bodyIndex;\n"
+	"}\n"
+	"//hooks the larger root below the smaller one, parents only ever decrease so there are no cycles\n"
+	"//a hook can be overwritten by a concurrent one, the host repeats the pass until nothing changes\n"
+	"void uniteIslands(volatile __global int* islandParents, volatile __global int* changed, int bodyA, int bodyB)\n"
+	"{\n"
+	"	int rootA = findIslandRoot(islandParents, bodyA);\n"
+	"	int rootB = findIslandRoot(islandParents, bodyB);\n"
+	"	if (rootA != rootB)\n"
+	"	{\n"
+	"		atomic_min(&islandParents[max(rootA, rootB)], min(rootA, rootB));\n"
+	"		*changed = 1;\n"
+	"	}\n"
+	"}\n"
+	"//a body that sleeps and is touched by an awake body wakes the island it fell asleep in\n"
+	"void wakeTouchedIsland(__global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int bodyA, int bodyB)\n"
+	"{\n"
+	"	if (bodySleeping[bodyA] && isBodyActive(bodies, bodySleeping, bodyB))\n"
+	"	{\n"
+	"		islandWake[bodyIslands[bodyA]] = 1;\n"
+	"	}\n"
+	"	if (bodySleeping[bodyB] && isBodyActive(bodies, bodySleeping, bodyA))\n"
+	"	{\n"
+	"		islandWake[bodyIslands[bodyB]] = 1;\n"
+	"	}\n"
+	"}\n"
+	"__kernel void resetSleepStateKernel(__global int* bodySleeping, __global float* sleepTimers, int firstBody, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0) + firstBody;\n"
+	"	if (i < numBodies)\n"
+	"	{\n"
+	"		bodySleeping[i] = 0;\n"
+	"		sleepTimers[i] = 0.f;\n"
+	"	}\n"
+	"}\n"
+	"//keeps the broadphase pairs that have at least one awake dynamic body, the others need no contacts\n"
+	"__kernel void filterSleepingPairsKernel(__global const int4* pairs, __global int4* pairsOut, volatile __global int* pairCount, __global const Body* bodies, __global const int* bodySleeping, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		int4 pair = pairs[i];\n"
+	"		if (isBodyActive(bodies, bodySleeping, pair.x) || isBodyActive(bodies, bodySleeping, pair.y))\n"
+	"		{\n"
+	"			int curPair = atomic_inc(pairCount);\n"
+	"			pairsOut[curPair] = pair;\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"__kernel void initIslandsKernel(__global int* islandParents, __global int* islandTimers, __global int* islandWake, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies)\n"
+	"	{\n"
+	"		islandParents[i] = i;\n"
+	"		islandTimers[i] = 0x7fffffff;\n"
+	"		islandWake[i] = 0;\n"
+	"	}\n"
+	"}\n"
+	"//runs on the broadphase pairs before they are filtered, every contact comes from one of them\n"
+	"__kernel void wakePairIslandsKernel(__global const int4* pairs, __global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int numPairs)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numPairs)\n"
+	"	{\n"
+	"		int4 pair = pairs[i];\n"
+	"		wakeTouchedIsland(bodies, bodySleeping, bodyIslands, islandWake, pair.x, pair.y);\n"
+	"	}\n"
+	"}\n"
+	"__kernel void wakeConstraintIslandsKernel(__global const GenericConstraint* constraints, __global const Body* bodies, __global const int* bodySleeping, __global const int* bodyIslands, __global int* islandWake, int numConstraints)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numConstraints && (constraints[i].m_flags & B3_CONSTRAINT_FLAG_ENABLED))\n"
+	"	{\n"
+	"		wakeTouchedIsland(bodies, bodySleeping, bodyIslands, islandWake, constraints[i].m_rbA, constraints[i].m_rbB);\n"
+	"	}\n"
+	"}\n"
+	"__kernel void wakeIslandsKernel(__global int* bodySleeping, __global float* sleepTimers, __global const int* bodyIslands, __global const int* islandWake, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies && bodySleeping[i] && islandWake[bodyIslands[i]])\n"
+	"	{\n"
+	"		bodySleeping[i] = 0;\n"
+	"		sleepTimers[i] = 0.f;\n"
+	"	}\n"
+	"}\n"
+	"//a body counts how long it has been slow, any fast step starts the count again\n"
+	"__kernel void updateSleepTimersKernel(__global const Body* bodies, __global const int* bodySleeping, __global float* sleepTimers, int numBodies, float timeStep, float linearThresholdSqr, float angularThresholdSqr)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies && isBodyActive(bodies, bodySleeping, i))\n"
+	"	{\n"
+	"		float4 linVel = bodies[i].m_linVel;\n"
+	"		float4 angVel = bodies[i].m_angVel;\n"
+	"		linVel.w = 0.f;\n"
+	"		angVel.w = 0.f;\n"
+	"		if (dot(linVel, linVel) < linearThresholdSqr && dot(angVel, angVel) < angularThresholdSqr)\n"
+	"		{\n"
+	"			sleepTimers[i] += timeStep;\n"
+	"		}\n"
+	"		else\n"
+	"		{\n"
+	"			sleepTimers[i] = 0.f;\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"__kernel void uniteContactIslandsKernel(__global const Contact4* contacts, __global const Body* bodies, __global const int* bodySleeping, volatile __global int* islandParents, volatile __global int* changed, int numContacts)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numContacts)\n"
+	"	{\n"
+	"		int bodyA = abs(contacts[i].m_bodyAPtrAndSignBit);\n"
+	"		int bodyB = abs(contacts[i].m_bodyBPtrAndSignBit);\n"
+	"		if (isBodyActive(bodies, bodySleeping, bodyA) && isBodyActive(bodies, bodySleeping, bodyB))\n"
+	"		{\n"
+	"			uniteIslands(islandParents, changed, bodyA, bodyB);\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"__kernel void uniteConstraintIslandsKernel(__global const GenericConstraint* constraints, __global const Body* bodies, __global const int* bodySleeping, volatile __global int* islandParents, volatile __global int* changed, int numConstraints)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numConstraints && (constraints[i].m_flags & B3_CONSTRAINT_FLAG_ENABLED))\n"
+	"	{\n"
+	"		int bodyA = constraints[i].m_rbA;\n"
+	"		int bodyB = constraints[i].m_rbB;\n"
+	"		if (isBodyActive(bodies, bodySleeping, bodyA) && isBodyActive(bodies, bodySleeping, bodyB))\n"
+	"		{\n"
+	"			uniteIslands(islandParents, changed, bodyA, bodyB);\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"//points each body directly at its root, which also shortens the paths for the next union pass\n"
+	"__kernel void compressIslandsKernel(volatile __global int* islandParents, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies)\n"
+	"	{\n"
+	"		islandParents[i] = findIslandRoot(islandParents, i);\n"
+	"	}\n"
+	"}\n"
+	"//the timers are not negative, so their bits compare like integers\n"
+	"__kernel void islandSleepTimersKernel(__global const Body* bodies, __global const int* bodySleeping, __global const float* sleepTimers, __global const int* islandParents, volatile __global int* islandTimers, int numBodies)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies && isBodyActive(bodies, bodySleeping, i))\n"
+	"	{\n"
+	"		atomic_min(&islandTimers[islandParents[i]], as_int(sleepTimers[i]));\n"
+	"	}\n"
+	"}\n"
+	"//the whole island falls asleep when its most recently moving body has been slow for timeToSleep\n"
+	"__kernel void sleepIslandsKernel(__global Body* bodies, __global int* bodySleeping, __global const int* islandParents, __global const int* islandTimers, __global int* bodyIslands, volatile __global int* numSleepingBodies, int numBodies, float timeToSleep)\n"
+	"{\n"
+	"	int i = get_global_id(0);\n"
+	"	if (i < numBodies && bodies[i].m_invMass != 0.f)\n"
+	"	{\n"
+	"		if (!bodySleeping[i])\n"
+	"		{\n"
+	"			int island = islandParents[i];\n"
+	"			if (as_float(islandTimers[island]) >= timeToSleep)\n"
+	"			{\n"
+	"				bodySleeping[i] = 1;\n"
+	"				bodyIslands[i] = island;\n"
+	"				bodies[i].m_linVel = (float4)(0.f, 0.f, 0.f, 0.f);\n"
+	"				bodies[i].m_angVel = (float4)(0.f, 0.f, 0.f, 0.f);\n"
+	"			}\n"
+	"		}\n"
+	"		if (bodySleeping[i])\n"
+	"		{\n"
+	"			atomic_inc(numSleepingBodies);\n"
+	"		}\n"
+	"	}\n"
+	"}\n";
@@ -499,3 +499,158 @@ __kernel void solveSingleContactKernel(__global Body* gBodies,
 		solveContactConstraint( gBodies, gShapes, &gConstraints[idx] );
 	}    
 }
+
+//applies the impulses the constraint was warm started with, so the bodies and the accumulated impulses agree
+void warmStartContactConstraint(__global Body* gBodies, __global Shape* gShapes, __global Constraint4* cs)
+{
+	int aIdx = cs->m_bodyA;
+	int bIdx = cs->m_bodyB;
+
+	float4 posA = gBodies[aIdx].m_pos;
+	float4 linVelA = gBodies[aIdx].m_linVel;
+	float4 angVelA = gBodies[aIdx].m_angVel;
+	float invMassA = gBodies[aIdx].m_invMass;
+	Matrix3x3 invInertiaA = gShapes[aIdx].m_invInertia;
+
+	float4 posB = gBodies[bIdx].m_pos;
+	float4 linVelB = gBodies[bIdx].m_linVel;
+	float4 angVelB = gBodies[bIdx].m_angVel;
+	float invMassB = gBodies[bIdx].m_invMass;
+	Matrix3x3 invInertiaB = gShapes[bIdx].m_invInertia;
+
+	float4 angular0, angular1, linear;
+	for(int ic=0; ic<4; ic++)
+	{
+		float rambdaDt = cs->m_appliedRambdaDt[ic];
+		if( cs->m_jacCoeffInv[ic] == 0.f || rambdaDt == 0.f ) continue;
+
+		float4 r0 = cs->m_worldPos[ic] - posA;
+		float4 r1 = cs->m_worldPos[ic] - posB;
+		setLinearAndAngular( -cs->m_linear, r0, r1, &linear, &angular0, &angular1 );
+
+		linVelA += invMassA*linear*rambdaDt;
+		linVelB += invMassB*(-linear)*rambdaDt;
+		angVelA += mtMul1(invInertiaA, angular0)*rambdaDt;
+		angVelB += mtMul1(invInertiaB, angular1)*rambdaDt;
+	}
+
+	if( cs->m_fJacCoeffInv[0] != 0.f || cs->m_fJacCoeffInv[1] != 0.f )
+	{
+		float4 n = -cs->m_linear;
+		float4 tangent[2];
+		btPlaneSpace1(&n,&tangent[0],&tangent[1]);
+		float4 r0 = cs->m_center - posA;
+		float4 r1 = cs->m_center - posB;
+		for(int i=0; i<2; i++)
+		{
+			float rambdaDt = cs->m_fAppliedRambdaDt[i];
+			setLinearAndAngular( tangent[i], r0, r1, &linear, &angular0, &angular1 );
+
+			linVelA += invMassA*linear*rambdaDt;
+			linVelB += invMassB*(-linear)*rambdaDt;
+			angVelA += mtMul1(invInertiaA, angular0)*rambdaDt;
+			angVelB += mtMul1(invInertiaB, angular1)*rambdaDt;
+		}
+	}
+
+	if (invMassA)
+	{
+		gBodies[aIdx].m_linVel = linVelA;
+		gBodies[aIdx].m_angVel = angVelA;
+	}
+	if (invMassB)
+	{
+		gBodies[bIdx].m_linVel = linVelB;
+		gBodies[bIdx].m_angVel = angVelB;
+	}
+}
+
+//same cell and batch order as BatchSolveKernelContact, so no two work items write the same body at once
+__kernel
+__attribute__((reqd_work_group_size(WG_SIZE,1,1)))
+void BatchWarmStartKernelContact(__global Body* gBodies,
+                      __global Shape* gShapes,
+                      __global Constraint4* gConstraints,
+                      __global int* gN,
+                      __global int* gOffsets,
+                      __global	int* batchSizes,
+                       int maxBatch1,
+                       int cellBatch,
+                       int4 nSplit
+                      )
+{
+	__local int ldsCurBatch;
+	__local int ldsStart;
+
+	int lIdx = GET_LOCAL_IDX;
+	int wgIdx = GET_GROUP_IDX;
+
+	int zIdx = (wgIdx/((nSplit.x*nSplit.y)/4))*2+((cellBatch&4)>>2);
+	int remain= (wgIdx%((nSplit.x*nSplit.y)/4));
+	int yIdx = (remain/(nSplit.x/2))*2 + ((cellBatch&2)>>1);
+	int xIdx = (remain%(nSplit.x/2))*2 + (cellBatch&1);
+	int cellIdx = xIdx+yIdx*nSplit.x+zIdx*(nSplit.x*nSplit.y);
+
+	if( gN[cellIdx] == 0 ) 
+		return;
+
+	int maxBatch = batchSizes[cellIdx];
+	const int start = gOffsets[cellIdx];
+	const int end = start + gN[cellIdx];
+
+	if( lIdx == 0 )
+	{
+		ldsCurBatch = 0;
+		ldsStart = start;
+	}
+	GROUP_LDS_BARRIER;
+
+	int idx=ldsStart+lIdx;
+	while (ldsCurBatch < maxBatch)
+	{
+		for(; idx<end; )
+		{
+			if (gConstraints[idx].m_batchIdx == ldsCurBatch)
+			{
+				warmStartContactConstraint( gBodies, gShapes, &gConstraints[idx] );
+				idx+=64;
+			} else
+			{
+				break;
+			}
+		}
+		GROUP_LDS_BARRIER;
+		if( lIdx == 0 )
+		{
+			ldsCurBatch++;
+		}
+		GROUP_LDS_BARRIER;
+	}
+}
+
+//solves the constraints of one color of the graph coloring, launched with a single work item the range is solved serially
+__kernel void SolveColorContactKernel(__global Body* gBodies,
+                      __global Shape* gShapes,
+                      __global Constraint4* gConstraints,
+                       int colorOffset,
+                       int numConstraintsInColor
+                      )
+{
+	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))
+	{
+		solveContactConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );
+	}
+}
+
+__kernel void WarmStartColorContactKernel(__global Body* gBodies,
+                      __global Shape* gShapes,
+                      __global Constraint4* gConstraints,
+                       int colorOffset,
+                       int numConstraintsInColor
+                      )
+{
+	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))
+	{
+		warmStartContactConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );
+	}
+}
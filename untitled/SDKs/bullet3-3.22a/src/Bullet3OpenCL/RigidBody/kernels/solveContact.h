@@ -389,4 +389,141 @@ static const char* solveContactCL =
 	"		int idx=batchOffset+index;\n"
 	"		solveContactConstraint( gBodies, gShapes, &gConstraints[idx] );\n"
 	"	}    \n"
+	"}\n"
+	"//applies the impulses the constraint was warm started with, so the bodies and the accumulated impulses agree\n"
+	"void warmStartContactConstraint(__global Body* gBodies, __global Shape* gShapes, __global Constraint4* cs)\n"
+	"{\n"
+	"	int aIdx = cs->m_bodyA;\n"
+	"	int bIdx = cs->m_bodyB;\n"
+	"	float4 posA = gBodies[aIdx].m_pos;\n"
+	"	float4 linVelA = gBodies[aIdx].m_linVel;\n"
+	"	float4 angVelA = gBodies[aIdx].m_angVel;\n"
+	"	float invMassA = gBodies[aIdx].m_invMass;\n"
+	"	Matrix3x3 invInertiaA = gShapes[aIdx].m_invInertia;\n"
+	"	float4 posB = gBodies[bIdx].m_pos;\n"
+	"	float4 linVelB = gBodies[bIdx].m_linVel;\n"
+	"	float4 angVelB = gBodies[bIdx].m_angVel;\n"
+	"	float invMassB = gBodies[bIdx].m_invMass;\n"
+	"	Matrix3x3 invInertiaB = gShapes[bIdx].m_invInertia;\n"
+	"	float4 angular0, angular1, linear;\n"
+	"	for(int ic=0; ic<4; ic++)\n"
+	"	{\n"
+	"		float rambdaDt = cs->m_appliedRambdaDt[ic];\n"
+	"		if( cs->m_jacCoeffInv[ic] == 0.f || rambdaDt == 0.f ) continue;\n"
+	"		float4 r0 = cs->m_worldPos[ic] - posA;\n"
+	"		float4 r1 = cs->m_worldPos[ic] - posB;\n"
+	"		setLinearAndAngular( -cs->m_linear, r0, r1, &linear, &angular0, &angular1 );\n"
+	"		linVelA += invMassA*linear*rambdaDt;\n"
+	"		linVelB += invMassB*(-linear)*rambdaDt;\n"
+	"		angVelA += mtMul1(invInertiaA, angular0)*rambdaDt;\n"
+	"		angVelB += mtMul1(invInertiaB, angular1)*rambdaDt;\n"
+	"	}\n"
+	"	if( cs->m_fJacCoeffInv[0] != 0.f || cs->m_fJacCoeffInv[1] != 0.f )\n"
+	"	{\n"
+	"		float4 n = -cs->m_linear;\n"
+	"		float4 tangent[2];\n"
+	"		btPlaneSpace1(&n,&tangent[0],&tangent[1]);\n"
+	"		float4 r0 = cs->m_center - posA;\n"
+	"		float4 r1 = cs->m_center - posB;\n"
+	"		for(int i=0; i<2; i++)\n"
+	"		{\n"
+	"			float rambdaDt = cs->m_fAppliedRambdaDt[i];\n"
+	"			setLinearAndAngular( tangent[i], r0, r1, &linear, &angular0, &angular1 );\n"
+	"			linVelA += invMassA*linear*rambdaDt;\n"
+	"			linVelB += invMassB*(-linear)*rambdaDt;\n"
+	"			angVelA += mtMul1(invInertiaA, angular0)*rambdaDt;\n"
+	"			angVelB += mtMul1(invInertiaB, angular1)*rambdaDt;\n"
+	"		}\n"
+	"	}\n"
+	"	if (invMassA)\n"
+	"	{\n"
+	"		gBodies[aIdx].m_linVel = linVelA;\n"
+	"		gBodies[aIdx].m_angVel = angVelA;\n"
+	"	}\n"
+	"	if (invMassB)\n"
+	"	{\n"
+	"		gBodies[bIdx].m_linVel = linVelB;\n"
+	"		gBodies[bIdx].m_angVel = angVelB;\n"
+	"	}\n"
+	"}\n"
+	"//same cell and batch order as BatchSolveKernelContact, so no two work items write the same body at once\n"
+	"__kernel\n"
+	"__attribute__((reqd_work_group_size(WG_SIZE,1,1)))\n"
+	"void BatchWarmStartKernelContact(__global Body* gBodies,\n"
+	"                      __global Shape* gShapes,\n"
+	"                      __global Constraint4* gConstraints,\n"
+	"                      __global int* gN,\n"
+	"                      __global int* gOffsets,\n"
+	"                      __global	int* batchSizes,\n"
+	"                       int maxBatch1,\n"
+	"                       int cellBatch,\n"
+	"                       int4 nSplit\n"
+	"                      )\n"
+	"{\n"
+	"	__local int ldsCurBatch;\n"
+	"	__local int ldsStart;\n"
+	"	int lIdx = GET_LOCAL_IDX;\n"
+	"	int wgIdx = GET_GROUP_IDX;\n"
+	"	int zIdx = (wgIdx/((nSplit.x*nSplit.y)/4))*2+((cellBatch&4)>>2);\n"
+	"	int remain= (wgIdx%((nSplit.x*nSplit.y)/4));\n"
+	"	int yIdx = (remain/(nSplit.x/2))*2 + ((cellBatch&2)>>1);\n"
+	"	int xIdx = (remain%(nSplit.x/2))*2 + (cellBatch&1);\n"
+	"	int cellIdx = xIdx+yIdx*nSplit.x+zIdx*(nSplit.x*nSplit.y);\n"
+	"	if( gN[cellIdx] == 0 ) \n"
+	"		return;\n"
+	"	int maxBatch = batchSizes[cellIdx];\n"
+	"	const int start = gOffsets[cellIdx];\n"
+	"	const int end = start + gN[cellIdx];\n"
+	"	if( lIdx == 0 )\n"
+	"	{\n"
+	"		ldsCurBatch = 0;\n"
+	"		ldsStart = start;\n"
+	"	}\n"
+	"	GROUP_LDS_BARRIER;\n"
+	"	int idx=ldsStart+lIdx;\n"
+	"	while (ldsCurBatch < maxBatch)\n"
+	"	{\n"
+	"		for(; idx<end; )\n"
+	"		{\n"
+	"			if (gConstraints[idx].m_batchIdx == ldsCurBatch)\n"
+	"			{\n"
+	"				warmStartContactConstraint( gBodies, gShapes, &gConstraints[idx] );\n"
+	"				idx+=64;\n"
+	"			} else\n"
+	"			{\n"
+	"				break;\n"
+	"			}\n"
+	"		}\n"
+	"		GROUP_LDS_BARRIER;\n"
+	"		if( lIdx == 0 )\n"
+	"		{\n"
+	"			ldsCurBatch++;\n"
+	"		}\n"
+	"		GROUP_LDS_BARRIER;\n"
+	"	}\n"
+	"}\n"
+	"//solves the constraints of one color of the graph coloring, launched with a single work item the range is solved serially\n"
+	"__kernel void SolveColorContactKernel(__global Body* gBodies,\n"
+	"                      __global Shape* gShapes,\n"
+	"                      __global Constraint4* gConstraints,\n"
+	"                       int colorOffset,\n"
+	"                       int numConstraintsInColor\n"
+	"                      )\n"
+	"{\n"
+	"	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))\n"
+	"	{\n"
+	"		solveContactConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );\n"
+	"	}\n"
+	"}\n"
+	"__kernel void WarmStartColorContactKernel(__global Body* gBodies,\n"
+	"                      __global Shape* gShapes,\n"
+	"                      __global Constraint4* gConstraints,\n"
+	"                       int colorOffset,\n"
+	"                       int numConstraintsInColor\n"
+	"                      )\n"
+	"{\n"
+	"	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))\n"
+	"	{\n"
+	"		warmStartContactConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );\n"
+	"	}\n"
 	"}\n";
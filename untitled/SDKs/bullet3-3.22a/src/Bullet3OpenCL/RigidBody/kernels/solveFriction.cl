@@ -524,4 +524,18 @@ __kernel void solveSingleFrictionKernel(__global Body* gBodies,
 	
 		solveFrictionConstraint( gBodies, gShapes, &gConstraints[idx] );
 	}    
-}
\ No newline at end of file
+}
+
+//solves the friction of one color of the graph coloring, see SolveColorContactKernel
+__kernel void SolveColorFrictionKernel(__global Body* gBodies,
+                      __global Shape* gShapes,
+                      __global Constraint4* gConstraints,
+                       int colorOffset,
+                       int numConstraintsInColor
+                      )
+{
+	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))
+	{
+		solveFrictionConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );
+	}
+}
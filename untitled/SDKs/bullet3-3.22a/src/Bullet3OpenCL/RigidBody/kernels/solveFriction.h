@@ -417,4 +417,17 @@ static const char* solveFrictionCL =
 	"	\n"
 	"		solveFrictionConstraint( gBodies, gShapes, &gConstraints[idx] );\n"
 	"	}    \n"
+	"}\n"
+	"//solves the friction of one color of the graph coloring, see SolveColorContactKernel\n"
+	"__kernel void SolveColorFrictionKernel(__global Body* gBodies,\n"
+	"                      __global Shape* gShapes,\n"
+	"                      __global Constraint4* gConstraints,\n"
+	"                       int colorOffset,\n"
+	"                       int numConstraintsInColor\n"
+	"                      )\n"
+	"{\n"
+	"	for(int i=get_global_id(0); i<numConstraintsInColor; i+=get_global_size(0))\n"
+	"	{\n"
+	"		solveFrictionConstraint( gBodies, gShapes, &gConstraints[colorOffset+i] );\n"
+	"	}\n"
 	"}\n";
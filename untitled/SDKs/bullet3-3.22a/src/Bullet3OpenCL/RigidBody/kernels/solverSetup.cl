@@ -275,3 +275,123 @@ float positionConstraintCoeff
 
 
 
+
+//Warm starting: the contacts of the previous step are looked up by body pair and child shapes in an open addressing
+//hash table, and each new contact point starts from the impulse of the nearest point of the previous manifold
+
+#define B3_CONTACT_CACHE_EMPTY -1
+
+u32 contactCacheHash(__global struct b3Contact4Data* contact)
+{
+	u32 hash = (u32)abs(contact->m_bodyAPtrAndSignBit)*73856093u;
+	hash ^= (u32)abs(contact->m_bodyBPtrAndSignBit)*19349663u;
+	hash ^= (u32)(contact->m_childIndexA+1)*83492791u;
+	hash ^= (u32)(contact->m_childIndexB+1)*2654435761u;
+	return hash;
+}
+
+int contactCacheKeyEqual(__global struct b3Contact4Data* contactA, __global struct b3Contact4Data* contactB)
+{
+	return abs(contactA->m_bodyAPtrAndSignBit)==abs(contactB->m_bodyAPtrAndSignBit) &&
+		abs(contactA->m_bodyBPtrAndSignBit)==abs(contactB->m_bodyBPtrAndSignBit) &&
+		contactA->m_childIndexA==contactB->m_childIndexA && contactA->m_childIndexB==contactB->m_childIndexB;
+}
+
+__kernel void ClearContactCacheKernel(__global int* hashTable, int hashTableSize)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < hashTableSize )
+	{
+		hashTable[gIdx] = B3_CONTACT_CACHE_EMPTY;
+	}
+}
+
+__kernel void BuildContactCacheKernel(__global struct b3Contact4Data* prevContacts, __global int* hashTable, int nPrevContacts, int hashMask)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < nPrevContacts )
+	{
+		u32 slot = contactCacheHash(&prevContacts[gIdx]) & hashMask;
+		for(int probe=0; probe<=hashMask; probe++)
+		{
+			if (AtomCmpxhg(hashTable[slot], B3_CONTACT_CACHE_EMPTY, gIdx)==B3_CONTACT_CACHE_EMPTY)
+				return;
+			slot = (slot+1) & hashMask;
+		}
+	}
+}
+
+__kernel
+__attribute__((reqd_work_group_size(WG_SIZE,1,1)))
+void WarmStartContactsKernel(__global struct b3Contact4Data* gContact, __global b3ContactConstraint4_t* gConstraints,
+__global struct b3Contact4Data* prevContacts, __global b3ContactConstraint4_t* prevConstraints, __global int* hashTable,
+int nContacts,
+int hashMask,
+float maxDistanceSq,
+float minNormalDot,
+float warmStartingFactor
+)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx >= nContacts )
+		return;
+
+	__global struct b3Contact4Data* contact = &gContact[gIdx];
+
+	int prevIdx = B3_CONTACT_CACHE_EMPTY;
+	u32 slot = contactCacheHash(contact) & hashMask;
+	for(int probe=0; probe<=hashMask; probe++)
+	{
+		int entry = hashTable[slot];
+		if (entry==B3_CONTACT_CACHE_EMPTY)
+			break;
+		if (contactCacheKeyEqual(contact, &prevContacts[entry]))
+		{
+			prevIdx = entry;
+			break;
+		}
+		slot = (slot+1) & hashMask;
+	}
+	if (prevIdx==B3_CONTACT_CACHE_EMPTY)
+		return;
+
+	//a rotated manifold has other features in contact, and its tangent directions changed as well
+	__global struct b3Contact4Data* prevContact = &prevContacts[prevIdx];
+	float4 normal = make_float4(contact->m_worldNormalOnB.xyz, 0.f);
+	float4 prevNormal = make_float4(prevContact->m_worldNormalOnB.xyz, 0.f);
+	if (dot(normal, prevNormal) < minNormalDot)
+		return;
+
+	b3ContactConstraint4_t cs = gConstraints[gIdx];
+	b3ContactConstraint4_t prevCs = prevConstraints[prevIdx];
+	int numPoints = (int)contact->m_worldNormalOnB.w;
+	int numPrevPoints = (int)prevContact->m_worldNormalOnB.w;
+	int numMatched = 0;
+	for(int ic=0; ic<numPoints; ic++)
+	{
+		float4 pos = make_float4(contact->m_worldPosB[ic].xyz, 0.f);
+		float closestDistanceSq = maxDistanceSq;
+		int closest = -1;
+		for(int ip=0; ip<numPrevPoints; ip++)
+		{
+			float4 diff = pos - make_float4(prevContact->m_worldPosB[ip].xyz, 0.f);
+			float distanceSq = dot(diff, diff);
+			if (distanceSq < closestDistanceSq)
+			{
+				closestDistanceSq = distanceSq;
+				closest = ip;
+			}
+		}
+		if (closest>=0)
+		{
+			cs.m_appliedRambdaDt[ic] = prevCs.m_appliedRambdaDt[closest]*warmStartingFactor;
+			numMatched++;
+		}
+	}
+	if (numMatched)
+	{
+		cs.m_fAppliedRambdaDt[0] = prevCs.m_fAppliedRambdaDt[0]*warmStartingFactor;
+		cs.m_fAppliedRambdaDt[1] = prevCs.m_fAppliedRambdaDt[1]*warmStartingFactor;
+	}
+	gConstraints[gIdx] = cs;
+}
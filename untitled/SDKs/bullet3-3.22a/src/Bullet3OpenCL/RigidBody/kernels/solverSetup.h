@@ -699,4 +699,113 @@ static const char* solverSetupCL =
 	"		cs.m_batchIdx = gContact[gIdx].m_batchIdx;\n"
 	"		gConstraintOut[gIdx] = cs;\n"
 	"	}\n"
+	"}\n"
+	"//Warm starting: the contacts of the previous step are looked up by body pair and child shapes in an open addressing\n"
+	"//hash table, and each new contact point starts from the impulse of the nearest point of the previous manifold\n"
+	"#define B3_CONTACT_CACHE_EMPTY -1\n"
+	"u32 contactCacheHash(__global struct b3Contact4Data* contact)\n"
+	"{\n"
+	"	u32 hash = (u32)abs(contact->m_bodyAPtrAndSignBit)*73856093u;\n"
+	"	hash ^= (u32)abs(contact->m_bodyBPtrAndSignBit)*19349663u;\n"
+	"	hash ^= (u32)(contact->m_childIndexA+1)*83492791u;\n"
+	"	hash ^= (u32)(contact->m_childIndexB+1)*2654435761u;\n"
+	"	return hash;\n"
+	"}\n"
+	"int contactCacheKeyEqual(__global struct b3Contact4Data* contactA, __global struct b3Contact4Data* contactB)\n"
+	"{\n"
+	"	return abs(contactA->m_bodyAPtrAndSignBit)==abs(contactB->m_bodyAPtrAndSignBit) &&\n"
+	"		abs(contactA->m_bodyBPtrAndSignBit)==abs(contactB->m_bodyBPtrAndSignBit) &&\n"
+	"		contactA->m_childIndexA==contactB->m_childIndexA && contactA->m_childIndexB==contactB->m_childIndexB;\n"
+	"}\n"
+	"__kernel void ClearContactCacheKernel(__global int* hashTable, int hashTableSize)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < hashTableSize )\n"
+	"	{\n"
+	"		hashTable[gIdx] = B3_CONTACT_CACHE_EMPTY;\n"
+	"	}\n"
+	"}\n"
+	"__kernel void BuildContactCacheKernel(__global struct b3Contact4Data* prevContacts, __global int* hashTable, int nPrevContacts, int hashMask)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < nPrevContacts )\n"
+	"	{\n"
+	"		u32 slot = contactCacheHash(&prevContacts[gIdx]) & hashMask;\n"
+	"		for(int probe=0; probe<=hashMask; probe++)\n"
+	"		{\n"
+	"			if (AtomCmpxhg(hashTable[slot], B3_CONTACT_CACHE_EMPTY, gIdx)==B3_CONTACT_CACHE_EMPTY)\n"
+	"				return;\n"
+	"			slot = (slot+1) & hashMask;\n"
+	"		}\n"
+	"	}\n"
+	"}\n"
+	"__kernel\n"
+	"__attribute__((reqd_work_group_size(WG_SIZE,1,1)))\n"
+	"void WarmStartContactsKernel(__global struct b3Contact4Data* gContact, __global b3ContactConstraint4_t* gConstraints,\n"
+	"__global struct b3Contact4Data* prevContacts, __global b3ContactConstraint4_t* prevConstraints, __global int* hashTable,\n"
+	"int nContacts,\n"
+	"int hashMask,\n"
+	"float maxDistanceSq,\n"
+	"float minNormalDot,\n"
+	"float warmStartingFactor\n"
+	")\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx >= nContacts )\n"
+	"		return;\n"
+	"	__global struct b3Contact4Data* contact = &gContact[gIdx];\n"
+	"	int prevIdx = B3_CONTACT_CACHE_EMPTY;\n"
+	"	u32 slot = contactCacheHash(contact) & hashMask;\n"
+	"	for(int probe=0; probe<=hashMask; probe++)\n"
+	"	{\n"
+	"		int entry = hashTable[slot];\n"
+	"		if (entry==B3_CONTACT_CACHE_EMPTY)\n"
+	"			break;\n"
+	"		if (contactCacheKeyEqual(contact, &prevContacts[entry]))\n"
+	"		{\n"
+	"			prevIdx = entry;\n"
+	"			break;\n"
+	"		}\n"
+	"		slot = (slot+1) & hashMask;\n"
+	"	}\n"
+	"	if (prevIdx==B3_CONTACT_CACHE_EMPTY)\n"
+	"		return;\n"
+	"	//a rotated manifold has other features in contact, and its tangent directions changed as well\n"
+	"	__global struct b3Contact4Data* prevContact = &prevContacts[prevIdx];\n"
+	"	float4 normal = make_float4(contact->m_worldNormalOnB.xyz, 0.f);\n"
+	"	float4 prevNormal = make_float4(prevContact->m_worldNormalOnB.xyz, 0.f);\n"
+	"	if (dot(normal, prevNormal) < minNormalDot)\n"
+	"		return;\n"
+	"	b3ContactConstraint4_t cs = gConstraints[gIdx];\n"
+	"	b3ContactConstraint4_t prevCs = prevConstraints[prevIdx];\n"
+	"	int numPoints = (int)contact->m_worldNormalOnB.w;\n"
+	"	int numPrevPoints = (int)prevContact->m_worldNormalOnB.w;\n"
+	"	int numMatched = 0;\n"
+	"	for(int ic=0; ic<numPoints; ic++)\n"
+	"	{\n"
+	"		float4 pos = make_float4(contact->m_worldPosB[ic].xyz, 0.f);\n"
+	"		float closestDistanceSq = maxDistanceSq;\n"
+	"		int closest = -1;\n"
+	"		for(int ip=0; ip<numPrevPoints; ip++)\n"
+	"		{\n"
+	"			float4 diff = pos - make_float4(prevContact->m_worldPosB[ip].xyz, 0.f);\n"
+	"			float distanceSq = dot(diff, diff);\n"
+	"			if (distanceSq < closestDistanceSq)\n"
+	"			{\n"
+	"				closestDistanceSq = distanceSq;\n"
+	"				closest = ip;\n"
+	"			}\n"
+	"		}\n"
+	"		if (closest>=0)\n"
+	"		{\n"
+	"			cs.m_appliedRambdaDt[ic] = prevCs.m_appliedRambdaDt[closest]*warmStartingFactor;\n"
+	"			numMatched++;\n"
+	"		}\n"
+	"	}\n"
+	"	if (numMatched)\n"
+	"	{\n"
+	"		cs.m_fAppliedRambdaDt[0] = prevCs.m_fAppliedRambdaDt[0]*warmStartingFactor;\n"
+	"		cs.m_fAppliedRambdaDt[1] = prevCs.m_fAppliedRambdaDt[1]*warmStartingFactor;\n"
+	"	}\n"
+	"	gConstraints[gIdx] = cs;\n"
 	"}\n";
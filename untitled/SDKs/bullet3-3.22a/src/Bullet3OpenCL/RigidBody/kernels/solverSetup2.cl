@@ -611,3 +611,126 @@ void CopyConstraintKernel(__global struct b3Contact4Data* gIn, __global struct b
 
 
 
+
+//Graph coloring of the contact constraints (Jones-Plassmann). Every round each uncolored contact claims its dynamic bodies
+//with a unique pseudo random priority, the contacts that hold the claim of all their dynamic bodies get the color of the
+//round. Contacts of one color share no dynamic body, so they are solved in parallel without conflicts.
+
+__kernel void ResetContactColorsKernel(__global int* gColors, __global int* gColorCounts, int nContacts, int numColorCounts)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < nContacts )
+		gColors[gIdx] = -1;
+	if( gIdx < numColorCounts )
+		gColorCounts[gIdx] = 0;
+}
+
+//0xffffffff before the claims of a round, 0 before the degrees are counted
+__kernel void ResetBodyClaimsKernel(__global u32* gClaims, int numBodies, u32 value)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < numBodies )
+		gClaims[gIdx] = value;
+}
+
+//counts the contacts of each dynamic body, the largest count sizes the number of rounds of the next step
+__kernel void CountBodyDegreesKernel(__global const struct b3Contact4Data* gContact, volatile __global u32* gDegrees, volatile __global int* gColorCounts, int nContacts, int staticIdx, int maxDegreeSlot)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx >= nContacts )
+		return;
+
+	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;
+	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;
+	if( aPtrAndSignBit>=0 && aPtrAndSignBit!=staticIdx )
+		atomic_max(&gColorCounts[maxDegreeSlot], (int)atomic_inc(&gDegrees[aPtrAndSignBit])+1);
+	if( bPtrAndSignBit>=0 && bPtrAndSignBit!=staticIdx )
+		atomic_max(&gColorCounts[maxDegreeSlot], (int)atomic_inc(&gDegrees[bPtrAndSignBit])+1);
+}
+
+//the odd multiplier makes the priority a permutation of the contact index, so no two contacts have the same priority
+u32 contactColorPriority(int contactIdx)
+{
+	return ((u32)contactIdx)*0x9E3779B1u;
+}
+
+__kernel void ClaimContactBodiesKernel(__global const struct b3Contact4Data* gContact, __global const int* gColors, volatile __global u32* gClaims, int nContacts, int staticIdx)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx >= nContacts || gColors[gIdx] >= 0 )
+		return;
+
+	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;
+	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;
+	u32 priority = contactColorPriority(gIdx);
+	if( aPtrAndSignBit>=0 && aPtrAndSignBit!=staticIdx )
+		atomic_min(&gClaims[aPtrAndSignBit], priority);
+	if( bPtrAndSignBit>=0 && bPtrAndSignBit!=staticIdx )
+		atomic_min(&gClaims[bPtrAndSignBit], priority);
+}
+
+__kernel void AssignContactColorKernel(__global const struct b3Contact4Data* gContact, __global int* gColors, __global const u32* gClaims, volatile __global int* gColorCounts, int nContacts, int staticIdx, int color)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx >= nContacts || gColors[gIdx] >= 0 )
+		return;
+
+	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;
+	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;
+	u32 priority = contactColorPriority(gIdx);
+	bool ownsA = aPtrAndSignBit<0 || aPtrAndSignBit==staticIdx || gClaims[aPtrAndSignBit]==priority;
+	bool ownsB = bPtrAndSignBit<0 || bPtrAndSignBit==staticIdx || gClaims[bPtrAndSignBit]==priority;
+	if( ownsA && ownsB )
+	{
+		gColors[gIdx] = color;
+		atomic_inc(&gColorCounts[color]);
+	}
+}
+
+//with a cap on the size of a color the winners of a round are marked first, a prefix scan ranks them by contact index
+__kernel void MarkColorWinnersKernel(__global const struct b3Contact4Data* gContact, __global const int* gColors, __global const u32* gClaims, __global u32* gWinners, int nContacts, int staticIdx)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx >= nContacts )
+		return;
+
+	u32 winner = 0;
+	if( gColors[gIdx] < 0 )
+	{
+		int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;
+		int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;
+		u32 priority = contactColorPriority(gIdx);
+		bool ownsA = aPtrAndSignBit<0 || aPtrAndSignBit==staticIdx || gClaims[aPtrAndSignBit]==priority;
+		bool ownsB = bPtrAndSignBit<0 || bPtrAndSignBit==staticIdx || gClaims[bPtrAndSignBit]==priority;
+		winner = (ownsA && ownsB)? 1 : 0;
+	}
+	gWinners[gIdx] = winner;
+}
+
+//the winners and their ranks only depend on the contact indices, so the cap turns away the same contacts every run
+__kernel void AssignCappedContactColorKernel(__global int* gColors, __global const u32* gWinners, __global const u32* gRanks, volatile __global int* gColorCounts, int nContacts, int color, int colorCap)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < nContacts && gWinners[gIdx] && gRanks[gIdx] < (u32)colorCap )
+	{
+		gColors[gIdx] = color;
+		atomic_inc(&gColorCounts[color]);
+	}
+}
+
+//the contacts left uncolored after the last round go to overflowColor, which is solved by a single work item
+__kernel void SetColorSortDataKernel(__global const int* gColors, volatile __global int* gColorCounts, __global int2* gSortDataOut, int nContacts, int overflowColor)
+{
+	int gIdx = GET_GLOBAL_IDX;
+	if( gIdx < nContacts )
+	{
+		int color = gColors[gIdx];
+		if( color < 0 )
+		{
+			color = overflowColor;
+			atomic_inc(&gColorCounts[overflowColor]);
+		}
+		gSortDataOut[gIdx].x = color;
+		gSortDataOut[gIdx].y = gIdx;
+	}
+}
@@ -597,4 +597,113 @@ static const char* solverSetup2CL =
 	"	{\n"
 	"		gOut[gIdx] = gIn[gIdx];\n"
 	"	}\n"
+	"}\n"
+	"//Graph coloring of the contact constraints (Jones-Plassmann). Every round each uncolored contact claims its dynamic bodies\n"
+	"//with a unique pseudo random priority, the contacts that hold the claim of all their dynamic bodies get the color of the\n"
+	"//round. Contacts of one color share no dynamic body, so they are solved in parallel without conflicts.\n"
+	"__kernel void ResetContactColorsKernel(__global int* gColors, __global int* gColorCounts, int nContacts, int numColorCounts)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < nContacts )\n"
+	"		gColors[gIdx] = -1;\n"
+	"	if( gIdx < numColorCounts )\n"
+	"		gColorCounts[gIdx] = 0;\n"
+	"}\n"
+	"//0xffffffff before the claims of a round, 0 before the degrees are counted\n"
+	"__kernel void ResetBodyClaimsKernel(__global u32* gClaims, int numBodies, u32 value)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < numBodies )\n"
+	"		gClaims[gIdx] = value;\n"
+	"}\n"
+	"//counts the contacts of each dynamic body, the largest count sizes the number of rounds of the next step\n"
+	"__kernel void CountBodyDegreesKernel(__global const struct b3Contact4Data* gContact, volatile __global u32* gDegrees, volatile __global int* gColorCounts, int nContacts, int staticIdx, int maxDegreeSlot)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx >= nContacts )\n"
+	"		return;\n"
+	"	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;\n"
+	"	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;\n"
+	"	if( aPtrAndSignBit>=0 && aPtrAndSignBit!=staticIdx )\n"
+	"		atomic_max(&gColorCounts[maxDegreeSlot], (int)atomic_inc(&gDegrees[aPtrAndSignBit])+1);\n"
+	"	if( bPtrAndSignBit>=0 && bPtrAndSignBit!=staticIdx )\n"
+	"		atomic_max(&gColorCounts[maxDegreeSlot], (int)atomic_inc(&gDegrees[bPtrAndSignBit])+1);\n"
+	"}\n"
+	"//the odd multiplier makes the priority a permutation of the contact index, so no two contacts have the same priority\n"
+	"u32 contactColorPriority(int contactIdx)\n"
+	"{\n"
+	"	return ((u32)contactIdx)*0x9E3779B1u;\n"
+	"}\n"
+	"__kernel void ClaimContactBodiesKernel(__global const struct b3Contact4Data* gContact, __global const int* gColors, volatile __global u32* gClaims, int nContacts, int staticIdx)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx >= nContacts || gColors[gIdx] >= 0 )\n"
+	"		return;\n"
+	"	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;\n"
+	"	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;\n"
+	"	u32 priority = contactColorPriority(gIdx);\n"
+	"	if( aPtrAndSignBit>=0 && aPtrAndSignBit!=staticIdx )\n"
+	"		atomic_min(&gClaims[aPtrAndSignBit], priority);\n"
+	"	if( bPtrAndSignBit>=0 && bPtrAndSignBit!=staticIdx )\n"
+	"		atomic_min(&gClaims[bPtrAndSignBit], priority);\n"
+	"}\n"
+	"__kernel void AssignContactColorKernel(__global const struct b3Contact4Data* gContact, __global int* gColors, __global const u32* gClaims, volatile __global int* gColorCounts, int nContacts, int staticIdx, int color)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx >= nContacts || gColors[gIdx] >= 0 )\n"
+	"		return;\n"
+	"	int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;\n"
+	"	int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;\n"
+	"	u32 priority = contactColorPriority(gIdx);\n"
+	"	bool ownsA = aPtrAndSignBit<0 || aPtrAndSignBit==staticIdx || gClaims[aPtrAndSignBit]==priority;\n"
+	"	bool ownsB = bPtrAndSignBit<0 || bPtrAndSignBit==staticIdx || gClaims[bPtrAndSignBit]==priority;\n"
+	"	if( ownsA && ownsB )\n"
+	"	{\n"
+	"		gColors[gIdx] = color;\n"
+	"		atomic_inc(&gColorCounts[color]);\n"
+	"	}\n"
+	"}\n"
+	"//with a cap on the size of a color the winners of a round are marked first, a prefix scan ranks them by contact index\n"
+	"__kernel void MarkColorWinnersKernel(__global const struct b3Contact4Data* gContact, __global const int* gColors, __global const u32* gClaims, __global u32* gWinners, int nContacts, int staticIdx)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx >= nContacts )\n"
+	"		return;\n"
+	"	u32 winner = 0;\n"
+	"	if( gColors[gIdx] < 0 )\n"
+	"	{\n"
+	"		int aPtrAndSignBit = gContact[gIdx].m_bodyAPtrAndSignBit;\n"
+	"		int bPtrAndSignBit = gContact[gIdx].m_bodyBPtrAndSignBit;\n"
+	"		u32 priority = contactColorPriority(gIdx);\n"
+	"		bool ownsA = aPtrAndSignBit<0 || aPtrAndSignBit==staticIdx || gClaims[aPtrAndSignBit]==priority;\n"
+	"		bool ownsB = bPtrAndSignBit<0 || bPtrAndSignBit==staticIdx || gClaims[bPtrAndSignBit]==priority;\n"
+	"		winner = (ownsA && ownsB)? 1 : 0;\n"
+	"	}\n"
+	"	gWinners[gIdx] = winner;\n"
+	"}\n"
+	"//the winners and their ranks only depend on the contact indices, so the cap turns away the same contacts every run\n"
+	"__kernel void AssignCappedContactColorKernel(__global int* gColors, __global const u32* gWinners, __global const u32* gRanks, volatile __global int* gColorCounts, int nContacts, int color, int colorCap)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < nContacts && gWinners[gIdx] && gRanks[gIdx] < (u32)colorCap )\n"
+	"	{\n"
+	"		gColors[gIdx] = color;\n"
+	"		atomic_inc(&gColorCounts[color]);\n"
+	"	}\n"
+	"}\n"
+	"//the contacts left uncolored after the last round go to overflowColor, which is solved by a single work item\n"
+	"__kernel void SetColorSortDataKernel(__global const int* gColors, volatile __global int* gColorCounts, __global int2* gSortDataOut, int nContacts, int overflowColor)\n"
+	"{\n"
+	"	int gIdx = GET_GLOBAL_IDX;\n"
+	"	if( gIdx < nContacts )\n"
+	"	{\n"
+	"		int color = gColors[gIdx];\n"
+	"		if( color < 0 )\n"
+	"		{\n"
+	"			color = overflowColor;\n"
+	"			atomic_inc(&gColorCounts[overflowColor]);\n"
+	"		}\n"
+	"		gSortDataOut[gIdx].x = color;\n"
+	"		gSortDataOut[gIdx].y = gIdx;\n"
+	"	}\n"
 	"}\n";
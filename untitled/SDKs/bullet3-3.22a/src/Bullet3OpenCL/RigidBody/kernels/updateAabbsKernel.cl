@@ -3,12 +3,44 @@
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3UpdateAabbs.h"
 
 
-__kernel void initializeGpuAabbsFull(  const int numNodes, __global b3RigidBodyData_t* gBodies,__global b3Collidable_t* collidables, __global b3Aabb_t* plocalShapeAABB, __global b3Aabb_t* pAABB)
+//the aabb of a body that moves more than ccdMotionThreshold times its smallest half extent during the step is
+//extended by its motion, so the broadphase and the bvh traversal report what it would pass through (see ccdKernels.cl)
+//only xyz are touched, w holds the body index and the static flag
+void b3SweepWorldAabb(int bodyId, __global const b3RigidBodyData_t* bodies, __global const b3Collidable_t* collidables, __global const b3Aabb_t* localShapeAABB, __global b3Aabb_t* worldAabbs, float timeStep, float ccdMotionThreshold)
+{
+	__global const b3RigidBodyData_t* body = &bodies[bodyId];
+	int collidableIndex = body->m_collidableIdx;
+	if (body->m_invMass == 0.f || collidables[collidableIndex].m_shapeIndex < 0)
+		return;
+
+	b3Float4 localExtents = localShapeAABB[collidableIndex].m_maxVec - localShapeAABB[collidableIndex].m_minVec;
+	float radius = 0.5f * min(localExtents.x, min(localExtents.y, localExtents.z));
+	float motion[3] = {body->m_linVel.x * timeStep, body->m_linVel.y * timeStep, body->m_linVel.z * timeStep};
+	float motionThreshold = ccdMotionThreshold * radius;
+	if (motion[0] * motion[0] + motion[1] * motion[1] + motion[2] * motion[2] <= motionThreshold * motionThreshold)
+		return;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (motion[i] < 0.f)
+			worldAabbs[bodyId].m_min[i] += motion[i];
+		else
+			worldAabbs[bodyId].m_max[i] += motion[i];
+	}
+}
+
+//sleeping bodies do not move, their aabbs from the step they fell asleep stay valid unless updateSleepingBodies is set
+//a timeStep of 0 disables the sweep
+__kernel void initializeGpuAabbsFull(  const int numNodes, __global b3RigidBodyData_t* gBodies,__global b3Collidable_t* collidables, __global b3Aabb_t* plocalShapeAABB, __global b3Aabb_t* pAABB, __global const int* bodySleeping, int updateSleepingBodies, float timeStep, float ccdMotionThreshold)
 {
 	int nodeID = get_global_id(0);
-	if( nodeID < numNodes )
+	if( nodeID < numNodes && (updateSleepingBodies || !bodySleeping[nodeID]))
 	{
 		b3ComputeWorldAabb(nodeID, gBodies, collidables, plocalShapeAABB,pAABB);
+		if (timeStep > 0.f && !bodySleeping[nodeID])
+		{
+			b3SweepWorldAabb(nodeID, gBodies, collidables, plocalShapeAABB, pAABB, timeStep, ccdMotionThreshold);
+		}
 	}
 }
 
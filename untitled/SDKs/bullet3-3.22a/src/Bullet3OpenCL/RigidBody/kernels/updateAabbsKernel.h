@@ -464,12 +464,41 @@ static const char* updateAabbsKernelCL =
 	"	}\n"
 	"}\n"
 	"#endif //B3_UPDATE_AABBS_H\n"
-	"__kernel void initializeGpuAabbsFull(  const int numNodes, __global b3RigidBodyData_t* gBodies,__global b3Collidable_t* collidables, __global b3Aabb_t* plocalShapeAABB, __global b3Aabb_t* pAABB)\n"
+	"//the aabb of a body that moves more than ccdMotionThreshold times its smallest half extent during the step is\n"
+	"//extended by its motion, so the broadphase and the bvh traversal report what it would pass through (see ccdKernels.cl)\n"
+	"//only xyz are touched, w holds the body index and the static flag\n"
+	"void b3SweepWorldAabb(int bodyId, __global const b3RigidBodyData_t* bodies, __global const b3Collidable_t* collidables, __global const b3Aabb_t* localShapeAABB, __global b3Aabb_t* worldAabbs, float timeStep, float ccdMotionThreshold)\n"
+	"{\n"
+	"	__global const b3RigidBodyData_t* body = &bodies[bodyId];\n"
+	"	int collidableIndex = body->m_collidableIdx;\n"
+	"	if (body->m_invMass == 0.f || collidables[collidableIndex].m_shapeIndex < 0)\n"
+	"		return;\n"
+	"	b3Float4 localExtents = localShapeAABB[collidableIndex].m_maxVec - localShapeAABB[collidableIndex].m_minVec;\n"
+	"	float radius = 0.5f * min(localExtents.x, min(localExtents.y, localExtents.z));\n"
+	"	float motion[3] = {body->m_linVel.x * timeStep, body->m_linVel.y * timeStep, body->m_linVel.z * timeStep};\n"
+	"	float motionThreshold = ccdMotionThreshold * radius;\n"
+	"	if (motion[0] * motion[0] + motion[1] * motion[1] + motion[2] * motion[2] <= motionThreshold * motionThreshold)\n"
+	"		return;\n"
+	"	for (int i = 0; i < 3; i++)\n"
+	"	{\n"
+	"		if (motion[i] < 0.f)\n"
+	"			worldAabbs[bodyId].m_min[i] += motion[i];\n"
+	"		else\n"
+	"			worldAabbs[bodyId].m_max[i] += motion[i];\n"
+	"	}\n"
+	"}\n"
+	"//sleeping bodies do not move, their aabbs from the step they fell asleep stay valid unless updateSleepingBodies is set\n"
+	"//a timeStep of 0 disables the sweep\n"
+	"__kernel void initializeGpuAabbsFull(  const int numNodes, __global b3RigidBodyData_t* gBodies,__global b3Collidable_t* collidables, __global b3Aabb_t* plocalShapeAABB, __global b3Aabb_t* pAABB, __global const int* bodySleeping, int updateSleepingBodies, float timeStep, float ccdMotionThreshold)\n"
 	"{\n"
 	"	int nodeID = get_global_id(0);\n"
-	"	if( nodeID < numNodes )\n"
+	"	if( nodeID < numNodes && (updateSleepingBodies || !bodySleeping[nodeID]))\n"
 	"	{\n"
 	"		b3ComputeWorldAabb(nodeID, gBodies, collidables, plocalShapeAABB,pAABB);\n"
+	"		if (timeStep > 0.f && !bodySleeping[nodeID])\n"
+	"		{\n"
+	"			b3SweepWorldAabb(nodeID, gBodies, collidables, plocalShapeAABB, pAABB, timeStep, ccdMotionThreshold);\n"
+	"		}\n"
 	"	}\n"
 	"}\n"
 	"__kernel void clearOverlappingPairsKernel(  __global int4* pairs, int numPairs)\n"
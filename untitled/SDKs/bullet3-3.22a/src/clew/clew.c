@@ -110,6 +110,9 @@ PFNCLENQUEUEMARKER __clewEnqueueMarker = NULL;
 PFNCLENQUEUEWAITFOREVENTS __clewEnqueueWaitForEvents = NULL;
 PFNCLENQUEUEBARRIER __clewEnqueueBarrier = NULL;
 PFNCLGETEXTENSIONFUNCTIONADDRESS __clewGetExtensionFunctionAddress = NULL;
+PFNCLCREATEFROMGLBUFFER __clewCreateFromGLBuffer = NULL;
+PFNCLENQUEUEACQUIREGLOBJECTS __clewEnqueueAcquireGLObjects = NULL;
+PFNCLENQUEUERELEASEGLOBJECTS __clewEnqueueReleaseGLObjects = NULL;
 
 void clewExit(void)
 {
@@ -229,6 +232,9 @@ int clewInit(const char* path)
 	__clewEnqueueWaitForEvents = (PFNCLENQUEUEWAITFOREVENTS)CLEW_DYNLIB_IMPORT(module, "clEnqueueWaitForEvents");
 	__clewEnqueueBarrier = (PFNCLENQUEUEBARRIER)CLEW_DYNLIB_IMPORT(module, "clEnqueueBarrier");
 	__clewGetExtensionFunctionAddress = (PFNCLGETEXTENSIONFUNCTIONADDRESS)CLEW_DYNLIB_IMPORT(module, "clGetExtensionFunctionAddress");
+	__clewCreateFromGLBuffer = (PFNCLCREATEFROMGLBUFFER)CLEW_DYNLIB_IMPORT(module, "clCreateFromGLBuffer");
+	__clewEnqueueAcquireGLObjects = (PFNCLENQUEUEACQUIREGLOBJECTS)CLEW_DYNLIB_IMPORT(module, "clEnqueueAcquireGLObjects");
+	__clewEnqueueReleaseGLObjects = (PFNCLENQUEUERELEASEGLOBJECTS)CLEW_DYNLIB_IMPORT(module, "clEnqueueReleaseGLObjects");
 
 	return CLEW_SUCCESS;
 }
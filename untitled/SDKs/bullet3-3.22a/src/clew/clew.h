@@ -2502,6 +2502,35 @@ float nanf(const char *);
 	//
 	typedef CL_API_ENTRY void *(CL_API_CALL *PFNCLGETEXTENSIONFUNCTIONADDRESS)(const char * /* func_name */)CL_API_SUFFIX__VERSION_1_0;
 
+	/* cl_khr_gl_sharing */
+#define CL_GL_CONTEXT_KHR 0x2008
+#define CL_EGL_DISPLAY_KHR 0x2009
+#define CL_GLX_DISPLAY_KHR 0x200A
+#define CL_WGL_HDC_KHR 0x200B
+#define CL_CGL_SHAREGROUP_KHR 0x200C
+
+	typedef CL_API_ENTRY cl_mem(CL_API_CALL *
+									PFNCLCREATEFROMGLBUFFER)(cl_context /* context */,
+															 cl_mem_flags /* flags */,
+															 cl_GLuint /* bufobj */,
+															 cl_int * /* errcode_ret */) CL_API_SUFFIX__VERSION_1_0;
+
+	typedef CL_API_ENTRY cl_int(CL_API_CALL *
+									PFNCLENQUEUEACQUIREGLOBJECTS)(cl_command_queue /* command_queue */,
+																  cl_uint /* num_objects */,
+																  const cl_mem * /* mem_objects */,
+																  cl_uint /* num_events_in_wait_list */,
+																  const cl_event * /* event_wait_list */,
+																  cl_event * /* event */) CL_API_SUFFIX__VERSION_1_0;
+
+	typedef CL_API_ENTRY cl_int(CL_API_CALL *
+									PFNCLENQUEUERELEASEGLOBJECTS)(cl_command_queue /* command_queue */,
+																  cl_uint /* num_objects */,
+																  const cl_mem * /* mem_objects */,
+																  cl_uint /* num_events_in_wait_list */,
+																  const cl_event * /* event_wait_list */,
+																  cl_event * /* event */) CL_API_SUFFIX__VERSION_1_0;
+
 #define CLEW_STATIC
 
 #ifdef CLEW_STATIC
@@ -2599,6 +2628,9 @@ float nanf(const char *);
 	CLEW_FUN_EXPORT PFNCLENQUEUEWAITFOREVENTS __clewEnqueueWaitForEvents;
 	CLEW_FUN_EXPORT PFNCLENQUEUEBARRIER __clewEnqueueBarrier;
 	CLEW_FUN_EXPORT PFNCLGETEXTENSIONFUNCTIONADDRESS __clewGetExtensionFunctionAddress;
+	CLEW_FUN_EXPORT PFNCLCREATEFROMGLBUFFER __clewCreateFromGLBuffer;
+	CLEW_FUN_EXPORT PFNCLENQUEUEACQUIREGLOBJECTS __clewEnqueueAcquireGLObjects;
+	CLEW_FUN_EXPORT PFNCLENQUEUERELEASEGLOBJECTS __clewEnqueueReleaseGLObjects;
 
 #define clGetPlatformIDs CLEW_GET_FUN(__clewGetPlatformIDs)
 #define clGetPlatformInfo CLEW_GET_FUN(__clewGetPlatformInfo)
@@ -2687,6 +2719,9 @@ float nanf(const char *);
 #define clEnqueueWaitForEvents CLEW_GET_FUN(__clewEnqueueWaitForEvents)
 #define clEnqueueBarrier CLEW_GET_FUN(__clewEnqueueBarrier)
 #define clGetExtensionFunctionAddress CLEW_GET_FUN(__clewGetExtensionFunctionAddress)
+#define clCreateFromGLBuffer CLEW_GET_FUN(__clewCreateFromGLBuffer)
+#define clEnqueueAcquireGLObjects CLEW_GET_FUN(__clewEnqueueAcquireGLObjects)
+#define clEnqueueReleaseGLObjects CLEW_GET_FUN(__clewEnqueueReleaseGLObjects)
 
 #define CLEW_SUCCESS 0               //!<    Success error code
 #define CLEW_ERROR_OPEN_FAILED -1    //!<    Error code for failing to open the dynamic library
@@ -0,0 +1,177 @@
+#include "SimulationThread.h"
+
+SimulationThread::SimulationThread()
+    : m_pPipeline(nullptr)
+    , m_fFixedDt(1.0f / 60.0f)
+    , m_nMaxSubSteps(4)
+    , m_bStop(false)
+    , m_bWriteRenderInstances(false)
+    , m_nRenderInstanceFrame(0)
+    , m_glDoneEvent(0)
+{
+    m_elapsedTimer.start();
+}
+
+SimulationThread::~SimulationThread()
+{
+    Stop();
+    if (0 != m_glDoneEvent)
+    {
+        clReleaseEvent(m_glDoneEvent);
+    }
+}
+
+void SimulationThread::Start(b3GpuRigidBodyPipeline *pPipeline, float fFixedDt, int nMaxSubSteps)
+{
+    m_pPipeline = pPipeline;
+    m_fFixedDt = fFixedDt;
+    m_nMaxSubSteps = nMaxSubSteps;
+    m_bStop = false;
+    m_bWriteRenderInstances = m_pPipeline->isRenderInstanceBufferShared();
+
+    // initial state, so the renderer has something to draw before the first step
+    WriteRenderInstances();
+    PublishSnapshot();
+
+    start();
+}
+
+void SimulationThread::Stop()
+{
+    m_bStop = true;
+    wait();
+}
+
+qint64 SimulationThread::NsecsElapsed() const
+{
+    return m_elapsedTimer.nsecsElapsed();
+}
+
+const TransformSnapshot &SimulationThread::GetLatestSnapshot()
+{
+    m_snapshots.Fetch();
+    return m_snapshots.GetReadBuffer();
+}
+
+float SimulationThread::GetAlpha(const TransformSnapshot &snapshot, qint64 nNowNs)
+{
+    // the renderer runs one fixed step behind the simulation, so it always has two states to blend
+    float fAlpha = (float)(nNowNs - snapshot.nTimeNs) / 1000000000.0f / snapshot.fFixedDt;
+    if (fAlpha < 0.0f) { fAlpha = 0.0f; }
+    if (fAlpha > 1.0f) { fAlpha = 1.0f; }
+    return fAlpha;
+}
+
+glm::mat4 SimulationThread::GetWorldMatrix(const TransformSnapshot &snapshot, int nBodyId, float fAlpha)
+{
+    const b3GpuBodyTransform &prev = snapshot.listPrevious.at(nBodyId);
+    const b3GpuBodyTransform &curr = snapshot.listCurrent.at(nBodyId);
+
+    glm::vec3 v3Prev(prev.m_position[0], prev.m_position[1], prev.m_position[2]);
+    glm::vec3 v3Curr(curr.m_position[0], curr.m_position[1], curr.m_position[2]);
+    glm::quat qPrev(prev.m_orientation[3], prev.m_orientation[0], prev.m_orientation[1], prev.m_orientation[2]);
+    glm::quat qCurr(curr.m_orientation[3], curr.m_orientation[0], curr.m_orientation[1], curr.m_orientation[2]);
+
+    glm::vec3 v3Pos = glm::mix(v3Prev, v3Curr, fAlpha);
+    glm::quat quat = glm::slerp(qPrev, qCurr, fAlpha);
+
+    return glm::translate(v3Pos) * glm::mat4_cast(quat);
+}
+
+qint64 SimulationThread::LockRenderInstances()
+{
+    m_renderInstanceMutex.lock();
+    return m_nRenderInstanceFrame;
+}
+
+void SimulationThread::UnlockRenderInstances(cl_event glDoneEvent)
+{
+    // a fence of a later frame also covers the draws of the earlier ones
+    if (0 != m_glDoneEvent)
+    {
+        clReleaseEvent(m_glDoneEvent);
+    }
+    m_glDoneEvent = glDoneEvent;
+    m_renderInstanceMutex.unlock();
+}
+
+void SimulationThread::WriteRenderInstances()
+{
+    if (false == m_bWriteRenderInstances)
+    {
+        return;
+    }
+
+    // waits while the render thread draws from the buffer, writeRenderInstancesGpu returns once the matrices are written
+    QMutexLocker locker(&m_renderInstanceMutex);
+    m_pPipeline->writeRenderInstancesGpu(m_glDoneEvent);
+    m_nRenderInstanceFrame++;
+    if (0 != m_glDoneEvent)
+    {
+        clReleaseEvent(m_glDoneEvent);
+        m_glDoneEvent = 0;
+    }
+}
+
+void SimulationThread::PublishSnapshot()
+{
+    int nNumBodies = 0;
+    m_pPipeline->readbackTransformsAsync();
+    const b3GpuBodyTransform *pTransforms = m_pPipeline->getTransformsCpu(&nNumBodies, true);
+
+    TransformSnapshot &snapshot = m_snapshots.GetWriteBuffer();
+
+    if (m_listCurrent.size() != (size_t)nNumBodies)
+    {
+        // first snapshot (or the body count changed): no previous state to blend from
+        m_listCurrent.assign(pTransforms, pTransforms + nNumBodies);
+    }
+    snapshot.listPrevious = m_listCurrent;
+    m_listCurrent.assign(pTransforms, pTransforms + nNumBodies);
+    snapshot.listCurrent = m_listCurrent;
+    snapshot.nTimeNs = NsecsElapsed();
+    snapshot.fFixedDt = m_fFixedDt;
+
+    m_snapshots.Publish();
+}
+
+void SimulationThread::run()
+{
+    const qint64 nFixedDtNs = (qint64)(m_fFixedDt * 1000000000.0);
+    qint64 nLastTime = NsecsElapsed();
+    qint64 nAccumulator = 0;
+
+    while (false == m_bStop)
+    {
+        qint64 nCurrentTime = NsecsElapsed();
+        qint64 nFrameTime = nCurrentTime - nLastTime;
+        nLastTime = nCurrentTime;
+
+        // avoid the spiral of death after a long stall (debugger, window drag)
+        if (nFrameTime > nFixedDtNs * m_nMaxSubSteps) { nFrameTime = nFixedDtNs * m_nMaxSubSteps; }
+        nAccumulator += nFrameTime;
+
+        int nSubSteps = 0;
+        while (nAccumulator >= nFixedDtNs && nSubSteps < m_nMaxSubSteps)
+        {
+            m_pPipeline->stepSimulation(m_fFixedDt);
+            nAccumulator -= nFixedDtNs;
+            nSubSteps++;
+        }
+
+        if (nSubSteps > 0)
+        {
+            WriteRenderInstances();
+            PublishSnapshot();
+        }
+        else
+        {
+            // sleep until the next step is due
+            qint64 nWaitUs = (nFixedDtNs - nAccumulator) / 1000;
+            if (nWaitUs > 0)
+            {
+                QThread::usleep((unsigned long)nWaitUs);
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "glm/glm.hpp"
+#include "glm/ext.hpp"
+#include "glm/gtx/transform.hpp"
+
+#include "Bullet3OpenCL/RigidBody/b3GpuRigidBodyPipeline.h"
+
+#include "TripleBuffer.h"
+
+#include <QThread>
+#include <QElapsedTimer>
+#include <QMutex>
+
+#include <atomic>
+#include <vector>
+
+// transforms of two consecutive fixed steps, the renderer interpolates between them
+struct TransformSnapshot
+{
+    std::vector<b3GpuBodyTransform> listPrevious;
+    std::vector<b3GpuBodyTransform> listCurrent;
+    qint64 nTimeNs = 0; // time of listCurrent, on the clock of SimulationThread::NsecsElapsed()
+    float fFixedDt = 1.0f / 60.0f;
+};
+
+// Runs b3GpuRigidBodyPipeline::stepSimulation at a fixed rate on its own thread.
+// After Start() the pipeline and its OpenCL queue must only be used by this thread.
+class SimulationThread : public QThread
+{
+public:
+    SimulationThread();
+    ~SimulationThread();
+
+    void Start(b3GpuRigidBodyPipeline *pPipeline, float fFixedDt = 1.0f / 60.0f, int nMaxSubSteps = 4);
+    void Stop();
+
+    // render thread: fetch the newest snapshot, the reference stays valid until the next call
+    const TransformSnapshot &GetLatestSnapshot();
+    qint64 NsecsElapsed() const;
+
+    // interpolated world matrix of a body, fAlpha = 0 is the previous step, 1 the current
+    static glm::mat4 GetWorldMatrix(const TransformSnapshot &snapshot, int nBodyId, float fAlpha);
+    static float GetAlpha(const TransformSnapshot &snapshot, qint64 nNowNs);
+
+    // render thread: with a GL shared render instance buffer the simulation thread writes it after each step
+    // lock it while the draws from it are submitted, returns the number of writes so far (0: not written yet)
+    // unlock with the event of a GL fence after those draws (see b3GpuRigidBodyPipeline::createEventFromGLSync),
+    // the next write waits for it on the device, without one glFinish before unlocking
+    qint64 LockRenderInstances();
+    void UnlockRenderInstances(cl_event glDoneEvent = 0);
+
+protected:
+    void run() override;
+
+private:
+    void PublishSnapshot();
+    void WriteRenderInstances();
+
+    b3GpuRigidBodyPipeline *m_pPipeline;
+    float m_fFixedDt;
+    int m_nMaxSubSteps;
+
+    std::atomic<bool> m_bStop;
+    QElapsedTimer m_elapsedTimer;
+
+    std::vector<b3GpuBodyTransform> m_listCurrent;
+    TripleBuffer<TransformSnapshot> m_snapshots;
+
+    bool m_bWriteRenderInstances;
+    QMutex m_renderInstanceMutex;
+    qint64 m_nRenderInstanceFrame;
+    cl_event m_glDoneEvent;
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,58 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single producer / single consumer triple buffer.
+// The writer fills GetWriteBuffer() and calls Publish(), the reader calls Fetch() and uses GetReadBuffer().
+// Neither side ever waits for the other, the reader always gets the newest published buffer.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer()
+        : m_nWrite(0)
+        , m_nMiddle(1)
+        , m_nRead(2)
+    {
+    }
+
+    T &GetWriteBuffer()
+    {
+        return m_buffers[m_nWrite];
+    }
+
+    void Publish()
+    {
+        int nOldMiddle = m_nMiddle.exchange(m_nWrite | FRESH_BIT, std::memory_order_acq_rel);
+        m_nWrite = nOldMiddle & INDEX_MASK;
+    }
+
+    // returns true if a newer buffer was published since the last call
+    bool Fetch()
+    {
+        if (0 == (m_nMiddle.load(std::memory_order_relaxed) & FRESH_BIT))
+        {
+            return false;
+        }
+
+        int nOldMiddle = m_nMiddle.exchange(m_nRead, std::memory_order_acq_rel);
+        m_nRead = nOldMiddle & INDEX_MASK;
+        return true;
+    }
+
+    const T &GetReadBuffer() const
+    {
+        return m_buffers[m_nRead];
+    }
+
+private:
+    enum { INDEX_MASK = 3, FRESH_BIT = 4 };
+
+    T m_buffers[3];
+    int m_nWrite;               // only touched by the writer
+    std::atomic<int> m_nMiddle; // index of the shared buffer + FRESH_BIT if it was not fetched yet
+    int m_nRead;                // only touched by the reader
+};
+
+#endif // TRIPLEBUFFER_H
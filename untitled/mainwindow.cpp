@@ -5,6 +5,9 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QException>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -44,7 +47,7 @@ bool MainWindow::Init(QSplashScreen &splash)
         return false;
     }
 
-    splash.showMessage("Initilaize BulletPhysics... (this may take a few minutes)", nAlignment);
+    splash.showMessage("Initilaize BulletPhysics... (the first start may take a while)", nAlignment);
     splash.update();
     if (false == InitPhysics())
     {
@@ -71,6 +74,8 @@ bool MainWindow::Init(QSplashScreen &splash)
     m_bMouseButtonDown = true;
     ui->glWidget->setCursor(Qt::BlankCursor);
 
+    m_simulationThread.Start(m_rigidBodyPipeline, 1.0f / 60.0f, 4);
+
     m_elapsedTimer.start();
     m_nElapsedTime = m_nCurrentTime = m_elapsedTimer.nsecsElapsed();
 
@@ -87,6 +92,11 @@ MainWindow::~MainWindow()
 
     ui->glWidget->setCursor(Qt::ArrowCursor);
 
+    m_simulationThread.Stop();
+    if (0 != m_renderInstanceFence)
+    {
+        glDeleteSync(m_renderInstanceFence);
+    }
     ExitPhysics();
     delete ui;
 }
@@ -146,6 +156,8 @@ bool MainWindow::InitScene(QSplashScreen &splash)
 
     m_shaderDraw.Load("Shaders/Draw.vs.txt", "Shaders/Draw.fs.txt");
     m_shaderShadowMap.Load("Shaders/DrawToDepthTexture.vs.txt", "Shaders/DrawToDepthTexture.fs.txt");
+    m_shaderDrawInstanced.Load("Shaders/DrawInstanced.vs.txt", "Shaders/Draw.fs.txt");
+    m_shaderShadowMapInstanced.Load("Shaders/DrawToDepthTextureInstanced.vs.txt", "Shaders/DrawToDepthTexture.fs.txt");
     std::vector<int> listTypes;
     listTypes.push_back(GL_RGBA32F);
     m_RenderToShadowTexture.Load(listTypes, nShadowWidth, nShadowWidth);
@@ -155,15 +167,22 @@ bool MainWindow::InitScene(QSplashScreen &splash)
     // 1/2 - draw
     m_modelDraw.Load("Scene", "Scene.obj");
     m_modelDraw.CreateOpenGLBuffers();
-    // 2/2 - physics
-    m_modelPhysics.Load("Scene", "Physics.obj", glm::mat4(1.0f), false);
-    CreateConcaveMesh(glm::vec3(0,0,0), glm::vec3(0,0,0), 0.0f, m_modelPhysics.GetVertices());
-
-    //Model avatar;
-    //avatar.Load("Scene", "Avatar.obj");
-    //m_rigidbodyAvatarId = CreateConvexMesh(glm::vec3(20,3,20), glm::vec3(0,0,0), 85.0f, avatar.GetVertices());
+    // 2/2 - physics, the obj is only loaded when the cooked shape is missing or older
+    glm::mat4 mPhysicsTransform = glm::mat4(1.0f);
+    int nSceneShape = RegisterCookedShape("Scene/Physics.cooked", "Scene/Physics.obj", mPhysicsTransform);
+    if (-1 == nSceneShape)
+    {
+        m_modelPhysics.Load("Scene", "Physics.obj", mPhysicsTransform, false);
+        nSceneShape = RegisterConcaveMeshShape(glm::vec3(0,0,0), &m_modelPhysics);
+        CookShape(nSceneShape, "Scene/Physics.cooked", mPhysicsTransform);
+    }
+    if (-1 == CreateConcaveMesh(nSceneShape, glm::vec3(0,0,0), 0.0f))
+    {
+        return false;
+    }
 
-    m_dynamicmodel.Load("Scene", "barrel.obj", glm::scale(glm::vec3(0.015f, 0.015f, 0.015f)), false);
+    glm::mat4 mBarrelTransform = glm::scale(glm::vec3(0.015f, 0.015f, 0.015f));
+    m_dynamicmodel.Load("Scene", "barrel.obj", mBarrelTransform, false);
     m_dynamicmodel.CreateOpenGLBuffers();
     for (int i = 0; i < numTextures; i++)
     {
@@ -174,8 +193,8 @@ bool MainWindow::InitScene(QSplashScreen &splash)
         textures[i] = texture.ID();
     }
 
-    int max = 10000;
-    int curr = 0;
+    // collect the barrels first and register them with one call, the bodies get consecutive ids
+    std::vector<glm::vec3> listPositions;
     for(int x = -5; x < 5; x++)
     {
         for(int z = -5; z < 5; z++)
@@ -183,21 +202,68 @@ bool MainWindow::InitScene(QSplashScreen &splash)
             for(int y = 0; y < (1/*100db*/ * 100/*10000db*/); y++)
             {
                 float fScale = 1.5f;
-                int dynamic_id = CreateConvexMesh(glm::vec3(x * fScale, 20 + (y * fScale), z * fScale), glm::vec3(0,0,0), 10.0f, m_dynamicmodel.GetVertices());
-                m_listDynamicIds.push_back(dynamic_id);
+                listPositions.push_back(glm::vec3(x * fScale, 20 + (y * fScale), z * fScale));
+            }
+        }
+    }
+
+    std::string strMessage = "Loading Scene... (" + std::to_string(listPositions.size()) + " rigid bodies)";
+    splash.showMessage(strMessage.c_str(), nAlignment);
+    splash.update();
+
+    // the cooked hull is built from the scaled vertices, it is cooked again when the scaling above changes
+    int nBarrelShape = RegisterCookedShape("Scene/barrel.cooked", "Scene/barrel.obj", mBarrelTransform);
+    if (-1 == nBarrelShape)
+    {
+        nBarrelShape = RegisterConvexHullShape(m_dynamicmodel.GetVertices());
+        CookShape(nBarrelShape, "Scene/barrel.cooked", mBarrelTransform);
+    }
 
-                int id = rand() % numTextures;
-                m_listRigidBodiesTextureId.push_back( textures[id] );
+    std::vector< int > listDynamicIds;
+    if (-1 == CreateConvexMeshes(listPositions, glm::vec3(0,0,0), 10.0f, nBarrelShape, listDynamicIds))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < (int)listPositions.size(); i++)
+    {
+        m_listDynamicIds.push_back(listDynamicIds.at(i));
 
-                curr++;
-                std::string strMessage = "Loading Scene... (" + std::to_string(curr) + "/" + std::to_string(max) + ")";
-                splash.showMessage(strMessage.c_str(), nAlignment);
-                splash.update();
+        int id = rand() % numTextures;
+        m_listRigidBodiesTextureId.push_back( textures[id] );
+    }
+
+    // group the bodies by texture, so one instanced draw call per texture is enough
+    m_listInstanceOrder.clear();
+    for (int j = 0; j < numTextures; j++)
+    {
+        m_nInstanceFirst[j] = (int)m_listInstanceOrder.size();
+        for (int i = 0; i < (int)m_listDynamicIds.size(); i++)
+        {
+            if (m_listRigidBodiesTextureId.at(i) == textures[j])
+            {
+                m_listInstanceOrder.push_back(i);
             }
         }
+        m_nInstanceCount[j] = (int)m_listInstanceOrder.size() - m_nInstanceFirst[j];
+    }
+    m_listInstanceMatrices.resize(m_listInstanceOrder.size());
+    m_dynamicmodel.CreateInstanceBuffer((int)m_listInstanceOrder.size());
+
+    std::vector<int> listInstanceBodyIds;
+    for (int k = 0; k < (int)m_listInstanceOrder.size(); k++)
+    {
+        listInstanceBodyIds.push_back(m_listDynamicIds.at(m_listInstanceOrder.at(k)));
+    }
+    m_rigidBodyPipeline->setRenderInstances(listInstanceBodyIds.data(), (int)listInstanceBodyIds.size());
+    if (true == m_bCLGLInterop)
+    {
+        // the world matrices are written by OpenCL into the instance buffer, no host copy
+        m_bCLGLInterop = m_rigidBodyPipeline->setRenderInstanceBufferGL(m_dynamicmodel.GetInstanceBuffer());
     }
 
     m_rigidBodyPipeline->setGravity(b3MakeVector3(0, -9.81f, 0));
+    m_rigidBodyPipeline->setNumTransformReadbackBuffers(3);
 
     m_rigidBodyPipeline->writeAllInstancesToGpu();
     m_np->writeAllBodiesToGpu();
@@ -208,7 +274,7 @@ bool MainWindow::InitScene(QSplashScreen &splash)
     return true;
 }
 
-int MainWindow::CreateConvexMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, float fMass, std::vector< Vertex > *pListVertices)
+int MainWindow::RegisterConvexHullShape(std::vector< Vertex > *pListVertices)
 {
     static int colIndex = -1;
     if (-1 == colIndex)
@@ -228,31 +294,76 @@ int MainWindow::CreateConvexMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, float
         colIndex = m_np->registerConvexHullShape( (float*)vertices.data() , 3 * sizeof(float), vertices.size(), scaling);
     }
 
-    b3Vector3 position = b3MakeVector3(v3Position.x, v3Position.y, v3Position.z);
+    return colIndex;
+}
+
+int MainWindow::CreateConvexMeshes(std::vector< glm::vec3 > &listPositions, glm::vec3 v3Rotate, float fMass, int colIndex, std::vector< int > &listBodyIndices)
+{
+    if (-1 == colIndex)
+    {
+        return -1;
+    }
+
+    int nCount = (int)listPositions.size();
+
     b3Quaternion orn(v3Rotate.x, v3Rotate.y, v3Rotate.z);
 
-    int nRigidBodyIndex = m_rigidBodyPipeline->registerPhysicsInstance(fMass, position, orn, colIndex, 0, false);
+    std::vector<b3Vector3> listBodyPositions(nCount);
+    std::vector<b3Quaternion> listBodyOrientations(nCount, orn);
+    std::vector<float> listMasses(nCount, fMass);
+    std::vector<int> listColIndices(nCount, colIndex);
+    for (int i = 0; i < nCount; i++)
+    {
+        glm::vec3 v3Position = listPositions.at(i);
+        listBodyPositions[i] = b3MakeVector3(v3Position.x, v3Position.y, v3Position.z);
+    }
 
-    return nRigidBodyIndex;
+    // the bodies reuse the slots of removed bodies first, so the indices are not always consecutive
+    listBodyIndices.resize(nCount);
+    int nRegistered = m_rigidBodyPipeline->registerPhysicsInstances(nCount, listMasses.data(), (float*)listBodyPositions.data(), (float*)listBodyOrientations.data(), listColIndices.data(), false, listBodyIndices.data());
+
+    return nRegistered;
 }
 
-int MainWindow::CreateConcaveMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, float fMass, std::vector< Vertex > *pListVertices)
+int MainWindow::RegisterConcaveMeshShape(glm::vec3 v3Position, Model *pModel, float fWeldDistance)
 {
-    b3AlignedObjectArray<b3Vector3> vertices;
-    b3AlignedObjectArray<int> indices;
+    std::vector< glm::vec3 > *pListPositions = pModel->GetPositions();
+    std::vector< uint32_t > *pListIndices = pModel->GetPositionIndices();
 
-    for(int i = 0; i < (int)pListVertices->size(); i++)
+    b3AlignedObjectArray<b3Vector3> vertices;
+    vertices.reserve((int)pListPositions->size());
+    for(int i = 0; i < (int)pListPositions->size(); i++)
     {
-        Vertex vertex = pListVertices->at(i);
-
-        glm::vec3 pos = vertex.v3Position + v3Position;
+        glm::vec3 pos = pListPositions->at(i) + v3Position;
         vertices.push_back(b3MakeVector3(pos.x, pos.y, pos.z));
+    }
+
+    b3AlignedObjectArray<int> indices;
+    indices.reserve((int)pListIndices->size());
+    for(int i = 0; i < (int)pListIndices->size(); i++)
+    {
+        indices.push_back((int)pListIndices->at(i));
+    }
 
-        indices.push_back(i);
+    // the file splits the vertices at uv and normal seams, the physics only needs one vertex per position
+    b3AlignedObjectArray<b3Vector3> weldedVertices;
+    b3AlignedObjectArray<int> weldedIndices;
+    b3GeometryUtil::weldVertices(vertices, indices, fWeldDistance, weldedVertices, weldedIndices);
+    if (0 == weldedIndices.size())
+    {
+        return -1;
     }
 
     b3Vector3 scaling = b3MakeVector3(1.0f, 1.0f, 1.0f);
-    int colIndex = m_np->registerConcaveMesh(&vertices, &indices, scaling);
+    return m_np->registerConcaveMesh(&weldedVertices, &weldedIndices, scaling);
+}
+
+int MainWindow::CreateConcaveMesh(int colIndex, glm::vec3 v3Rotate, float fMass)
+{
+    if (-1 == colIndex)
+    {
+        return -1;
+    }
 
     b3Vector3 position = b3MakeVector3(0, 0, 0);
     b3Quaternion orn(v3Rotate.x, v3Rotate.y, v3Rotate.z);
@@ -262,14 +373,72 @@ int MainWindow::CreateConcaveMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, floa
     return nRigidBodyIndex;
 }
 
+unsigned int MainWindow::CookedShapeKey(const glm::mat4 &mTransform)
+{
+    return (unsigned int)qHashBits(glm::value_ptr(mTransform), sizeof(float) * 16);
+}
+
+int MainWindow::RegisterCookedShape(QString strCookedFilename, QString strSourceFilename, const glm::mat4 &mTransform)
+{
+    // a cooked shape older than its source is cooked again
+    QFileInfo cookedInfo(strCookedFilename);
+    if (false == cookedInfo.exists() || cookedInfo.lastModified() < QFileInfo(strSourceFilename).lastModified())
+    {
+        return -1;
+    }
+
+    QFile file(strCookedFilename);
+    if (false == file.open(QIODevice::ReadOnly))
+    {
+        return -1;
+    }
+
+    // the narrowphase copies the arrays straight out of the mapped file, -1 if it was cooked by another version
+    // or with another transform of the source vertices
+    int colIndex = -1;
+    uchar *pData = file.map(0, file.size());
+    if (nullptr != pData)
+    {
+        colIndex = m_np->registerCookedShape(pData, (int)file.size(), CookedShapeKey(mTransform));
+        file.unmap(pData);
+    }
+
+    return colIndex;
+}
+
+bool MainWindow::CookShape(int colIndex, QString strCookedFilename, const glm::mat4 &mTransform)
+{
+    b3AlignedObjectArray<unsigned char> cookedData;
+    if (-1 == colIndex || false == m_np->cookShape(colIndex, cookedData, CookedShapeKey(mTransform)))
+    {
+        return false;
+    }
+
+    QFile file(strCookedFilename);
+    if (false == file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    qint64 nSize = cookedData.size();
+    return nSize == file.write((const char*)&cookedData[0], nSize);
+}
+
 bool MainWindow::InitPhysics()
 {
-    if (false == initCL(-1, -1))
+    // prefer a context that shares buffers with OpenGL (cl_khr_gl_sharing), otherwise copy through the host
+    m_bCLGLInterop = initCL(-1, -1, true);
+    if (false == m_bCLGLInterop && false == initCL(-1, -1, false))
     {
         return false;
     }
 
-    m_config.m_maxConvexBodies = 65535;
+    // start compiling all OpenCL programs in parallel, the constructors below only wait for the ones they use
+    b3GpuRigidBodyPipeline::compileProgramsAsync(m_clContext, m_clDevice);
+
+    // initial capacities only, the bodies, pairs and contacts grow when they overflow (and the step is run again)
+    m_config.m_capacityGrowthPolicy = B3_CAPACITY_GROW_RERUN;
+    m_config.m_maxConvexBodies = 16 * 1024;
     m_config.m_maxConvexShapes = m_config.m_maxConvexBodies;
     int maxPairsPerBody = 8;
     m_config.m_maxBroadphasePairs = maxPairsPerBody * m_config.m_maxConvexBodies;
@@ -277,21 +446,31 @@ bool MainWindow::InitPhysics()
     m_config.m_maxTriConvexPairCapacity = 128 * 1024;
 
     m_np = new b3GpuNarrowPhase(m_clContext, m_clDevice, m_clQueue, m_config);
-    m_bp = new b3GpuSapBroadphase(m_clContext, m_clDevice, m_clQueue);
+    m_bp = new b3GpuAdaptiveBroadphase(m_clContext, m_clDevice, m_clQueue);
     m_broadphaseDbvt = new b3DynamicBvhBroadphase(m_config.m_maxConvexBodies);
 
     m_rigidBodyPipeline = new b3GpuRigidBodyPipeline(m_clContext, m_clDevice, m_clQueue, m_np, m_bp, m_broadphaseDbvt, m_config);
+    if (true == m_bGpuProfiling)
+    {
+        m_rigidBodyPipeline->setGpuProfilingEnabled(true);
+    }
 
     return true;
 }
 
-bool MainWindow::initCL(int preferredDeviceIndex, int preferredPlatformIndex)
+bool MainWindow::initCL(int preferredDeviceIndex, int preferredPlatformIndex, bool bShareWithGL)
 {
     int ciErrNum = 0;
 
     cl_device_type deviceType = CL_DEVICE_TYPE_GPU;
 
-    m_clContext = b3OpenCLUtils::createContextFromType(deviceType, &ciErrNum, 0, 0, preferredDeviceIndex, preferredPlatformIndex, &m_platformId);
+    void *pGLContext = (true == bShareWithGL) ? (void*)hRC : nullptr;
+    void *pGLDC = (true == bShareWithGL) ? (void*)hDC : nullptr;
+    m_clContext = b3OpenCLUtils::createContextFromType(deviceType, &ciErrNum, pGLContext, pGLDC, preferredDeviceIndex, preferredPlatformIndex, &m_platformId);
+    if (true == bShareWithGL && 0 == m_clContext)
+    {
+        return false;
+    }
 
     oclCHECKERROR(ciErrNum, CL_SUCCESS);
 
@@ -300,7 +479,8 @@ bool MainWindow::initCL(int preferredDeviceIndex, int preferredPlatformIndex)
     if (numDev > 0)
     {
         m_clDevice = b3OpenCLUtils::getDevice(m_clContext, 0);
-        m_clQueue = clCreateCommandQueue(m_clContext, m_clDevice, 0, &ciErrNum);
+        cl_command_queue_properties queueProperties = (true == m_bGpuProfiling) ? CL_QUEUE_PROFILING_ENABLE : 0;
+        m_clQueue = clCreateCommandQueue(m_clContext, m_clDevice, queueProperties, &ciErrNum);
         oclCHECKERROR(ciErrNum, CL_SUCCESS);
 
         b3OpenCLDeviceInfo info;
@@ -315,11 +495,17 @@ bool MainWindow::initCL(int preferredDeviceIndex, int preferredPlatformIndex)
 
 void MainWindow::ExitPhysics()
 {
+    if (true == m_bGpuProfiling)
+    {
+        m_rigidBodyPipeline->getGpuProfiler()->writeChromeTrace("gpu_trace.json");
+    }
+
     delete m_np;
     delete m_bp;
     delete m_broadphaseDbvt;
     delete m_rigidBodyPipeline;
 
+    b3OpenCLUtils::releasePendingPrograms(m_clContext);
     clReleaseCommandQueue(m_clQueue);
     clReleaseContext(m_clContext);
 }
@@ -353,13 +539,29 @@ void MainWindow::TimerTick()
     if (nWidth < 1) { nWidth = 1; }
     if (nHeight < 1) { nHeight = 1; }
 
-    // physics
-    float dt2 = dt;
-    if (dt2 > (1.0f / 60.0f)){ dt2 = 1.0f / 60.0f; }
-    m_rigidBodyPipeline->stepSimulation(dt2);
-    Sleep(10);
+    // physics runs on m_simulationThread, blend the two newest fixed steps
+    const TransformSnapshot &snapshot = m_simulationThread.GetLatestSnapshot();
+    float fAlpha = SimulationThread::GetAlpha(snapshot, m_simulationThread.NsecsElapsed());
+    int nNumTransforms = (int)snapshot.listCurrent.size();
 
-    m_np->readbackAllBodiesToCpu();
+    if (false == m_bCLGLInterop)
+    {
+        // fallback: interpolated host copy, one upload of all world matrices per frame, in texture order
+        for (int k = 0; k < (int)m_listInstanceOrder.size(); k++)
+        {
+            int nRigidBodyId = m_listDynamicIds.at(m_listInstanceOrder.at(k));
+            if (nRigidBodyId < nNumTransforms)
+            {
+                m_listInstanceMatrices[k] = SimulationThread::GetWorldMatrix(snapshot, nRigidBodyId, fAlpha);
+            }
+            else
+            {
+                // not simulated yet, a zero matrix collapses the instance
+                m_listInstanceMatrices[k] = glm::mat4(0.0f);
+            }
+        }
+        m_dynamicmodel.SetInstances(m_listInstanceMatrices.data(), (int)m_listInstanceMatrices.size());
+    }
 
     // mouse rotate
     if (true == m_bMouseButtonDown)
@@ -443,41 +645,33 @@ void MainWindow::TimerTick()
     m_modelDraw.Begin(&m_shaderShadowMap);
     m_modelDraw.Draw(&m_shaderShadowMap);
     m_modelDraw.End(&m_shaderShadowMap);
+    m_shaderShadowMap.End();
 
+    bool bDrawInstances = true;
+    if (true == m_bCLGLInterop)
     {
-        b3RigidBodyData *pRigidBodies = (b3RigidBodyData*)m_np->getBodiesCpu();
+        // the instance buffer is shared with OpenCL and written by the simulation thread after each step,
+        // it stays locked while the draws from it are submitted (see below)
+        bDrawInstances = (0 != m_simulationThread.LockRenderInstances());
+    }
 
-        m_dynamicmodel.Begin(&m_shaderShadowMap);
+    if (true == bDrawInstances)
+    {
+        m_shaderShadowMapInstanced.Begin();
+        m_shaderShadowMapInstanced.SetMatrix("matView", &mLightView);
+        m_shaderShadowMapInstanced.SetMatrix("matProj", &mLightProj);
+
+        m_dynamicmodel.BeginInstanced(&m_shaderShadowMapInstanced);
         for (int j = 0; j < numTextures; j++)
         {
-            m_shaderShadowMap.SetTexture("g_Texture", textures[j], 0);
-
-            for (int i = 0; i < m_listDynamicIds.size(); i++)
-            {
-                if (m_listRigidBodiesTextureId.at(i) != textures[j])
-                {
-                    continue;
-                }
-
-                int nRigidBodyId = m_listDynamicIds.at(i);
-                //b3RigidBodyData *pRigidBody = &(pRigidBodies[nRigidBodyId]);
-
-                //b3Vector3 tr = pRigidBody->m_pos;
-                //b3Quat quat = pRigidBody->m_quat;
-                b3Vector3 tr;
-                b3Quat quat;
-                m_np->getObjectTransformFromCpu(&tr.x, &quat.x, nRigidBodyId);
-
-                glm::mat4 mWorld = glm::translate(glm::vec3(tr.x, tr.y, tr.z) ) * glm::rotate(quat.getAngle(), glm::vec3(quat.getAxis().x, quat.getAxis().y, quat.getAxis().z));
-
-                m_shaderShadowMap.SetMatrix("matWorld", &mWorld);
-                m_dynamicmodel.Draw(&m_shaderShadowMap);
-            }
+            m_shaderShadowMapInstanced.SetTexture("g_Texture", textures[j], 0);
+            m_dynamicmodel.DrawInstanced(&m_shaderShadowMapInstanced, m_nInstanceFirst[j], m_nInstanceCount[j]);
         }
-        m_dynamicmodel.End(&m_shaderShadowMap);
+        m_dynamicmodel.EndInstanced(&m_shaderShadowMapInstanced);
+
+        m_shaderShadowMapInstanced.End();
     }
 
-    m_shaderShadowMap.End();
     m_RenderToShadowTexture.Unbind();
 
     // 2/2 - draw to screen with shadow
@@ -502,42 +696,57 @@ void MainWindow::TimerTick()
     m_modelDraw.Draw(&m_shaderDraw);
     m_modelDraw.End(&m_shaderDraw);
 
-    {
-        b3RigidBodyData *pRigidBodies = (b3RigidBodyData*)m_np->getBodiesCpu();
+    m_shaderDraw.DisableTexture(1);
+    m_shaderDraw.End();
 
-        m_dynamicmodel.Begin(&m_shaderDraw);
+    if (true == bDrawInstances)
+    {
+        m_shaderDrawInstanced.Begin();
+        m_shaderDrawInstanced.SetMatrix("matView", &mCameraView);
+        m_shaderDrawInstanced.SetMatrix("matProj", &mCameraProj);
+        m_shaderDrawInstanced.SetMatrix("matLightView", &mLightView);
+        m_shaderDrawInstanced.SetMatrix("matLightProj", &mLightProj);
+        m_shaderDrawInstanced.SetVector3("lightDir", &v3LightDir);
+        m_shaderDrawInstanced.SetTexture("g_DepthTexture", m_RenderToShadowTexture.GetTextureID(0), 1);
+
+        m_dynamicmodel.BeginInstanced(&m_shaderDrawInstanced);
         for (int j = 0; j < numTextures; j++)
         {
-            m_shaderDraw.SetTexture("g_Texture", textures[j], 0);
-
-            for (int i = 0; i < m_listDynamicIds.size(); i++)
-            {
-                if (m_listRigidBodiesTextureId.at(i) != textures[j])
-                {
-                    continue;
-                }
-
-                int nRigidBodyId = m_listDynamicIds.at(i);
-                b3RigidBodyData *pRigidBody = &(pRigidBodies[nRigidBodyId]);
+            m_shaderDrawInstanced.SetTexture("g_Texture", textures[j], 0);
+            m_dynamicmodel.DrawInstanced(&m_shaderDrawInstanced, m_nInstanceFirst[j], m_nInstanceCount[j]);
+        }
+        m_dynamicmodel.EndInstanced(&m_shaderDrawInstanced);
 
-                //b3Vector3 tr = pRigidBody->m_pos;
-                //b3Quat quat = pRigidBody->m_quat;
-                b3Vector3 tr;
-                b3Quat quat;
-                m_np->getObjectTransformFromCpu(&tr.x, &quat.x, nRigidBodyId);
+        m_shaderDrawInstanced.DisableTexture(1);
+        m_shaderDrawInstanced.End();
+    }
 
-                glm::mat4 mWorld = glm::translate(glm::vec3(tr.x, tr.y, tr.z) ) * glm::rotate(quat.getAngle(), glm::vec3(quat.getAxis().x, quat.getAxis().y, quat.getAxis().z));
+    if (true == m_bCLGLInterop)
+    {
+        // OpenCL may only acquire the buffer again after GL is done with it, with cl_khr_gl_event the device
+        // waits for a fence, so the lock is only held while the draws are submitted
+        cl_event glDoneEvent = 0;
+        GLsync fence = 0;
+        if (true == m_rigidBodyPipeline->isGLSyncSupported())
+        {
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+            glDoneEvent = m_rigidBodyPipeline->createEventFromGLSync(fence);
+        }
+        if (0 == glDoneEvent)
+        {
+            glFinish();
+        }
+        m_simulationThread.UnlockRenderInstances(glDoneEvent);
 
-                m_shaderDraw.SetMatrix("matWorld", &mWorld);
-                m_dynamicmodel.Draw(&m_shaderDraw);
-            }
+        // the event of the previous fence is released or has completed by now
+        if (0 != m_renderInstanceFence)
+        {
+            glDeleteSync(m_renderInstanceFence);
         }
-        m_dynamicmodel.End(&m_shaderDraw);
+        m_renderInstanceFence = fence;
     }
 
-    m_shaderDraw.DisableTexture(1);
-    m_shaderDraw.End();
-
     // sky
     glMatrixMode(GL_PROJECTION);
     glLoadMatrixf(glm::value_ptr(mCameraProj));
@@ -11,14 +11,17 @@
 #include "Camera.h"
 #include "SkyBox.h"
 #include "RenderTarget.h"
+#include "SimulationThread.h"
 
 #include "Bullet3OpenCL/Initialize/b3OpenCLUtils.h"
 #include "Bullet3OpenCL/RigidBody/b3GpuRigidBodyPipeline.h"
+#include "Bullet3OpenCL/ParallelPrimitives/b3GpuProfiler.h"
 #include "Bullet3OpenCL/RigidBody/b3GpuNarrowPhase.h"
-#include "Bullet3OpenCL/BroadphaseCollision/b3GpuSapBroadphase.h"
+#include "Bullet3OpenCL/BroadphaseCollision/b3GpuAdaptiveBroadphase.h"
 #include "Bullet3Collision/NarrowPhaseCollision/b3Config.h"
 #include "Bullet3Collision/BroadPhaseCollision/b3DynamicBvhBroadphase.h"
 #include "Bullet3Collision/NarrowPhaseCollision/shared/b3RigidBodyData.h"
+#include "Bullet3Geometry/b3GeometryUtil.h"
 
 #include <Windows.h>
 
@@ -62,9 +65,16 @@ private:
     // physics
     bool InitPhysics();
     void ExitPhysics();
-    bool initCL(int preferredDeviceIndex, int preferredPlatformIndex);
-    int CreateConvexMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, float fMass, std::vector< Vertex > *pListVertices);
-    int CreateConcaveMesh(glm::vec3 v3Position, glm::vec3 v3Rotate, float fMass, std::vector< Vertex > *pListVertices);
+    bool initCL(int preferredDeviceIndex, int preferredPlatformIndex, bool bShareWithGL);
+    int RegisterConvexHullShape(std::vector< Vertex > *pListVertices);
+    int CreateConvexMeshes(std::vector< glm::vec3 > &listPositions, glm::vec3 v3Rotate, float fMass, int colIndex, std::vector< int > &listBodyIndices);
+    int RegisterConcaveMeshShape(glm::vec3 v3Position, Model *pModel, float fWeldDistance = 0.001f);
+    int CreateConcaveMesh(int colIndex, glm::vec3 v3Rotate, float fMass);
+    // cooked collision shapes (see b3GpuCookedShape.h), written on the first start and memory mapped on the next ones
+    // mTransform is the one the source was loaded with, its hash is stored in the cooked header
+    unsigned int CookedShapeKey(const glm::mat4 &mTransform);
+    int RegisterCookedShape(QString strCookedFilename, QString strSourceFilename, const glm::mat4 &mTransform);
+    bool CookShape(int colIndex, QString strCookedFilename, const glm::mat4 &mTransform);
 
     // scene
     bool InitScene(QSplashScreen &splash);
@@ -90,10 +100,17 @@ private:
     int numTextures = 6;
     QString strFilenames[6] = { "diffus_black.tga", "diffus_blue.tga", "diffus_green.tga", "diffus_red.tga", "diffus_rust.tga", "diffus_yellow.tga" };
     GLuint textures[6];
+    // instancing: m_listDynamicIds indices sorted by texture, one range per texture
+    std::vector<int> m_listInstanceOrder;
+    int m_nInstanceFirst[6];
+    int m_nInstanceCount[6];
+    std::vector<glm::mat4> m_listInstanceMatrices;
 
     // shader
     Shader m_shaderDraw;
     Shader m_shaderShadowMap;
+    Shader m_shaderDrawInstanced;
+    Shader m_shaderShadowMapInstanced;
 
     // RenderTarget
     RenderTarget m_RenderToShadowTexture;
@@ -122,6 +139,11 @@ private:
     // bullet physics
     cl_platform_id m_platformId;
     cl_context m_clContext;
+    bool m_bCLGLInterop = false;
+    // fence after the draws from the shared instance buffer, kept until the next frame replaces its event
+    GLsync m_renderInstanceFence = 0;
+    // per-stage device times of each step, written to gpu_trace.json on exit (chrome://tracing)
+    bool m_bGpuProfiling = false;
     cl_device_id m_clDevice;
     cl_command_queue m_clQueue;
     char* m_clDeviceName;
@@ -131,5 +153,8 @@ private:
     b3GpuBroadphaseInterface* m_bp;
     b3DynamicBvhBroadphase* m_broadphaseDbvt;
     b3GpuRigidBodyPipeline* m_rigidBodyPipeline;
+
+    // fixed timestep simulation, decoupled from the render timer
+    SimulationThread m_simulationThread;
 };
 #endif // MAINWINDOW_H
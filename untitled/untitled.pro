@@ -28,7 +28,9 @@ SOURCES += \
     SDKs/bullet3-3.22a/src/Bullet3Dynamics/b3CpuRigidBodyPipeline.cpp \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/b3ConvexHullComputer.cpp \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/b3GeometryUtil.cpp \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuAdaptiveBroadphase.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuGridBroadphase.cpp \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuMultiLevelGridBroadphase.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuParallelLinearBvh.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuParallelLinearBvhBroadphase.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuSapBroadphase.cpp \
@@ -44,6 +46,7 @@ SOURCES += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/b3VoronoiSimplexSolver.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3BoundSearchCL.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3FillCL.cpp \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3GpuProfiler.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3PrefixScanCL.cpp \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3PrefixScanFloat4CL.cpp \
@@ -243,6 +246,7 @@ SOURCES += \
     SDKs/bullet3-3.22a/src/btLinearMathAll.cpp \
     SDKs/bullet3-3.22a/src/clew/clew.c \
     Shader.cpp \
+    SimulationThread.cpp \
     Texture.cpp \
     main.cpp \
     mainwindow.cpp \
@@ -259,6 +263,7 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3Collision/BroadPhaseCollision/b3OverlappingPair.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/BroadPhaseCollision/b3OverlappingPairCache.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/BroadPhaseCollision/shared/b3Aabb.h \
+    SDKs/bullet3-3.22a/src/Bullet3Collision/BroadPhaseCollision/shared/b3CollisionFilter.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/b3Config.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/b3Contact4.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/b3ConvexUtility.h \
@@ -275,11 +280,13 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3ConvexPolyhedronData.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3FindConcaveSatAxis.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3FindSeparatingAxis.h \
+    SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3InternalEdgeAxis.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3MprPenetration.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3NewContactReduction.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3QuantizedBvhNodeData.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3ReduceContacts.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3RigidBodyData.h \
+    SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3TriangleInfo.h \
     SDKs/bullet3-3.22a/src/Bullet3Collision/NarrowPhaseCollision/shared/b3UpdateAabbs.h \
     SDKs/bullet3-3.22a/src/Bullet3Common/b3AlignedAllocator.h \
     SDKs/bullet3-3.22a/src/Bullet3Common/b3AlignedObjectArray.h \
@@ -323,13 +330,17 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/b3ConvexHullComputer.h \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/b3GeometryUtil.h \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/b3GrahamScan2dConvexHull.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuAdaptiveBroadphase.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuBroadphaseInterface.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuGridBroadphase.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuMultiLevelGridBroadphase.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuParallelLinearBvh.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuParallelLinearBvhBroadphase.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3GpuSapBroadphase.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/b3SapAabb.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/adaptiveBroadphaseKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/gridBroadphaseKernels.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/multiLevelGridBroadphaseKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/parallelLinearBvhKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/sapKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/Initialize/b3OpenCLInclude.h \
@@ -349,6 +360,7 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/b3VoronoiSimplexSolver.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/bvhTraversal.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/mprKernels.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/pairClassification.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/primitiveContacts.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/satClipHullContacts.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/satConcaveKernels.h \
@@ -356,6 +368,7 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3BoundSearchCL.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3BufferInfoCL.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3FillCL.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3GpuProfiler.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3LauncherCL.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3OpenCLArray.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/ParallelPrimitives/b3PrefixScanCL.h \
@@ -370,6 +383,7 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/Raycast/b3GpuRaycast.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/Raycast/kernels/rayCastKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3GpuConstraint4.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3GpuCookedShape.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3GpuGenericConstraint.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3GpuJacobiContactSolver.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3GpuNarrowPhase.h \
@@ -383,7 +397,9 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/b3Solver.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/batchingKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/batchingKernelsNew.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/ccdKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/integrateKernel.h \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/islandKernels.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/jointSolver.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/solveContact.h \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/solveFriction.h \
@@ -684,7 +700,9 @@ HEADERS += \
     SDKs/bullet3-3.22a/src/btBulletDynamicsCommon.h \
     SDKs/bullet3-3.22a/src/clew/clew.h \
     Shader.h \
+    SimulationThread.h \
     Texture.h \
+    TripleBuffer.h \
     mainwindow.h \
     skybox.h
 
@@ -738,12 +756,15 @@ DISTFILES += \
     SDKs/bullet3-3.22a/src/Bullet3Dynamics/premake4.lua \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/CMakeLists.txt \
     SDKs/bullet3-3.22a/src/Bullet3Geometry/premake4.lua \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/adaptiveBroadphase.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/gridBroadphase.cl \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/multiLevelGridBroadphase.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/parallelLinearBvh.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/BroadphaseCollision/kernels/sap.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/CMakeLists.txt \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/bvhTraversal.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/mpr.cl \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/pairClassification.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/primitiveContacts.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/sat.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/NarrowphaseCollision/kernels/satClipHullContacts.cl \
@@ -757,7 +778,9 @@ DISTFILES += \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/Raycast/kernels/rayCastKernels.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/batchingKernels.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/batchingKernelsNew.cl \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/ccdKernels.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/integrateKernel.cl \
+    SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/islandKernels.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/jointSolver.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/solveContact.cl \
     SDKs/bullet3-3.22a/src/Bullet3OpenCL/RigidBody/kernels/solveFriction.cl \